@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+//  amx.c - 2026
+//
+/// This module reports whether AMX (Advanced Matrix Extensions) can be used
+/// inside an enclave on this host, and what it costs.
+///
+/// Using AMX in an enclave needs all of these:
+///
+///   - The CPU has AMX-TILE (and AMX-BF16/INT8/FP16/COMPLEX for the data
+///     types you want), with a tile palette in CPUID leaf 1DH
+///   - SGX allows TILECFG & TILEDATA in `SECS.ATTRIBUTES.XFRM`
+///   - The OS has enabled TILECFG & TILEDATA in XCR0
+///   - Linux arms XFD (eXtended Feature Disable) for TILEDATA, so a process
+///     must ask for it with `arch_prctl(ARCH_REQ_XCOMP_PERM)` before it
+///     touches a tile.  EENTER faults while XFD is armed for a component in
+///     the enclave's XFRM, so the host process needs the permission too.
+///
+/// The cost is in the SSA:  TILEDATA is 8 KiB of XSAVE state, so every SSA
+/// frame grows by (about) two pages for every TCS x NSSA in the enclave --
+/// whether or not the thread is using AMX at the time of the AEX.
+///
+/// The permission request is made for real (it only affects this process),
+/// so it isn't made for `--from` captures.
+///
+/// Usage:
+///
+///     test-sgx --amx                     # Report this host
+///     test-sgx --amx --nssa 2            # Two SSA frames per thread
+///     test-sgx --amx --from host17.cap   # Report a captured host
+///
+/// @see https://docs.kernel.org/arch/x86/xstate.html
+///
+/// @file   amx.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `syscall()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf()
+#include <stdlib.h>    // For atol()
+#include <string.h>    // For strcmp() strerror()
+#include <inttypes.h>  // For PRIx64 PRIu64 uint64_t
+#include <errno.h>     // For errno
+
+#ifdef __linux__
+   #include <unistd.h>        // For syscall()
+   #include <sys/syscall.h>   // For SYS_arch_prctl
+#endif
+
+#include "amx.h"       // For obvious reasons
+#include "capture.h"   // For capture_load() capture_find_cpuid()
+#include "cache.h"     // For cache_probe()
+#include "decode.h"    // For fields[] field_from_capture() field_from_regs() XSTATE_TILEDATA
+#include "xsave.h"     // For XSAVE_area_size()
+#include "planner.h"   // For SSA_frame_pages()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+// From arch/x86/include/uapi/asm/prctl.h -- older headers don't have them
+#ifndef ARCH_GET_XCOMP_SUPP
+   #define ARCH_GET_XCOMP_SUPP 0x1021
+#endif
+#ifndef ARCH_GET_XCOMP_PERM
+   #define ARCH_GET_XCOMP_PERM 0x1022
+#endif
+#ifndef ARCH_REQ_XCOMP_PERM
+   #define ARCH_REQ_XCOMP_PERM 0x1023
+#endif
+
+#define PAGE_SIZE 4096
+
+/// The XSAVE state components AMX uses
+#define XFRM_TILE ( ((uint64_t) 1 << XSTATE_TILECFG) | ((uint64_t) 1 << XSTATE_TILEDATA) )
+
+
+/// @return The value of field `id` in `cap`, or `0` if it wasn't captured
+static uint64_t field_or_zero( const struct sgx_capture* cap, enum field_id id ) {
+   uint64_t value = 0;
+   field_from_capture( &fields[id], cap, &value );
+   return value;
+}
+
+
+/// Print every tile palette (CPUID.(EAX=1DH, ECX=1+)) and the TMUL limits
+///
+/// @return `false` if there isn't a palette
+static bool print_palettes( const struct sgx_capture* cap ) {
+   uint64_t maxPalette = 0;
+
+   if( !field_from_capture( &fields[FIELD_TILE_MAX_PALETTE], cap, &maxPalette ) || maxPalette == 0 ) {
+      printf( "  Tile palettes:  None enumerated (CPUID leaf 1DH)\n" );
+      return false;
+   }
+
+   for( uint32_t p = 1 ; p <= maxPalette ; p++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( cap, 0x1D, p );
+      if( r == NULL ) {
+         printf( "  Palette %u:  Not captured\n", p );
+         continue;
+      }
+      printf( "  Palette %u:  %" PRIu64 " tiles of %" PRIu64 " rows x %" PRIu64 " bytes (%" PRIu64 " bytes each, %" PRIu64 " bytes in all)\n"
+             ,p
+             ,field_from_regs( &fields[FIELD_TILE_NAMES],       r->eax, r->ebx, r->ecx, r->edx )
+             ,field_from_regs( &fields[FIELD_TILE_ROWS],        r->eax, r->ebx, r->ecx, r->edx )
+             ,field_from_regs( &fields[FIELD_TILE_ROW_BYTES],   r->eax, r->ebx, r->ecx, r->edx )
+             ,field_from_regs( &fields[FIELD_TILE_BYTES],       r->eax, r->ebx, r->ecx, r->edx )
+             ,field_from_regs( &fields[FIELD_TILE_TOTAL_BYTES], r->eax, r->ebx, r->ecx, r->edx ) );
+   }
+
+   uint64_t maxK = 0;
+   uint64_t maxN = 0;
+   if( field_from_capture( &fields[FIELD_TMUL_MAXK], cap, &maxK ) && field_from_capture( &fields[FIELD_TMUL_MAXN], cap, &maxN ) ) {
+      printf( "  TMUL:  Up to K = %" PRIu64 " rows and N = %" PRIu64 " column bytes\n", maxK, maxN );
+   }
+   return true;
+}
+
+
+/// Ask Linux for permission to use TILEDATA, and print what happened
+///
+/// @return `true` if this process may use TILEDATA
+static bool request_permission( void ) {
+   #ifdef __linux__
+      uint64_t supported = 0;
+      uint64_t before = 0;
+      uint64_t after = 0;
+
+      if( syscall( SYS_arch_prctl, ARCH_GET_XCOMP_SUPP, &supported ) != 0 ) {
+         printf( "  arch_prctl(ARCH_GET_XCOMP_SUPP):  %s (the kernel predates dynamic XSAVE features)\n", strerror( errno ) );
+         return false;
+      }
+      syscall( SYS_arch_prctl, ARCH_GET_XCOMP_PERM, &before );
+      printf( "  Dynamic XSAVE features the kernel supports:  %016" PRIx64 "\n", supported );
+      printf( "  Permitted for this process before asking:    %016" PRIx64 "\n", before );
+
+      if( !((supported >> XSTATE_TILEDATA) & 1) ) {
+         printf( "  The kernel doesn't support TILEDATA\n" );
+         return false;
+      }
+
+      if( syscall( SYS_arch_prctl, ARCH_REQ_XCOMP_PERM, XSTATE_TILEDATA ) != 0 ) {
+         printf( "  arch_prctl(ARCH_REQ_XCOMP_PERM, TILEDATA):  %s\n", strerror( errno ) );
+         return false;
+      }
+      syscall( SYS_arch_prctl, ARCH_GET_XCOMP_PERM, &after );
+      printf( "  arch_prctl(ARCH_REQ_XCOMP_PERM, TILEDATA):   Granted\n" );
+      printf( "  Permitted for this process after asking:     %016" PRIx64 "\n", after );
+      return (after >> XSTATE_TILEDATA) & 1;
+
+   #else
+      printf( "  Only Linux has ARCH_REQ_XCOMP_PERM\n" );
+      return false;
+   #endif
+}
+
+
+/// `--amx [--from CAPTURE] [--nssa N]`
+int amx_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;  // Too big for the stack
+   const char* fromFile = NULL;
+   long nssa = 1;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( strcmp( argv[i], "--nssa" ) == 0 && i + 1 < argc ) {
+         nssa = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --amx [--from CAPTURE] [--nssa N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( nssa <= 0 ) {
+      fprintf( stderr, "amx: NSSA must be at least 1\n" );
+      return EXIT_FAILURE;
+   }
+
+   if( fromFile != NULL ) {
+      if( !capture_load( fromFile, &cap ) ) {
+         return EXIT_FAILURE;
+      }
+   } else {
+      cache_probe( &cap, false );
+   }
+
+   printf( "AMX readiness for %s\n", cap.node );
+
+   bool tile = field_or_zero( &cap, FIELD_AMX_TILE );
+   printf( "  CPU:  amx-tile %d  amx-bf16 %d  amx-int8 %d  amx-fp16 %d  amx-complex %d\n"
+          ,tile
+          ,(int) field_or_zero( &cap, FIELD_AMX_BF16 )
+          ,(int) field_or_zero( &cap, FIELD_AMX_INT8 )
+          ,(int) field_or_zero( &cap, FIELD_AMX_FP16 )
+          ,(int) field_or_zero( &cap, FIELD_AMX_COMPLEX ) );
+
+   bool palette = tile && print_palettes( &cap );
+
+   bool     sgx         = field_or_zero( &cap, FIELD_SGX );
+   uint64_t xfrmAllowed = field_or_zero( &cap, FIELD_XFRM_HI ) << 32 | field_or_zero( &cap, FIELD_XFRM_LO );
+   uint64_t xcr0        = cap.has_xcr0 ? cap.xcr0 : 0;
+   bool     xcr0Tile    = (xcr0 & XFRM_TILE) == XFRM_TILE;
+   bool     xfrmTile    = sgx && (xfrmAllowed & XFRM_TILE) == XFRM_TILE;
+   bool     xfd         = field_or_zero( &cap, FIELD_XFD );
+   bool     xfdTile     = field_or_zero( &cap, FIELD_XFD_TILEDATA );
+
+   printf( "  XCR0 enables TILECFG & TILEDATA:  %s\n", xcr0Tile ? "Yes" : "No" );
+   printf( "  SGX XFRM allows TILECFG & TILEDATA:  %s\n", !sgx ? "No (this CPU has no SGX)" : xfrmTile ? "Yes" : "No" );
+   printf( "  XFD:  %s%s\n", xfd ? "Supported" : "Not supported", xfd && xfdTile ? " (and can arm TILEDATA)" : "" );
+
+   bool permitted = false;
+   if( fromFile == NULL ) {
+      permitted = request_permission();
+   } else {
+      printf( "  Permission:  Not requested for a captured host\n" );
+   }
+
+   // The XSAVE area (standard format) with and without the tile state
+   uint64_t userState = xcr0 & ~XFRM_TILE;
+   uint32_t without   = XSAVE_area_size( &cap, userState );
+   uint32_t with      = XSAVE_area_size( &cap, userState | XFRM_TILE );
+   if( without != 0 && with != 0 && tile ) {
+      printf( "  XSAVE area:  %u bytes without AMX, %u bytes with it (+%u bytes)\n", without, with, with - without );
+   }
+
+   // An SSA frame holds the XSAVE area for the enclave's XFRM
+   uint64_t enclaveState = (sgx ? xfrmAllowed & xcr0 : xcr0) & ~XFRM_TILE;
+   uint64_t framesWithout = SSA_frame_pages( &cap, enclaveState );
+   uint64_t framesWith    = SSA_frame_pages( &cap, enclaveState | XFRM_TILE );
+   if( framesWithout != 0 && framesWith != 0 && tile ) {
+      uint64_t extra = (framesWith - framesWithout) * PAGE_SIZE;
+      printf( "  SSA frame:  %" PRIu64 " pages without AMX, %" PRIu64 " pages with it\n", framesWithout, framesWith );
+      printf( "  Extra EPC per enclave thread (NSSA = %ld):  %" PRIu64 " bytes\n", nssa, extra * (uint64_t) nssa );
+   }
+
+   bool ready = tile && palette && xcr0Tile && xfrmTile && (fromFile != NULL || permitted);
+   if( ready ) {
+      printf( "AMX can be used inside an enclave on this host%s\n", fromFile != NULL ? " (once the process has permission)" : "" );
+   } else {
+      printf( "AMX can NOT be used inside an enclave on this host\n" );
+   }
+   return ready ? EXIT_SUCCESS : EXIT_FAILURE;
+}
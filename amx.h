@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  amx.h - 2026
+//
+/// This module reports whether AMX (Advanced Matrix Extensions) can be used
+/// inside an enclave on this host, and what it costs.
+///
+/// @file   amx.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--amx [--from CAPTURE] [--nssa N]`
+int amx_main( int argc, char* argv[] );
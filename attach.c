@@ -0,0 +1,639 @@
+///////////////////////////////////////////////////////////////////////////////
+//  attach.c - 2026
+//
+/// This module attaches to a running enclave host process and counts what
+/// each of its threads does with `perf_event_open()`.
+///
+/// When an enclave application slows down, the usual suspects are:
+///
+///   - EPC paging:  An enclave bigger than the EPC faults (and the kernel
+///     runs EWB/ELDU, tens of microseconds each).  They show up as page
+///     faults of the thread that touched the page.
+///   - Blocking ocalls & sleeping waits:  Context switches
+///   - Threads moving between CPUs (or sockets, each with its own EPC):
+///     CPU migrations
+///   - Throttling or stalls:  Cycles & instructions (GHz & IPC)
+///
+/// Each thread of the process gets one counter group -- task-clock, page
+/// faults, major faults, context switches, CPU migrations and (if there's a
+/// PMU) cycles & instructions -- so one `read()` per thread gets them all at
+/// the same instant.  Threads that start while we're attached are picked up
+/// at the next interval.
+///
+/// At the end, the counts are set against this host:  The EPC charged to
+/// the process' cgroup (`misc.current`) vs. the EPC from CPUID.(EAX=12H), the
+/// packages its threads ran on, and whether CPUID.(EAX=0AH) has a PMU at all.
+/// The size of its enclave mappings is printed too, but that's the address
+/// space the enclaves reserved (ELRANGE), not the EPC they've committed --
+/// SDK enclaves reserve far more than they touch.
+///
+/// Attaching needs ptrace access to the process (the same user, or
+/// CAP_SYS_PTRACE) and `perf_event_paranoid` <= 2.  When kernel counting
+/// isn't allowed, the counters are user-mode only -- and context switches &
+/// CPU migrations, which only ever happen in the kernel, show as `n/a`.
+///
+/// The slots of threads that have exited are reused, so up to MAX_THREADS
+/// threads are followed at once.  Any more are counted as dropped.
+///
+/// Usage:
+///
+///     test-sgx --attach 1234                          # One 1s table
+///     test-sgx --attach 1234 --interval 5000 --count 12
+///
+/// @file   attach.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `syscall()` and `clock_nanosleep()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For atol() strtoul() strtoull()
+#include <string.h>    // For strcmp() strstr() strrchr() memset() strerror()
+#include <inttypes.h>  // For PRIu64 uint64_t
+#include <stdbool.h>   // For bool
+#include <errno.h>     // For errno
+#include <time.h>      // For clock_gettime() clock_nanosleep()
+#include <limits.h>    // For PATH_MAX
+
+#ifdef __linux__
+   #include <unistd.h>               // For syscall() read() close() access()
+   #include <dirent.h>               // For opendir() readdir() closedir()
+   #include <sys/syscall.h>          // For SYS_perf_event_open
+   #include <linux/perf_event.h>     // For struct perf_event_attr
+#endif
+
+#include "attach.h"    // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32() find_EPC_sections() NUMBER_OF_EPCs_TO_ENUMERATE
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_package_of()
+#include "cgroup.h"    // For cgroup_read_epc()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The most threads we'll follow
+#define MAX_THREADS 1024
+
+/// The most packages we'll tell apart
+#define MAX_PACKAGES 16
+
+/// A rough cost of one EPC page fault (AEX, EWB of a victim, ELDU, ERESUME)
+#define EPC_FAULT_US 40.0
+
+/// A cgroup using this much of the EPC (percent) is likely paging
+#define EPC_NEARLY_FULL 90
+
+/// This many context switches per second, per busy thread, is worth a look
+#define MANY_SWITCHES 1000.0
+
+
+/// The counters in each thread's group, in group (and `read()`) order
+enum attach_event {
+   EVENT_TASK_CLOCK,        ///< The group leader:  ns on a CPU
+   EVENT_FAULTS,
+   EVENT_MAJOR_FAULTS,
+   EVENT_CONTEXT_SWITCHES,
+   EVENT_MIGRATIONS,
+   EVENT_CYCLES,            ///< The first hardware event.  Optional.
+   EVENT_INSTRUCTIONS,
+   EVENT_COUNT
+};
+
+
+#ifdef __linux__
+
+/// The type & config of each event
+static const struct {
+   uint32_t type;
+   uint64_t config;
+} eventAttrs[EVENT_COUNT] = {
+   { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK       },
+   { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS      },
+   { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ  },
+   { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+   { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS   },
+   { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES       },
+   { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS     },
+};
+
+
+/// One thread of the process and its counter group
+struct thread {
+   pid_t    tid;
+   int      fds[EVENT_COUNT];    ///< `fds[0]` leads the group.  `-1` when closed.
+   int      events;              ///< How many events are in the group
+   bool     seen;                ///< It was in `/proc/PID/task` at the last scan
+   bool     fresh;               ///< Its group was opened at the last scan, so it has no interval yet
+   char     name[16];            ///< Its `comm`
+   int      cpu;                 ///< Where it last ran
+   uint64_t last[EVENT_COUNT];   ///< The (scaled) counts at the last read
+   uint64_t delta[EVENT_COUNT];  ///< Since the last read
+};
+
+
+/// How the groups are opened.  Settled by the first thread.
+static struct {
+   bool decided;
+   bool hardware;  ///< Count cycles & instructions
+   bool userOnly;  ///< `perf_event_paranoid` doesn't let us count the kernel
+   int  error;     ///< The last `errno` from `perf_event_open()`
+   int  dropped;   ///< Threads not followed at the last scan, because every slot was taken
+} how;
+
+
+/// Close a thread's group
+static void close_group( struct thread* thread ) {
+   for( int e = 0 ; e < EVENT_COUNT ; e++ ) {
+      if( thread->fds[e] >= 0 ) {
+         close( thread->fds[e] );
+      }
+      thread->fds[e] = -1;
+   }
+   thread->events = 0;
+}
+
+
+/// Open a counter group on one thread
+///
+/// @return `false` if not even the software events could be opened
+static bool try_group( struct thread* thread, bool hardware, bool userOnly ) {
+   for( int e = 0 ; e < EVENT_COUNT ; e++ ) {
+      thread->fds[e] = -1;
+   }
+   thread->events = 0;
+
+   for( int e = 0 ; e < EVENT_COUNT && (e < EVENT_CYCLES || hardware) ; e++ ) {
+      struct perf_event_attr attr;
+      memset( &attr, 0, sizeof( attr ) );
+      attr.size = sizeof( attr );
+      attr.type = eventAttrs[e].type;
+      attr.config = eventAttrs[e].config;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.exclude_kernel = userOnly;
+      attr.exclude_hv = userOnly;
+
+      int fd = (int) syscall( SYS_perf_event_open, &attr, thread->tid, -1, e == 0 ? -1 : thread->fds[0], PERF_FLAG_FD_CLOEXEC );
+      if( fd < 0 ) {
+         how.error = errno;
+         if( e < EVENT_CYCLES ) {
+            close_group( thread );
+            return false;
+         }
+         break;  // No PMU (or it's busy):  Keep the software events
+      }
+      thread->fds[e] = fd;
+      thread->events = e + 1;
+   }
+   return true;
+}
+
+
+/// Open a counter group on a new thread, working out what's allowed on the
+/// first one
+static bool open_group( struct thread* thread ) {
+   if( !how.decided ) {
+      bool ok = try_group( thread, how.hardware, false );
+      if( !ok && (how.error == EACCES || how.error == EPERM) ) {
+         ok = try_group( thread, how.hardware, true );
+         how.userOnly = ok;
+      }
+      if( ok ) {
+         how.hardware = how.hardware && thread->events == EVENT_COUNT;
+         how.decided = true;
+      }
+      return ok;
+   }
+   return try_group( thread, how.hardware, how.userOnly );
+}
+
+
+/// Read a thread's group with one `read()`, scaling for multiplexing, into
+/// `thread->delta`
+static bool read_group( struct thread* thread ) {
+   uint64_t values[3 + EVENT_COUNT];  // nr, time enabled, time running, then the events
+
+   memset( thread->delta, 0, sizeof( thread->delta ) );
+   if( thread->fds[0] < 0 || read( thread->fds[0], values, sizeof( values ) ) < (ssize_t) (4 * sizeof( uint64_t )) ) {
+      return false;
+   }
+   uint64_t enabled = values[1];
+   uint64_t running = values[2];
+   for( int e = 0 ; e < (int) values[0] && e < thread->events ; e++ ) {
+      uint64_t count = values[3 + e];
+      if( running > 0 && running < enabled ) {
+         count = (uint64_t) ((double) count * (double) enabled / (double) running);
+      }
+      thread->delta[e] = count > thread->last[e] ? count - thread->last[e] : 0;
+      thread->last[e] = count;
+   }
+   return true;
+}
+
+
+/// Read a thread's name & the CPU it last ran on from `/proc/PID/task/TID/stat`
+static void read_stat( pid_t pid, struct thread* thread ) {
+   char path[64];
+   char line[1024];
+
+   snprintf( path, sizeof( path ), "/proc/%d/task/%d/stat", pid, thread->tid );
+   FILE* file = fopen( path, "r" );
+   if( file == NULL ) {
+      return;
+   }
+   if( fgets( line, sizeof( line ), file ) != NULL ) {
+      char* open = strchr( line, '(' );
+      char* close = strrchr( line, ')' );
+      if( open != NULL && close != NULL && close > open ) {
+         size_t length = (size_t) (close - open - 1) < sizeof( thread->name ) - 1 ? (size_t) (close - open - 1) : sizeof( thread->name ) - 1;
+         memcpy( thread->name, open + 1, length );
+         thread->name[length] = '\0';
+
+         // After the name, the fields start at #3 (state).  #39 is the CPU.
+         char* p = close + 1;
+         for( int field = 3 ; field < 39 && p != NULL ; field++ ) {
+            p = strchr( p + 1, ' ' );
+         }
+         if( p != NULL ) {
+            thread->cpu = (int) strtol( p + 1, NULL, 10 );
+         }
+      }
+   }
+   fclose( file );
+}
+
+
+/// Find the process' threads, open a group on each new one and mark the ones
+/// that are gone
+///
+/// @return `false` if the process is gone
+static bool scan_threads( pid_t pid, struct thread* threads, int* pCount ) {
+   char path[64];
+
+   snprintf( path, sizeof( path ), "/proc/%d/task", pid );
+   DIR* dir = opendir( path );
+   if( dir == NULL ) {
+      return false;
+   }
+   for( int t = 0 ; t < *pCount ; t++ ) {
+      threads[t].seen = false;
+      threads[t].fresh = false;
+   }
+   how.dropped = 0;
+
+   struct dirent* entry;
+   while( (entry = readdir( dir )) != NULL ) {
+      char* end = NULL;
+      pid_t tid = (pid_t) strtol( entry->d_name, &end, 10 );
+      if( tid <= 0 || *end != '\0' ) {
+         continue;
+      }
+      int t = 0;
+      while( t < *pCount && (threads[t].fds[0] < 0 || threads[t].tid != tid) ) {
+         t++;
+      }
+      if( t == *pCount ) {
+         // A new thread:  Reuse the slot of one that exited, or take a new one
+         t = 0;
+         while( t < *pCount && threads[t].fds[0] >= 0 ) {
+            t++;
+         }
+         if( t == MAX_THREADS ) {
+            how.dropped++;
+            continue;
+         }
+         memset( &threads[t], 0, sizeof( threads[t] ) );
+         threads[t].tid = tid;
+         if( !open_group( &threads[t] ) ) {
+            threads[t].fds[0] = -1;  // Leave the slot free
+            continue;
+         }
+         read_group( &threads[t] );  // The baseline
+         threads[t].fresh = true;
+         if( t == *pCount ) {
+            (*pCount)++;
+         }
+      }
+      threads[t].seen = true;
+      read_stat( pid, &threads[t] );
+   }
+   closedir( dir );
+   return true;
+}
+
+
+/// @return The bytes of the process' address space mapped from an SGX
+///         driver (`/dev/sgx_enclave`, or the out-of-tree `/dev/isgx`).
+///         This is the enclaves' ELRANGE, not the EPC they use.
+static uint64_t reserved_bytes( pid_t pid ) {
+   char path[64];
+   char line[512];
+   uint64_t bytes = 0;
+
+   snprintf( path, sizeof( path ), "/proc/%d/maps", pid );
+   FILE* file = fopen( path, "r" );
+   if( file == NULL ) {
+      return 0;
+   }
+   while( fgets( line, sizeof( line ), file ) != NULL ) {
+      line[strcspn( line, "\n" )] = '\0';
+      const char* device = strchr( line, '/' );
+      if(    device == NULL
+          || (    strcmp( device, "/dev/sgx_enclave" ) != 0
+               && strcmp( device, "/dev/sgx/enclave" ) != 0
+               && strcmp( device, "/dev/isgx" ) != 0 ) ) {
+         continue;  // Not an enclave (`/dev/sgx_vepc` is a VM's EPC)
+      }
+      char* end = NULL;
+      uint64_t start = strtoull( line, &end, 16 );
+      uint64_t stop = *end == '-' ? strtoull( end + 1, NULL, 16 ) : start;
+      bytes += stop > start ? stop - start : 0;
+   }
+   fclose( file );
+   return bytes;
+}
+
+
+/// Read the EPC charged to the process' (cgroup v2) cgroup
+///
+/// @return `false` if the misc controller doesn't account EPC there
+static bool cgroup_epc_bytes( pid_t pid, uint64_t* pUsed, uint64_t* pLimitHits ) {
+   char path[64];
+   char line[1024];
+   char dir[PATH_MAX] = "";
+
+   snprintf( path, sizeof( path ), "/proc/%d/cgroup", pid );
+   FILE* file = fopen( path, "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   while( fgets( line, sizeof( line ), file ) != NULL ) {
+      line[strcspn( line, "\n" )] = '\0';
+      if( strncmp( line, "0::", 3 ) == 0 ) {
+         snprintf( dir, sizeof( dir ), "/sys/fs/cgroup%s", strcmp( line + 3, "/" ) == 0 ? "" : line + 3 );
+         break;
+      }
+   }
+   fclose( file );
+
+   *pLimitHits = 0;
+   if( dir[0] == '\0' || !cgroup_read_epc( dir, "misc.current", pUsed ) ) {
+      return false;  // No cgroup v2, or the root cgroup (which has no misc.current)
+   }
+   cgroup_read_epc( dir, "misc.events", pLimitHits );
+   return true;
+}
+
+
+/// Format a size like `48 KiB`, `1.5 MiB` or `64 GiB`
+static const char* format_size( uint64_t bytes, char* out, size_t size ) {
+   const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+   double value = (double) bytes;
+   int u = 0;
+
+   while( value >= 1024 && u < 4 ) {
+      value /= 1024;
+      u++;
+   }
+   snprintf( out, size, value == (double) (uint64_t) value ? "%.0f %s" : "%.1f %s", value, units[u] );
+   return out;
+}
+
+
+/// Return the time in seconds from `start` to `now`
+static double seconds_between( const struct timespec* start, const struct timespec* now ) {
+   return (double) (now->tv_sec - start->tv_sec) + (double) (now->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/// Print one thread's row (or the total) for an interval of `elapsed` seconds
+///
+/// Context switches & migrations happen in the kernel, so they read `n/a`
+/// when only user mode is counted.
+static void print_row( const char* tid, const char* name, const char* cpu, const uint64_t* delta, double elapsed, bool hardware, bool userOnly ) {
+   double taskSeconds = (double) delta[EVENT_TASK_CLOCK] / 1e9;
+
+   printf( "  %7s  %-15s  %4s  %5.1f  %8.0f  %7.0f", tid, name, cpu
+          ,taskSeconds / elapsed * 100
+          ,(double) delta[EVENT_FAULTS] / elapsed
+          ,(double) delta[EVENT_MAJOR_FAULTS] / elapsed );
+   if( userOnly ) {
+      printf( "  %7s  %6s", "n/a", "n/a" );
+   } else {
+      printf( "  %7.0f  %6.1f"
+             ,(double) delta[EVENT_CONTEXT_SWITCHES] / elapsed
+             ,(double) delta[EVENT_MIGRATIONS] / elapsed );
+   }
+   if( hardware && delta[EVENT_CYCLES] > 0 && taskSeconds > 0 ) {
+      printf( "  %5.2f  %5.2f\n", (double) delta[EVENT_CYCLES] / taskSeconds / 1e9, (double) delta[EVENT_INSTRUCTIONS] / (double) delta[EVENT_CYCLES] );
+   } else {
+      printf( "  %5s  %5s\n", "-", "-" );
+   }
+}
+
+#endif  // __linux__
+
+
+/// `--attach PID [--interval MS] [--count N]`
+int attach_main( int argc, char* argv[] ) {
+   long pid = 0;
+   long intervalMS = 1000;
+   long samples = 1;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         intervalMS = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--count" ) == 0 && i + 1 < argc ) {
+         samples = atol( argv[++i] );
+      } else if( pid == 0 && argv[i][0] != '-' ) {
+         pid = atol( argv[i] );
+      } else {
+         pid = -1;
+         break;
+      }
+   }
+   if( pid <= 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --attach PID [--interval MS] [--count N]\n" );
+      return EXIT_FAILURE;
+   }
+   if( intervalMS <= 0 || samples <= 0 ) {
+      fprintf( stderr, "attach: The interval and count must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct thread threads[MAX_THREADS];
+      int threadCount = 0;  // The slots in use, including those of exited threads
+
+      // Is there a PMU with cycles & instructions?
+      uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+      uint64_t pmuVersion = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      if( eax >= 0x0A ) {
+         eax = 0x0A; ebx = 0; ecx = 0; edx = 0;
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+         pmuVersion = field_from_regs( &fields[FIELD_PERFMON_VERSION], eax, ebx, ecx, edx );
+         how.hardware = pmuVersion > 0
+                     && !field_from_regs( &fields[FIELD_PERFMON_NO_CYCLES], eax, ebx, ecx, edx )
+                     && !field_from_regs( &fields[FIELD_PERFMON_NO_INSTRS], eax, ebx, ecx, edx );
+      }
+      bool pmuEnumerated = how.hardware;
+
+      if( !scan_threads( (pid_t) pid, threads, &threadCount ) ) {
+         fprintf( stderr, "attach: There's no process %ld\n", pid );
+         return EXIT_FAILURE;
+      }
+      if( threadCount == 0 ) {
+         fprintf( stderr, "attach: Unable to count process %ld's threads: %s\n", pid, strerror( how.error ) );
+         fprintf( stderr, "attach: That needs ptrace access to it and perf_event_paranoid <= 2 (or CAP_PERFMON)\n" );
+         return EXIT_FAILURE;
+      }
+
+      uint64_t totals[EVENT_COUNT];
+      static int packages[MAX_PACKAGES];
+      int packageCount = 0;
+      memset( totals, 0, sizeof( totals ) );
+
+      printf( "Attached to process %ld (%d threads)%s\n", pid, threadCount, how.userOnly ? ", counting user mode only (perf_event_paranoid)" : "" );
+
+      struct timespec start, next, last, now;
+      clock_gettime( CLOCK_MONOTONIC, &start );
+      next = start;
+      last = start;
+      bool alive = true;
+
+      for( long s = 1 ; s <= samples && alive ; s++ ) {
+         next.tv_sec  += intervalMS / 1000;
+         next.tv_nsec += (intervalMS % 1000) * 1000000;
+         if( next.tv_nsec >= 1000000000 ) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+         }
+         clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+
+         clock_gettime( CLOCK_MONOTONIC, &now );
+         double elapsed = seconds_between( &last, &now );
+         last = now;
+
+         uint64_t sum[EVENT_COUNT];
+         memset( sum, 0, sizeof( sum ) );
+         int counted = 0;
+         for( int t = 0 ; t < threadCount ; t++ ) {
+            if( read_group( &threads[t] ) ) {
+               counted++;
+            }
+         }
+         alive = scan_threads( (pid_t) pid, threads, &threadCount );
+
+         printf( "\nInterval %ld:  %.3f s, %d threads%s\n", s, elapsed, counted, alive ? "" : " (the process has exited)" );
+         if( how.dropped > 0 ) {
+            printf( "  %d more threads aren't followed:  All %d slots are in use\n", how.dropped, MAX_THREADS );
+         }
+         printf( "      TID  Thread            CPU  Busy%%  Faults/s  Major/s  CtxSw/s  Migr/s    GHz    IPC\n" );
+         printf( "  =======  ===============  ====  =====  ========  =======  =======  ======  =====  =====\n" );
+         for( int t = 0 ; t < threadCount ; t++ ) {
+            struct thread* thread = &threads[t];
+            if( thread->fds[0] < 0 || thread->fresh ) {
+               continue;  // Closed, or it started this interval
+            }
+            char tid[16];
+            char cpu[16];
+            snprintf( tid, sizeof( tid ), "%d", thread->tid );
+            snprintf( cpu, sizeof( cpu ), "%d", thread->cpu );
+            print_row( tid, thread->name, thread->seen ? cpu : "exit", thread->delta, elapsed, how.hardware, how.userOnly );
+
+            for( int e = 0 ; e < EVENT_COUNT ; e++ ) {
+               sum[e] += thread->delta[e];
+            }
+            int package = topology_package_of( thread->cpu );
+            bool known = false;
+            for( int p = 0 ; p < packageCount ; p++ ) {
+               known = known || packages[p] == package;
+            }
+            if( !known && packageCount < MAX_PACKAGES && thread->delta[EVENT_TASK_CLOCK] > 0 ) {
+               packages[packageCount++] = package;
+            }
+            if( !thread->seen ) {
+               close_group( thread );  // Printed its last interval
+            }
+         }
+         print_row( "", "Total", "", sum, elapsed, how.hardware, how.userOnly );
+         for( int e = 0 ; e < EVENT_COUNT ; e++ ) {
+            totals[e] += sum[e];
+         }
+      }
+
+      // What it means on this host
+      struct epc_section sections[NUMBER_OF_EPCs_TO_ENUMERATE];
+      int sectionCount = find_EPC_sections( sections, NUMBER_OF_EPCs_TO_ENUMERATE );
+      uint64_t epc = 0;
+      for( int i = 0 ; i < sectionCount ; i++ ) {
+         epc += sections[i].size;
+      }
+      uint64_t reserved = reserved_bytes( (pid_t) pid );
+      uint64_t used = 0;
+      uint64_t limitHits = 0;
+      bool     accounted = cgroup_epc_bytes( (pid_t) pid, &used, &limitHits );
+      double total = seconds_between( &start, &last );
+      double faults = total > 0 ? (double) totals[EVENT_FAULTS] / total : 0;
+      double busyThreads = total > 0 ? (double) totals[EVENT_TASK_CLOCK] / 1e9 / total : 0;
+      char text1[32];
+      char text2[32];
+
+      printf( "\nOn this host\n" );
+      if( sectionCount == 0 ) {
+         printf( "  SGX isn't available (CPUID has no EPC sections), so none of these faults are EPC paging\n" );
+      } else if( reserved == 0 ) {
+         printf( "  Process %ld has no SGX driver mappings (yet), so none of its faults are EPC paging\n", pid );
+      } else {
+         printf( "  EPC:  %s in %d section(s).  Enclave address space reserved (not EPC):  %s\n", format_size( epc, text1, sizeof( text1 ) ), sectionCount, format_size( reserved, text2, sizeof( text2 ) ) );
+         if( !accounted ) {
+            printf( "  The misc controller doesn't account EPC to its cgroup, so the EPC its enclaves\n" );
+            printf( "  use is unknown and EPC faults can't be told from others.  `--epc-monitor` shows\n" );
+            printf( "  whether ksgxd is reclaiming.\n" );
+         } else {
+            printf( "  EPC charged to its cgroup:  %s (%.0f%%)", format_size( used, text1, sizeof( text1 ) ), epc > 0 ? 100.0 * (double) used / (double) epc : 0 );
+            if( limitHits > 0 ) {
+               printf( ", which hit its limit %" PRIu64 " times", limitHits );
+            }
+            printf( "\n" );
+            if( limitHits > 0 || used * 100 >= epc * EPC_NEARLY_FULL ) {
+               printf( "  The EPC is (nearly) full, so it's likely paging:  Many of the page faults may be\n" );
+               printf( "  EPC faults.  At ~%.0f us each, %.0f faults/s would cost %.1f CPUs.\n", EPC_FAULT_US, faults, faults * EPC_FAULT_US / 1e6 );
+            } else {
+               printf( "  Its enclaves fit in the EPC.  Unless other enclaves on this host crowd them out,\n" );
+               printf( "  the page faults are on the untrusted side (or EAUGs with SGX2).\n" );
+            }
+         }
+      }
+      if( totals[EVENT_MIGRATIONS] > 0 ) {
+         printf( "  %.1f CPU migrations/s:  Pin the enclave threads (`--c2c` can pick CPUs that pair well)\n", total > 0 ? (double) totals[EVENT_MIGRATIONS] / total : 0 );
+      }
+      if( packageCount > 1 ) {
+         printf( "  The threads ran on %d packages.  Each package has its own EPC section, so keep an\n", packageCount );
+         printf( "  enclave's threads on the package whose memory holds its pages.\n" );
+      }
+      if( busyThreads > 0 && (double) totals[EVENT_CONTEXT_SWITCHES] / total / busyThreads > MANY_SWITCHES ) {
+         printf( "  %.0f context switches/s per busy thread:  Blocking ocalls or sleeping waits.\n", (double) totals[EVENT_CONTEXT_SWITCHES] / total / busyThreads );
+         printf( "  Switchless calls avoid them (see `--spsc`).\n" );
+      }
+      if( how.userOnly ) {
+         printf( "  Context switches & CPU migrations happen in the kernel, so they can't be counted\n" );
+         printf( "  in user mode only.  Lower perf_event_paranoid to 1 (or grant CAP_PERFMON) to see them.\n" );
+      }
+      if( !how.hardware ) {
+         printf( "  No cycles or instructions:  %s\n", pmuEnumerated ? "The PMU couldn't be opened (it may be in use, or not allowed)"
+                                                                   : "CPUID.(EAX=0AH) reports no architectural PMU (a VM without a virtual PMU?)" );
+      }
+
+      for( int t = 0 ; t < threadCount ; t++ ) {
+         close_group( &threads[t] );
+      }
+      return EXIT_SUCCESS;
+
+   #else
+      printf( "Attaching to a process needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  attach.h - 2026
+//
+/// This module attaches to a running enclave host process and counts what
+/// each of its threads does with `perf_event_open()`.
+///
+/// @file   attach.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--attach PID [--interval MS] [--count N]`
+int attach_main( int argc, char* argv[] );
@@ -0,0 +1,412 @@
+///////////////////////////////////////////////////////////////////////////////
+//  avx512.c - 2026
+//
+/// This module scans `/proc` for processes that have used AVX-512 state, to
+/// find enclaves that could drop AVX-512 from their XFRM.
+///
+/// On CPUs with AVX-512, Linux reports `AVX512_elapsed_ms` in
+/// `/proc/PID/task/TID/arch_status`:  the milliseconds since the kernel last
+/// saw the thread's AVX-512 state in use when it switched the thread out, or
+/// `-1` if it never has.  (`/proc/PID/arch_status` is only the main thread.)
+///
+/// An enclave's XFRM sets which state components live in each SSA frame and
+/// are saved on every AEX.  AVX-512 (opmask, ZMM_Hi256 & Hi16_ZMM) is 1.6 KiB
+/// of that, so an enclave that doesn't need it has a smaller SSA frame and a
+/// cheaper AEX when XFRM leaves it out.
+///
+/// The scan has to cover thousands of processes, so it holds `/proc` open and
+/// reaches everything with `openat()` relative to directory fds, reads into
+/// one reused buffer and only walks the threads of the processes it reports.
+/// A process is an enclave host if it maps an SGX driver (`/dev/sgx_enclave`
+/// or the out-of-tree `/dev/isgx`).
+///
+/// The kernel only sees the untrusted side of an enclave host:  An AEX
+/// replaces the enclave's registers with synthetic state before the kernel
+/// runs, so AVX-512 used inside an enclave never shows up here.  A host that
+/// never used AVX-512 is a candidate -- check how the enclave was built before
+/// dropping AVX-512 from its XFRM.
+///
+/// Usage:
+///
+///     test-sgx --avx512-usage                  # Enclave hosts
+///     test-sgx --avx512-usage --all            # Every process that used AVX-512
+///     test-sgx --avx512-usage --recent 60000   # "Recently" is the last minute
+///
+/// @see https://docs.kernel.org/filesystems/proc.html (/proc/<pid>/arch_status)
+///
+/// @file   avx512.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `openat()` `fdopendir()` and `memmem()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fprintf()
+#include <stdlib.h>    // For atol() strtol()
+#include <string.h>    // For strcmp() strstr() memmem() memmove()
+#include <inttypes.h>  // For PRIx64 PRIu64 uint64_t
+#include <stdbool.h>   // For bool
+#include <ctype.h>     // For isdigit()
+#include <time.h>      // For clock_gettime()
+#include <limits.h>    // For NAME_MAX
+
+#ifdef __linux__
+   #include <dirent.h>    // For opendir() fdopendir() readdir() dirfd()
+   #include <fcntl.h>     // For openat() O_RDONLY O_DIRECTORY O_CLOEXEC
+   #include <unistd.h>    // For read() close()
+#endif
+
+#include "avx512.h"    // For obvious reasons
+#include "cache.h"     // For cache_probe()
+#include "capture.h"   // For struct sgx_capture
+#include "decode.h"    // For fields[] field_from_capture() XSTATE_OPMASK
+#include "xsave.h"     // For XSAVE_area_size()
+#include "planner.h"   // For SSA_frame_pages()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The XSAVE state components AVX-512 uses
+#define XFRM_AVX512 ( ((uint64_t) 1 << XSTATE_OPMASK) | ((uint64_t) 1 << XSTATE_ZMM_HI256) | ((uint64_t) 1 << XSTATE_HI16_ZMM) )
+
+/// No thread has used AVX-512
+#define NEVER -1
+
+/// The size of the reused read buffer.  A chunk of `maps` at a time.
+#define BUFFER_SIZE 65536
+
+
+/// What one process did
+struct process_usage {
+   long threads;       ///< Threads whose arch_status we read
+   long recent;        ///< Threads that used AVX-512 within `--recent MS`
+   long lastUsed;      ///< The fewest ms since any thread used it, or `NEVER`
+   bool tracked;       ///< The kernel reported `AVX512_elapsed_ms`
+};
+
+
+/// Totals over the scan
+struct scan_totals {
+   long processes;
+   long hosts;         ///< Enclave hosts
+   long hostsRecent;   ///< ... that used AVX-512 within `--recent MS`
+   long hostsEarlier;  ///< ... that used it, but not recently
+   long hostsNever;    ///< ... that never did
+   long others;        ///< Other processes that used AVX-512 recently
+   bool tracked;       ///< Any arch_status had `AVX512_elapsed_ms`
+};
+
+
+#ifdef __linux__
+
+/// The one buffer every read goes through
+static char buffer[BUFFER_SIZE + 1];
+
+
+/// Read (the start of) the file `name` relative to `dirFd` into `buffer`
+///
+/// @return The bytes read, or `-1` if it couldn't be read
+static ssize_t read_at( int dirFd, const char* name ) {
+   int fd = openat( dirFd, name, O_RDONLY | O_CLOEXEC );
+   if( fd < 0 ) {
+      return -1;
+   }
+   ssize_t size = read( fd, buffer, BUFFER_SIZE );
+   close( fd );
+   if( size >= 0 ) {
+      buffer[size] = '\0';
+   }
+   return size;
+}
+
+
+/// @return `true` if the process in `pidFd` maps an SGX enclave driver.
+///         `maps` is read a chunk at a time, keeping the end of the last
+///         chunk in case a name straddles two chunks.  Each name is matched
+///         as a whole path at the end of a line, so a VM's `/dev/sgx_vepc`
+///         isn't an enclave.
+static bool maps_enclave( int pidFd ) {
+   static const char* drivers[] = { " /dev/sgx_enclave\n", " /dev/sgx/enclave\n", " /dev/isgx\n" };
+   const size_t keep = 24;  // Longer than any driver's name
+   size_t held = 0;
+   bool found = false;
+
+   int fd = openat( pidFd, "maps", O_RDONLY | O_CLOEXEC );
+   if( fd < 0 ) {
+      return false;
+   }
+   for( ;; ) {
+      ssize_t size = read( fd, buffer + held, BUFFER_SIZE - held );
+      if( size <= 0 ) {
+         break;
+      }
+      size_t length = held + (size_t) size;
+      for( size_t d = 0 ; d < sizeof( drivers ) / sizeof( drivers[0] ) && !found ; d++ ) {
+         found = memmem( buffer, length, drivers[d], strlen( drivers[d] ) ) != NULL;
+      }
+      if( found ) {
+         break;
+      }
+      held = length < keep ? length : keep;
+      memmove( buffer, buffer + length - held, held );
+   }
+   close( fd );
+   return found;
+}
+
+
+/// Read `AVX512_elapsed_ms` from the `arch_status` in `dirFd`
+///
+/// @return `false` if the kernel didn't report it
+static bool read_elapsed( int dirFd, const char* name, long* elapsed ) {
+   if( read_at( dirFd, name ) <= 0 ) {
+      return false;
+   }
+   const char* line = strstr( buffer, "AVX512_elapsed_ms:" );
+   if( line == NULL ) {
+      return false;
+   }
+   *elapsed = strtol( line + strlen( "AVX512_elapsed_ms:" ), NULL, 10 );
+   return true;
+}
+
+
+/// Read `arch_status` for every thread of the process in `pidFd`
+static void read_threads( int pidFd, long recentMs, struct process_usage* usage ) {
+   char name[NAME_MAX + 16];
+
+   usage->threads  = 0;
+   usage->recent   = 0;
+   usage->lastUsed = NEVER;
+   usage->tracked  = false;
+
+   int taskFd = openat( pidFd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+   DIR* tasks = taskFd < 0 ? NULL : fdopendir( taskFd );
+   if( tasks == NULL ) {
+      if( taskFd >= 0 ) {
+         close( taskFd );
+      }
+      return;
+   }
+
+   struct dirent* entry;
+   while( (entry = readdir( tasks )) != NULL ) {
+      if( !isdigit( (unsigned char) entry->d_name[0] ) ) {
+         continue;
+      }
+      long elapsed = NEVER;
+      snprintf( name, sizeof( name ), "%s/arch_status", entry->d_name );
+      if( !read_elapsed( taskFd, name, &elapsed ) ) {
+         continue;  // The thread exited, or the kernel doesn't track AVX-512
+      }
+      usage->tracked = true;
+      usage->threads++;
+      if( elapsed != NEVER ) {
+         if( elapsed <= recentMs ) {
+            usage->recent++;
+         }
+         if( usage->lastUsed == NEVER || elapsed < usage->lastUsed ) {
+            usage->lastUsed = elapsed;
+         }
+      }
+   }
+   closedir( tasks );  // Closes taskFd too
+}
+
+
+/// Scan every process in `procDir`, printing the enclave hosts (or, with
+/// `all`, every process that used AVX-512)
+///
+/// @return `false` if `procDir` couldn't be opened
+static bool scan( const char* procDir, long recentMs, bool all, struct scan_totals* totals ) {
+   DIR* proc = opendir( procDir );
+   if( proc == NULL ) {
+      return false;
+   }
+   int procFd = dirfd( proc );
+
+   struct dirent* entry;
+   while( (entry = readdir( proc )) != NULL ) {
+      if( !isdigit( (unsigned char) entry->d_name[0] ) ) {
+         continue;
+      }
+      int pidFd = openat( procFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+      if( pidFd < 0 ) {
+         continue;  // It exited
+      }
+      totals->processes++;
+
+      // The main thread's arch_status is the cheap test for --all
+      long mainElapsed = NEVER;
+      bool host = maps_enclave( pidFd );
+      bool mainTracked = read_elapsed( pidFd, "arch_status", &mainElapsed );
+      totals->tracked = totals->tracked || mainTracked;
+
+      if( host || (all && mainTracked) ) {
+         struct process_usage usage;
+         read_threads( pidFd, recentMs, &usage );
+
+         if( host ) {
+            totals->hosts++;
+            if( usage.recent > 0 ) {
+               totals->hostsRecent++;
+            } else if( usage.lastUsed != NEVER ) {
+               totals->hostsEarlier++;
+            } else {
+               totals->hostsNever++;
+            }
+         } else if( usage.recent > 0 ) {
+            totals->others++;
+         }
+
+         if( host || usage.lastUsed != NEVER ) {
+            char comm[32] = "?";
+            if( read_at( pidFd, "comm" ) > 0 ) {
+               sscanf( buffer, "%31[^\n]", comm );
+            }
+            char last[32];
+            if( !usage.tracked ) {
+               snprintf( last, sizeof( last ), "unknown" );
+            } else if( usage.lastUsed == NEVER ) {
+               snprintf( last, sizeof( last ), "never" );
+            } else {
+               snprintf( last, sizeof( last ), "%.1f s ago", (double) usage.lastUsed / 1000 );
+            }
+            printf( "    %7s  %-15s  %-7s  %7ld  %14ld  %s\n"
+                   ,entry->d_name, comm, host ? "yes" : "no", usage.threads, usage.recent, last );
+         }
+      }
+      close( pidFd );
+   }
+   closedir( proc );
+   return true;
+}
+
+
+/// @return CLOCK_MONOTONIC in seconds
+static double now_seconds( void ) {
+   struct timespec now;
+
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// @return The value of field `id` in `cap`, or `0` if it wasn't captured
+static uint64_t field_or_zero( const struct sgx_capture* cap, enum field_id id ) {
+   uint64_t value = 0;
+   field_from_capture( &fields[id], cap, &value );
+   return value;
+}
+
+
+/// Print what dropping AVX-512 from XFRM saves on this host
+///
+/// @return `true` if an enclave here can have AVX-512 in its XFRM at all
+static bool print_xfrm( const struct sgx_capture* cap ) {
+   bool     sgx         = field_or_zero( cap, FIELD_SGX );
+   uint64_t xfrmAllowed = field_or_zero( cap, FIELD_XFRM_HI ) << 32 | field_or_zero( cap, FIELD_XFRM_LO );
+   uint64_t xcr0        = cap->has_xcr0 ? cap->xcr0 : 0;
+   uint64_t usable      = sgx ? xfrmAllowed & xcr0 : xcr0;
+   bool     avx512      = (usable & XFRM_AVX512) == XFRM_AVX512;
+
+   printf( "  XCR0 enabled by the OS:            %016" PRIx64 "\n", xcr0 );
+   if( sgx ) {
+      printf( "  XFRM allowed by SGX:               %016" PRIx64 "\n", xfrmAllowed );
+   } else {
+      printf( "  This CPU does not support SGX.  Using XCR0 alone.\n" );
+   }
+   printf( "  AVX-512 in an enclave's XFRM:      %s\n", avx512 ? "Possible" : "Not possible (so there's nothing to drop)" );
+   if( !avx512 ) {
+      return false;
+   }
+
+   // An enclave that wants AVX-512 usually has x87, SSE & AVX as well
+   uint64_t without = usable & ( ((uint64_t) 1 << XSTATE_X87) | ((uint64_t) 1 << XSTATE_SSE) | ((uint64_t) 1 << XSTATE_AVX) );
+   uint64_t with    = without | XFRM_AVX512;
+   uint32_t bytesWithout = XSAVE_area_size( cap, without );
+   uint32_t bytesWith    = XSAVE_area_size( cap, with );
+   uint64_t pagesWithout = SSA_frame_pages( cap, without );
+   uint64_t pagesWith    = SSA_frame_pages( cap, with );
+
+   if( bytesWithout != 0 && bytesWith != 0 ) {
+      printf( "  XSAVE area (saved on every AEX):   %u bytes with AVX-512, %u bytes without (%u fewer)\n"
+             ,bytesWith, bytesWithout, bytesWith - bytesWithout );
+   }
+   if( pagesWithout != 0 && pagesWith != 0 ) {
+      printf( "  SSA frame:                         %" PRIu64 " pages with AVX-512, %" PRIu64 " without\n", pagesWith, pagesWithout );
+   }
+   return true;
+}
+
+#endif  // __linux__
+
+
+/// `--avx512-usage [--proc DIR] [--recent MS] [--all]`
+int avx512_main( int argc, char* argv[] ) {
+   const char* procDir = "/proc";
+   long recentMs = 10000;
+   bool all = false;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--proc" ) == 0 && i + 1 < argc ) {
+         procDir = argv[++i];
+      } else if( strcmp( argv[i], "--recent" ) == 0 && i + 1 < argc ) {
+         recentMs = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--all" ) == 0 ) {
+         all = true;
+      } else {
+         recentMs = -1;
+         break;
+      }
+   }
+   if( recentMs < 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --avx512-usage [--proc DIR] [--recent MS] [--all]\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct sgx_capture cap;  // Too big for the stack
+      cache_probe( &cap, false );
+
+      printf( "AVX-512 usage by %s (%s/PID/task/TID/arch_status):\n", all ? "every process" : "enclave hosts", procDir );
+      bool avx512 = print_xfrm( &cap );
+
+      struct scan_totals totals = { 0 };
+      printf( "        PID  Command          Enclave  Threads  Recent threads  AVX-512 last used\n" );
+      printf( "    =======  ===============  =======  =======  ==============  =================\n" );
+      double start = now_seconds();
+      if( !scan( procDir, recentMs, all, &totals ) ) {
+         fprintf( stderr, PROGRAM_NAME ": Can't open %s\n", procDir );
+         return EXIT_FAILURE;
+      }
+      double seconds = now_seconds() - start;
+
+      printf( "  Scanned %ld processes in %.1f ms\n", totals.processes, seconds * 1000 );
+      if( !totals.tracked ) {
+         printf( "  The kernel doesn't report AVX512_elapsed_ms here (it needs an x86 CPU with AVX-512)\n" );
+         return EXIT_FAILURE;
+      }
+      if( all ) {
+         printf( "  %ld other processes used AVX-512 in the last %.1f s\n", totals.others, (double) recentMs / 1000 );
+      }
+      if( totals.hosts == 0 ) {
+         printf( "  No process maps an SGX driver\n" );
+         return EXIT_SUCCESS;
+      }
+      printf( "  %ld enclave hosts:  %ld used AVX-512 in the last %.1f s, %ld before that and %ld never\n"
+             ,totals.hosts, totals.hostsRecent, (double) recentMs / 1000, totals.hostsEarlier, totals.hostsNever );
+      if( avx512 && totals.hostsNever > 0 ) {
+         printf( "  The %ld hosts that never used AVX-512 are candidates to drop it from their enclaves' XFRM.\n", totals.hostsNever );
+         printf( "  The kernel can't see the registers inside an enclave, so check how the enclave was built first.\n" );
+      }
+   #else
+      (void) procDir;
+      (void) all;
+      printf( "The AVX-512 usage scan needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  avx512.h - 2026
+//
+/// This module scans `/proc` for processes that have used AVX-512 state, to
+/// find enclaves that could drop AVX-512 from their XFRM.
+///
+/// @file   avx512.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--avx512-usage [--proc DIR] [--recent MS] [--all]`
+int avx512_main( int argc, char* argv[] );
@@ -0,0 +1,734 @@
+///////////////////////////////////////////////////////////////////////////////
+//  c2c.c - 2026
+//
+/// This module measures core-to-core cache-line latency between pairs of
+/// CPUs, to pick where an enclave thread and its switchless worker should
+/// run.
+///
+/// A switchless call is a request & a reply passed through shared cache lines
+/// between a trusted thread (in the enclave) and an untrusted worker, both
+/// spinning.  So its latency is mostly how long a cache line takes to move
+/// from one core to another and back -- and that depends on whether the
+/// cores are SMT siblings, share an L3, or are in the same package.
+///
+/// For each pair of CPUs, one thread is pinned to each and they ping-pong a
+/// counter in one cache line.  The result is the best batch of round trips
+/// (one-way latency is about half of it).  Each CPU is annotated with where
+/// it sits:  the package, core & L3 from sysfs (falling back to the x2APIC ID
+/// fields in CPUID leaf 0BH), and the NUMA node.
+///
+/// A host with n CPUs has n(n-1)/2 pairs -- over 20,000 on a 2-socket,
+/// 200-CPU host.  So:
+///
+///   - Each pair stops early, once a few batches in a row don't improve on
+///     the best one.
+///   - When there are more than `--pairs` pairs (1000 by default), a sample
+///     is measured:  an equal share from each topology class (SMT siblings,
+///     shared L3, same package, other package), so every class gets a
+///     latency even on the biggest hosts.
+///
+/// Usage:
+///
+///     test-sgx --c2c                       # Every CPU this process may use
+///     test-sgx --c2c --cpus 0-7,56-63      # Just these CPUs
+///     test-sgx --c2c --pairs 5000          # A bigger sample
+///
+/// @file   c2c.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sched_setaffinity()` and `CPU_SET()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fscanf() snprintf()
+#include <stdlib.h>    // For atol() malloc() calloc() free() qsort()
+#include <string.h>    // For strcmp()
+#include <inttypes.h>  // For PRIu32 uint64_t uint32_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime()
+
+#ifdef __linux__
+   #include <sched.h>          // For sched_setaffinity() sched_getaffinity() CPU_SET()
+   #include <pthread.h>        // For pthread_create() pthread_join()
+#endif
+
+#include "c2c.h"       // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_online_cpus() topology_parse_cpulist() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The most pairs to measure, unless `--pairs` says otherwise
+#define DEFAULT_PAIRS 1000
+
+/// Round trips to run before timing a pair
+#define WARMUP_ROUNDS 1000
+
+/// Round trips in each timed batch
+#define BATCH_ROUNDS 500
+
+/// Every pair gets at least this many batches...
+#define MIN_BATCHES 5
+
+/// ...and at most this many
+#define MAX_BATCHES 50
+
+/// Stop a pair once this many batches in a row are no more than 1% better
+/// than its best
+#define STALE_BATCHES 3
+
+/// Give up on a pair that takes longer than this (seconds) -- the other CPU
+/// is probably busy with something else
+#define PAIR_TIMEOUT 1.0
+
+/// The most NUMA nodes we look for
+#define MAX_NODES 64
+
+/// Print a full matrix for up to this many CPUs
+#define MATRIX_CPUS 32
+
+/// The most pairings to recommend
+#define MAX_RECOMMENDED 8
+
+/// Tells the responder thread to exit
+#define STOP UINT64_MAX
+
+
+/// How two CPUs are related, from closest to farthest
+enum relation {
+   REL_SMT,      ///< Two threads of one core
+   REL_L3,       ///< Different cores that share an L3
+   REL_PACKAGE,  ///< Same package, different L3s
+   REL_REMOTE,   ///< Different packages
+   REL_COUNT
+};
+
+/// Names for `enum relation`
+static const char* relationNames[REL_COUNT] = { "SMT siblings", "Shared L3", "Same package", "Other package" };
+
+/// Where a CPU sits in the topology
+struct cpu_info {
+   int      cpu;
+   uint32_t apic;     ///< x2APIC ID (or the initial APIC ID)
+   int      core;     ///< Only unique within a die
+   int      die;      ///< Within the package.  `0` if sysfs doesn't say.
+   int      l3;
+   int      package;
+   int      node;     ///< NUMA node, or `-1`
+};
+
+/// A pair of CPUs (as indexes into the `cpu_info` array)
+struct pair {
+   int           a;
+   int           b;
+   enum relation relation;
+   bool          chosen;
+   double        ns;     ///< The best round trip, or `0` if it wasn't measured
+};
+
+/// The cache line the two threads ping-pong, and the responder's state on
+/// lines of its own.  128-byte alignment keeps the adjacent-line prefetcher
+/// from pulling the state along with `seq`.
+struct pingpong {
+   _Alignas( 128 ) uint64_t seq;  ///< Odd:  Waiting for the responder.  Even:  Waiting for the initiator.
+   _Alignas( 128 ) int cpu;       ///< Where the responder runs
+   int state;                     ///< 0:  Starting, 1:  Running, 2:  Exited, -1:  Couldn't pin
+};
+
+
+#ifdef __linux__
+
+/// @return The time in seconds from a monotonic clock
+static double now_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Pin the calling thread to `cpu`
+///
+/// @return `false` if it couldn't be pinned
+static bool pin_to( int cpu ) {
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   return sched_setaffinity( 0, sizeof( set ), &set ) == 0;
+}
+
+
+/// Read one number from a sysfs file (`format` has a `%d` for the CPU)
+///
+/// @return The number, or `-1` if it isn't there
+static int read_cpu_value( const char* format, int cpu ) {
+   char path[128];
+   int  value = -1;
+
+   snprintf( path, sizeof( path ), format, cpu );
+   FILE* file = fopen( path, "r" );
+   if( file != NULL ) {
+      if( fscanf( file, "%d", &value ) != 1 ) {
+         value = -1;
+      }
+      fclose( file );
+   }
+   return value;
+}
+
+
+/// Find the NUMA node of every CPU (`nodeOf` is indexed by CPU number)
+static void read_nodes( int* nodeOf ) {
+   static int cpus[MAX_CPUS];
+   char path[128];
+   char line[4096];
+
+   for( int cpu = 0 ; cpu < MAX_CPUS ; cpu++ ) {
+      nodeOf[cpu] = -1;
+   }
+   for( int node = 0 ; node < MAX_NODES ; node++ ) {
+      snprintf( path, sizeof( path ), "/sys/devices/system/node/node%d/cpulist", node );
+      FILE* file = fopen( path, "r" );
+      if( file == NULL ) {
+         continue;  // Node numbers can have gaps
+      }
+      int count = -1;
+      if( fgets( line, sizeof( line ), file ) != NULL ) {
+         count = topology_parse_cpulist( line, cpus, MAX_CPUS );
+      }
+      fclose( file );
+      for( int i = 0 ; i < count ; i++ ) {
+         if( cpus[i] < MAX_CPUS ) {
+            nodeOf[cpus[i]] = node;
+         }
+      }
+   }
+}
+
+
+/// Find where `info->cpu` sits.  This pins the calling thread to it, to read
+/// its APIC ID.
+static void read_topology( struct cpu_info* info, const int* nodeOf ) {
+   uint32_t eax, ebx, ecx, edx;
+   uint32_t smtShift = 0;
+   uint32_t packageShift = 0;
+
+   pin_to( info->cpu );
+
+   eax = 0; ebx = 0; ecx = 0; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   if( eax >= 0x0B ) {
+      eax = 0x0B; ebx = 0; ecx = 0; edx = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      info->apic = (uint32_t) field_from_regs( &fields[FIELD_X2APIC_ID], eax, ebx, ecx, edx );
+      if( field_from_regs( &fields[FIELD_TOPOLOGY_LEVEL], eax, ebx, ecx, edx ) == 1 ) {
+         smtShift = (uint32_t) field_from_regs( &fields[FIELD_TOPOLOGY_SHIFT], eax, ebx, ecx, edx );
+      }
+      eax = 0x0B; ebx = 0; ecx = 1; edx = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      if( field_from_regs( &fields[FIELD_TOPOLOGY_LEVEL], eax, ebx, ecx, edx ) == 2 ) {
+         packageShift = (uint32_t) field_from_regs( &fields[FIELD_TOPOLOGY_SHIFT], eax, ebx, ecx, edx );
+      }
+   } else {
+      eax = 0x01; ebx = 0; ecx = 0; edx = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      info->apic = (uint32_t) field_from_regs( &fields[FIELD_INITIAL_APIC_ID], eax, ebx, ecx, edx );
+   }
+
+   // sysfs knows best (it also sees through odd APIC ID layouts), so the
+   // APIC ID is only used when it's missing
+   info->package = read_cpu_value( "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", info->cpu );
+   info->die     = read_cpu_value( "/sys/devices/system/cpu/cpu%d/topology/die_id", info->cpu );
+   info->core    = read_cpu_value( "/sys/devices/system/cpu/cpu%d/topology/core_id", info->cpu );
+   info->l3      = read_cpu_value( "/sys/devices/system/cpu/cpu%d/cache/index3/id", info->cpu );
+   info->node    = info->cpu < MAX_CPUS ? nodeOf[info->cpu] : -1;
+
+   if( info->package < 0 ) {
+      info->package = packageShift > 0 ? (int) (info->apic >> packageShift) : 0;
+   }
+   if( info->die < 0 ) {
+      info->die = 0;  // Older kernels don't have die_id.  The APIC fallback below is unique anyway.
+   }
+   if( info->core < 0 ) {
+      info->core = (int) (info->apic >> smtShift);
+   }
+   if( info->l3 < 0 ) {
+      info->l3 = info->package;
+   }
+}
+
+
+/// @return How CPUs `a` and `b` are related.  `core_id` repeats on each die
+///         of a multi-die package, so SMT siblings share the die too.
+static enum relation relate( const struct cpu_info* a, const struct cpu_info* b ) {
+   if( a->package != b->package ) {
+      return REL_REMOTE;
+   }
+   if( a->die == b->die && a->core == b->core ) {
+      return REL_SMT;
+   }
+   return a->l3 == b->l3 ? REL_L3 : REL_PACKAGE;
+}
+
+
+/// The responder:  Pinned to `pp->cpu`, it answers each odd `seq` with the
+/// next even one until it sees `STOP`
+static void* responder( void* arg ) {
+   struct pingpong* pp = arg;
+
+   if( !pin_to( pp->cpu ) ) {
+      __atomic_store_n( &pp->state, -1, __ATOMIC_RELEASE );
+      return NULL;
+   }
+   __atomic_store_n( &pp->state, 1, __ATOMIC_RELEASE );
+
+   for( uint64_t expect = 1 ; ; expect += 2 ) {
+      uint64_t seq;
+      while( (seq = __atomic_load_n( &pp->seq, __ATOMIC_ACQUIRE )) != expect ) {
+         if( seq == STOP ) {
+            __atomic_store_n( &pp->state, 2, __ATOMIC_RELEASE );
+            return NULL;
+         }
+      }
+      __atomic_store_n( &pp->seq, expect + 1, __ATOMIC_RELEASE );
+   }
+}
+
+
+/// Run `rounds` round trips from the initiator's side
+///
+/// @return `false` if the responder didn't answer before `deadline`
+static bool round_trips( struct pingpong* pp, uint64_t* next, int rounds, double deadline ) {
+   for( int r = 0 ; r < rounds ; r++ ) {
+      uint64_t spins = 0;
+
+      __atomic_store_n( &pp->seq, *next, __ATOMIC_RELEASE );
+      while( __atomic_load_n( &pp->seq, __ATOMIC_ACQUIRE ) != *next + 1 ) {
+         if( (++spins & 0xFFFFF) == 0 && now_seconds() > deadline ) {
+            return false;
+         }
+      }
+      *next += 2;
+   }
+   return true;
+}
+
+
+/// Measure the round trip between `cpuA` (this thread) and `cpuB`
+///
+/// @return The best round trip in ns, or `0` if it couldn't be measured
+static double measure_pair( int cpuA, int cpuB ) {
+   static struct pingpong pp;
+   pthread_t thread;
+   double best = 0;
+
+   if( !pin_to( cpuA ) ) {
+      return 0;
+   }
+   __atomic_store_n( &pp.seq, 0, __ATOMIC_RELAXED );
+   __atomic_store_n( &pp.state, 0, __ATOMIC_RELAXED );
+   pp.cpu = cpuB;
+   if( pthread_create( &thread, NULL, responder, &pp ) != 0 ) {
+      return 0;
+   }
+
+   double deadline = now_seconds() + PAIR_TIMEOUT;
+   int state;
+   while( (state = __atomic_load_n( &pp.state, __ATOMIC_ACQUIRE )) == 0 ) {
+      if( now_seconds() > deadline ) {
+         break;
+      }
+   }
+
+   if( state == 1 ) {
+      uint64_t next = 1;
+      bool ok = round_trips( &pp, &next, WARMUP_ROUNDS, deadline );
+      int stale = 0;
+
+      for( int batch = 0 ; ok && batch < MAX_BATCHES ; batch++ ) {
+         double start = now_seconds();
+         ok = round_trips( &pp, &next, BATCH_ROUNDS, deadline );
+         double ns = (now_seconds() - start) * 1e9 / BATCH_ROUNDS;
+
+         if( !ok ) {
+            best = 0;  // Don't report a pair that stalled
+            break;
+         }
+         stale = best == 0 || ns < best * 0.99 ? 0 : stale + 1;
+         best = best == 0 || ns < best ? ns : best;
+         if( batch + 1 >= MIN_BATCHES && stale >= STALE_BATCHES ) {
+            break;
+         }
+      }
+
+      // Keep telling it to stop:  A responder that was mid-reply when we
+      // timed out could overwrite the first STOP
+      while( __atomic_load_n( &pp.state, __ATOMIC_ACQUIRE ) != 2 ) {
+         __atomic_store_n( &pp.seq, STOP, __ATOMIC_RELEASE );
+      }
+   } else if( state == 0 ) {
+      // The responder never started; it stops as soon as it sees STOP
+      __atomic_store_n( &pp.seq, STOP, __ATOMIC_RELEASE );
+   }
+
+   pthread_join( thread, NULL );
+   return best;
+}
+
+
+/// Shuffle `pairs` (with a fixed seed, so runs sample the same pairs)
+static void shuffle_pairs( struct pair* pairs, size_t count ) {
+   uint64_t x = 0x2545F4914F6CDD1D;
+
+   for( size_t i = count ; i > 1 ; i-- ) {
+      x ^= x << 13;  // xorshift64
+      x ^= x >> 7;
+      x ^= x << 17;
+      size_t j = (size_t) (x % i);
+      struct pair t = pairs[i - 1];
+      pairs[i - 1] = pairs[j];
+      pairs[j] = t;
+   }
+}
+
+
+/// Choose up to `max` pairs:  An equal share from each relation first, then
+/// whatever's left in (shuffled) order
+///
+/// @return The number of pairs chosen
+static size_t choose_pairs( struct pair* pairs, size_t count, size_t max ) {
+   size_t chosen = 0;
+   size_t perRelation[REL_COUNT] = { 0 };
+
+   if( count <= max ) {
+      for( size_t i = 0 ; i < count ; i++ ) {
+         pairs[i].chosen = true;
+      }
+      return count;
+   }
+
+   shuffle_pairs( pairs, count );
+   for( size_t i = 0 ; i < count && chosen < max ; i++ ) {
+      if( perRelation[pairs[i].relation] < max / REL_COUNT ) {
+         perRelation[pairs[i].relation]++;
+         pairs[i].chosen = true;
+         chosen++;
+      }
+   }
+   for( size_t i = 0 ; i < count && chosen < max ; i++ ) {
+      if( !pairs[i].chosen ) {
+         pairs[i].chosen = true;
+         chosen++;
+      }
+   }
+   return chosen;
+}
+
+
+/// Sort pairs by CPU:  Chosen pairs first
+static int compare_by_cpu( const void* left, const void* right ) {
+   const struct pair* l = left;
+   const struct pair* r = right;
+
+   if( l->chosen != r->chosen ) {
+      return l->chosen ? -1 : 1;
+   }
+   if( l->a != r->a ) {
+      return l->a < r->a ? -1 : 1;
+   }
+   return (l->b > r->b) - (l->b < r->b);
+}
+
+
+/// Sort pairs by latency:  Measured pairs first
+static int compare_by_ns( const void* left, const void* right ) {
+   const struct pair* l = left;
+   const struct pair* r = right;
+
+   if( (l->ns > 0) != (r->ns > 0) ) {
+      return l->ns > 0 ? -1 : 1;
+   }
+   return (l->ns > r->ns) - (l->ns < r->ns);
+}
+
+
+/// @return The number of distinct values of `key( cpus[i] )`
+static int count_distinct( const struct cpu_info* cpus, int count, int (*key)( const struct cpu_info* ) ) {
+   int distinct = 0;
+
+   for( int i = 0 ; i < count ; i++ ) {
+      bool seen = false;
+      for( int j = 0 ; j < i && !seen ; j++ ) {
+         seen = key( &cpus[j] ) == key( &cpus[i] );
+      }
+      distinct += seen ? 0 : 1;
+   }
+   return distinct;
+}
+
+static int package_key( const struct cpu_info* info ) { return info->package; }
+static int l3_key( const struct cpu_info* info )      { return info->package * 65536 + info->l3; }
+static int core_key( const struct cpu_info* info )    { return info->package * 65536 + info->core; }
+static int node_key( const struct cpu_info* info )    { return info->node; }
+
+
+/// Print where `info` sits, like `CPU 3 (package 0, core 1, L3 0, node 0, x2APIC 3)`
+static void print_cpu( const struct cpu_info* info ) {
+   printf( "CPU %d (package %d, core %d, L3 %d", info->cpu, info->package, info->core, info->l3 );
+   if( info->node >= 0 ) {
+      printf( ", node %d", info->node );
+   }
+   printf( ", x2APIC %" PRIu32 ")", info->apic );
+}
+
+
+/// Print the round trip between every pair of CPUs
+static void print_matrix( const struct cpu_info* cpus, int count, const struct pair* pairs, size_t pairCount ) {
+   printf( "  Round trip (ns)\n" );
+   printf( "     CPU" );
+   for( int j = 0 ; j < count ; j++ ) {
+      printf( " %5d", cpus[j].cpu );
+   }
+   printf( "\n" );
+   for( int i = 0 ; i < count ; i++ ) {
+      printf( "   %5d", cpus[i].cpu );
+      for( int j = 0 ; j < count ; j++ ) {
+         double ns = 0;
+         for( size_t p = 0 ; p < pairCount ; p++ ) {
+            if( (pairs[p].a == i && pairs[p].b == j) || (pairs[p].a == j && pairs[p].b == i) ) {
+               ns = pairs[p].ns;
+               break;
+            }
+         }
+         if( i == j ) {
+            printf( "     -" );
+         } else if( ns > 0 ) {
+            printf( " %5.0f", ns );
+         } else {
+            printf( "     ?" );
+         }
+      }
+      printf( "\n" );
+   }
+}
+
+
+/// Recommend pairings for enclave threads & switchless workers:  The fastest
+/// pairs that aren't SMT siblings, with no CPU in two of them.  `sorted` is
+/// the measured pairs, fastest first.
+static void print_recommendations( const struct cpu_info* cpus, int count, const struct pair* sorted, size_t measured ) {
+   bool* used = calloc( (size_t) count, sizeof( bool ) );
+   int recommended = 0;
+
+   if( used == NULL ) {
+      return;
+   }
+
+   printf( "  Pairings for an enclave thread & its switchless worker (fastest first):\n" );
+   for( int pass = 0 ; pass < 2 && recommended == 0 ; pass++ ) {
+      // SMT siblings are only recommended if there's nothing else
+      for( size_t p = 0 ; p < measured && recommended < MAX_RECOMMENDED ; p++ ) {
+         const struct pair* pair = &sorted[p];
+         if( (pass == 0 && pair->relation == REL_SMT) || used[pair->a] || used[pair->b] ) {
+            continue;
+         }
+         used[pair->a] = true;
+         used[pair->b] = true;
+         recommended++;
+         printf( "    %5.0f ns  %-13s  ", pair->ns, relationNames[pair->relation] );
+         print_cpu( &cpus[pair->a] );
+         printf( " + " );
+         print_cpu( &cpus[pair->b] );
+         printf( "\n" );
+      }
+   }
+   free( used );
+
+   for( size_t p = 0 ; p < measured ; p++ ) {
+      if( sorted[p].relation == REL_SMT ) {
+         printf( "  SMT siblings answer in %.0f ns, but a spinning worker takes execution\n", sorted[p].ns );
+         printf( "  resources from the enclave thread on the same core.  Pair them only if the\n" );
+         printf( "  worker sleeps while it waits.\n" );
+         break;
+      }
+   }
+}
+
+#endif
+
+
+/// `--c2c [--cpus LIST] [--pairs N]`
+int c2c_main( int argc, char* argv[] ) {
+   const char* cpuList = NULL;
+   long maxPairs = DEFAULT_PAIRS;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--cpus" ) == 0 && i + 1 < argc ) {
+         cpuList = argv[++i];
+      } else if( strcmp( argv[i], "--pairs" ) == 0 && i + 1 < argc ) {
+         maxPairs = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --c2c [--cpus LIST] [--pairs N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( maxPairs <= 0 ) {
+      fprintf( stderr, "c2c: The number of pairs must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static int cpuNumbers[MAX_CPUS];
+      static int nodeOf[MAX_CPUS];
+      cpu_set_t allowed;
+      int count = 0;
+
+      if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) {
+         fprintf( stderr, "c2c: Unable to read this process's CPU affinity\n" );
+         return EXIT_FAILURE;
+      }
+
+      if( cpuList != NULL ) {
+         count = topology_parse_cpulist( cpuList, cpuNumbers, MAX_CPUS );
+         if( count < 0 ) {
+            fprintf( stderr, "c2c: [%s] isn't a CPU list\n", cpuList );
+            return EXIT_FAILURE;
+         }
+         for( int i = 0 ; i < count ; i++ ) {
+            if( cpuNumbers[i] >= CPU_SETSIZE || !CPU_ISSET( cpuNumbers[i], &allowed ) ) {
+               fprintf( stderr, "c2c: CPU %d isn't online or available to this process\n", cpuNumbers[i] );
+               return EXIT_FAILURE;
+            }
+            for( int j = 0 ; j < i ; j++ ) {
+               if( cpuNumbers[j] == cpuNumbers[i] ) {
+                  fprintf( stderr, "c2c: CPU %d is in the list twice\n", cpuNumbers[i] );
+                  return EXIT_FAILURE;
+               }
+            }
+         }
+      } else {
+         int online = topology_online_cpus( cpuNumbers, MAX_CPUS );
+         for( int i = 0 ; i < online ; i++ ) {
+            if( cpuNumbers[i] < CPU_SETSIZE && CPU_ISSET( cpuNumbers[i], &allowed ) ) {
+               cpuNumbers[count++] = cpuNumbers[i];
+            }
+         }
+      }
+      if( count < 2 ) {
+         fprintf( stderr, "c2c: Measuring core-to-core latency needs at least two CPUs\n" );
+         return EXIT_FAILURE;
+      }
+
+      size_t pairCount = (size_t) count * (size_t) (count - 1) / 2;
+      struct cpu_info* cpus = calloc( (size_t) count, sizeof( struct cpu_info ) );
+      struct pair* pairs = calloc( pairCount, sizeof( struct pair ) );
+      if( cpus == NULL || pairs == NULL ) {
+         free( cpus );
+         free( pairs );
+         fprintf( stderr, "c2c: Out of memory\n" );
+         return EXIT_FAILURE;
+      }
+
+      read_nodes( nodeOf );
+      for( int i = 0 ; i < count ; i++ ) {
+         cpus[i].cpu = cpuNumbers[i];
+         read_topology( &cpus[i], nodeOf );
+      }
+
+      size_t p = 0;
+      for( int a = 0 ; a < count ; a++ ) {
+         for( int b = a + 1 ; b < count ; b++ ) {
+            pairs[p].a = a;
+            pairs[p].b = b;
+            pairs[p].relation = relate( &cpus[a], &cpus[b] );
+            p++;
+         }
+      }
+
+      size_t chosen = choose_pairs( pairs, pairCount, (size_t) maxPairs );
+      qsort( pairs, pairCount, sizeof( struct pair ), compare_by_cpu );
+
+      printf( "Core-to-core latency (cache-line round trips) between %d CPUs\n", count );
+      printf( "  %d package(s), %d L3 domain(s), %d core(s)", count_distinct( cpus, count, package_key ), count_distinct( cpus, count, l3_key ), count_distinct( cpus, count, core_key ) );
+      if( cpus[0].node >= 0 ) {
+         printf( ", %d NUMA node(s)", count_distinct( cpus, count, node_key ) );
+      }
+      printf( "\n" );
+      if( chosen < pairCount ) {
+         printf( "  Sampling %zu of the %zu pairs (an equal share of each topology class)\n", chosen, pairCount );
+      } else {
+         printf( "  Measuring all %zu pairs\n", pairCount );
+      }
+      fflush( stdout );  // Big hosts take a while
+
+      double start = now_seconds();
+      for( size_t i = 0 ; i < chosen ; i++ ) {
+         pairs[i].ns = measure_pair( cpus[pairs[i].a].cpu, cpus[pairs[i].b].cpu );
+      }
+      double elapsed = now_seconds() - start;
+
+      if( count <= MATRIX_CPUS && chosen == pairCount ) {
+         for( int i = 0 ; i < count ; i++ ) {
+            printf( "    " );
+            print_cpu( &cpus[i] );
+            printf( "\n" );
+         }
+         print_matrix( cpus, count, pairs, chosen );
+      }
+
+      qsort( pairs, chosen, sizeof( struct pair ), compare_by_ns );
+      size_t measured = 0;
+      while( measured < chosen && pairs[measured].ns > 0 ) {
+         measured++;
+      }
+
+      printf( "    Relation        Pairs     Min  Median     Max\n" );
+      printf( "                               ns      ns      ns\n" );
+      printf( "    =============  ======  ======  ======  ======\n" );
+      for( int r = 0 ; r < REL_COUNT ; r++ ) {
+         size_t n = 0;
+         double min = 0, max = 0, median = 0;
+         for( size_t i = 0 ; i < measured ; i++ ) {  // `pairs` is sorted by ns
+            if( pairs[i].relation == (enum relation) r ) {
+               min = n == 0 ? pairs[i].ns : min;
+               max = pairs[i].ns;
+               n++;
+            }
+         }
+         if( n == 0 ) {
+            continue;
+         }
+         for( size_t i = 0, k = 0 ; i < measured ; i++ ) {
+            if( pairs[i].relation == (enum relation) r && k++ == n / 2 ) {
+               median = pairs[i].ns;
+               break;
+            }
+         }
+         printf( "    %-13s  %6zu  %6.0f  %6.0f  %6.0f\n", relationNames[r], n, min, median, max );
+      }
+      if( measured < chosen ) {
+         printf( "  %zu pair(s) didn't answer within %.0f s (is something else running there?)\n", chosen - measured, PAIR_TIMEOUT );
+      }
+
+      if( measured > 0 ) {
+         print_recommendations( cpus, count, pairs, measured );
+         printf( "  Slowest pair:  %.0f ns between ", pairs[measured - 1].ns );
+         print_cpu( &cpus[pairs[measured - 1].a] );
+         printf( " and " );
+         print_cpu( &cpus[pairs[measured - 1].b] );
+         printf( "\n" );
+      }
+      printf( "  Measured in %.1f s.  One-way latency is about half the round trip.\n", elapsed );
+
+      free( cpus );
+      free( pairs );
+      return measured > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+   #else
+      (void) cpuList;
+      printf( "The core-to-core benchmark needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,15 @@
+///////////////////////////////////////////////////////////////////////////////
+//  c2c.h - 2026
+//
+/// This module measures core-to-core cache-line latency between pairs of
+/// CPUs, to pick where an enclave thread and its switchless worker should
+/// run.
+///
+/// @file   c2c.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--c2c [--cpus LIST] [--pairs N]`
+int c2c_main( int argc, char* argv[] );
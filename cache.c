@@ -0,0 +1,438 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cache.c - 2026
+//
+/// This module keeps the values test-sgx probes in an on-disk cache that is
+/// valid until the next reboot or microcode update.
+///
+/// CPUID and the SGX MSRs can't change without a reboot or a microcode load,
+/// so a cache entry is keyed by `/proc/sys/kernel/random/boot_id` and the
+/// microcode revision from `/proc/cpuinfo`.  XCR0 and IA32_XSS are set by the
+/// OS and can change at any time, so they are always read live -- and so is
+/// CPUID.(EAX=0DH, ECX=0 & 1), whose EBX is the XSAVE area size for them.
+///
+/// The cache is a capture (see capture.c) with a short header:
+///
+///     # test-sgx probe cache.  Delete this file to rebuild it.
+///     key 2.0.0-p4 6f1e8a9c-3b2d-4e5f-9a8b-7c6d5e4f3a2b 000000f0 1
+///     checksum 9c4a1e2b7d3f5a60
+///     node sgx-host-17
+///     cpuid 00000000 00000000 00000016 756e6547 6c65746e 49656e69
+///     ...
+///
+/// The key holds the program version (and `CAPTURE_PROBE_REVISION`), the boot
+/// ID, the microcode revision and whether the MSRs were read.  The checksum is a 64-bit FNV-1a hash of
+/// everything after the checksum line.  A stale, truncated or corrupted cache
+/// is silently rebuilt.  The cache is written to a temporary file that is
+/// renamed into place, so readers never see a partial cache.
+///
+/// The cache holds the SGX MSRs, so it is only readable by its owner, and a
+/// cache owned by anybody else (or writable by anybody else) is ignored.
+///
+/// The cache lives in:
+///   - `$TEST_SGX_CACHE` if it's set.  Set it to `off` to disable the cache.
+///   - `/var/cache/test-sgx/probe.cap` for root
+///   - `$XDG_CACHE_HOME/test-sgx/probe.cap` or `~/.cache/test-sgx/probe.cap`
+///
+/// @file   cache.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `fmemopen()` `open_memstream()` and `mkstemp()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>      // For printf() fopen() fmemopen() open_memstream()
+#include <stdlib.h>     // For getenv() mkstemp() free()
+#include <string.h>     // For strcmp() strlen() strchr()
+#include <inttypes.h>   // For PRIx64 SCNx64 uint64_t
+#include <limits.h>     // For PATH_MAX
+
+#ifdef __linux__
+   #include <fcntl.h>     // For open() O_RDONLY
+   #include <unistd.h>    // For geteuid() access() read() close() unlink() fsync()
+   #include <sys/stat.h>  // For fstat() mkdir() fchmod()
+#endif
+
+#include "cache.h"      // For obvious reasons
+#include "capture.h"    // For capture_probe() capture_write() capture_read() capture_refresh_cpuid() CAPTURE_PROBE_REVISION
+#include "rdmsr.h"      // For checkCapabilitiesQuietly() rdmsr() IA32_XSS IA32_SGXLEPUBKEYHASH0
+#include "decode.h"     // For fields[] field_extract()
+#include "xsave.h"      // For native_XGETBV()
+#include "test-sgx.h"   // For PROGRAM_NAME PROGRAM_VERSION_MAJOR
+
+
+/// The largest cache we'll read.  A full capture is about 10K.
+#define MAX_CACHE_SIZE ( 64 * 1024 )
+
+#define BOOT_ID_FILE "/proc/sys/kernel/random/boot_id"
+
+
+/// What a cache entry is valid for
+struct cache_key {
+   char     version[16];
+   char     boot_id[40];
+   uint32_t microcode;   ///< 0 if the OS doesn't tell us
+   int      msrs;        ///< 1 if the MSRs were read
+};
+
+
+#ifdef __linux__
+
+/// Find where the cache lives
+///
+/// @return `false` if the cache is disabled
+static bool cache_path( char* path, size_t size ) {
+   const char* env = getenv( "TEST_SGX_CACHE" );
+   const char* base = NULL;
+
+   if( env != NULL ) {
+      snprintf( path, size, "%s", env );
+      return env[0] != '\0' && strcmp( env, "off" ) != 0;
+   }
+
+   if( geteuid() == 0 ) {
+      snprintf( path, size, "/var/cache/" PROGRAM_NAME "/probe.cap" );
+   } else if( (base = getenv( "XDG_CACHE_HOME" )) != NULL && base[0] != '\0' ) {
+      snprintf( path, size, "%s/" PROGRAM_NAME "/probe.cap", base );
+   } else if( (base = getenv( "HOME" )) != NULL && base[0] != '\0' ) {
+      snprintf( path, size, "%s/.cache/" PROGRAM_NAME "/probe.cap", base );
+   } else {
+      return false;
+   }
+   return true;
+}
+
+
+/// Get the key for this boot & microcode
+///
+/// @return `false` if there's no boot ID, so nothing can be cached
+static bool current_key( struct cache_key* key, bool msrs ) {
+   char line[256];
+
+   memset( key, 0, sizeof( *key ) );
+   snprintf( key->version, sizeof( key->version ), "%d.%d.%d-p%d", PROGRAM_VERSION_MAJOR, PROGRAM_VERSION_MINOR, PROGRAM_VERSION_PATCH, CAPTURE_PROBE_REVISION );
+   key->msrs = msrs;
+
+   FILE* file = fopen( BOOT_ID_FILE, "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   bool ok = fgets( line, sizeof( line ), file ) != NULL && sscanf( line, "%39s", key->boot_id ) == 1;
+   fclose( file );
+   if( !ok ) {
+      return false;
+   }
+
+   // Every CPU reports a revision, but the first one is enough to notice a
+   // late microcode load.  VMs often don't report one at all.
+   file = fopen( "/proc/cpuinfo", "r" );
+   if( file != NULL ) {
+      while( fgets( line, sizeof( line ), file ) != NULL ) {
+         if( strncmp( line, "microcode", 9 ) == 0 ) {
+            const char* colon = strchr( line, ':' );
+            if( colon != NULL ) {
+               sscanf( colon + 1, "%" SCNx32, &key->microcode );
+            }
+            break;
+         }
+      }
+      fclose( file );
+   }
+
+   return true;
+}
+
+
+/// A 64-bit FNV-1a hash of `size` bytes
+static uint64_t fnv1a( const char* data, size_t size ) {
+   uint64_t hash = 0xcbf29ce484222325;  // FNV offset basis
+
+   for( size_t i = 0 ; i < size ; i++ ) {
+      hash ^= (unsigned char) data[i];
+      hash *= 0x100000001b3;  // FNV prime
+   }
+   return hash;
+}
+
+
+/// Read the cache at `path` into `cap`, checking that it's ours, intact and
+/// was written with the key `key`.  `key->msrs` is updated from the cache.
+///
+/// @return `false` if the cache is missing, stale or corrupt
+static bool read_cache( const char* path, struct cache_key* key, struct sgx_capture* cap, bool verbose ) {
+   static char buffer[MAX_CACHE_SIZE + 1];
+   struct stat st;
+   ssize_t size = 0;
+
+   int fd = open( path, O_RDONLY | O_NOFOLLOW );
+   if( fd < 0 ) {
+      if( verbose ) {
+         printf( "  There's no cache yet\n" );
+      }
+      return false;
+   }
+   if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_uid != geteuid() || (st.st_mode & 022) != 0 ) {
+      close( fd );
+      if( verbose ) {
+         printf( "  The cache isn't a regular file that only we can write.  Ignoring it.\n" );
+      }
+      return false;
+   }
+   size = read( fd, buffer, MAX_CACHE_SIZE );
+   close( fd );
+   if( size <= 0 ) {
+      return false;
+   }
+   buffer[size] = '\0';
+
+   // The header is a comment, the key and the checksum
+   char* keyLine = strstr( buffer, "\nkey " );
+   char* checksumLine = keyLine == NULL ? NULL : strstr( keyLine + 1, "\nchecksum " );
+   char* body = checksumLine == NULL ? NULL : strchr( checksumLine + 1, '\n' );
+   struct cache_key cached;
+   uint64_t checksum = 0;
+
+   memset( &cached, 0, sizeof( cached ) );
+   if( body == NULL
+    || sscanf( keyLine, "\nkey %15s %39s %" SCNx32 " %d", cached.version, cached.boot_id, &cached.microcode, &cached.msrs ) != 4
+    || sscanf( checksumLine, "\nchecksum %" SCNx64, &checksum ) != 1
+    || checksum != fnv1a( body + 1, (size_t) (buffer + size - (body + 1)) ) ) {
+      if( verbose ) {
+         printf( "  The cache is corrupt\n" );
+      }
+      return false;
+   }
+
+   if( strcmp( cached.version, key->version ) != 0
+    || strcmp( cached.boot_id, key->boot_id ) != 0
+    || cached.microcode != key->microcode ) {
+      if( verbose ) {
+         printf( "  The cache is stale (key %s %s %08" PRIx32 ")\n", cached.version, cached.boot_id, cached.microcode );
+      }
+      return false;
+   }
+
+   FILE* file = fmemopen( body + 1, (size_t) (buffer + size - (body + 1)), "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   struct capture_reader reader;
+   capture_reader_init( &reader, file, path );
+   bool found = capture_read( &reader, cap );
+   fclose( file );
+
+   key->msrs = cached.msrs;
+   return found;
+}
+
+
+/// Make the directory holding `path` (and its parent), if they don't exist
+static void make_parent_directories( const char* path ) {
+   char dir[PATH_MAX];
+
+   snprintf( dir, sizeof( dir ), "%s", path );
+   char* slash = strrchr( dir, '/' );
+   if( slash == NULL || slash == dir ) {
+      return;
+   }
+   *slash = '\0';
+
+   char* parent = strrchr( dir, '/' );
+   if( parent != NULL && parent != dir ) {
+      *parent = '\0';
+      mkdir( dir, 0700 );  // It's fine if it already exists
+      *parent = '/';
+   }
+   mkdir( dir, 0700 );
+}
+
+
+/// Write `cap` to the cache at `path` with the key `key`
+static void write_cache( const char* path, const struct cache_key* key, const struct sgx_capture* cap ) {
+   char*  body = NULL;
+   size_t bodySize = 0;
+   char   tempPath[PATH_MAX];
+
+   FILE* memory = open_memstream( &body, &bodySize );
+   if( memory == NULL ) {
+      return;
+   }
+   capture_write( memory, cap );
+   fclose( memory );
+
+   make_parent_directories( path );
+
+   if( snprintf( tempPath, sizeof( tempPath ), "%s.XXXXXX", path ) >= (int) sizeof( tempPath ) ) {
+      free( body );
+      return;
+   }
+   int fd = mkstemp( tempPath );  // mkstemp() makes the file 0600
+   FILE* file = fd < 0 ? NULL : fdopen( fd, "w" );
+   if( file == NULL ) {
+      if( fd >= 0 ) {
+         close( fd );
+         unlink( tempPath );
+      }
+      free( body );
+      return;  // The cache is an optimization, so don't complain
+   }
+
+   fprintf( file, "# " PROGRAM_NAME " probe cache.  Delete this file to rebuild it.\n" );
+   fprintf( file, "key %s %s %08" PRIx32 " %d\n", key->version, key->boot_id, key->microcode, key->msrs );
+   fprintf( file, "checksum %016" PRIx64 "\n", fnv1a( body, bodySize ) );
+   fwrite( body, 1, bodySize, file );
+   free( body );
+
+   bool ok = fflush( file ) == 0 && fsync( fd ) == 0;
+   ok = fclose( file ) == 0 && ok;
+   if( !ok || rename( tempPath, path ) != 0 ) {
+      unlink( tempPath );
+   }
+}
+
+
+/// Return `true` if we have the privileges and the `msr` driver to read MSRs.
+/// It's quiet, so the report still says why not where it always has.
+static bool can_read_msrs( void ) {
+   return checkCapabilitiesQuietly() && access( "/dev/cpu/0/msr", R_OK ) == 0;
+}
+
+
+/// Replace (or add) the live value of an MSR in `cap`
+static void refresh_msr( struct sgx_capture* cap, uint32_t reg ) {
+   uint64_t value = 0;
+   bool readable = rdmsr( reg, 0, &value );
+
+   for( uint32_t i = 0 ; i < cap->msr_count ; i++ ) {
+      if( cap->msr[i].reg == reg ) {
+         if( readable ) {
+            cap->msr[i].value = value;
+         } else {
+            cap->msr[i] = cap->msr[--cap->msr_count];
+         }
+         return;
+      }
+   }
+   if( readable && cap->msr_count < CAPTURE_MAX_MSR ) {
+      cap->msr[cap->msr_count].reg = reg;
+      cap->msr[cap->msr_count].value = value;
+      cap->msr_count++;
+   }
+}
+
+
+/// Re-read IA32_SGXLEPUBKEYHASH0-3 if launch control lets the kernel write
+/// them.  With Flexible Launch Control unlocked, the kernel sets the hash of
+/// each enclave's signer before EINIT, so the cached hash is only the last
+/// one that was loaded.
+static void refresh_lepubkeyhash( struct sgx_capture* cap ) {
+   uint64_t featureControl = 0;
+
+   if( capture_find_msr( cap, IA32_FEATURE_CONTROL, &featureControl )
+    && field_extract( &fields[FIELD_FC_SGX_LC], featureControl ) != 0 ) {
+      for( uint32_t i = 0 ; i < 4 ; i++ ) {
+         refresh_msr( cap, IA32_SGXLEPUBKEYHASH0 + i );
+      }
+   }
+}
+
+#endif  // __linux__
+
+
+/// Fill `cap` from the probe cache if it's still valid for this boot and
+/// microcode, otherwise probe this node and rebuild the cache.  XCR0,
+/// IA32_XSS and the XSAVE sizes that depend on them are always read live, and
+/// so is IA32_SGXLEPUBKEYHASH0-3 when launch control lets the kernel write it.
+/// It doesn't print anything.
+///
+/// @param want_msrs Also read the SGX MSRs (if we have the privileges)
+/// @return `true` if `cap` holds the SGX MSRs
+bool cache_probe( struct sgx_capture* cap, bool want_msrs ) {
+   #ifdef __linux__
+      char path[PATH_MAX];
+      struct cache_key key;
+
+      if( cache_path( path, sizeof( path ) ) && current_key( &key, false ) ) {
+         if( read_cache( path, &key, cap, false ) ) {
+            // A cache without the MSRs is only good enough if we still can't read them
+            if( key.msrs || !want_msrs || !can_read_msrs() ) {
+               if( cap->has_xcr0 ) {
+                  cap->xcr0 = native_XGETBV( 0 );
+               }
+               if( key.msrs ) {
+                  refresh_msr( cap, IA32_XSS );
+                  refresh_lepubkeyhash( cap );
+               }
+               capture_refresh_cpuid( cap, 0x0D, 0 );  // EBX:  The XSAVE area for XCR0
+               capture_refresh_cpuid( cap, 0x0D, 1 );  // EBX:  ...for XCR0 | IA32_XSS
+               return key.msrs;
+            }
+            key.msrs = true;  // We just got the privileges
+         } else {
+            key.msrs = want_msrs && can_read_msrs();
+         }
+
+         capture_probe( cap, key.msrs );
+         write_cache( path, &key, cap );
+         return key.msrs;
+      }
+   #endif
+
+   #ifdef __linux__
+      bool msrs = want_msrs && can_read_msrs();
+   #else
+      bool msrs = false;
+      (void) want_msrs;
+   #endif
+   capture_probe( cap, msrs );
+   return msrs;
+}
+
+
+/// `--cache [--clear]`:  Show (or delete) the probe cache
+int cache_main( int argc, char* argv[] ) {
+   bool clear = argc > 1 && strcmp( argv[1], "--clear" ) == 0;
+
+   if( argc > 2 || (argc == 2 && !clear) ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --cache [--clear]\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct sgx_capture cap;  // Too big for the stack
+      char path[PATH_MAX];
+      struct cache_key key;
+
+      if( !cache_path( path, sizeof( path ) ) ) {
+         printf( "The probe cache is disabled\n" );
+         return EXIT_SUCCESS;
+      }
+      printf( "Probe cache: %s\n", path );
+
+      if( clear ) {
+         if( unlink( path ) != 0 ) {
+            printf( "  There's no cache to delete\n" );
+         }
+         return EXIT_SUCCESS;
+      }
+
+      if( !current_key( &key, false ) ) {
+         printf( "  There's no " BOOT_ID_FILE ", so nothing is cached\n" );
+         return EXIT_SUCCESS;
+      }
+      printf( "  Current key: %s %s %08" PRIx32 "\n", key.version, key.boot_id, key.microcode );
+
+      if( read_cache( path, &key, &cap, true ) ) {
+         printf( "  Valid:  %" PRIu32 " CPUID leaves, %" PRIu32 " MSRs%s\n"
+                ,cap.cpuid_count, cap.msr_count, key.msrs ? "" : " (MSRs weren't readable)" );
+      } else {
+         printf( "  Not valid.  The next run will rebuild it.\n" );
+      }
+   #else
+      (void) clear;
+      printf( "The probe cache is only supported on Linux\n" );
+   #endif
+
+   return EXIT_SUCCESS;
+}
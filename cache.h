@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cache.h - 2026
+//
+/// This module keeps the values test-sgx probes in an on-disk cache that is
+/// valid until the next reboot or microcode update.
+///
+/// @file   cache.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdbool.h>   // For bool
+
+#include "capture.h"   // For struct sgx_capture
+
+
+/// Fill `cap` from the probe cache if it's still valid for this boot and
+/// microcode, otherwise probe this node and rebuild the cache.  XCR0,
+/// IA32_XSS and the XSAVE sizes that depend on them are always read live, and
+/// so is IA32_SGXLEPUBKEYHASH0-3 when launch control lets the kernel write it.
+/// It doesn't print anything.
+///
+/// @param want_msrs Also read the SGX MSRs (if we have the privileges)
+/// @return `true` if `cap` holds the SGX MSRs
+bool cache_probe( struct sgx_capture* cap, bool want_msrs );
+
+/// `--cache [--clear]`:  Show (or delete) the probe cache
+int cache_main( int argc, char* argv[] );
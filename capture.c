@@ -0,0 +1,526 @@
+///////////////////////////////////////////////////////////////////////////////
+//  capture.c - 2026
+//
+/// This module records the raw values that test-sgx reads (CPUID leaves,
+/// XCR0 and the SGX MSRs) so they can be saved, shipped around and decoded
+/// later on another machine.
+///
+/// The capture format is line-oriented text so captures are easy to diff,
+/// grep and concatenate.  Many captures may be concatenated into one stream;
+/// each one starts with a `node` line:
+///
+///     # test-sgx capture (version 2.0.0)
+///     node sgx-host-17
+///     cpuid 00000007 00000000 00000000 029c6fbf 40000000 bc000e00
+///     cpuid 00000012 00000002 70200001 00000000 05d80001 00000000
+///     xcr0 000000000000001f
+///     msr 0000003a 0000000000060005
+///
+/// Lines starting with `#` are comments.  Lines with a keyword this version
+/// doesn't know about are ignored, so newer captures can be read by older
+/// tools.
+///
+/// @file   capture.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `gethostname()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For qsort()
+#include <string.h>    // For memset() memcmp() strcmp() strcpy()
+#include <inttypes.h>  // For PRIx32 PRIx64 SCNx32 SCNx64
+
+#ifdef __linux__
+   #include <unistd.h> // For gethostname()
+#endif
+
+#include "capture.h"   // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32() decode_EPC_section()
+#include "rdmsr.h"     // For checkCapabilities() rdmsr()
+#include "xsave.h"     // For native_XGETBV()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "test-sgx.h"  // For PROGRAM_NAME PROGRAM_VERSION_MAJOR
+
+
+/// How to walk the sub-leaves of a CPUID leaf
+enum subleaf_policy {
+   SUBLEAF_NONE,   ///< Only sub-leaf 0
+   SUBLEAF_EAX,    ///< Sub-leaf 0 EAX holds the maximum sub-leaf (leaves 7 & 1DH)
+   SUBLEAF_XSAVE,  ///< Sub-leaves 0, 1 and one per supported state component (leaf 0DH)
+   SUBLEAF_SGX,    ///< Sub-leaves 0, 1 and then EPC sections until an invalid one (leaf 12H)
+   SUBLEAF_CACHE   ///< Sub-leaves until the cache type is 0 (leaf 4)
+};
+
+
+/// The CPUID leaves test-sgx reads.  Keep this sorted by leaf, and bump
+/// `CAPTURE_PROBE_REVISION` when it (or `probeMSRs`) changes.
+static const struct {
+   uint32_t leaf;
+   enum subleaf_policy policy;
+} probeLeaves[] = {
+   { 0x00000000, SUBLEAF_NONE  },  // Vendor & maximum basic leaf
+   { 0x00000001, SUBLEAF_NONE  },  // Version & feature information
+   { 0x00000004, SUBLEAF_CACHE },  // Deterministic cache parameters
+   { 0x00000006, SUBLEAF_NONE  },  // Thermal & power management
+   { 0x00000007, SUBLEAF_EAX   },  // Structured extended features
+   { 0x0000000D, SUBLEAF_XSAVE },  // XSAVE features and state-components
+   { 0x00000012, SUBLEAF_SGX   },  // SGX capabilities, attributes & EPC sections
+   { 0x00000016, SUBLEAF_NONE  },  // Processor frequency
+   { 0x0000001D, SUBLEAF_EAX   },  // AMX tile palettes
+   { 0x0000001E, SUBLEAF_NONE  },  // AMX TMUL information
+   { 0x80000000, SUBLEAF_NONE  },  // Maximum extended leaf
+   { 0x80000001, SUBLEAF_NONE  },  // Extended feature bits
+   { 0x80000002, SUBLEAF_NONE  },  // Processor brand string
+   { 0x80000003, SUBLEAF_NONE  },
+   { 0x80000004, SUBLEAF_NONE  },
+};
+
+
+/// The MSRs a capture holds.  `MSR_SGXOWNEREPOCH` goes into every sealing
+/// key, so it's never captured (or cached) -- the report reads it live.
+static const uint32_t probeMSRs[] = {
+   IA32_FEATURE_CONTROL,
+   IA32_SGXLEPUBKEYHASH0,
+   IA32_SGXLEPUBKEYHASH0 + 1,
+   IA32_SGXLEPUBKEYHASH0 + 2,
+   IA32_SGXLEPUBKEYHASH0 + 3,
+   IA32_SGX_SVN_STATUS,
+   IA32_XSS,
+};
+
+
+/// Return `true` if `reg` is one of the MSRs a capture reads
+bool capture_probes_msr( uint32_t reg ) {
+   for( size_t i = 0 ; i < sizeof( probeMSRs ) / sizeof( probeMSRs[0] ) ; i++ ) {
+      if( probeMSRs[i] == reg ) {
+         return true;
+      }
+   }
+   return false;
+}
+
+
+/// Return `true` if `reg` is a secret that must never be written to a capture
+static bool secret_msr( uint32_t reg ) {
+   return reg == MSR_SGXOWNEREPOCH0 || reg == MSR_SGXOWNEREPOCH0 + 1;
+}
+
+
+/// Execute CPUID for `leaf`/`subleaf` and append the result to `cap`
+///
+/// @return The new record or `NULL` if the capture is full
+static struct cpuid_record* probe_subleaf( struct sgx_capture* cap, uint32_t leaf, uint32_t subleaf ) {
+   if( cap->cpuid_count >= CAPTURE_MAX_CPUID ) {
+      fprintf( stderr, "capture: Too many CPUID leaves.  Increase CAPTURE_MAX_CPUID.\n" );
+      return NULL;
+   }
+
+   struct cpuid_record* record = &cap->cpuid[cap->cpuid_count++];
+
+   record->leaf    = leaf;
+   record->subleaf = subleaf;
+   record->eax     = leaf;
+   record->ebx     = 0;
+   record->ecx     = subleaf;
+   record->edx     = 0;
+
+   native_cpuid32( &record->eax, &record->ebx, &record->ecx, &record->edx );
+
+   // The initial APIC ID in CPUID.1:EBX[31:24] depends on which CPU we happen
+   // to be running on.  Clear it so captures of the same node are identical.
+   if( leaf == 1 ) {
+      record->ebx &= 0x00FFFFFF;
+   }
+
+   return record;
+}
+
+
+/// Read every CPUID leaf, XCR0 and (if `read_msrs`) the SGX MSRs on this node
+void capture_probe( struct sgx_capture* cap, bool read_msrs ) {
+   memset( cap, 0, sizeof( *cap ) );
+
+   #ifdef __linux__
+      if( gethostname( cap->node, sizeof( cap->node ) - 1 ) != 0 ) {
+         strcpy( cap->node, "localhost" );
+      }
+   #else
+      strcpy( cap->node, "localhost" );
+   #endif
+
+   uint32_t maxBasicLeaf = 0;
+   uint32_t maxExtendedLeaf = 0;
+   bool     osxsave = false;
+
+   for( size_t i = 0 ; i < sizeof( probeLeaves ) / sizeof( probeLeaves[0] ) ; i++ ) {
+      uint32_t leaf = probeLeaves[i].leaf;
+
+      if( leaf < 0x80000000 && leaf > maxBasicLeaf ) {
+         continue;
+      }
+      if( leaf > 0x80000000 && leaf > maxExtendedLeaf ) {
+         continue;
+      }
+
+      struct cpuid_record* record = probe_subleaf( cap, leaf, 0 );
+      if( record == NULL ) {
+         return;
+      }
+
+      if( leaf == 0 ) {
+         maxBasicLeaf = record->eax;
+      } else if( leaf == 1 ) {
+         osxsave = field_from_regs( &fields[FIELD_OSXSAVE], record->eax, record->ebx, record->ecx, record->edx );
+      } else if( leaf == 0x80000000 ) {
+         maxExtendedLeaf = record->eax;
+      }
+
+      switch( probeLeaves[i].policy ) {
+         case SUBLEAF_NONE:
+            break;
+
+         case SUBLEAF_EAX: {
+            uint32_t maxSubleaf = record->eax;
+            for( uint32_t sub = 1 ; sub <= maxSubleaf && sub < 8 ; sub++ ) {
+               probe_subleaf( cap, leaf, sub );
+            }
+            break;
+         }
+
+         case SUBLEAF_XSAVE: {
+            uint64_t xcr0Supported = (uint64_t) record->edx << 32 | record->eax;
+            struct cpuid_record* sub1 = probe_subleaf( cap, leaf, 1 );
+            if( sub1 == NULL ) {
+               return;
+            }
+            uint64_t xssSupported = (uint64_t) sub1->edx << 32 | sub1->ecx;
+
+            for( uint32_t sub = 2 ; sub < 64 ; sub++ ) {
+               if( ((xcr0Supported | xssSupported) >> sub) & 1 ) {
+                  probe_subleaf( cap, leaf, sub );
+               }
+            }
+            break;
+         }
+
+         case SUBLEAF_SGX:
+            probe_subleaf( cap, leaf, 1 );
+            for( uint32_t sub = 2 ; sub <= 16 ; sub++ ) {
+               struct cpuid_record* epc = probe_subleaf( cap, leaf, sub );
+               if( epc == NULL || field_from_regs( &fields[FIELD_EPC_TYPE], epc->eax, epc->ebx, epc->ecx, epc->edx ) == 0 ) {
+                  break;  // The first invalid sub-leaf ends the EPC sections
+               }
+            }
+            break;
+
+         case SUBLEAF_CACHE: {
+            const struct cpuid_record* cache = record;
+            for( uint32_t sub = 1 ; sub < 16 && cache != NULL ; sub++ ) {
+               if( field_from_regs( &fields[FIELD_CACHE_TYPE], cache->eax, cache->ebx, cache->ecx, cache->edx ) == 0 ) {
+                  break;  // No more caches
+               }
+               cache = probe_subleaf( cap, leaf, sub );
+            }
+            break;
+         }
+      }
+   }
+
+   if( osxsave ) {
+      cap->has_xcr0 = true;
+      cap->xcr0 = native_XGETBV( 0 );
+   }
+
+   if( read_msrs ) {
+      for( size_t i = 0 ; i < sizeof( probeMSRs ) / sizeof( probeMSRs[0] ) ; i++ ) {
+         uint64_t value;
+         if( rdmsr( probeMSRs[i], 0, &value ) && cap->msr_count < CAPTURE_MAX_MSR ) {
+            cap->msr[cap->msr_count].reg = probeMSRs[i];
+            cap->msr[cap->msr_count].value = value;
+            cap->msr_count++;
+         }
+      }
+   }
+}
+
+
+/// Write `cap` to `file` in the text capture format
+void capture_write( FILE* file, const struct sgx_capture* cap ) {
+   fprintf( file, "# " PROGRAM_NAME " capture (version %d.%d.%d)\n", PROGRAM_VERSION_MAJOR, PROGRAM_VERSION_MINOR, PROGRAM_VERSION_PATCH );
+   fprintf( file, "node %s\n", cap->node );
+
+   for( uint32_t i = 0 ; i < cap->cpuid_count ; i++ ) {
+      const struct cpuid_record* r = &cap->cpuid[i];
+      fprintf( file, "cpuid %08" PRIx32 " %08" PRIx32 " %08" PRIx32 " %08" PRIx32 " %08" PRIx32 " %08" PRIx32 "\n"
+              ,r->leaf, r->subleaf, r->eax, r->ebx, r->ecx, r->edx );
+   }
+
+   if( cap->has_xcr0 ) {
+      fprintf( file, "xcr0 %016" PRIx64 "\n", cap->xcr0 );
+   }
+
+   for( uint32_t i = 0 ; i < cap->msr_count ; i++ ) {
+      if( secret_msr( cap->msr[i].reg ) ) {
+         continue;  // In case an older capture holds it
+      }
+      fprintf( file, "msr %08" PRIx32 " %016" PRIx64 "\n", cap->msr[i].reg, cap->msr[i].value );
+   }
+}
+
+
+/// Prepare `reader` to read captures from `file`
+void capture_reader_init( struct capture_reader* reader, FILE* file, const char* name ) {
+   memset( reader, 0, sizeof( *reader ) );
+   reader->file = file;
+   reader->name = name;
+}
+
+
+/// Order CPUID records by leaf then sub-leaf
+static int compare_cpuid_records( const void* a, const void* b ) {
+   const struct cpuid_record* ra = a;
+   const struct cpuid_record* rb = b;
+
+   if( ra->leaf != rb->leaf ) {
+      return ra->leaf < rb->leaf ? -1 : 1;
+   }
+   if( ra->subleaf != rb->subleaf ) {
+      return ra->subleaf < rb->subleaf ? -1 : 1;
+   }
+   return 0;
+}
+
+
+/// Start a new capture from a `node <name>` line
+static void start_capture( struct sgx_capture* cap, const char* line ) {
+   memset( cap, 0, sizeof( *cap ) );
+   if( sscanf( line, "node %63s", cap->node ) != 1 ) {
+      strcpy( cap->node, "unnamed" );
+   }
+}
+
+
+/// Read the next capture from `reader`
+///
+/// @return `true` if a capture was read.  `false` at the end of the stream.
+bool capture_read( struct capture_reader* reader, struct sgx_capture* cap ) {
+   char line[256];
+   bool started = false;
+
+   if( reader->have_pending ) {
+      start_capture( cap, reader->pending );
+      reader->have_pending = false;
+      started = true;
+   }
+
+   while( fgets( line, sizeof( line ), reader->file ) != NULL ) {
+      reader->line_number++;
+
+      char keyword[16];
+      if( sscanf( line, "%15s", keyword ) != 1 || keyword[0] == '#' ) {
+         continue;  // Blank line or comment
+      }
+
+      if( strcmp( keyword, "node" ) == 0 ) {
+         if( started ) {
+            snprintf( reader->pending, sizeof( reader->pending ), "%s", line );
+            reader->have_pending = true;
+            break;
+         }
+         start_capture( cap, line );
+         started = true;
+         continue;
+      }
+
+      if( !started ) {  // Tolerate a capture without a `node` line
+         memset( cap, 0, sizeof( *cap ) );
+         snprintf( cap->node, sizeof( cap->node ), "%s", reader->name );
+         started = true;
+      }
+
+      if( strcmp( keyword, "cpuid" ) == 0 ) {
+         struct cpuid_record r;
+         if( sscanf( line, "cpuid %" SCNx32 " %" SCNx32 " %" SCNx32 " %" SCNx32 " %" SCNx32 " %" SCNx32
+                    ,&r.leaf, &r.subleaf, &r.eax, &r.ebx, &r.ecx, &r.edx ) != 6 ) {
+            fprintf( stderr, "%s:%u: Malformed cpuid record\n", reader->name, reader->line_number );
+         } else if( cap->cpuid_count < CAPTURE_MAX_CPUID ) {
+            cap->cpuid[cap->cpuid_count++] = r;
+         }
+      } else if( strcmp( keyword, "xcr0" ) == 0 ) {
+         if( sscanf( line, "xcr0 %" SCNx64, &cap->xcr0 ) == 1 ) {
+            cap->has_xcr0 = true;
+         } else {
+            fprintf( stderr, "%s:%u: Malformed xcr0 record\n", reader->name, reader->line_number );
+         }
+      } else if( strcmp( keyword, "msr" ) == 0 ) {
+         struct msr_record r;
+         if( sscanf( line, "msr %" SCNx32 " %" SCNx64, &r.reg, &r.value ) != 2 ) {
+            fprintf( stderr, "%s:%u: Malformed msr record\n", reader->name, reader->line_number );
+         } else if( secret_msr( r.reg ) ) {
+            // Older versions captured the owner epoch.  Drop it.
+         } else if( cap->msr_count < CAPTURE_MAX_MSR ) {
+            cap->msr[cap->msr_count++] = r;
+         }
+      }
+      // Anything else is from a newer version of the format.  Ignore it.
+   }
+
+   if( started ) {
+      // Sorting makes the CPUID set canonical, so hashes don't depend on the
+      // order in which records were written.
+      qsort( cap->cpuid, cap->cpuid_count, sizeof( cap->cpuid[0] ), compare_cpuid_records );
+   }
+
+   return started;
+}
+
+
+/// Read the first capture in the file `fileName` (`-` is stdin)
+///
+/// @return `true` if a capture was read
+bool capture_load( const char* fileName, struct sgx_capture* cap ) {
+   struct capture_reader reader;
+   FILE* file = stdin;
+
+   if( strcmp( fileName, "-" ) != 0 ) {
+      file = fopen( fileName, "r" );
+      if( file == NULL ) {
+         fprintf( stderr, "capture: Unable to open [%s]\n", fileName );
+         return false;
+      }
+   }
+
+   capture_reader_init( &reader, file, fileName );
+   bool found = capture_read( &reader, cap );
+
+   if( file != stdin ) {
+      fclose( file );
+   }
+
+   if( !found ) {
+      fprintf( stderr, "capture: [%s] doesn't hold a capture\n", fileName );
+   }
+   return found;
+}
+
+
+/// Find a CPUID leaf/sub-leaf in a capture
+///
+/// @return A pointer to the record or `NULL` if it was not captured
+const struct cpuid_record* capture_find_cpuid( const struct sgx_capture* cap, uint32_t leaf, uint32_t subleaf ) {
+   struct cpuid_record key = { .leaf = leaf, .subleaf = subleaf };
+
+   return bsearch( &key, cap->cpuid, cap->cpuid_count, sizeof( cap->cpuid[0] ), compare_cpuid_records );
+}
+
+
+/// Execute CPUID again for a `leaf`/`subleaf` that `cap` holds.  Don't call
+/// this while `cpuid_use_capture( cap )` is in effect.
+void capture_refresh_cpuid( struct sgx_capture* cap, uint32_t leaf, uint32_t subleaf ) {
+   struct cpuid_record key = { .leaf = leaf, .subleaf = subleaf };
+   struct cpuid_record* r = bsearch( &key, cap->cpuid, cap->cpuid_count, sizeof( cap->cpuid[0] ), compare_cpuid_records );
+
+   if( r != NULL ) {
+      r->eax = leaf;
+      r->ebx = 0;
+      r->ecx = subleaf;
+      r->edx = 0;
+      native_cpuid32( &r->eax, &r->ebx, &r->ecx, &r->edx );
+   }
+}
+
+
+/// Find an MSR in a capture
+///
+/// @return `true` if the MSR was captured
+bool capture_find_msr( const struct sgx_capture* cap, uint32_t reg, uint64_t* pData ) {
+   for( uint32_t i = 0 ; i < cap->msr_count ; i++ ) {
+      if( cap->msr[i].reg == reg ) {
+         *pData = cap->msr[i].value;
+         return true;
+      }
+   }
+   return false;
+}
+
+
+/// Return the total size of all of the EPC sections in a capture
+uint64_t capture_total_EPC( const struct sgx_capture* cap ) {
+   uint64_t total = 0;
+
+   for( uint32_t sub = 2 ; sub <= NUMBER_OF_EPCs_TO_ENUMERATE ; sub++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( cap, 0x12, sub );
+      struct epc_section section;
+      if( r != NULL && decode_EPC_section( r->eax, r->ebx, r->ecx, r->edx, &section ) ) {
+         total += section.size;
+      }
+   }
+
+   return total;
+}
+
+
+/// A 64-bit FNV-1a hash over all of the CPUID records in a capture
+///
+/// @see http://www.isthe.com/chongo/tech/comp/fnv/index.html
+uint64_t capture_cpuid_hash( const struct sgx_capture* cap ) {
+   uint64_t hash = 0xcbf29ce484222325;  // FNV offset basis
+
+   for( uint32_t i = 0 ; i < cap->cpuid_count ; i++ ) {
+      const struct cpuid_record* r = &cap->cpuid[i];
+      uint32_t words[6] = { r->leaf, r->subleaf, r->eax, r->ebx, r->ecx, r->edx };
+
+      // Hash byte-by-byte in little-endian order so the hash is portable
+      for( int w = 0 ; w < 6 ; w++ ) {
+         for( int b = 0 ; b < 4 ; b++ ) {
+            hash ^= (words[w] >> (b * 8)) & 0xFF;
+            hash *= 0x100000001b3;  // FNV prime
+         }
+      }
+   }
+
+   return hash;
+}
+
+
+/// Return `true` if two captures have identical CPUID records
+bool capture_cpuid_equal( const struct sgx_capture* a, const struct sgx_capture* b ) {
+   return a->cpuid_count == b->cpuid_count
+       && memcmp( a->cpuid, b->cpuid, a->cpuid_count * sizeof( a->cpuid[0] ) ) == 0;
+}
+
+
+/// `--capture [FILE] [NODE]`:  Write a capture of this node to FILE (or
+/// stdout).  NODE defaults to the hostname.
+int capture_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;  // Too big for the stack
+
+   const char* fileName = argc > 1 ? argv[1] : "-";
+
+   capture_probe( &cap, checkCapabilities() );
+
+   if( argc > 2 ) {
+      snprintf( cap.node, sizeof( cap.node ), "%s", argv[2] );
+   }
+
+   FILE* file = stdout;
+   if( strcmp( fileName, "-" ) != 0 ) {
+      file = fopen( fileName, "w" );
+      if( file == NULL ) {
+         fprintf( stderr, "capture: Unable to open [%s]\n", fileName );
+         return EXIT_FAILURE;
+      }
+   }
+
+   capture_write( file, &cap );
+
+   if( file != stdout ) {
+      fclose( file );
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+//  capture.h - 2026
+//
+/// This module records the raw values that test-sgx reads (CPUID leaves,
+/// XCR0 and the SGX MSRs) so they can be saved, shipped around and decoded
+/// later on another machine.
+///
+/// @file   capture.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdio.h>     // For FILE
+#include <stdbool.h>   // For bool
+#include <inttypes.h>  // For uint32_t uint64_t
+
+
+/// The largest number of CPUID sub-leaves a capture will hold
+#define CAPTURE_MAX_CPUID  160
+
+/// The largest number of MSRs a capture will hold
+#define CAPTURE_MAX_MSR     16
+
+/// The longest node name (including the terminating NUL)
+#define CAPTURE_NODE_NAME_SIZE 64
+
+/// Which set of leaves & MSRs `capture_probe()` reads.  The probe cache is
+/// keyed by this, so a cache from an older set is probed again.
+#define CAPTURE_PROBE_REVISION 4
+
+
+/// The registers returned by one CPUID leaf/sub-leaf
+struct cpuid_record {
+   uint32_t leaf;
+   uint32_t subleaf;
+   uint32_t eax;
+   uint32_t ebx;
+   uint32_t ecx;
+   uint32_t edx;
+};
+
+
+/// The value of one MSR (as read from CPU 0)
+struct msr_record {
+   uint32_t reg;
+   uint64_t value;
+};
+
+
+/// Everything test-sgx reads from one node
+struct sgx_capture {
+   char     node[CAPTURE_NODE_NAME_SIZE];  ///< Usually the hostname
+   uint32_t cpuid_count;
+   struct cpuid_record cpuid[CAPTURE_MAX_CPUID];  ///< Sorted by leaf, sub-leaf
+   bool     has_xcr0;
+   uint64_t xcr0;
+   uint32_t msr_count;
+   struct msr_record msr[CAPTURE_MAX_MSR];
+};
+
+
+/// Reads a stream of captures.  A single stream may hold many nodes.
+struct capture_reader {
+   FILE*    file;
+   const char* name;       ///< For error messages
+   unsigned line_number;
+   bool     have_pending;  ///< `pending` holds the next capture's `node` line
+   char     pending[256];
+};
+
+
+/// Read every CPUID leaf, XCR0 and (if `read_msrs`) the SGX MSRs on this
+/// node.  The node name is set to the hostname.
+void capture_probe( struct sgx_capture* cap, bool read_msrs );
+
+/// Write `cap` to `file` in the text capture format
+void capture_write( FILE* file, const struct sgx_capture* cap );
+
+/// Prepare `reader` to read captures from `file`
+void capture_reader_init( struct capture_reader* reader, FILE* file, const char* name );
+
+/// Read the next capture from `reader`
+///
+/// @return `true` if a capture was read.  `false` at the end of the stream.
+bool capture_read( struct capture_reader* reader, struct sgx_capture* cap );
+
+/// Read the first capture in the file `fileName` (`-` is stdin)
+///
+/// @return `true` if a capture was read
+bool capture_load( const char* fileName, struct sgx_capture* cap );
+
+/// Find a CPUID leaf/sub-leaf in a capture
+///
+/// @return A pointer to the record or `NULL` if it was not captured
+const struct cpuid_record* capture_find_cpuid( const struct sgx_capture* cap, uint32_t leaf, uint32_t subleaf );
+
+/// Execute CPUID again for a `leaf`/`subleaf` that `cap` holds.  Don't call
+/// this while `cpuid_use_capture( cap )` is in effect.
+void capture_refresh_cpuid( struct sgx_capture* cap, uint32_t leaf, uint32_t subleaf );
+
+/// Return `true` if `reg` is one of the MSRs a capture reads
+bool capture_probes_msr( uint32_t reg );
+
+/// Find an MSR in a capture
+///
+/// @return `true` if the MSR was captured
+bool capture_find_msr( const struct sgx_capture* cap, uint32_t reg, uint64_t* pData );
+
+/// Return the total size of all of the EPC sections in a capture
+uint64_t capture_total_EPC( const struct sgx_capture* cap );
+
+/// A 64-bit FNV-1a hash over all of the CPUID records in a capture
+uint64_t capture_cpuid_hash( const struct sgx_capture* cap );
+
+/// Return `true` if two captures have identical CPUID records
+bool capture_cpuid_equal( const struct sgx_capture* a, const struct sgx_capture* b );
+
+/// `--capture [FILE] [NODE]`:  Write a capture of this node to FILE (or stdout)
+int capture_main( int argc, char* argv[] );
@@ -0,0 +1,325 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cgroup.c - 2026
+//
+/// This module reports how the cgroup v2 misc controller accounts EPC to
+/// each cgroup (container).
+///
+/// Newer kernels charge EPC pages to the `sgx_epc` key of the misc
+/// controller:
+///
+///   - `misc.capacity` (root only):  The EPC the kernel manages, in bytes
+///   - `misc.current`:  EPC charged to the cgroup and its descendants
+///   - `misc.max` (not on root):  The limit, or `max` for no limit
+///   - `misc.events` (not on root):  `sgx_epc.max` counts how often the
+///     cgroup hit its limit.  Each hit makes the kernel reclaim (page out)
+///     EPC from the cgroup, which is slow.
+///
+/// A cgroup can never use more than the smallest limit of it and its
+/// ancestors, so this reports that *effective* limit too.  The capacity is
+/// cross-checked against the EPC sections enumerated by CPUID, and the sum
+/// of the limits against the capacity, to show how densely enclave
+/// containers are packed.
+///
+/// Usage:
+///
+///     test-sgx --epc-cgroup                          # Walk /sys/fs/cgroup
+///     test-sgx --epc-cgroup --root /tmp/fake-cgroup  # Walk a copy of a cgroup tree
+///     test-sgx --epc-cgroup --from host17.cap        # Cross-check against a captured host
+///
+/// @see https://docs.kernel.org/admin-guide/cgroup-v2.html#misc
+///
+/// @file   cgroup.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `scandir()` and `alphasort()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>     // For printf() fopen() fgets()
+#include <stdlib.h>    // For free()
+#include <string.h>    // For strcmp() strlen()
+#include <inttypes.h>  // For PRIu64 uint64_t
+
+#ifdef __linux__
+   #include <dirent.h>    // For scandir() alphasort()
+   #include <limits.h>    // For PATH_MAX
+   #include <sys/stat.h>  // For stat() S_ISDIR
+#endif
+
+#include "cgroup.h"    // For obvious reasons
+#include "capture.h"   // For capture_load() capture_total_EPC()
+#include "cache.h"     // For cache_probe()
+#include "decode.h"    // For fields[] field_from_capture()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The default cgroup v2 mount point
+#define DEFAULT_CGROUP_ROOT "/sys/fs/cgroup"
+
+/// The misc controller's key for EPC
+#define EPC_KEY "sgx_epc"
+
+/// Flag a cgroup when it's using this much of its effective limit
+#define NEAR_LIMIT_PERCENT 90
+
+/// Stop walking at this depth, in case of a loop
+#define MAX_CGROUP_DEPTH 32
+
+/// No limit
+#define UNLIMITED UINT64_MAX
+
+#define MiB ((uint64_t) 1 << 20)
+
+
+#ifdef __linux__  // Cgroups are Linux's
+
+/// The EPC accounting of one cgroup
+struct epc_usage {
+   uint64_t current;    ///< Bytes charged to this cgroup and its descendants
+   uint64_t max;        ///< Its own limit, or UNLIMITED
+   uint64_t effective;  ///< The smallest limit of it and its ancestors
+   uint64_t events;     ///< How many times it hit its limit
+};
+
+
+/// Totals over the whole hierarchy
+struct epc_totals {
+   unsigned cgroups;       ///< Cgroups with EPC accounting
+   unsigned limited;       ///< ...that have their own limit
+   unsigned at_limit;      ///< ...that have hit their limit
+   uint64_t sum_of_limits; ///< Of the top-most limited cgroups
+   uint64_t events;
+};
+
+
+/// Read the `sgx_epc` value from a flat-keyed misc file like `misc.current`.
+/// `misc.events` uses `sgx_epc.max` as its key, so that is matched too.
+///
+/// @return `false` if the file doesn't exist or doesn't have the key
+bool cgroup_read_epc( const char* dir, const char* file, uint64_t* pValue ) {
+   char path[PATH_MAX];
+   char line[256];
+   bool found = false;
+
+   snprintf( path, sizeof( path ), "%s/%s", dir, file );
+
+   FILE* f = fopen( path, "r" );
+   if( f == NULL ) {
+      return false;
+   }
+
+   while( !found && fgets( line, sizeof( line ), f ) != NULL ) {
+      char key[64];
+      char value[32];
+
+      if( sscanf( line, "%63s %31s", key, value ) != 2 ) {
+         continue;
+      }
+      if( strcmp( key, EPC_KEY ) != 0 && strcmp( key, EPC_KEY ".max" ) != 0 ) {
+         continue;
+      }
+
+      if( strcmp( value, "max" ) == 0 ) {
+         *pValue = UNLIMITED;
+      } else if( sscanf( value, "%" SCNu64, pValue ) != 1 ) {
+         fprintf( stderr, "epc-cgroup: Unable to parse [%s] in [%s]\n", value, path );
+         break;
+      }
+      found = true;
+   }
+
+   fclose( f );
+   return found;
+}
+
+
+/// Format a byte count (or UNLIMITED) in MiB
+static const char* format_MiB( uint64_t bytes, char* out, size_t size ) {
+   if( bytes == UNLIMITED ) {
+      snprintf( out, size, "max" );
+   } else {
+      snprintf( out, size, "%.1f MiB", (double) bytes / MiB );
+   }
+   return out;
+}
+
+
+/// Print one cgroup's row
+static void print_usage( const char* name, const struct epc_usage* usage ) {
+   char current[32];
+   char max[32];
+   char effective[32];
+   const char* note = "";
+
+   if( usage->events > 0 ) {
+      note = "hit its limit (paged)";
+   } else if( usage->effective != UNLIMITED && usage->current * 100 >= usage->effective * NEAR_LIMIT_PERCENT ) {
+      note = "near its limit";
+   }
+
+   printf( "    %-40s %12s %12s %12s %10" PRIu64 "%s%s\n"
+          ,name
+          ,format_MiB( usage->current, current, sizeof( current ) )
+          ,format_MiB( usage->max, max, sizeof( max ) )
+          ,format_MiB( usage->effective, effective, sizeof( effective ) )
+          ,usage->events
+          ,note[0] != '\0' ? "  " : ""
+          ,note );
+}
+
+
+/// Walk the cgroup at `path` and everything below it.  `rootLength` is the
+/// length of the root's path, so names print relative to the root.
+///
+/// @param parentLimit The effective limit of the parent cgroup
+/// @param limitCounted `true` if an ancestor's limit is already in the sum of limits
+static void walk_cgroup( char* path, size_t rootLength, int depth, uint64_t parentLimit
+                        ,bool limitCounted, bool all, struct epc_totals* totals ) {
+   struct epc_usage usage = { 0, UNLIMITED, parentLimit, 0 };
+
+   // If the misc controller isn't enabled here, it isn't enabled below here
+   // either.  Older kernels don't have misc.current on the root.
+   if( !cgroup_read_epc( path, "misc.current", &usage.current ) && depth > 0 ) {
+      return;
+   }
+
+   if( depth > 0 ) {
+      cgroup_read_epc( path, "misc.max", &usage.max );
+      cgroup_read_epc( path, "misc.events", &usage.events );
+   }
+   if( usage.max < usage.effective ) {
+      usage.effective = usage.max;
+   }
+
+   totals->cgroups++;
+   totals->events += usage.events;
+   if( usage.max != UNLIMITED ) {
+      totals->limited++;
+      if( !limitCounted ) {
+         totals->sum_of_limits += usage.max;
+         limitCounted = true;
+      }
+   }
+   if( usage.events > 0 ) {
+      totals->at_limit++;
+   }
+
+   if( all || depth == 0 || usage.current > 0 || usage.max != UNLIMITED || usage.events > 0 ) {
+      print_usage( path[rootLength] == '\0' ? "/" : path + rootLength, &usage );
+   }
+
+   if( depth >= MAX_CGROUP_DEPTH ) {
+      return;
+   }
+
+   struct dirent** entries = NULL;
+   int count = scandir( path, &entries, NULL, alphasort );  // Sorted, so the report is stable
+   size_t length = strlen( path );
+
+   for( int i = 0 ; i < count ; i++ ) {
+      const char* name = entries[i]->d_name;
+      struct stat st;
+
+      if( strcmp( name, "." ) != 0 && strcmp( name, ".." ) != 0
+       && length + 1 + strlen( name ) < PATH_MAX ) {
+         snprintf( path + length, PATH_MAX - length, "/%s", name );
+         if( stat( path, &st ) == 0 && S_ISDIR( st.st_mode ) ) {
+            walk_cgroup( path, rootLength, depth + 1, usage.effective, limitCounted, all, totals );
+         }
+         path[length] = '\0';
+      }
+      free( entries[i] );
+   }
+   free( entries );
+}
+
+
+#endif  // __linux__
+
+
+/// `--epc-cgroup [--root DIR] [--from CAPTURE] [--all]`
+int cgroup_main( int argc, char* argv[] ) {
+   const char* root = DEFAULT_CGROUP_ROOT;
+   const char* fromFile = NULL;
+   bool all = false;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--root" ) == 0 && i + 1 < argc ) {
+         root = argv[++i];
+      } else if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( strcmp( argv[i], "--all" ) == 0 ) {
+         all = true;
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --epc-cgroup [--root DIR] [--from CAPTURE] [--all]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+
+   #ifdef __linux__
+      static struct sgx_capture cap;  // Too big for the stack
+
+      if( fromFile != NULL ) {
+         if( !capture_load( fromFile, &cap ) ) {
+            return EXIT_FAILURE;
+         }
+      } else {
+         cache_probe( &cap, false );
+      }
+
+      uint64_t sgx = 0;
+      field_from_capture( &fields[FIELD_SGX], &cap, &sgx );
+      uint64_t enumerated = sgx ? capture_total_EPC( &cap ) : 0;
+
+      char text[32];
+      printf( "EPC cgroups (misc controller) under %s\n", root );
+
+      uint64_t capacity = 0;
+      if( !cgroup_read_epc( root, "misc.capacity", &capacity ) ) {
+         printf( "  The kernel doesn't account EPC in the misc controller (no " EPC_KEY " in %s/misc.capacity)\n", root );
+         printf( "  EPC enumerated by CPUID: %s\n", format_MiB( enumerated, text, sizeof( text ) ) );
+         return EXIT_FAILURE;
+      }
+
+      printf( "  EPC capacity (misc.capacity): %s\n", format_MiB( capacity, text, sizeof( text ) ) );
+      printf( "  EPC enumerated by CPUID:      %s", format_MiB( enumerated, text, sizeof( text ) ) );
+      if( !sgx ) {
+         printf( "  (this CPU does not support SGX)\n" );
+      } else if( capacity == enumerated ) {
+         printf( "  (matches)\n" );
+      } else {
+         printf( "  (MISMATCH:  the kernel manages %s %s than CPUID enumerates)\n"
+                ,format_MiB( capacity > enumerated ? capacity - enumerated : enumerated - capacity, text, sizeof( text ) )
+                ,capacity > enumerated ? "more" : "less" );
+      }
+
+      printf( "    %-40s %12s %12s %12s %10s\n", "Cgroup", "Current", "Max", "Effective", "Limit hits" );
+      printf( "    %-40s %12s %12s %12s %10s\n", "========================================", "============", "============", "============", "==========" );
+
+      char path[PATH_MAX];
+      struct epc_totals totals = { 0, 0, 0, 0, 0 };
+
+      snprintf( path, sizeof( path ), "%s", root );
+      walk_cgroup( path, strlen( path ), 0, UNLIMITED, false, all, &totals );
+
+      printf( "  %u cgroups account EPC, %u have a limit and %u hit it (%" PRIu64 " limit hits)\n"
+             ,totals.cgroups, totals.limited, totals.at_limit, totals.events );
+      if( totals.limited > 0 && capacity > 0 ) {
+         printf( "  Sum of the top-most limits: %s (%.0f%% of capacity)%s\n"
+                ,format_MiB( totals.sum_of_limits, text, sizeof( text ) )
+                ,100.0 * (double) totals.sum_of_limits / (double) capacity
+                ,totals.sum_of_limits > capacity ? ".  EPC is overcommitted, so expect paging when every container is busy." : "" );
+      }
+
+      return EXIT_SUCCESS;
+
+   #else
+      (void) root;
+      (void) fromFile;
+      (void) all;
+      printf( "EPC cgroups need Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
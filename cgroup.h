@@ -0,0 +1,27 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cgroup.h - 2026
+//
+/// This module reports how the cgroup v2 misc controller accounts EPC to
+/// each cgroup (container).
+///
+/// @file   cgroup.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdbool.h>  // For bool
+#include <stdint.h>   // For uint64_t
+
+
+/// `--epc-cgroup [--root DIR] [--from CAPTURE] [--all]`
+int cgroup_main( int argc, char* argv[] );
+
+#ifdef __linux__
+
+/// Read the `sgx_epc` value from a flat-keyed misc file like `misc.current`
+/// in the cgroup directory `dir`.  A value of `max` reads as `UINT64_MAX`.
+///
+/// @return `false` if the file doesn't exist or doesn't have the key
+bool cgroup_read_epc( const char* dir, const char* file, uint64_t* pValue );
+
+#endif  // __linux__
@@ -0,0 +1,485 @@
+///////////////////////////////////////////////////////////////////////////////
+//  clockpage.c - 2026
+//
+/// A reference "clock page":  An untrusted thread publishes the time in a
+/// seqlock-protected cache line that an enclave can read without exiting,
+/// and a benchmark of it against the vDSO's `clock_gettime()`.
+///
+/// An enclave can't call the vDSO (it's outside the enclave, and it reads
+/// the kernel's vvar page, which the enclave can't trust or even see), so
+/// the usual way to get the time is an ocall:  EEXIT, `clock_gettime()`,
+/// EENTER -- microseconds, for a call that takes 20 ns outside.  A clock
+/// page trades that for staleness:
+///
+///   - The updater thread reads CLOCK_MONOTONIC, CLOCK_REALTIME and the TSC
+///     `--rate` times a second and publishes them in one cache line.  `seq`
+///     is odd while it writes, like the kernel's own vDSO data.
+///   - A reader (the enclave) copies the line and retries if `seq` was odd
+///     or changed.  No locked instructions, no exits.  It's as old as the
+///     update period.
+///   - The page also publishes the TSC rate, so a reader that can run RDTSC
+///     (enclaves on SGX2 CPUs) can extrapolate from the last update, which
+///     is nearly as fresh as the vDSO.
+///
+/// The time is untrusted, of course -- the host can publish any time it
+/// likes -- exactly as it is with an ocall.
+///
+/// The benchmark measures, for the vDSO (fine & coarse clocks), the
+/// `clock_gettime` syscall and the clock page at each rate:
+///
+///   - Read:  The ns per call, back to back on the reader's CPU
+///   - Staleness:  How far behind a fresh CLOCK_MONOTONIC the time was (the
+///     median, 99th percentile & worst)
+///   - Updater CPU:  The share of its CPU the updater used, and the rate it
+///     actually kept up
+///
+/// Usage:
+///
+///     test-sgx --clock-page                      # 1, 10 & 100 kHz
+///     test-sgx --clock-page --cpus 2,3 --rate 5000 --reads 5000000
+///
+/// @file   clockpage.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sched_setaffinity()`, `CPU_SET()` and `syscall()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fprintf()
+#include <stdlib.h>    // For atol() atof() malloc() free() qsort()
+#include <string.h>    // For strcmp() memset()
+#include <inttypes.h>  // For uint64_t int64_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime() clock_nanosleep() clock_getres()
+
+#ifdef __linux__
+   #include <sched.h>          // For sched_setaffinity() sched_getaffinity() CPU_SET()
+   #include <pthread.h>        // For pthread_create() pthread_join()
+   #include <unistd.h>         // For syscall()
+   #include <sys/syscall.h>    // For SYS_clock_gettime
+   #include <sys/prctl.h>      // For prctl() PR_SET_TIMERSLACK
+#endif
+
+#include "clockpage.h" // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_online_cpus() topology_parse_cpulist() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// Calibrate the TSC rate over at least this many ns
+#define CALIBRATION_NS 10000000
+
+/// Reads per source, unless `--reads` says otherwise
+#define DEFAULT_READS 1000000
+
+/// At most this many staleness samples per source
+#define MAX_SAMPLES 100000
+
+#ifdef __linux__  // The page is made of POSIX clocks and read with GNU asm
+
+/// The rates to try, unless `--rate` says otherwise
+static const double defaultRates[] = { 1000, 10000, 100000 };
+
+
+/// @return The time stamp counter
+static inline uint64_t read_tsc( void ) {
+   uint32_t lo, hi;
+   __asm__ volatile ( "rdtsc" : "=a" (lo), "=d" (hi) );
+   return (uint64_t) hi << 32 | lo;
+}
+
+
+/// @return `clock`'s time in ns
+static int64_t clock_ns( clockid_t clock ) {
+   struct timespec now;
+   clock_gettime( clock, &now );
+   return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+
+/// Clear `page` before its first update
+void clock_page_init( struct clock_page* page ) {
+   memset( page, 0, sizeof( *page ) );
+}
+
+
+/// Publish the current time (and TSC) in `page`.  Only one thread may update
+/// a page.
+void clock_page_update( struct clock_page* page ) {
+   uint64_t before    = read_tsc();
+   int64_t  monotonic = clock_ns( CLOCK_MONOTONIC );
+   int64_t  realtime  = clock_ns( CLOCK_REALTIME );
+   uint64_t tsc       = before + (read_tsc() - before) / 2;  // About when the clocks were read
+   uint64_t nsPerTick = page->nsPerTick;
+
+   if( page->baseTsc == 0 ) {
+      page->baseTsc = tsc;
+      page->baseMonotonic = monotonic;
+   } else if( monotonic - page->baseMonotonic >= CALIBRATION_NS && tsc > page->baseTsc ) {
+      nsPerTick = (uint64_t) ((double) (monotonic - page->baseMonotonic) / (double) (tsc - page->baseTsc) * 4294967296.0);
+   }
+
+   uint32_t seq = page->seq;
+   __atomic_store_n( &page->seq, seq + 1, __ATOMIC_RELAXED );  // Odd:  Writing
+   __atomic_thread_fence( __ATOMIC_RELEASE );
+   __atomic_store_n( &page->tsc,       tsc,       __ATOMIC_RELAXED );
+   __atomic_store_n( &page->monotonic, monotonic, __ATOMIC_RELAXED );
+   __atomic_store_n( &page->realtime,  realtime,  __ATOMIC_RELAXED );
+   __atomic_store_n( &page->nsPerTick, nsPerTick, __ATOMIC_RELAXED );
+   __atomic_store_n( &page->seq, seq + 2, __ATOMIC_RELEASE );  // Even:  Done
+}
+
+
+/// Copy the page, retrying while it's being updated
+void clock_page_read( const struct clock_page* page, struct clock_sample* sample ) {
+   uint32_t seq;
+
+   do {
+      seq = __atomic_load_n( &page->seq, __ATOMIC_ACQUIRE );
+      if( seq & 1 ) {
+         __asm__ volatile ( "pause" ::: "memory" );
+         continue;
+      }
+      sample->tsc       = __atomic_load_n( &page->tsc,       __ATOMIC_RELAXED );
+      sample->monotonic = __atomic_load_n( &page->monotonic, __ATOMIC_RELAXED );
+      sample->realtime  = __atomic_load_n( &page->realtime,  __ATOMIC_RELAXED );
+      sample->nsPerTick = __atomic_load_n( &page->nsPerTick, __ATOMIC_RELAXED );
+      __atomic_thread_fence( __ATOMIC_ACQUIRE );
+   } while( (seq & 1) || __atomic_load_n( &page->seq, __ATOMIC_RELAXED ) != seq );
+}
+
+
+/// @return CLOCK_MONOTONIC (ns) at `tsc`, extrapolated from the page with
+///         its TSC rate.  Just the page's time if it isn't calibrated yet.
+int64_t clock_page_monotonic_at( const struct clock_page* page, uint64_t tsc ) {
+   struct clock_sample sample;
+
+   clock_page_read( page, &sample );
+   uint64_t ticks = tsc > sample.tsc ? tsc - sample.tsc : 0;  // Another CPU's TSC may be a hair behind
+
+   // ticks * nsPerTick >> 32, without overflowing 64 bits
+   uint64_t ns = (ticks >> 32) * sample.nsPerTick + (((ticks & 0xFFFFFFFF) * (sample.nsPerTick & 0xFFFFFFFF)) >> 32)
+                                                  + (ticks & 0xFFFFFFFF) * (sample.nsPerTick >> 32);
+   return sample.monotonic + (int64_t) ns;
+}
+
+
+/// @return The CPU time (seconds) the calling thread has used
+static double thread_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Pin the calling thread to `cpu`
+static void pin_to( int cpu ) {
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   sched_setaffinity( 0, sizeof( set ), &set );
+}
+
+
+/// The updater:  Update the page every `period` until told to stop.  It
+/// sleeps to absolute times, so the rate doesn't drift, and skips ahead if
+/// it falls behind.
+static void* updater_main( void* arg ) {
+   struct clock_updater* u = arg;
+   struct timespec next;
+
+   if( u->cpu >= 0 ) {
+      pin_to( u->cpu );
+   }
+   prctl( PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL );  // Wake on time, not up to 50 us late
+
+   double  startCPU = thread_seconds();
+   int64_t start = clock_ns( CLOCK_MONOTONIC );
+   int64_t periodNs = (int64_t) (u->period * 1e9);
+   int64_t due = start;
+
+   while( !__atomic_load_n( &u->stop, __ATOMIC_ACQUIRE ) ) {
+      clock_page_update( u->page );
+      u->updates++;
+
+      due += periodNs;
+      int64_t now = clock_ns( CLOCK_MONOTONIC );
+      due = due < now ? now : due;
+      next.tv_sec  = due / 1000000000;
+      next.tv_nsec = due % 1000000000;
+      clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+   }
+   u->cpuSeconds = thread_seconds() - startCPU;
+   u->seconds = (double) (clock_ns( CLOCK_MONOTONIC ) - start) / 1e9;
+   return NULL;
+}
+
+
+/// Start a thread that updates `page` `hz` times a second, pinned to `cpu`
+/// (`-1` for anywhere)
+///
+/// @return `false` if the thread couldn't be started
+bool clock_page_start( struct clock_updater* updater, struct clock_page* page, double hz, int cpu ) {
+   memset( updater, 0, sizeof( *updater ) );
+   updater->page = page;
+   updater->period = 1 / hz;
+   updater->cpu = cpu;
+
+   clock_page_update( page );  // Readers never see an empty page
+   return hz > 0 && pthread_create( &updater->thread, NULL, updater_main, updater ) == 0;
+}
+
+
+/// Stop the updater and fill in what it did
+void clock_page_stop( struct clock_updater* updater ) {
+   __atomic_store_n( &updater->stop, 1, __ATOMIC_RELEASE );
+   pthread_join( updater->thread, NULL );
+}
+
+
+static int compare_doubles( const void* left, const void* right ) {
+   double l = *(const double*) left;
+   double r = *(const double*) right;
+   return (l > r) - (l < r);
+}
+
+
+/// One row of the benchmark
+struct result {
+   double readNs;
+   double staleMedianUs;  ///< Staleness (or extrapolation error)
+   double staleP99Us;
+   double staleMaxUs;
+};
+
+
+/// Sort `count` staleness samples (ns) into `result` (us)
+static void summarize( double* stale, size_t count, struct result* result ) {
+   qsort( stale, count, sizeof( double ), compare_doubles );
+   result->staleMedianUs = stale[count / 2] / 1e3;
+   result->staleP99Us = stale[count * 99 / 100] / 1e3;
+   result->staleMaxUs = stale[count - 1] / 1e3;
+}
+
+
+/// Time `reads` calls of `clock_gettime( clock )`, and how far behind
+/// CLOCK_MONOTONIC it is
+static void measure_clock( clockid_t clock, uint64_t reads, double* stale, size_t samples, struct result* result ) {
+   struct timespec ts;
+
+   int64_t start = clock_ns( CLOCK_MONOTONIC );
+   for( uint64_t i = 0 ; i < reads ; i++ ) {
+      clock_gettime( clock, &ts );
+   }
+   result->readNs = (double) (clock_ns( CLOCK_MONOTONIC ) - start) / (double) reads;
+
+   for( size_t s = 0 ; s < samples ; s++ ) {
+      int64_t then = clock_ns( clock );
+      int64_t now = clock_ns( CLOCK_MONOTONIC );
+      stale[s] = clock == CLOCK_MONOTONIC ? 0 : (double) (now - then);
+   }
+   summarize( stale, samples, result );
+}
+
+
+/// Time `reads` `clock_gettime` syscalls (what an ocall does once it's out)
+static void measure_syscall( uint64_t reads, struct result* result ) {
+   struct timespec ts;
+
+   int64_t start = clock_ns( CLOCK_MONOTONIC );
+   for( uint64_t i = 0 ; i < reads ; i++ ) {
+      syscall( SYS_clock_gettime, CLOCK_MONOTONIC, &ts );
+   }
+   result->readNs = (double) (clock_ns( CLOCK_MONOTONIC ) - start) / (double) reads;
+}
+
+
+/// Read the page `reads` times and measure its staleness, with and without
+/// TSC extrapolation
+static void measure_page( const struct clock_page* page, uint64_t reads, double* stale, size_t samples, struct result* plain, struct result* extrapolated ) {
+   struct clock_sample sample;
+   volatile int64_t sink = 0;
+
+   int64_t start = clock_ns( CLOCK_MONOTONIC );
+   for( uint64_t i = 0 ; i < reads ; i++ ) {
+      clock_page_read( page, &sample );
+      sink += sample.monotonic;
+   }
+   plain->readNs = (double) (clock_ns( CLOCK_MONOTONIC ) - start) / (double) reads;
+
+   start = clock_ns( CLOCK_MONOTONIC );
+   for( uint64_t i = 0 ; i < reads ; i++ ) {
+      sink += clock_page_monotonic_at( page, read_tsc() );
+   }
+   extrapolated->readNs = (double) (clock_ns( CLOCK_MONOTONIC ) - start) / (double) reads;
+
+   for( size_t s = 0 ; s < samples ; s++ ) {
+      clock_page_read( page, &sample );
+      stale[s] = (double) (clock_ns( CLOCK_MONOTONIC ) - sample.monotonic);
+   }
+   summarize( stale, samples, plain );
+
+   for( size_t s = 0 ; s < samples ; s++ ) {
+      int64_t estimate = clock_page_monotonic_at( page, read_tsc() );
+      int64_t error = clock_ns( CLOCK_MONOTONIC ) - estimate;
+      stale[s] = (double) (error < 0 ? -error : error);
+   }
+   summarize( stale, samples, extrapolated );
+}
+
+
+/// Print a row of the table
+static void print_result( const char* source, const struct result* result, const char* updater ) {
+   printf( "    %-36s  %7.1f  %8.2f  %8.2f  %8.2f%s%s\n", source, result->readNs, result->staleMedianUs, result->staleP99Us, result->staleMaxUs
+          ,updater[0] != '\0' ? "  " : "", updater );
+}
+
+#endif
+
+
+/// `--clock-page [--cpus A,B] [--rate HZ] [--reads N]`
+int clockpage_main( int argc, char* argv[] ) {
+   const char* cpuList = NULL;
+   double rate = 0;
+   long reads = DEFAULT_READS;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--cpus" ) == 0 && i + 1 < argc ) {
+         cpuList = argv[++i];
+      } else if( strcmp( argv[i], "--rate" ) == 0 && i + 1 < argc ) {
+         rate = atof( argv[++i] );
+         if( rate <= 0 ) {
+            fprintf( stderr, "clock-page: The rate must be positive\n" );
+            return EXIT_FAILURE;
+         }
+      } else if( strcmp( argv[i], "--reads" ) == 0 && i + 1 < argc ) {
+         reads = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --clock-page [--cpus A,B] [--rate HZ] [--reads N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( reads <= 0 ) {
+      fprintf( stderr, "clock-page: The number of reads must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static int cpus[MAX_CPUS];
+      cpu_set_t allowed;
+      int count = 0;
+
+      if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) {
+         fprintf( stderr, "clock-page: Unable to read this process's CPU affinity\n" );
+         return EXIT_FAILURE;
+      }
+      if( cpuList != NULL ) {
+         count = topology_parse_cpulist( cpuList, cpus, MAX_CPUS );
+         if( count != 2 ) {
+            fprintf( stderr, "clock-page: --cpus takes the reader's and the updater's CPU, like 2,3\n" );
+            return EXIT_FAILURE;
+         }
+         for( int i = 0 ; i < count ; i++ ) {
+            if( cpus[i] >= CPU_SETSIZE || !CPU_ISSET( cpus[i], &allowed ) ) {
+               fprintf( stderr, "clock-page: CPU %d isn't online or available to this process\n", cpus[i] );
+               return EXIT_FAILURE;
+            }
+         }
+      } else {
+         int online = topology_online_cpus( cpus, MAX_CPUS );
+         for( int i = 0 ; i < online && count < 2 ; i++ ) {
+            if( cpus[i] < CPU_SETSIZE && CPU_ISSET( cpus[i], &allowed ) ) {
+               cpus[count++] = cpus[i];
+            }
+         }
+         if( count == 1 ) {
+            cpus[1] = cpus[0];  // The updater sleeps, so it can share
+         }
+      }
+
+      size_t samples = (size_t) reads / 10 < MAX_SAMPLES ? (size_t) reads / 10 + 1 : MAX_SAMPLES;
+      double* stale = malloc( samples * sizeof( double ) );
+      static struct clock_page page;
+      if( stale == NULL ) {
+         fprintf( stderr, "clock-page: Out of memory\n" );
+         return EXIT_FAILURE;
+      }
+
+      pin_to( cpus[0] );
+      printf( "Exitless clock page vs. vDSO:  Reader on CPU %d, updater on CPU %d%s\n", cpus[0], cpus[1]
+             ,cpus[0] == cpus[1] ? " (the same CPU -- the page is staler)" : "" );
+      printf( "                                             Read  Staleness or error (us)\n" );
+      printf( "    Source                                     ns    median       p99     worst  Updater CPU (actual rate)\n" );
+      printf( "    ====================================  =======  ========  ========  ========  =========================\n" );
+
+      struct result result;
+      struct result extrapolated;
+      struct timespec resolution = { 0, 0 };
+      memset( &result, 0, sizeof( result ) );
+      measure_clock( CLOCK_MONOTONIC, (uint64_t) reads, stale, samples, &result );
+      print_result( "vDSO CLOCK_MONOTONIC", &result, "-" );
+      double vdsoNs = result.readNs;
+
+      clock_getres( CLOCK_MONOTONIC_COARSE, &resolution );
+      measure_clock( CLOCK_MONOTONIC_COARSE, (uint64_t) reads, stale, samples, &result );
+      char label[64];
+      snprintf( label, sizeof( label ), "vDSO CLOCK_MONOTONIC_COARSE (%.0f ms)", (double) resolution.tv_nsec / 1e6 + (double) resolution.tv_sec * 1e3 );
+      print_result( label, &result, "-" );
+
+      memset( &result, 0, sizeof( result ) );
+      measure_syscall( (uint64_t) reads / 10 + 1, &result );
+      print_result( "clock_gettime syscall", &result, "-" );
+
+      for( size_t r = 0 ; r < sizeof( defaultRates ) / sizeof( defaultRates[0] ) ; r++ ) {
+         double hz = rate > 0 ? rate : defaultRates[r];
+         struct clock_updater updater;
+
+         clock_page_init( &page );
+         if( !clock_page_start( &updater, &page, hz, cpus[1] ) ) {
+            fprintf( stderr, "clock-page: Unable to start the updater\n" );
+            free( stale );
+            return EXIT_FAILURE;
+         }
+         struct timespec settle = { 0, 2 * CALIBRATION_NS };  // Let it calibrate the TSC rate
+         nanosleep( &settle, NULL );
+         measure_page( &page, (uint64_t) reads, stale, samples, &result, &extrapolated );
+         clock_page_stop( &updater );
+
+         char cost[64];
+         snprintf( cost, sizeof( cost ), "%5.1f%% (%.0f Hz)", updater.seconds > 0 ? updater.cpuSeconds / updater.seconds * 100 : 0
+                  ,updater.seconds > 0 ? (double) updater.updates / updater.seconds : 0 );
+         snprintf( label, sizeof( label ), "Clock page at %.0f Hz", hz );
+         print_result( label, &result, cost );
+         print_result( "  + TSC extrapolation", &extrapolated, "" );
+         if( rate > 0 ) {
+            break;
+         }
+      }
+      free( stale );
+
+      // RDTSC is only legal in an enclave on SGX2 CPUs
+      uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+      bool sgx2 = false;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      if( eax >= 0x12 ) {
+         eax = 0x12; ebx = 0; ecx = 0; edx = 0;
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+         sgx2 = field_from_regs( &fields[FIELD_SGX2], eax, ebx, ecx, edx ) != 0;
+      }
+
+      printf( "  An ocall for the time adds EEXIT & EENTER (microseconds with the mitigations --\n" );
+      printf( "  see `--mitigations`) to the %.0f ns vDSO call.  Pick the slowest rate whose p99\n", vdsoNs );
+      printf( "  staleness the enclave can accept.\n" );
+      printf( "  TSC extrapolation needs RDTSC in the enclave:  %s\n", sgx2 ? "This CPU reports SGX2, so it can" : "Only SGX2 CPUs allow it, and this one doesn't report SGX2" );
+      return EXIT_SUCCESS;
+
+   #else
+      (void) cpuList;
+      (void) rate;
+      printf( "The clock page benchmark needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
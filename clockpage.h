@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+//  clockpage.h - 2026
+//
+/// A reference "clock page":  An untrusted thread publishes the time in a
+/// seqlock-protected cache line that an enclave can read without exiting,
+/// and a benchmark of it against the vDSO's `clock_gettime()`.
+///
+/// @file   clockpage.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdbool.h>  // For bool
+#include <stdint.h>   // For uint64_t int64_t uint32_t
+
+#ifdef __linux__  // The clock page is made of POSIX clocks and threads
+
+#include <pthread.h>  // For pthread_t
+
+
+/// The page:  One cache line, written only by the updater.  `seq` is odd
+/// while an update is in progress.
+struct clock_page {
+   _Alignas( 64 ) uint32_t seq;
+   uint32_t reserved;
+   uint64_t tsc;          ///< The TSC when the times were read
+   int64_t  monotonic;    ///< CLOCK_MONOTONIC (ns)
+   int64_t  realtime;     ///< CLOCK_REALTIME (ns since the epoch)
+   uint64_t nsPerTick;    ///< ns per TSC tick in 32.32 fixed point.  `0` until it's calibrated.
+   uint64_t baseTsc;      ///< Where the calibration started (only the updater reads these)
+   int64_t  baseMonotonic;
+};
+
+/// A consistent copy of the page
+struct clock_sample {
+   uint64_t tsc;
+   int64_t  monotonic;
+   int64_t  realtime;
+   uint64_t nsPerTick;
+};
+
+/// The thread that keeps a page up to date
+struct clock_updater {
+   struct clock_page* page;
+   double             period;      ///< Seconds between updates
+   int                cpu;         ///< Where it runs, or `-1` for anywhere
+   uint32_t           stop;        ///< Set by `clock_page_stop()`
+   uint64_t           updates;     ///< How many it made
+   double             cpuSeconds;  ///< The CPU time it used
+   double             seconds;     ///< How long it ran
+   pthread_t          thread;
+};
+
+
+/// Clear `page` before its first update
+void clock_page_init( struct clock_page* page );
+
+/// Publish the current time (and TSC) in `page`.  Only one thread may update
+/// a page.
+void clock_page_update( struct clock_page* page );
+
+/// Copy the page, retrying while it's being updated
+void clock_page_read( const struct clock_page* page, struct clock_sample* sample );
+
+/// @return CLOCK_MONOTONIC (ns) at `tsc`, extrapolated from the page with
+///         its TSC rate.  Just the page's time if it isn't calibrated yet.
+///         (An enclave can only read the TSC itself on SGX2 CPUs.)
+int64_t clock_page_monotonic_at( const struct clock_page* page, uint64_t tsc );
+
+/// Start a thread that updates `page` `hz` times a second, pinned to `cpu`
+/// (`-1` for anywhere)
+///
+/// @return `false` if the thread couldn't be started
+bool clock_page_start( struct clock_updater* updater, struct clock_page* page, double hz, int cpu );
+
+/// Stop the updater and fill in what it did
+void clock_page_stop( struct clock_updater* updater );
+
+#endif  // __linux__
+
+/// `--clock-page [--cpus A,B] [--rate HZ] [--reads N]`
+int clockpage_main( int argc, char* argv[] );
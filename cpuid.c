@@ -18,11 +18,19 @@
 #include "cpuid.h"     // For obvious reasons
 #include "test-sgx.h"  // For EXIT_ON_FAILURE
 #include "rdmsr.h"     // For TBD
+#include "decode.h"    // For fields[] field_from_regs() print_cpuid_fields()
+#include "capture.h"   // For capture_find_cpuid()
 
 
-// This number is kinda arbitrary.  Let us know if you ever find a situation
-// where we need to increase this.
-#define NUMBER_OF_EPCs_TO_ENUMERATE 16
+/// When set, `native_cpuid32()` answers from this capture (the probe cache)
+static const struct sgx_capture* cpuidCapture = NULL;
+
+
+/// Answer `native_cpuid32()` from `cap` for every leaf it holds.  Pass `NULL`
+/// to go back to executing CPUID.
+void cpuid_use_capture( const struct sgx_capture* cap ) {
+   cpuidCapture = cap;
+}
 
 
 /// Call `CPUID`, passing `eax`, `ebx`, `ecx` and `eax` in & out.
@@ -30,6 +38,17 @@ void native_cpuid32( uint32_t* eax
                     ,uint32_t* ebx
                     ,uint32_t* ecx
                     ,uint32_t* edx ) {
+   if( cpuidCapture != NULL ) {
+      const struct cpuid_record* r = capture_find_cpuid( cpuidCapture, *eax, *ecx );
+      if( r != NULL ) {
+         *eax = r->eax;
+         *ebx = r->ebx;
+         *ecx = r->ecx;
+         *edx = r->edx;
+         return;
+      }
+   }
+
 #if !defined( _MSC_VER )
    __asm volatile (
        "mov eax, %0;"
@@ -231,16 +250,15 @@ void supportsSGXInstructions( void ) {
    native_cpuid32( &eax, &ebx, &ecx, &edx );
    // print_registers32( eax, ebx, ecx, edx );
 
-   printf("  Stepping %-2d      ", eax & 0xF); // Bit 3-0
-   printf("  Model %-2d         ", (eax >> 4) & 0xF); // Bit 7-4
-   printf("  Family %-2d\n", (eax >> 8) & 0xF); // Bit 11-8
-   printf("  Processor type %-2d", (eax >> 12) & 0x3); // Bit 13-12
-   printf("  Extended model %-2d", (eax >> 16) & 0xF); // Bit 19-16
-   printf("  Extended family %-2d\n", (eax >> 20) & 0xFF); // Bit 27-20
+   printf("  Stepping %-2d      ", (int) field_from_regs( &fields[FIELD_STEPPING], eax, ebx, ecx, edx ) );
+   printf("  Model %-2d         ", (int) field_from_regs( &fields[FIELD_MODEL], eax, ebx, ecx, edx ) );
+   printf("  Family %-2d\n", (int) field_from_regs( &fields[FIELD_FAMILY], eax, ebx, ecx, edx ) );
+   printf("  Processor type %-2d", (int) field_from_regs( &fields[FIELD_PROCESSOR_TYPE], eax, ebx, ecx, edx ) );
+   printf("  Extended model %-2d", (int) field_from_regs( &fields[FIELD_EXTENDED_MODEL], eax, ebx, ecx, edx ) );
+   printf("  Extended family %-2d\n", (int) field_from_regs( &fields[FIELD_EXTENDED_FAMILY], eax, ebx, ecx, edx ) );
 
    // if smx set - SGX global enable is supported
-   int smxFlag = (ecx >> 6) & 1;  // CPUID.1:ECX.[bit6]
-   printf("Safer Mode Extensions (SMX): %d\n", smxFlag );
+   print_field( &fields[FIELD_SMX], field_from_regs( &fields[FIELD_SMX], eax, ebx, ecx, edx ) );
 
    eax = 7;  // Structured Extended Features leaf
    ebx = 0;
@@ -251,18 +269,13 @@ void supportsSGXInstructions( void ) {
    printf( "Extended feature bits (EAX=7, ECX=0): " );
    print_registers32( eax, ebx, ecx, edx );
 
-   int sgxFeature = (ebx >> 2) & 1;  // (EAX=7, ECX=0):EBX[2]
-   if( !sgxFeature ) {
+   if( !field_from_regs( &fields[FIELD_SGX], eax, ebx, ecx, edx ) ) {
       printf( "Does not support SGX\n" );
       EXIT_ON_FAILURE;
    }
    printf( "Supports SGX\n" );
 
-   int sgxLaunchConfig = (ecx >> 30) & 1;  // (EAX=7, ECX=0):ECX[30]
-   printf( "SGX Launch Configuration (SGX_LC): %d\n", sgxLaunchConfig );
-
-   int sgxAttestationServices = (edx >> 1) & 1; // (EAX=7, ECX=0H):EDX[1]
-   printf( "SGX Attestation Services (SGX_KEYS): %d\n", sgxAttestationServices );
+   print_cpuid_fields( GROUP_SGX, 0x07, 0, eax, ebx, ecx, edx );
 
 
    eax = 0x12;  // SGX Capability Enumeration Leaf
@@ -281,34 +294,11 @@ void supportsSGXInstructions( void ) {
     * the Intel Docs Architectures-software-developer-system-programming-manual - 35.1 Architectural MSRS
     */
 
-   int sgx1 = (eax & 1);  // (EAX=12H, ECX=0H):EAX[0]
-   printf( "SGX1 leaf instructions (SGX1): %d\n", sgx1 );
-
-   int sgx2 = (eax >> 1) & 1; // (EAX=12H, ECX=0H):EAX[1]
-   printf( "SGX2 leaf instructions (SGX2): %d\n", sgx2 );
-
-   int sgxOversubscription1 = (eax >> 5) & 1; // (EAX=12H, ECX=0H):EAX[5]
-   printf( "EINCVIRTCHILD, EDECVIRTCHILD, and ESETCONTEXT (OVERSUB-VMX): %d\n", sgxOversubscription1 );
+   print_cpuid_fields( GROUP_SGX, 0x12, 0, eax, ebx, ecx, edx );
 
-   int sgxOversubscription2 = (eax >> 6) & 1; // (EAX=12H, ECX=0H):EAX[6]
-   printf( "ETRACKC, ERDINFO, ELDBC, and ELDUC (OVERSUB-Supervisor): %d\n", sgxOversubscription2 );
-
-   int sgxEVERIFYREPORT2 = (eax >> 7) & 1; // (EAX=12H, ECX=0H):EAX[7]
-   printf( "EVERIFYREPORT2: %d\n", sgxEVERIFYREPORT2 );
-
-   int sgxEUPDATESVN = (eax >> 10) & 1; // (EAX=12H, ECX=0H):EAX[10]
-   printf( "Allow attestation w/ updated microcode (EUPDATESVN): %d\n", sgxEUPDATESVN );
-
-   int sgxEDECCSSA = (eax >> 11) & 1; // (EAX=12H, ECX=0H):EAX[11]
-   printf( "Allow enclave thread to decrement TCS.CSSA (EDECCSSA): %d\n", sgxEDECCSSA );
-
-   printf( "Supported Extended features for MISC region of SSA (MISCSELECT) 0x%08" PRIx32 "\n", ebx );
-
-   uint32_t maxNon64bitEnclaveBase= edx & 0xFF;
-   printf( "The maximum supported enclave size in non-64-bit mode is 2^%" PRIu32 "\n", maxNon64bitEnclaveBase );
-
-   uint32_t max64bitEnclaveBase= (edx & 0xFF00) >> 8;
-   printf( "The maximum supported enclave size in     64-bit mode is 2^%" PRIu32 "\n", max64bitEnclaveBase );
+   printf( "%s 0x%08" PRIx32 "\n", fields[FIELD_MISCSELECT].description, (uint32_t) field_from_regs( &fields[FIELD_MISCSELECT], eax, ebx, ecx, edx ) );
+   printf( "%s%" PRIu64 "\n", fields[FIELD_MAX_ENCLAVE_SIZE_32].description, field_from_regs( &fields[FIELD_MAX_ENCLAVE_SIZE_32], eax, ebx, ecx, edx ) );
+   printf( "%s%" PRIu64 "\n", fields[FIELD_MAX_ENCLAVE_SIZE_64].description, field_from_regs( &fields[FIELD_MAX_ENCLAVE_SIZE_64], eax, ebx, ecx, edx ) );
 
 
    eax = 0x12;  // SGX Attributes Enumeration Leaf
@@ -321,26 +311,62 @@ void supportsSGXInstructions( void ) {
 
    printf( "Raw ECREATE SECS.ATTRIBUTES[63:0]: %08" PRIx32 " %08" PRIx32 "\n", ebx, eax );
 
-   printf( "    ECREATE SECS.ATTRIBUTES[DEBUG] (Debugger can read/write enclave data w/ EDBGRD/EDBGWR): %d\n", (eax >> 1) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[MODE64BIT] (Enclave can run as 64-bit): %d\n", (eax >> 2) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[PROVISIONKEY] (Provisioning key available from EGETKEY): %d\n", (eax >> 4) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[EINITTOKEN_KEY] (EINIT token key available from EGETKEY): %d\n",(eax >> 5) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[CET] (Enable Control-flow Enforcement Technology in enclave): %d\n",(eax >> 6) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[KSS] (Key Separation and Sharing Enabled): %d\n",(eax >> 7) & 1 );
-   printf( "    ECREATE SECS.ATTRIBUTES[AEXNOTIFY] (Threads may receive AEX notifications): %d\n",(eax >> 10) & 1 );
+   print_cpuid_fields( GROUP_SECS, 0x12, 1, eax, ebx, ecx, edx );
 
    printf( "Raw ECREATE SECS.ATTRIBUTES[127:64] (XFRM: Copy of XCR0): %08" PRIx32 " %08" PRIx32 "\n", edx, ecx );
 
 }
 
 
-void enumerateEPCsections( void ) {
+/// Decode the registers returned by CPUID.(EAX=12H, ECX=n) into `section`.
+///
+/// This is shared by the live enumeration below and by anything that decodes
+/// saved captures, so both agree on what an EPC section looks like.
+///
+/// @return `true` if the sub-leaf describes a valid EPC section
+bool decode_EPC_section( uint32_t eax
+                        ,uint32_t ebx
+                        ,uint32_t ecx
+                        ,uint32_t edx
+                        ,struct epc_section* section ) {
+   uint64_t leafType = field_from_regs( &fields[FIELD_EPC_TYPE], eax, ebx, ecx, edx );
+
+   if( leafType != 1 ) {  // 0 is invalid, everything else is reserved
+      return false;
+   }
+
+   section->base = (eax & 0xFFFFF000) | ((ebx & (uint64_t) 0x000FFFFF) << 32);
+   section->size = (ecx & 0xFFFFF000) | ((edx & (uint64_t) 0x000FFFFF) << 32);
+   section->confidentiality = ' ';
+   section->integrity = ' ';
+
+   switch( ecx & 0x0F ) {
+      case 0x1:
+          section->confidentiality = 'c';
+          section->integrity = 'i';
+          break;
+      case 0x2:
+          section->confidentiality = 'c';
+          break;
+      default:
+          break;
+   }
+
+   return true;
+}
+
+
+/// Enumerate the EPC sections with CPUID.(EAX=12H, ECX=2+)
+///
+/// @return The number of sections in `sections`
+int find_EPC_sections( struct epc_section* sections, int max ) {
    uint32_t eax = 0;
    uint32_t ebx = 0;
    uint32_t edx = 0;
    uint32_t ecx = 0;
+   int      count = 0;
 
-   for( uint32_t i = 2 ; i <= NUMBER_OF_EPCs_TO_ENUMERATE ; i++ ) {
+   for( uint32_t i = 2 ; i <= NUMBER_OF_EPCs_TO_ENUMERATE && count < max ; i++ ) {
       eax = 0x12;  // SGX EPC Enumeration Leaf Leaf
       ebx = 0;
       ecx = i;     // Sub-leaf n (EPC number-ish)
@@ -349,38 +375,21 @@ void enumerateEPCsections( void ) {
       native_cpuid32( &eax, &ebx, &ecx, &edx );
       // print_registers32( eax, ebx, ecx, edx );
 
-      uint8_t leafType = eax & 0x0F;
-      uint64_t epcBasePhysAddr = 0;
-      uint64_t epcSectionSize = 0;
-      switch( leafType ) {
-         case 0:
-            if( eax == 0 && ebx == 0 && ecx == 0 && edx == 0 ) {
-               // printf( "0" );  // The leaf type is invalid and all the the values are as expected (zeroed out)
-            } else {
-               // printf( "!" );  // One of the registers has an unexpected value
-            }
-            break;
-         case 1:
-            // printf( "@" );  // The leaf is an EPC section
-            // printf( "\n" );
-
-            epcBasePhysAddr = (eax & 0xFFFFF000) | ((ebx & (uint64_t) 0x000FFFFF) << 32);
-            epcSectionSize  = (ecx & 0xFFFFF000) | ((edx & (uint64_t) 0x000FFFFF) << 32);
-
-            char confidentiality = ' ';
-            char integrity = ' ';
-
-            switch( ecx & 0x0F ) {
-               case 0x1:
-                   confidentiality = 'c';
-                   integrity = 'i';
-                   break;
-               case 0x2:
-                   confidentiality = 'c';
-                   break;
-               default:
-                   break;
-            }
+      if( decode_EPC_section( eax, ebx, ecx, edx, &sections[count] ) ) {
+         sections[count].subleaf = i;
+         count++;
+      }
+   }
+   return count;
+}
+
+
+void enumerateEPCsections( void ) {
+   struct epc_section sections[NUMBER_OF_EPCs_TO_ENUMERATE];
+   int count = find_EPC_sections( sections, NUMBER_OF_EPCs_TO_ENUMERATE );
+
+   for( int s = 0 ; s < count ; s++ ) {
+      const struct epc_section* section = &sections[s];
 
 /*
  * Validated on SGX hardware in /proc/iomem
@@ -388,17 +397,11 @@ void enumerateEPCsections( void ) {
  * Prints the following:
  *   EPC[0]: Protection: ci  Base phys addr: 0000000070200000  size: 0000000005d80000
  */
-            printf( "EPC[%u]: Protection: %c%c  Base phys addr: %016" PRIx64 "  size: %016" PRIx64 "\n"
-              ,i-2
-              ,confidentiality
-              ,integrity
-              ,epcBasePhysAddr
-              ,epcSectionSize );
-
-            break;
-         default:
-            // printf( "r" );  // The leaf type is reserved
-            break;
-      }
+      printf( "EPC[%u]: Protection: %c%c  Base phys addr: %016" PRIx64 "  size: %016" PRIx64 "\n"
+        ,section->subleaf-2
+        ,section->confidentiality
+        ,section->integrity
+        ,section->base
+        ,section->size );
    }
 }
@@ -11,6 +11,29 @@
 #pragma once
 
 #include <inttypes.h>  // For PRIx64 uint64_t PRIx32 uint32_t
+#include <stdbool.h>   // For bool
+
+
+// This number is kinda arbitrary.  Let us know if you ever find a situation
+// where we need to increase this.
+#define NUMBER_OF_EPCs_TO_ENUMERATE 16
+
+
+/// One EPC section as enumerated by CPUID.(EAX=12H, ECX=2+)
+struct epc_section {
+   uint32_t subleaf;          ///< The CPUID sub-leaf that enumerated this section
+   uint64_t base;             ///< Physical base address of the section
+   uint64_t size;             ///< Size of the section in bytes
+   char     confidentiality;  ///< `c` if the section has confidentiality protection
+   char     integrity;        ///< `i` if the section has integrity protection
+};
+
+
+struct sgx_capture;
+
+/// Answer `native_cpuid32()` from `cap` for every leaf it holds.  Pass `NULL`
+/// to go back to executing CPUID.
+void cpuid_use_capture( const struct sgx_capture* cap );
 
 
 /// Call `CPUID`, passing `eax`, `ebx`, `ecx` and `eax` in & out
@@ -55,3 +78,20 @@ void supportsSGXInstructions( void );
 
 
 void enumerateEPCsections( void );
+
+
+/// Enumerate the EPC sections with CPUID.(EAX=12H, ECX=2+)
+///
+/// @return The number of sections in `sections`
+int find_EPC_sections( struct epc_section* sections, int max );
+
+
+/// Decode the registers returned by CPUID.(EAX=12H, ECX=n) into `section`.
+///
+/// @return `true` if the sub-leaf describes a valid EPC section
+bool decode_EPC_section( uint32_t eax
+                        ,uint32_t ebx
+                        ,uint32_t ecx
+                        ,uint32_t edx
+                        ,struct epc_section* section );
+
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cpuidtab.c - 2026
+//
+/// This module writes a C header that answers CPUID & XGETBV inside an
+/// enclave from a table of this host's values.
+///
+/// CPUID raises #UD inside an enclave, so a trusted runtime either exits the
+/// enclave (an OCALL, thousands of cycles) for every feature query or
+/// hard-codes the answers.  The generated header holds every leaf test-sgx
+/// reads (see `probeLeaves` in capture.c) in a constant table sorted by
+/// (leaf, sub-leaf), and `enclave_cpuid()` looks a query up with a binary
+/// search that's unrolled at generation time.  Each step is a conditional
+/// move, so a lookup takes the same few nanoseconds whatever it asks for and
+/// never mispredicts.
+///
+/// Leaves that don't use ECX ignore the sub-leaf, just like CPUID.  A leaf
+/// that isn't in the table returns `0` with all registers zeroed.
+/// CPUID.1:EBX[31:24] (the initial APIC ID) is always 0, because it's
+/// different on every CPU.  Regenerate the header for each host class.
+///
+/// Usage:
+///
+///     test-sgx --cpuid-header enclave_cpuid.h
+///     test-sgx --cpuid-header --from host17.cap enclave_cpuid_host17.h
+///
+/// @file   cpuidtab.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fopen() fprintf()
+#include <stdlib.h>    // For EXIT_SUCCESS EXIT_FAILURE
+#include <string.h>    // For strcmp()
+#include <inttypes.h>  // For PRIx32 PRIx64 uint32_t uint64_t
+
+#include "cpuidtab.h"  // For obvious reasons
+#include "capture.h"   // For capture_load() struct sgx_capture
+#include "cache.h"     // For cache_probe()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The basic leaves that take a sub-leaf in ECX.  Every other leaf ignores
+/// ECX.
+static const uint32_t subleafLeaves[] = {
+   0x04, 0x07, 0x0B, 0x0D, 0x0F, 0x10, 0x12, 0x14, 0x17, 0x18, 0x1B, 0x1D, 0x1F, 0x20, 0x23, 0x24
+};
+
+
+/// Write the lookup header for `cap` to `fileName` (`-` is stdout)
+///
+/// @return `false` if the file couldn't be written
+static bool write_cpuid_header( const char* fileName, const struct sgx_capture* cap ) {
+   FILE* file = strcmp( fileName, "-" ) == 0 ? stdout : fopen( fileName, "w" );
+   if( file == NULL ) {
+      return false;
+   }
+
+   uint64_t subleafMask = 0;
+   for( size_t i = 0 ; i < sizeof( subleafLeaves ) / sizeof( subleafLeaves[0] ) ; i++ ) {
+      subleafMask |= (uint64_t) 1 << subleafLeaves[i];
+   }
+
+   fprintf( file, "// Generated by `" PROGRAM_NAME " --cpuid-header` for node %s.  Do not edit.\n", cap->node );
+   fprintf( file, "//\n" );
+   fprintf( file, "// CPUID raises #UD inside an enclave.  This table holds what CPUID returned\n" );
+   fprintf( file, "// on this host class, so enclave code can answer CPUID without an OCALL:\n" );
+   fprintf( file, "//\n" );
+   fprintf( file, "//     uint32_t regs[4];  // EAX, EBX, ECX, EDX\n" );
+   fprintf( file, "//     if( enclave_cpuid( 7, 0, regs ) && (regs[1] & (1 << 5)) ) { /* AVX2 */ }\n" );
+   fprintf( file, "//\n" );
+   fprintf( file, "// Leaves that aren't in the table return 0 and zeroed registers.\n" );
+   fprintf( file, "// CPUID.1:EBX[31:24] (the initial APIC ID) is 0 because it's per-CPU.\n" );
+   fprintf( file, "#pragma once\n\n" );
+   fprintf( file, "#include <stdint.h>\n\n" );
+
+   fprintf( file, "/// What XGETBV(0) returned on the host.  XGETBV itself is legal inside an\n" );
+   fprintf( file, "/// enclave, where XCR0 reads as SECS.ATTRIBUTES.XFRM -- this is the host's\n" );
+   fprintf( file, "/// value, for deciding which XFRM to ask for.\n" );
+   fprintf( file, "#define ENCLAVE_HOST_XCR0 0x%016" PRIx64 "ULL\n\n", cap->has_xcr0 ? cap->xcr0 : 0 );
+
+   fprintf( file, "/// Bit n is set if basic leaf n takes a sub-leaf in ECX\n" );
+   fprintf( file, "#define ENCLAVE_CPUID_SUBLEAF_LEAVES 0x%016" PRIx64 "ULL\n\n", subleafMask );
+
+   fprintf( file, "#define ENCLAVE_CPUID_COUNT %u\n\n", cap->cpuid_count );
+
+   fprintf( file, "/// Sorted by `key`, which is (leaf << 32 | sub-leaf)\n" );
+   fprintf( file, "static const struct enclave_cpuid_entry {\n" );
+   fprintf( file, "   uint64_t key;\n" );
+   fprintf( file, "   uint32_t regs[4];  // EAX, EBX, ECX, EDX\n" );
+   fprintf( file, "} enclave_cpuid_table[ENCLAVE_CPUID_COUNT] = {\n" );
+   for( uint32_t i = 0 ; i < cap->cpuid_count ; i++ ) {
+      const struct cpuid_record* r = &cap->cpuid[i];
+      uint32_t subleaf = r->leaf < 64 && ((subleafMask >> r->leaf) & 1) ? r->subleaf : 0;
+      fprintf( file, "   { 0x%08" PRIx32 "%08" PRIx32 "ULL, { 0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 " } },\n"
+              ,r->leaf, subleaf, r->eax, r->ebx, r->ecx, r->edx );
+   }
+   fprintf( file, "};\n\n" );
+
+   fprintf( file, "/// Answer CPUID.(EAX=leaf, ECX=subleaf) into `regs` (EAX, EBX, ECX, EDX)\n" );
+   fprintf( file, "///\n" );
+   fprintf( file, "/// @return 1 if the leaf is in the table, 0 if not (and `regs` is zeroed)\n" );
+   fprintf( file, "static inline int enclave_cpuid( uint32_t leaf, uint32_t subleaf, uint32_t regs[4] ) {\n" );
+   fprintf( file, "   uint32_t indexed = leaf < 64 ? (uint32_t) (ENCLAVE_CPUID_SUBLEAF_LEAVES >> leaf) & 1 : 0;\n" );
+   fprintf( file, "   uint64_t key = (uint64_t) leaf << 32 | (subleaf & (0 - indexed));\n" );
+   fprintf( file, "   const struct enclave_cpuid_entry* e = enclave_cpuid_table;\n\n" );
+   fprintf( file, "   // A binary search with the steps unrolled.  Each step is a conditional move.\n" );
+
+   // Halve the range until one entry is left.  The steps only depend on the
+   // table size, so they can be written out here.
+   for( uint32_t n = cap->cpuid_count ; n > 1 ; ) {
+      uint32_t half = n / 2;
+      fprintf( file, "   e += e[%u].key <= key ? %u : 0;\n", half, half );
+      n -= half;
+   }
+
+   fprintf( file, "\n   uint32_t hit = 0 - (uint32_t) (e->key == key);\n" );
+   fprintf( file, "   regs[0] = e->regs[0] & hit;\n" );
+   fprintf( file, "   regs[1] = e->regs[1] & hit;\n" );
+   fprintf( file, "   regs[2] = e->regs[2] & hit;\n" );
+   fprintf( file, "   regs[3] = e->regs[3] & hit;\n" );
+   fprintf( file, "   return (int) (hit & 1);\n" );
+   fprintf( file, "}\n\n" );
+
+   fprintf( file, "/// Answer XGETBV(xcr) with the host's value:  XCR0, or 0 for any other XCR\n" );
+   fprintf( file, "static inline uint64_t enclave_host_xgetbv( uint32_t xcr ) {\n" );
+   fprintf( file, "   return ENCLAVE_HOST_XCR0 & (0 - (uint64_t) (xcr == 0));\n" );
+   fprintf( file, "}\n" );
+
+   if( file == stdout ) {
+      return fflush( file ) == 0;
+   }
+   return fclose( file ) == 0;
+}
+
+
+/// `--cpuid-header [--from CAPTURE] FILE`
+int cpuidtab_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;  // Too big for the stack
+   const char* fromFile = NULL;
+   const char* headerFile = NULL;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( headerFile == NULL && (argv[i][0] != '-' || strcmp( argv[i], "-" ) == 0) ) {
+         headerFile = argv[i];
+      } else {
+         headerFile = NULL;
+         break;
+      }
+   }
+   if( headerFile == NULL ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --cpuid-header [--from CAPTURE] FILE\n" );
+      return EXIT_FAILURE;
+   }
+
+   if( fromFile != NULL ) {
+      if( !capture_load( fromFile, &cap ) ) {
+         return EXIT_FAILURE;
+      }
+   } else {
+      cache_probe( &cap, false );
+   }
+
+   if( cap.cpuid_count == 0 ) {
+      fprintf( stderr, "cpuid-header: No CPUID leaves to write\n" );
+      return EXIT_FAILURE;
+   }
+
+   if( !write_cpuid_header( headerFile, &cap ) ) {
+      fprintf( stderr, "cpuid-header: Unable to write [%s]\n", headerFile );
+      return EXIT_FAILURE;
+   }
+   if( strcmp( headerFile, "-" ) != 0 ) {
+      printf( "Wrote CPUID lookup header with %u leaves: %s\n", cap.cpuid_count, headerFile );
+   }
+   return EXIT_SUCCESS;
+}
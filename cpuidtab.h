@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  cpuidtab.h - 2026
+//
+/// This module writes a C header that answers CPUID & XGETBV inside an
+/// enclave from a table of this host's values.
+///
+/// @file   cpuidtab.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--cpuid-header [--from CAPTURE] FILE`
+int cpuidtab_main( int argc, char* argv[] );
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//  decode.c - 2026
+//
+/// Constant descriptor tables for every CPUID, MSR and XSAVE field test-sgx
+/// decodes, and the one generic decoder that extracts them.
+///
+/// Every report, output mode and bulk decode of captures goes through
+/// `field_extract()`, so a field is described in exactly one place.  The
+/// tables are checked at compile time:
+///
+///   - Every field's bit range must fit in its register
+///   - XSAVE state components must be listed in bit order, so a component
+///     can't silently decode the wrong bit
+///   - XSAVE state components must be managed by the register the SDM says
+///     manages them (XCR0 for user state, IA32_XSS for supervisor state)
+///
+/// @file   decode.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf()
+#include <inttypes.h>  // For PRIu64 uint64_t
+
+#include "decode.h"    // For obvious reasons
+
+
+/// XSAVE state components that are supervisor state (managed by IA32_XSS):
+/// PT, PASID, CET_U, CET_S, HDC, UINTR, LBR and HWP.
+///
+/// @see Intel SDM Vol. 1, Section 13.1 XSAVE-Supported Features and State-Component Bitmaps
+#define XSS_MANAGED_COMPONENTS 0x0001FD00
+
+
+#define X( id, group, leaf, sub, src, lo, hi, name, desc )                              \
+   _Static_assert( (lo) <= (hi), "Field " #id " has lo > hi" );                         \
+   _Static_assert( (hi) < ((src) == SRC_MSR ? 64 : 32), "Field " #id " doesn't fit in its register" );
+FIELD_TABLE( X )
+#undef X
+
+
+#define X( id, bit, src, name, desc )                                                   \
+   _Static_assert( XSTATE_##id == (bit), "XSAVE component " #id " is out of bit order" ); \
+   _Static_assert( ((src) == SRC_XSS) == ((XSS_MANAGED_COMPONENTS >> (bit)) & 1), "XSAVE component " #id " is managed by the wrong register" );
+XSAVE_COMPONENT_TABLE( X )
+#undef X
+
+
+/// Every CPUID & MSR field, indexed by `enum field_id`
+const struct field_desc fields[FIELD_COUNT] = {
+   #define X( id, group, leaf, sub, src, lo, hi, name, desc ) \
+      [FIELD_##id] = { group, leaf, sub, src, lo, hi, name, desc },
+   FIELD_TABLE( X )
+   #undef X
+};
+
+
+/// Every XSAVE state component, indexed by `enum xsave_component_id`
+const struct field_desc xsave_components[XSTATE_COUNT] = {
+   #define X( id, bit, src, name, desc ) \
+      [XSTATE_##id] = { GROUP_FEATURE, 0x0D, bit, src, bit, bit, name, desc },
+   XSAVE_COMPONENT_TABLE( X )
+   #undef X
+};
+
+
+/// The generic decoder:  Extract field `f` from the raw register value `raw`
+uint64_t field_extract( const struct field_desc* f, uint64_t raw ) {
+   unsigned width = f->hi - f->lo + 1;
+   uint64_t mask = width >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << width) - 1;
+
+   return (raw >> f->lo) & mask;
+}
+
+
+/// Decode field `f` from a set of CPUID registers
+uint64_t field_from_regs( const struct field_desc* f, uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx ) {
+   switch( f->source ) {
+      case SRC_EAX: return field_extract( f, eax );
+      case SRC_EBX: return field_extract( f, ebx );
+      case SRC_ECX: return field_extract( f, ecx );
+      case SRC_EDX: return field_extract( f, edx );
+      default:      return 0;  // Not a CPUID field
+   }
+}
+
+
+/// Decode field `f` from a capture
+///
+/// XSAVE state components decode to the captured (actual) XCR0.
+///
+/// @return `false` if the capture doesn't hold the field's register
+bool field_from_capture( const struct field_desc* f, const struct sgx_capture* cap, uint64_t* pValue ) {
+   const struct cpuid_record* r;
+   uint64_t raw;
+
+   switch( f->source ) {
+      case SRC_MSR:
+         if( !capture_find_msr( cap, f->leaf, &raw ) ) {
+            return false;
+         }
+         *pValue = field_extract( f, raw );
+         return true;
+
+      case SRC_XCR0:
+         if( !cap->has_xcr0 ) {
+            return false;
+         }
+         *pValue = field_extract( f, cap->xcr0 );
+         return true;
+
+      case SRC_XSS:
+         return false;  // IA32_XSS is volatile and isn't captured
+
+      default:
+         r = capture_find_cpuid( cap, f->leaf, f->subleaf );
+         if( r == NULL ) {
+            return false;
+         }
+         *pValue = field_from_regs( f, r->eax, r->ebx, r->ecx, r->edx );
+         return true;
+   }
+}
+
+
+/// Print field `f` with the value `value` in the style of its group
+void print_field( const struct field_desc* f, uint64_t value ) {
+   switch( f->group ) {
+      case GROUP_SGX:
+         printf( "%s: %d\n", f->description, (int) value );
+         break;
+
+      case GROUP_SECS:
+         printf( "    ECREATE SECS.ATTRIBUTES[%s] (%s): %d\n", f->name, f->description, (int) value );
+         break;
+
+      case GROUP_FEATURE_CONTROL:
+         printf( "    IA32_FEATURE_CONTROL.%s[bit %d]", f->name, f->lo );
+         if( f->description[0] != '\0' ) {
+            printf( " (%s)", f->description );
+         }
+         printf( ": %d\n", (int) value );
+         break;
+
+      case GROUP_XSAVE_FLAGS:
+         printf( "    %s - %s: %d\n", f->name, f->description, (int) value );
+         break;
+
+      default:
+         printf( "%s: %" PRIu64 "\n", f->description[0] != '\0' ? f->description : f->name, value );
+         break;
+   }
+}
+
+
+/// Print every field in `group` that comes from CPUID.(EAX=leaf, ECX=subleaf)
+void print_cpuid_fields( enum field_group group, uint32_t leaf, uint32_t subleaf
+                        ,uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx ) {
+   for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+      const struct field_desc* f = &fields[i];
+
+      if( f->group == group && f->leaf == leaf && f->subleaf == subleaf && f->source != SRC_MSR ) {
+         print_field( f, field_from_regs( f, eax, ebx, ecx, edx ) );
+      }
+   }
+}
+
+
+/// Print every field in `group` that comes from the MSR `reg`
+void print_msr_fields( enum field_group group, uint32_t reg, uint64_t value ) {
+   for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+      const struct field_desc* f = &fields[i];
+
+      if( f->group == group && f->leaf == reg && f->source == SRC_MSR ) {
+         print_field( f, field_extract( f, value ) );
+      }
+   }
+}
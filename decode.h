@@ -0,0 +1,268 @@
+///////////////////////////////////////////////////////////////////////////////
+//  decode.h - 2026
+//
+/// Constant descriptor tables for every CPUID, MSR and XSAVE field test-sgx
+/// decodes, and the one generic decoder that extracts them.
+///
+/// The tables are X-macros so the same list generates the field IDs, the
+/// descriptor arrays and the compile-time checks in decode.c.  To decode a
+/// new field, add one line to a table -- don't write another shift and mask.
+///
+/// @file   decode.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdbool.h>   // For bool
+#include <inttypes.h>  // For uint32_t uint64_t
+
+#include "capture.h"   // For struct sgx_capture
+#include "rdmsr.h"     // For IA32_FEATURE_CONTROL
+
+
+/// Where a field's raw value comes from
+enum field_source {
+   SRC_EAX,   ///< CPUID.(EAX=leaf, ECX=subleaf):EAX
+   SRC_EBX,
+   SRC_ECX,
+   SRC_EDX,
+   SRC_MSR,   ///< The MSR at address `leaf`
+   SRC_XCR0,  ///< An XSAVE state component managed by XCR0
+   SRC_XSS    ///< An XSAVE state component managed by IA32_XSS
+};
+
+
+/// How a field is printed in the report
+enum field_group {
+   GROUP_VERSION,          ///< CPUID.1:EAX processor version
+   GROUP_FEATURE,          ///< Printed with custom text
+   GROUP_SGX,              ///< `Description: value`
+   GROUP_SECS,             ///< `ECREATE SECS.ATTRIBUTES[NAME] (Description): value`
+   GROUP_FEATURE_CONTROL,  ///< `IA32_FEATURE_CONTROL.NAME[bit n] (Description): value`
+   GROUP_XSAVE_FLAGS,      ///< `name - Description: value`
+   GROUP_ISA,              ///< Instruction set extensions used to pick a compiler target
+   GROUP_POWER,            ///< Frequency & power enumeration
+   GROUP_CACHE,            ///< Deterministic cache parameters (any sub-leaf of leaf 4)
+   GROUP_AMX,              ///< AMX features, tile palettes (any sub-leaf of leaf 1DH) & TMUL
+   GROUP_TOPOLOGY,         ///< Extended topology (any sub-leaf of leaf 0BH)
+   GROUP_MITIGATION,       ///< Speculative-execution mitigations (CPUID, IA32_ARCH_CAPABILITIES & SGX SVNs)
+   GROUP_PERFMON           ///< Architectural performance monitoring (leaf 0AH)
+};
+
+
+/// A constant descriptor for one bit field
+struct field_desc {
+   enum field_group  group;
+   uint32_t          leaf;         ///< CPUID leaf or MSR address
+   uint32_t          subleaf;
+   enum field_source source;
+   uint8_t           lo;           ///< Lowest bit of the field
+   uint8_t           hi;           ///< Highest bit of the field (inclusive)
+   const char*       name;
+   const char*       description;
+};
+
+
+// Every CPUID & MSR field test-sgx decodes
+//
+//   id                  group                  leaf                 sub source   lo  hi  name                   description
+#define FIELD_TABLE( X ) \
+   X( STEPPING,           GROUP_VERSION,         0x01,                 0, SRC_EAX,  0,  3, "Stepping",            "" ) \
+   X( MODEL,              GROUP_VERSION,         0x01,                 0, SRC_EAX,  4,  7, "Model",               "" ) \
+   X( FAMILY,             GROUP_VERSION,         0x01,                 0, SRC_EAX,  8, 11, "Family",              "" ) \
+   X( PROCESSOR_TYPE,     GROUP_VERSION,         0x01,                 0, SRC_EAX, 12, 13, "Processor type",      "" ) \
+   X( EXTENDED_MODEL,     GROUP_VERSION,         0x01,                 0, SRC_EAX, 16, 19, "Extended model",      "" ) \
+   X( EXTENDED_FAMILY,    GROUP_VERSION,         0x01,                 0, SRC_EAX, 20, 27, "Extended family",     "" ) \
+   X( SMX,                GROUP_FEATURE,         0x01,                 0, SRC_ECX,  6,  6, "SMX",                 "Safer Mode Extensions (SMX)" ) \
+   X( OSXSAVE,            GROUP_FEATURE,         0x01,                 0, SRC_ECX, 27, 27, "OSXSAVE",             "OS has enabled XSETBV/XGETBV" ) \
+   X( SGX,                GROUP_FEATURE,         0x07,                 0, SRC_EBX,  2,  2, "SGX",                 "Supports SGX" ) \
+   X( SGX_LC,             GROUP_SGX,             0x07,                 0, SRC_ECX, 30, 30, "SGX_LC",              "SGX Launch Configuration (SGX_LC)" ) \
+   X( SGX_KEYS,           GROUP_SGX,             0x07,                 0, SRC_EDX,  1,  1, "SGX_KEYS",            "SGX Attestation Services (SGX_KEYS)" ) \
+   X( SGX1,               GROUP_SGX,             0x12,                 0, SRC_EAX,  0,  0, "SGX1",                "SGX1 leaf instructions (SGX1)" ) \
+   X( SGX2,               GROUP_SGX,             0x12,                 0, SRC_EAX,  1,  1, "SGX2",                "SGX2 leaf instructions (SGX2)" ) \
+   X( OVERSUB_VMX,        GROUP_SGX,             0x12,                 0, SRC_EAX,  5,  5, "OVERSUB-VMX",         "EINCVIRTCHILD, EDECVIRTCHILD, and ESETCONTEXT (OVERSUB-VMX)" ) \
+   X( OVERSUB_SUPERVISOR, GROUP_SGX,             0x12,                 0, SRC_EAX,  6,  6, "OVERSUB-Supervisor",  "ETRACKC, ERDINFO, ELDBC, and ELDUC (OVERSUB-Supervisor)" ) \
+   X( EVERIFYREPORT2,     GROUP_SGX,             0x12,                 0, SRC_EAX,  7,  7, "EVERIFYREPORT2",      "EVERIFYREPORT2" ) \
+   X( EUPDATESVN,         GROUP_SGX,             0x12,                 0, SRC_EAX, 10, 10, "EUPDATESVN",          "Allow attestation w/ updated microcode (EUPDATESVN)" ) \
+   X( EDECCSSA,           GROUP_SGX,             0x12,                 0, SRC_EAX, 11, 11, "EDECCSSA",            "Allow enclave thread to decrement TCS.CSSA (EDECCSSA)" ) \
+   X( MISCSELECT,         GROUP_FEATURE,         0x12,                 0, SRC_EBX,  0, 31, "MISCSELECT",          "Supported Extended features for MISC region of SSA (MISCSELECT)" ) \
+   X( MAX_ENCLAVE_SIZE_32,GROUP_FEATURE,         0x12,                 0, SRC_EDX,  0,  7, "MaxEnclaveSize_Not64","The maximum supported enclave size in non-64-bit mode is 2^" ) \
+   X( MAX_ENCLAVE_SIZE_64,GROUP_FEATURE,         0x12,                 0, SRC_EDX,  8, 15, "MaxEnclaveSize_64",   "The maximum supported enclave size in     64-bit mode is 2^" ) \
+   X( EPC_TYPE,           GROUP_FEATURE,         0x12,                 2, SRC_EAX,  0,  3, "EPC_Type",            "Sub-leaf type (0 = Invalid, 1 = EPC section) of every EPC sub-leaf" ) \
+   X( SECS_DEBUG,         GROUP_SECS,            0x12,                 1, SRC_EAX,  1,  1, "DEBUG",               "Debugger can read/write enclave data w/ EDBGRD/EDBGWR" ) \
+   X( SECS_MODE64BIT,     GROUP_SECS,            0x12,                 1, SRC_EAX,  2,  2, "MODE64BIT",           "Enclave can run as 64-bit" ) \
+   X( SECS_PROVISIONKEY,  GROUP_SECS,            0x12,                 1, SRC_EAX,  4,  4, "PROVISIONKEY",        "Provisioning key available from EGETKEY" ) \
+   X( SECS_EINITTOKEN_KEY,GROUP_SECS,            0x12,                 1, SRC_EAX,  5,  5, "EINITTOKEN_KEY",      "EINIT token key available from EGETKEY" ) \
+   X( SECS_CET,           GROUP_SECS,            0x12,                 1, SRC_EAX,  6,  6, "CET",                 "Enable Control-flow Enforcement Technology in enclave" ) \
+   X( SECS_KSS,           GROUP_SECS,            0x12,                 1, SRC_EAX,  7,  7, "KSS",                 "Key Separation and Sharing Enabled" ) \
+   X( SECS_AEXNOTIFY,     GROUP_SECS,            0x12,                 1, SRC_EAX, 10, 10, "AEXNOTIFY",           "Threads may receive AEX notifications" ) \
+   X( XFRM_LO,            GROUP_FEATURE,         0x12,                 1, SRC_ECX,  0, 31, "XFRM[31:0]",          "Allowed SECS.ATTRIBUTES.XFRM (low)" ) \
+   X( XFRM_HI,            GROUP_FEATURE,         0x12,                 1, SRC_EDX,  0, 31, "XFRM[63:32]",         "Allowed SECS.ATTRIBUTES.XFRM (high)" ) \
+   X( FC_LOCK,            GROUP_FEATURE_CONTROL, IA32_FEATURE_CONTROL, 0, SRC_MSR,  0,  0, "LOCK_BIT",            "" ) \
+   X( FC_SGX_LC,          GROUP_FEATURE_CONTROL, IA32_FEATURE_CONTROL, 0, SRC_MSR, 17, 17, "SGX_LAUNCH_CONTROL",  "Is the SGX LE PubKey writable?" ) \
+   X( FC_SGX_ENABLE,      GROUP_FEATURE_CONTROL, IA32_FEATURE_CONTROL, 0, SRC_MSR, 18, 18, "SGX_GLOBAL_ENABLE",   "" ) \
+   X( SSE2,               GROUP_ISA,             0x01,                 0, SRC_EDX, 26, 26, "sse2",                "" ) \
+   X( SSE3,               GROUP_ISA,             0x01,                 0, SRC_ECX,  0,  0, "sse3",                "" ) \
+   X( SSSE3,              GROUP_ISA,             0x01,                 0, SRC_ECX,  9,  9, "ssse3",               "" ) \
+   X( FMA,                GROUP_ISA,             0x01,                 0, SRC_ECX, 12, 12, "fma",                 "" ) \
+   X( CX16,               GROUP_ISA,             0x01,                 0, SRC_ECX, 13, 13, "cx16",                "" ) \
+   X( SSE4_1,             GROUP_ISA,             0x01,                 0, SRC_ECX, 19, 19, "sse4.1",              "" ) \
+   X( SSE4_2,             GROUP_ISA,             0x01,                 0, SRC_ECX, 20, 20, "sse4.2",              "" ) \
+   X( MOVBE,              GROUP_ISA,             0x01,                 0, SRC_ECX, 22, 22, "movbe",               "" ) \
+   X( POPCNT,             GROUP_ISA,             0x01,                 0, SRC_ECX, 23, 23, "popcnt",              "" ) \
+   X( AVX,                GROUP_ISA,             0x01,                 0, SRC_ECX, 28, 28, "avx",                 "" ) \
+   X( F16C,               GROUP_ISA,             0x01,                 0, SRC_ECX, 29, 29, "f16c",                "" ) \
+   X( BMI1,               GROUP_ISA,             0x07,                 0, SRC_EBX,  3,  3, "bmi",                 "" ) \
+   X( AVX2,               GROUP_ISA,             0x07,                 0, SRC_EBX,  5,  5, "avx2",                "" ) \
+   X( BMI2,               GROUP_ISA,             0x07,                 0, SRC_EBX,  8,  8, "bmi2",                "" ) \
+   X( AVX512F,            GROUP_ISA,             0x07,                 0, SRC_EBX, 16, 16, "avx512f",             "" ) \
+   X( AVX512DQ,           GROUP_ISA,             0x07,                 0, SRC_EBX, 17, 17, "avx512dq",            "" ) \
+   X( AVX512CD,           GROUP_ISA,             0x07,                 0, SRC_EBX, 28, 28, "avx512cd",            "" ) \
+   X( SHA,                GROUP_ISA,             0x07,                 0, SRC_EBX, 29, 29, "sha",                 "" ) \
+   X( AVX512BW,           GROUP_ISA,             0x07,                 0, SRC_EBX, 30, 30, "avx512bw",            "" ) \
+   X( AVX512VL,           GROUP_ISA,             0x07,                 0, SRC_EBX, 31, 31, "avx512vl",            "" ) \
+   X( WAITPKG,            GROUP_ISA,             0x07,                 0, SRC_ECX,  5,  5, "waitpkg",             "" ) \
+   X( AMX_BF16,           GROUP_ISA,             0x07,                 0, SRC_EDX, 22, 22, "amx-bf16",            "" ) \
+   X( AMX_TILE,           GROUP_ISA,             0x07,                 0, SRC_EDX, 24, 24, "amx-tile",            "" ) \
+   X( AMX_INT8,           GROUP_ISA,             0x07,                 0, SRC_EDX, 25, 25, "amx-int8",            "" ) \
+   X( LAHF_LM,            GROUP_ISA,             0x80000001,           0, SRC_ECX,  0,  0, "sahf",                "" ) \
+   X( LZCNT,              GROUP_ISA,             0x80000001,           0, SRC_ECX,  5,  5, "lzcnt",               "" ) \
+   X( APERFMPERF,         GROUP_POWER,           0x06,                 0, SRC_ECX,  0,  0, "APERFMPERF",          "IA32_MPERF & IA32_APERF (hardware coordination feedback)" ) \
+   X( BASE_MHZ,           GROUP_POWER,           0x16,                 0, SRC_EAX,  0, 15, "BaseMHz",             "Processor base frequency (MHz)" ) \
+   X( MAX_MHZ,            GROUP_POWER,           0x16,                 0, SRC_EBX,  0, 15, "MaxMHz",              "Maximum frequency (MHz)" ) \
+   X( BUS_MHZ,            GROUP_POWER,           0x16,                 0, SRC_ECX,  0, 15, "BusMHz",              "Bus (reference) frequency (MHz)" ) \
+   X( PLATFORM_BASE_RATIO,GROUP_POWER,           MSR_PLATFORM_INFO,    0, SRC_MSR,  8, 15, "MAX_NON_TURBO_RATIO", "Base (maximum non-turbo) ratio" ) \
+   X( PERF_STATUS_RATIO,  GROUP_POWER,           IA32_PERF_STATUS,     0, SRC_MSR,  8, 15, "CURRENT_RATIO",       "Current performance state ratio" ) \
+   X( RAPL_ESU,           GROUP_POWER,           MSR_RAPL_POWER_UNIT,  0, SRC_MSR,  8, 12, "ESU",                 "Energy status units (1/2^ESU joules)" ) \
+   X( PERFMON_VERSION,    GROUP_PERFMON,         0x0A,                 0, SRC_EAX,  0,  7, "Version",             "Architectural performance monitoring version (0 = none)" ) \
+   X( PERFMON_COUNTERS,   GROUP_PERFMON,         0x0A,                 0, SRC_EAX,  8, 15, "GPCounters",          "General-purpose counters per logical processor" ) \
+   X( PERFMON_NO_CYCLES,  GROUP_PERFMON,         0x0A,                 0, SRC_EBX,  0,  0, "NoCoreCycles",        "The core cycles event is not available" ) \
+   X( PERFMON_NO_INSTRS,  GROUP_PERFMON,         0x0A,                 0, SRC_EBX,  1,  1, "NoInstructions",      "The instructions retired event is not available" ) \
+   X( CACHE_TYPE,         GROUP_CACHE,           0x04,                 0, SRC_EAX,  0,  4, "CacheType",           "0 = No more caches, 1 = Data, 2 = Instruction, 3 = Unified" ) \
+   X( CACHE_LEVEL,        GROUP_CACHE,           0x04,                 0, SRC_EAX,  5,  7, "CacheLevel",          "Cache level (starts at 1)" ) \
+   X( CACHE_LINE_SIZE,    GROUP_CACHE,           0x04,                 0, SRC_EBX,  0, 11, "LineSize",            "System coherency line size - 1" ) \
+   X( CACHE_PARTITIONS,   GROUP_CACHE,           0x04,                 0, SRC_EBX, 12, 21, "Partitions",          "Physical line partitions - 1" ) \
+   X( CACHE_WAYS,         GROUP_CACHE,           0x04,                 0, SRC_EBX, 22, 31, "Ways",                "Ways of associativity - 1" ) \
+   X( CACHE_SETS,         GROUP_CACHE,           0x04,                 0, SRC_ECX,  0, 31, "Sets",                "Number of sets - 1" ) \
+   X( AMX_FP16,           GROUP_AMX,             0x07,                 1, SRC_EAX, 21, 21, "amx-fp16",            "" ) \
+   X( AMX_COMPLEX,        GROUP_AMX,             0x07,                 1, SRC_EDX,  8,  8, "amx-complex",         "" ) \
+   X( TILE_MAX_PALETTE,   GROUP_AMX,             0x1D,                 0, SRC_EAX,  0, 31, "max_palette",         "Highest tile palette" ) \
+   X( TILE_TOTAL_BYTES,   GROUP_AMX,             0x1D,                 1, SRC_EAX,  0, 15, "total_tile_bytes",    "Bytes of tile data in the palette" ) \
+   X( TILE_BYTES,         GROUP_AMX,             0x1D,                 1, SRC_EAX, 16, 31, "bytes_per_tile",      "Bytes per tile" ) \
+   X( TILE_ROW_BYTES,     GROUP_AMX,             0x1D,                 1, SRC_EBX,  0, 15, "bytes_per_row",       "Bytes per tile row" ) \
+   X( TILE_NAMES,         GROUP_AMX,             0x1D,                 1, SRC_EBX, 16, 31, "max_names",           "Number of tile registers" ) \
+   X( TILE_ROWS,          GROUP_AMX,             0x1D,                 1, SRC_ECX,  0, 15, "max_rows",            "Rows per tile" ) \
+   X( TMUL_MAXK,          GROUP_AMX,             0x1E,                 0, SRC_EBX,  0,  7, "tmul_maxk",           "TMUL rows or columns" ) \
+   X( TMUL_MAXN,          GROUP_AMX,             0x1E,                 0, SRC_EBX,  8, 23, "tmul_maxn",           "TMUL column bytes" ) \
+   X( XFD_TILEDATA,       GROUP_AMX,             0x0D,                18, SRC_ECX,  2,  2, "xfd_tiledata",        "XFD can arm TILEDATA" ) \
+   X( INITIAL_APIC_ID,    GROUP_TOPOLOGY,        0x01,                 0, SRC_EBX, 24, 31, "InitialAPIC_ID",      "Initial (8-bit) APIC ID of this logical processor" ) \
+   X( X2APIC_ID,          GROUP_TOPOLOGY,        0x0B,                 0, SRC_EDX,  0, 31, "x2APIC_ID",           "x2APIC ID of this logical processor" ) \
+   X( TOPOLOGY_SHIFT,     GROUP_TOPOLOGY,        0x0B,                 0, SRC_EAX,  0,  4, "Shift",               "x2APIC ID bits below the next level" ) \
+   X( TOPOLOGY_LEVEL,     GROUP_TOPOLOGY,        0x0B,                 0, SRC_ECX,  8, 15, "LevelType",           "0 = Invalid, 1 = SMT, 2 = Core" ) \
+   X( SRBDS_CTRL,         GROUP_MITIGATION,      0x07,                 0, SRC_EDX,  9,  9, "srbds_ctrl",          "RDRAND/RDSEED mitigation control" ) \
+   X( MD_CLEAR,           GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 10, 10, "md_clear",            "VERW clears CPU buffers" ) \
+   X( IBRS_IBPB,          GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 26, 26, "ibrs_ibpb",           "IBRS & IBPB" ) \
+   X( STIBP,              GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 27, 27, "stibp",               "Single-thread indirect branch predictors" ) \
+   X( L1D_FLUSH,          GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 28, 28, "flush_l1d",           "IA32_FLUSH_CMD flushes the L1D" ) \
+   X( ARCH_CAPABILITIES,  GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 29, 29, "arch_capabilities",   "IA32_ARCH_CAPABILITIES is there" ) \
+   X( SSBD,               GROUP_MITIGATION,      0x07,                 0, SRC_EDX, 31, 31, "ssbd",                "Speculative store bypass disable" ) \
+   X( BHI_CTRL,           GROUP_MITIGATION,      0x07,                 2, SRC_EDX,  4,  4, "bhi_ctrl",            "Branch history injection control" ) \
+   X( RDCL_NO,            GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  0,  0, "RDCL_NO",             "Not affected by Meltdown or L1TF" ) \
+   X( IBRS_ALL,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  1,  1, "IBRS_ALL",            "Enhanced IBRS" ) \
+   X( RSBA,               GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  2,  2, "RSBA",                "RET may predict from the BTB" ) \
+   X( SSB_NO,             GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  4,  4, "SSB_NO",              "Not affected by speculative store bypass" ) \
+   X( MDS_NO,             GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  5,  5, "MDS_NO",              "Not affected by MDS" ) \
+   X( TSX_CTRL,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  7,  7, "TSX_CTRL",            "TSX can be disabled" ) \
+   X( TAA_NO,             GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR,  8,  8, "TAA_NO",              "Not affected by TSX async abort" ) \
+   X( SBDR_SSDP_NO,       GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 13, 13, "SBDR_SSDP_NO",        "Not affected by MMIO stale data (SBDR & SSDP)" ) \
+   X( FBSDP_NO,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 14, 14, "FBSDP_NO",            "Not affected by MMIO stale data (FBSDP)" ) \
+   X( PSDP_NO,            GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 15, 15, "PSDP_NO",             "Not affected by MMIO stale data (PSDP)" ) \
+   X( FB_CLEAR,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 17, 17, "FB_CLEAR",            "VERW clears the fill buffers" ) \
+   X( RRSBA,              GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 19, 19, "RRSBA",               "RET may predict from the BTB (restricted)" ) \
+   X( BHI_NO,             GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 20, 20, "BHI_NO",              "Not affected by branch history injection" ) \
+   X( PBRSB_NO,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 24, 24, "PBRSB_NO",            "Not affected by post-barrier RSB predictions" ) \
+   X( GDS_CTRL,           GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 25, 25, "GDS_CTRL",            "The GDS mitigation can be controlled" ) \
+   X( GDS_NO,             GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 26, 26, "GDS_NO",              "Not affected by gather data sampling" ) \
+   X( RFDS_NO,            GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 27, 27, "RFDS_NO",             "Not affected by register file data sampling" ) \
+   X( RFDS_CLEAR,         GROUP_MITIGATION,      IA32_ARCH_CAPABILITIES, 0, SRC_MSR, 28, 28, "RFDS_CLEAR",          "VERW clears the register file" ) \
+   X( SVN_LOCK,           GROUP_MITIGATION,      IA32_SGX_SVN_STATUS,  0, SRC_MSR,  0,  0, "Lock",                "The SINIT SVN is locked" ) \
+   X( SVN_SINIT,          GROUP_MITIGATION,      IA32_SGX_SVN_STATUS,  0, SRC_MSR, 16, 23, "SGX_SVN_SINIT",       "SVN of the SINIT ACM" ) \
+   X( XSAVEOPT,           GROUP_XSAVE_FLAGS,     0x0D,                 1, SRC_EAX,  0,  0, "xsaveopt",            "save state-components that have been modified since last XRSTOR" ) \
+   X( XSAVEC,             GROUP_XSAVE_FLAGS,     0x0D,                 1, SRC_EAX,  1,  1, "xsavec",              "save/restore state with compaction" ) \
+   X( XGETBV_ECX1,        GROUP_XSAVE_FLAGS,     0x0D,                 1, SRC_EAX,  2,  2, "xgetbv_ecx1",         "XGETBV with ECX=1 support" ) \
+   X( XSS,                GROUP_XSAVE_FLAGS,     0x0D,                 1, SRC_EAX,  3,  3, "xss",                 "save/restore state with compaction, including supervisor state" ) \
+   X( XFD,                GROUP_XSAVE_FLAGS,     0x0D,                 1, SRC_EAX,  4,  4, "xfd",                 "Extended Feature Disable supported" )
+
+
+// Every XSAVE state component.  Entries must be in bit order with no gaps --
+// decode.c checks this at compile time.
+//
+//   id          bit  register  name          description
+#define XSAVE_COMPONENT_TABLE( X ) \
+   X( X87,         0, SRC_XCR0, "x87:",       "x87 Floating Point Unit & MMX" ) \
+   X( SSE,         1, SRC_XCR0, "SSE:",       "MXCSR and XMM registers" ) \
+   X( AVX,         2, SRC_XCR0, "AVX:",       "YMM registers" ) \
+   X( BNDREG,      3, SRC_XCR0, "BNDREG:",    "MPX for BND registers" ) \
+   X( BNDCSR,      4, SRC_XCR0, "BNDCSR:",    "MPX for BNDCFGU and BNDSTATUS registers" ) \
+   X( OPMASK,      5, SRC_XCR0, "opmask:",    "AVX-512 for AVX opmask and AKA k-mask" ) \
+   X( ZMM_HI256,   6, SRC_XCR0, "ZMM_hi256:", "AVX-512 for the upper-halves of lower ZMM registers" ) \
+   X( HI16_ZMM,    7, SRC_XCR0, "Hi16_ZMM:",  "AVX-512 for the upper ZMM registers" ) \
+   X( PT,          8, SRC_XSS,  "PT:",        "Processor Trace" ) \
+   X( PKRU,        9, SRC_XCR0, "PKRU:",      "User Protection Keys" ) \
+   X( PASID,      10, SRC_XSS,  "PASID:",     "Process Address Space ID" ) \
+   X( CET_U,      11, SRC_XSS,  "CET_U:",     "Control-flow Enforcement Technology: user-mode functionality MSRs" ) \
+   X( CET_S,      12, SRC_XSS,  "CET_S:",     "CET: shadow stack pointers for rings 0,1,2" ) \
+   X( HDC,        13, SRC_XSS,  "HDC:",       "Hardware Duty Cycling" ) \
+   X( UINTR,      14, SRC_XSS,  "UINTR:",     "User-Mode Interrupts" ) \
+   X( LBR,        15, SRC_XSS,  "LBR:",       "Last Branch Record" ) \
+   X( HWP,        16, SRC_XSS,  "HWP:",       "Hardware P-state control" ) \
+   X( TILECFG,    17, SRC_XCR0, "TILECFG:",   "AMX - Advanced Matrix Extensions" ) \
+   X( TILEDATA,   18, SRC_XCR0, "TILEDATA:",  "AMX - Advanced Matrix Extensions" ) \
+   X( APX,        19, SRC_XCR0, "APX:",       "Extended General Purpose Registers R16-R31" )
+
+
+/// IDs for every field in `fields[]`
+enum field_id {
+   #define X( id, group, leaf, sub, src, lo, hi, name, desc ) FIELD_##id,
+   FIELD_TABLE( X )
+   #undef X
+   FIELD_COUNT
+};
+
+
+/// IDs (and bit numbers) for every XSAVE state component
+enum xsave_component_id {
+   #define X( id, bit, src, name, desc ) XSTATE_##id,
+   XSAVE_COMPONENT_TABLE( X )
+   #undef X
+   XSTATE_COUNT
+};
+
+
+/// Every CPUID & MSR field, indexed by `enum field_id`
+extern const struct field_desc fields[FIELD_COUNT];
+
+/// Every XSAVE state component, indexed by `enum xsave_component_id`
+extern const struct field_desc xsave_components[XSTATE_COUNT];
+
+
+/// The generic decoder:  Extract field `f` from the raw register value `raw`
+uint64_t field_extract( const struct field_desc* f, uint64_t raw );
+
+/// Decode field `f` from a set of CPUID registers
+uint64_t field_from_regs( const struct field_desc* f, uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx );
+
+/// Decode field `f` from a capture
+///
+/// @return `false` if the capture doesn't hold the field's register
+bool field_from_capture( const struct field_desc* f, const struct sgx_capture* cap, uint64_t* pValue );
+
+/// Print field `f` with the value `value` in the style of its group
+void print_field( const struct field_desc* f, uint64_t value );
+
+/// Print every field in `group` that comes from CPUID.(EAX=leaf, ECX=subleaf)
+void print_cpuid_fields( enum field_group group, uint32_t leaf, uint32_t subleaf
+                        ,uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx );
+
+/// Print every field in `group` that comes from the MSR `reg`
+void print_msr_fields( enum field_group group, uint32_t reg, uint64_t value );
@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+//  energy.c - 2026
+//
+/// This module meters the energy a command uses with the RAPL (Running
+/// Average Power Limit) energy-status MSRs.
+///
+/// Each package has a set of 32-bit counters that count up in energy units:
+///
+///   - `PKG`:   MSR_PKG_ENERGY_STATUS -- The whole package
+///   - `PP0`:   MSR_PP0_ENERGY_STATUS -- The cores (not on every server part)
+///   - `DRAM`:  MSR_DRAM_ENERGY_STATUS -- The memory (not on every client part)
+///
+/// MSR_RAPL_POWER_UNIT bits 12:8 say an energy unit is 1/2^ESU joules
+/// (usually 61 µJ).  At that unit a package drawing 200 W wraps its 32-bit
+/// counter in about 20 minutes, so the counters are sampled every `--interval`
+/// (1000 ms by default) while the command runs and each delta is taken modulo
+/// 2^32.  Run the same workload inside and outside an enclave to compare them.
+///
+/// RAPL is package-wide, so everything else running on the package is counted
+/// too.  Some server parts count DRAM in a fixed unit that isn't ESU; their
+/// DRAM joules are only good for comparing one run against another.
+///
+/// Usage:
+///
+///     test-sgx --energy -- ./our_enclave_app --its --args
+///     test-sgx --energy --interval 250 -- ./our_enclave_app
+///
+/// @file   energy.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sigtimedwait()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fprintf()
+#include <stdlib.h>    // For atol()
+#include <string.h>    // For strcmp() strerror()
+#include <inttypes.h>  // For PRIu64 uint64_t uint32_t
+#include <time.h>      // For clock_gettime()
+#include <errno.h>     // For errno EAGAIN EINTR
+
+#ifdef __linux__
+   #include <unistd.h>     // For fork() execvp() _exit() access()
+   #include <signal.h>     // For sigprocmask() sigtimedwait() SIGCHLD
+   #include <sys/wait.h>   // For waitpid() WIFEXITED()
+#endif
+
+#include "energy.h"    // For obvious reasons
+#include "rdmsr.h"     // For rdmsr() checkCapabilities() MSR_RAPL_POWER_UNIT
+#include "decode.h"    // For fields[] field_extract()
+#include "topology.h"  // For topology_online_cpus() topology_package_of() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The RAPL energy domains we meter
+enum rapl_domain {
+   DOMAIN_PKG,
+   DOMAIN_PP0,
+   DOMAIN_DRAM,
+   DOMAIN_COUNT
+};
+
+#ifdef __linux__  // The meter reads /dev/cpu/N/msr
+
+/// The energy-status MSR and name of each `rapl_domain`
+static const struct {
+   uint32_t    msr;
+   const char* name;
+} domains[DOMAIN_COUNT] = {
+   { MSR_PKG_ENERGY_STATUS,  "PKG"  },
+   { MSR_PP0_ENERGY_STATUS,  "PP0 (cores)" },
+   { MSR_DRAM_ENERGY_STATUS, "DRAM" },
+};
+
+/// The RAPL counters of one package
+struct package_meter {
+   int      package;                  ///< The physical package ID
+   int      cpu;                      ///< The CPU we read the package's MSRs on
+   double   joules_per_unit;          ///< From MSR_RAPL_POWER_UNIT
+   bool     has[DOMAIN_COUNT];        ///< The domain's MSR is readable
+   uint32_t last[DOMAIN_COUNT];       ///< The counter at the last sample
+   uint64_t units[DOMAIN_COUNT];      ///< The energy units counted so far
+};
+
+/// The number of times we've read the counters
+static unsigned sampleCount = 0;
+
+/// The time spent reading the counters (in seconds)
+static double sampleSeconds = 0;
+
+
+/// @return The seconds from `from` to `to`
+static double seconds_between( const struct timespec* from, const struct timespec* to ) {
+   return (double) (to->tv_sec - from->tv_sec) + (double) (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+
+/// Find one online CPU in each package
+///
+/// @return The number of packages in `meters`
+static int find_packages( struct package_meter* meters, int max ) {
+   static int online[MAX_CPUS];
+   int onlineCount = topology_online_cpus( online, MAX_CPUS );
+   int count = 0;
+
+   for( int c = 0 ; c < onlineCount ; c++ ) {
+      int package = topology_package_of( online[c] );
+      bool seen = false;
+      for( int m = 0 ; m < count ; m++ ) {
+         seen = seen || meters[m].package == package;
+      }
+      if( !seen && count < max ) {
+         memset( &meters[count], 0, sizeof( meters[count] ) );
+         meters[count].package = package;
+         meters[count].cpu = online[c];
+         count++;
+      }
+   }
+   return count;
+}
+
+
+/// Read the energy unit and which domains the package has
+///
+/// @return `true` if the package has RAPL
+static bool open_package( struct package_meter* meter ) {
+   uint64_t powerUnit = 0;
+   uint64_t value = 0;
+
+   if( !rdmsr( MSR_RAPL_POWER_UNIT, meter->cpu, &powerUnit ) ) {
+      return false;
+   }
+   meter->joules_per_unit = 1.0 / (double) (1ULL << field_extract( &fields[FIELD_RAPL_ESU], powerUnit ));
+
+   for( int d = 0 ; d < DOMAIN_COUNT ; d++ ) {
+      meter->has[d] = rdmsr( domains[d].msr, meter->cpu, &value );
+      meter->last[d] = (uint32_t) value;
+   }
+   return meter->has[DOMAIN_PKG];
+}
+
+
+/// Read every package's counters and add what they counted since the last
+/// sample.  The subtraction is done in 32 bits, so a counter that wrapped
+/// (once) between samples still gives the right delta.
+static void sample_packages( struct package_meter* meters, int count ) {
+   struct timespec before, after;
+   clock_gettime( CLOCK_MONOTONIC, &before );
+
+   for( int m = 0 ; m < count ; m++ ) {
+      for( int d = 0 ; d < DOMAIN_COUNT ; d++ ) {
+         uint64_t value = 0;
+         if( meters[m].has[d] && rdmsr( domains[d].msr, meters[m].cpu, &value ) ) {
+            meters[m].units[d] += (uint32_t) ((uint32_t) value - meters[m].last[d]);
+            meters[m].last[d] = (uint32_t) value;
+         }
+      }
+   }
+
+   clock_gettime( CLOCK_MONOTONIC, &after );
+   sampleSeconds += seconds_between( &before, &after );
+   sampleCount++;
+}
+
+#endif  // __linux__
+
+
+/// `--energy [--interval MS] -- COMMAND [ARG]...`
+int energy_main( int argc, char* argv[] ) {
+   long intervalMS = 1000;
+   int  commandAt  = -1;
+
+   for( int i = 1 ; i < argc && commandAt < 0 ; i++ ) {
+      if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         intervalMS = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--" ) == 0 && i + 1 < argc ) {
+         commandAt = i + 1;
+      } else {
+         break;
+      }
+   }
+   if( commandAt < 0 || intervalMS <= 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --energy [--interval MS] -- COMMAND [ARG]...\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct package_meter meters[MAX_CPUS];
+      int packageCount = find_packages( meters, MAX_CPUS );
+
+      if( !checkCapabilities() || access( "/dev/cpu/0/msr", R_OK ) != 0 ) {
+         printf( "The RAPL MSRs aren't readable.  Run as root with the msr driver loaded (modprobe msr).\n" );
+         return EXIT_FAILURE;
+      }
+      for( int m = 0 ; m < packageCount ; m++ ) {
+         if( !open_package( &meters[m] ) ) {
+            printf( "Package %d (CPU %d) doesn't have RAPL energy counters\n", meters[m].package, meters[m].cpu );
+            return EXIT_FAILURE;
+         }
+      }
+
+      // Block SIGCHLD so we can wait for it (or the next sample) with sigtimedwait()
+      sigset_t childSignal, oldMask;
+      sigemptyset( &childSignal );
+      sigaddset( &childSignal, SIGCHLD );
+      sigprocmask( SIG_BLOCK, &childSignal, &oldMask );
+
+      struct timespec start, end;
+      clock_gettime( CLOCK_MONOTONIC, &start );
+      sample_packages( meters, packageCount );
+
+      pid_t child = fork();
+      if( child < 0 ) {
+         fprintf( stderr, "energy: Unable to fork: %s\n", strerror( errno ) );
+         sigprocmask( SIG_SETMASK, &oldMask, NULL );
+         return EXIT_FAILURE;
+      }
+      if( child == 0 ) {
+         sigprocmask( SIG_SETMASK, &oldMask, NULL );
+         execvp( argv[commandAt], &argv[commandAt] );
+         fprintf( stderr, "energy: Unable to run [%s]: %s\n", argv[commandAt], strerror( errno ) );
+         _exit( 127 );
+      }
+
+      const struct timespec interval = { intervalMS / 1000, (intervalMS % 1000) * 1000000 };
+      int   status = 0;
+      pid_t done   = 0;
+      for( ;; ) {
+         int caught = sigtimedwait( &childSignal, NULL, &interval );
+         if( caught < 0 && errno != EAGAIN && errno != EINTR ) {
+            // We can't sample on time any more, but the command still has to
+            // be waited for.  A counter may wrap more than once now.
+            fprintf( stderr, "energy: sigtimedwait failed: %s.  Waiting for the command without sampling.\n", strerror( errno ) );
+            while( (done = waitpid( child, &status, 0 )) < 0 && errno == EINTR ) {
+            }
+            break;
+         }
+         done = waitpid( child, &status, WNOHANG );
+         if( done != 0 ) {
+            break;  // The command exited (or waitpid failed)
+         }
+         sample_packages( meters, packageCount );  // Often enough that no counter wraps twice
+      }
+      if( done != child ) {
+         fprintf( stderr, "energy: Unable to wait for [%s]: %s\n", argv[commandAt], strerror( errno ) );
+      }
+
+      sample_packages( meters, packageCount );
+      clock_gettime( CLOCK_MONOTONIC, &end );
+      sigprocmask( SIG_SETMASK, &oldMask, NULL );
+
+      double elapsed = seconds_between( &start, &end );
+
+      printf( "Energy used while running [%s] for %.3f s", argv[commandAt], elapsed );
+      if( done != child ) {
+         printf( " (exit status unknown)\n" );
+      } else if( WIFEXITED( status ) ) {
+         printf( " (exit status %d)\n", WEXITSTATUS( status ) );
+      } else if( WIFSIGNALED( status ) ) {
+         printf( " (killed by signal %d)\n", WTERMSIG( status ) );
+      } else {
+         printf( "\n" );
+      }
+
+      printf( "    Package  Domain           Joules     Avg W\n" );
+      printf( "    =======  ===========  ==========  ========\n" );
+      double totalJoules = 0;
+      for( int m = 0 ; m < packageCount ; m++ ) {
+         for( int d = 0 ; d < DOMAIN_COUNT ; d++ ) {
+            if( !meters[m].has[d] ) {
+               printf( "    %7d  %-11s  %10s  %8s\n", meters[m].package, domains[d].name, "n/a", "n/a" );
+               continue;
+            }
+            double joules = (double) meters[m].units[d] * meters[m].joules_per_unit;
+            printf( "    %7d  %-11s  %10.3f  %8.2f\n", meters[m].package, domains[d].name, joules, elapsed > 0 ? joules / elapsed : 0 );
+            if( d == DOMAIN_PKG ) {
+               totalJoules += joules;
+            }
+         }
+      }
+      if( packageCount > 1 ) {
+         printf( "    %7s  %-11s  %10.3f  %8.2f\n", "All", "PKG", totalJoules, elapsed > 0 ? totalJoules / elapsed : 0 );
+      }
+
+      printf( "  Energy unit:  %.1f uJ\n", meters[0].joules_per_unit * 1e6 );
+      printf( "  Metering overhead:  %u samples took %.1f us (%.4f%% of the run)\n", sampleCount, sampleSeconds * 1e6, elapsed > 0 ? 100.0 * sampleSeconds / elapsed : 0 );
+
+      if( done == child && WIFEXITED( status ) ) {
+         return WEXITSTATUS( status ) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+      }
+      return EXIT_FAILURE;
+
+   #else
+      printf( "Energy metering needs Linux's /dev/cpu/N/msr\n" );
+      return EXIT_FAILURE;
+   #endif
+}
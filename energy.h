@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  energy.h - 2026
+//
+/// This module meters the energy a command uses with the RAPL energy-status
+/// MSRs.
+///
+/// @file   energy.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--energy [--interval MS] -- COMMAND [ARG]...`
+int energy_main( int argc, char* argv[] );
@@ -0,0 +1,353 @@
+///////////////////////////////////////////////////////////////////////////////
+//  epcmon.c - 2026
+//
+/// This module watches the in-kernel SGX driver's EPC per NUMA node and its
+/// reclaimer thread (`ksgxd`), and alerts when EPC reclaim starts.
+///
+/// When free EPC runs low, the driver wakes `ksgxd`, which picks the least
+/// recently used enclave pages, blocks them (EBLOCK & ETRACK, which IPIs
+/// every CPU running the enclave) and writes them out encrypted (EWB).  The
+/// next touch faults them back in with ELDU.  That's EPC paging -- the worst
+/// latency cliff an enclave has -- and `ksgxd` only wakes when it's needed,
+/// so any CPU time or wakeup of it means reclaim is happening.
+///
+/// Every interval this reads:
+///
+///   - `SYS/devices/system/node/nodeN/x86/sgx_total_bytes`:  The EPC on each
+///     node (these can change with memory hotplug)
+///   - `PROC/PID/stat` & `status` of `ksgxd`:  Its CPU time and context
+///     switches (each wakeup is a switch)
+///   - `CGROUP/misc.current` & `misc.capacity`:  The EPC in use, when the
+///     misc controller accounts it
+///
+/// and prints a line each interval, with an alert when reclaim starts and a
+/// note when it stops.  `--sys`, `--proc` and `--cgroup` point it at another
+/// tree, like a fake one for testing:
+///
+///     mkdir -p /tmp/fake/sys/devices/system/node/node0/x86 /tmp/fake/proc/42
+///     echo 4294967296 > /tmp/fake/sys/devices/system/node/node0/x86/sgx_total_bytes
+///     echo ksgxd > /tmp/fake/proc/42/comm
+///     echo '42 (ksgxd) S 2 0 0 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 0 0 0' > /tmp/fake/proc/42/stat
+///     test-sgx --epc-monitor --sys /tmp/fake/sys --proc /tmp/fake/proc
+///
+/// Usage:
+///
+///     test-sgx --epc-monitor                          # 10 x 1s
+///     test-sgx --epc-monitor --interval 100 --count 600
+///
+/// @file   epcmon.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `clock_nanosleep()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf() sscanf()
+#include <stdlib.h>    // For atol() strtol() strtoull()
+#include <string.h>    // For strcmp() strncmp() strrchr() strchr() memcmp() memcpy()
+#include <inttypes.h>  // For PRIu64 SCNu64 uint64_t
+#include <stdbool.h>   // For bool
+#include <ctype.h>     // For isdigit()
+#include <limits.h>    // For PATH_MAX
+#include <time.h>      // For clock_gettime() clock_nanosleep()
+
+#ifdef __linux__
+   #include <unistd.h>         // For sysconf()
+   #include <dirent.h>         // For opendir() readdir() closedir()
+#endif
+
+#include "epcmon.h"    // For obvious reasons
+#include "cpuid.h"     // For find_EPC_sections() NUMBER_OF_EPCs_TO_ENUMERATE
+#include "cgroup.h"    // For cgroup_read_epc()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The most NUMA nodes we look for
+#define MAX_NODES 64
+
+/// The name of the SGX driver's reclaimer thread
+#define KSGXD "ksgxd"
+
+#define MiB ((uint64_t) 1 << 20)
+
+
+/// What `ksgxd` has done so far
+struct ksgxd_counters {
+   uint64_t ticks;     ///< User + system CPU time, in clock ticks
+   uint64_t switches;  ///< Voluntary + involuntary context switches
+};
+
+
+#ifdef __linux__
+
+/// Find the `ksgxd` kernel thread in `procDir`
+///
+/// @return Its PID, or `-1` if there isn't one
+static long find_ksgxd( const char* procDir ) {
+   char path[PATH_MAX];
+   char comm[64];
+   long pid = -1;
+
+   DIR* dir = opendir( procDir );
+   if( dir == NULL ) {
+      return -1;
+   }
+   struct dirent* entry;
+   while( pid < 0 && (entry = readdir( dir )) != NULL ) {
+      if( !isdigit( (unsigned char) entry->d_name[0] ) ) {
+         continue;
+      }
+      snprintf( path, sizeof( path ), "%s/%s/comm", procDir, entry->d_name );
+      FILE* file = fopen( path, "r" );
+      if( file == NULL ) {
+         continue;
+      }
+      if( fgets( comm, sizeof( comm ), file ) != NULL && strncmp( comm, KSGXD, sizeof( KSGXD ) - 1 ) == 0
+          && (comm[sizeof( KSGXD ) - 1] == '\n' || comm[sizeof( KSGXD ) - 1] == '\0') ) {
+         pid = strtol( entry->d_name, NULL, 10 );
+      }
+      fclose( file );
+   }
+   closedir( dir );
+   return pid;
+}
+
+
+/// Read `ksgxd`'s CPU time from `PROC/PID/stat` and its context switches
+/// from `PROC/PID/status`
+///
+/// @return `false` if it's gone
+static bool read_ksgxd( const char* procDir, long pid, struct ksgxd_counters* counters ) {
+   char path[PATH_MAX];
+   char line[1024];
+   bool found = false;
+
+   snprintf( path, sizeof( path ), "%s/%ld/stat", procDir, pid );
+   FILE* file = fopen( path, "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   if( fgets( line, sizeof( line ), file ) != NULL ) {
+      // After the name, the fields start at #3 (state).  #14 & #15 are
+      // utime & stime.
+      char* p = strrchr( line, ')' );
+      for( int field = 2 ; field < 14 && p != NULL ; field++ ) {
+         p = strchr( p + 1, ' ' );
+      }
+      uint64_t utime = 0;
+      uint64_t stime = 0;
+      found = p != NULL && sscanf( p, " %" SCNu64 " %" SCNu64, &utime, &stime ) == 2;
+      counters->ticks = utime + stime;
+   }
+   fclose( file );
+
+   counters->switches = 0;
+   snprintf( path, sizeof( path ), "%s/%ld/status", procDir, pid );
+   file = fopen( path, "r" );
+   if( file != NULL ) {
+      while( fgets( line, sizeof( line ), file ) != NULL ) {
+         uint64_t switches = 0;
+         if( sscanf( line, "voluntary_ctxt_switches: %" SCNu64, &switches ) == 1
+          || sscanf( line, "nonvoluntary_ctxt_switches: %" SCNu64, &switches ) == 1 ) {
+            counters->switches += switches;
+         }
+      }
+      fclose( file );
+   }
+   return found;
+}
+
+
+/// Read each node's `sgx_total_bytes` (`bytes` is indexed by node)
+///
+/// @return The number of nodes that have it
+static int read_nodes( const char* sysDir, uint64_t* bytes ) {
+   char path[PATH_MAX];
+   int count = 0;
+
+   for( int node = 0 ; node < MAX_NODES ; node++ ) {
+      bytes[node] = 0;
+      snprintf( path, sizeof( path ), "%s/devices/system/node/node%d/x86/sgx_total_bytes", sysDir, node );
+      FILE* file = fopen( path, "r" );
+      if( file == NULL ) {
+         continue;  // Node numbers can have gaps
+      }
+      if( fscanf( file, "%" SCNu64, &bytes[node] ) == 1 ) {
+         count++;
+      }
+      fclose( file );
+   }
+   return count;
+}
+
+
+/// Print each node's EPC
+static void print_nodes( const uint64_t* bytes ) {
+   uint64_t total = 0;
+
+   printf( "  EPC per node:" );
+   for( int node = 0 ; node < MAX_NODES ; node++ ) {
+      if( bytes[node] > 0 ) {
+         printf( "  node%d %" PRIu64 " MiB", node, bytes[node] / MiB );
+         total += bytes[node];
+      }
+   }
+   printf( "  (%" PRIu64 " MiB in all)\n", total / MiB );
+}
+
+
+/// @return The number of seconds from `start` to `now`
+static double seconds_between( const struct timespec* start, const struct timespec* now ) {
+   return (double) (now->tv_sec - start->tv_sec) + (double) (now->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+#endif
+
+
+/// `--epc-monitor [--sys DIR] [--proc DIR] [--cgroup DIR] [--interval MS] [--count N]`
+int epcmon_main( int argc, char* argv[] ) {
+   const char* sysDir = "/sys";
+   const char* procDir = "/proc";
+   const char* cgroupDir = "/sys/fs/cgroup";
+   long intervalMS = 1000;
+   long samples = 10;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--sys" ) == 0 && i + 1 < argc ) {
+         sysDir = argv[++i];
+      } else if( strcmp( argv[i], "--proc" ) == 0 && i + 1 < argc ) {
+         procDir = argv[++i];
+      } else if( strcmp( argv[i], "--cgroup" ) == 0 && i + 1 < argc ) {
+         cgroupDir = argv[++i];
+      } else if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         intervalMS = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--count" ) == 0 && i + 1 < argc ) {
+         samples = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --epc-monitor [--sys DIR] [--proc DIR] [--cgroup DIR] [--interval MS] [--count N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( intervalMS <= 0 || samples <= 0 ) {
+      fprintf( stderr, "epc-monitor: The interval and count must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static uint64_t nodes[MAX_NODES];
+      static uint64_t lastNodes[MAX_NODES];
+      struct ksgxd_counters last = { 0, 0 };
+      struct ksgxd_counters now = { 0, 0 };
+      uint64_t capacity = 0;
+      uint64_t used = 0;
+      double ticksPerSecond = (double) sysconf( _SC_CLK_TCK );
+
+      int nodeCount = read_nodes( sysDir, nodes );
+      long pid = find_ksgxd( procDir );
+      bool accounted = cgroup_read_epc( cgroupDir, "misc.capacity", &capacity ) && cgroup_read_epc( cgroupDir, "misc.current", &used );
+
+      printf( "EPC reclaim monitor:  Every %ld ms (%s, %s)\n", intervalMS, sysDir, procDir );
+      if( nodeCount > 0 ) {
+         print_nodes( nodes );
+      } else {
+         printf( "  No node has %s/devices/system/node/nodeN/x86/sgx_total_bytes (an older kernel, or no SGX)\n", sysDir );
+      }
+
+      struct epc_section sections[NUMBER_OF_EPCs_TO_ENUMERATE];
+      int sectionCount = find_EPC_sections( sections, NUMBER_OF_EPCs_TO_ENUMERATE );
+      uint64_t enumerated = 0;
+      for( int s = 0 ; s < sectionCount ; s++ ) {
+         enumerated += sections[s].size;
+      }
+      printf( "  EPC enumerated by CPUID:  %" PRIu64 " MiB in %d section(s)\n", enumerated / MiB, sectionCount );
+
+      if( pid < 0 || !read_ksgxd( procDir, pid, &last ) ) {
+         printf( "  There's no " KSGXD " thread in %s (the in-kernel SGX driver isn't running)\n", procDir );
+         if( nodeCount == 0 ) {
+            return EXIT_FAILURE;
+         }
+         pid = -1;
+      } else {
+         printf( "  " KSGXD " is PID %ld and has used %.2f s of CPU\n", pid, (double) last.ticks / ticksPerSecond );
+      }
+      if( accounted ) {
+         printf( "  EPC in use (misc.current):  %" PRIu64 " of %" PRIu64 " MiB\n", used / MiB, capacity / MiB );
+      }
+
+      printf( "    Time (s)  " KSGXD " ms/s  Wakeups/s  EPC used (MiB)  Reclaim\n" );
+      printf( "    ========  ==========  =========  ==============  =======\n" );
+
+      struct timespec start, next, lastTime, nowTime;
+      clock_gettime( CLOCK_MONOTONIC, &start );
+      next = start;
+      lastTime = start;
+      memcpy( lastNodes, nodes, sizeof( nodes ) );
+      bool reclaiming = false;
+      long reclaimIntervals = 0;
+      uint64_t reclaimTicks = 0;
+
+      for( long s = 1 ; s <= samples ; s++ ) {
+         next.tv_sec  += intervalMS / 1000;
+         next.tv_nsec += (intervalMS % 1000) * 1000000;
+         if( next.tv_nsec >= 1000000000 ) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+         }
+         clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+         clock_gettime( CLOCK_MONOTONIC, &nowTime );
+         double elapsed = seconds_between( &lastTime, &nowTime );
+         lastTime = nowTime;
+
+         read_nodes( sysDir, nodes );
+         if( memcmp( nodes, lastNodes, sizeof( nodes ) ) != 0 ) {
+            printf( "    The EPC per node changed:\n  " );
+            print_nodes( nodes );
+            memcpy( lastNodes, nodes, sizeof( nodes ) );
+         }
+
+         bool active = false;
+         double cpuMs = 0;
+         double wakeups = 0;
+         if( pid >= 0 && read_ksgxd( procDir, pid, &now ) ) {
+            uint64_t ticks = now.ticks - last.ticks;
+            uint64_t switches = now.switches - last.switches;
+            active = ticks > 0 || switches > 0;
+            cpuMs = (double) ticks / ticksPerSecond * 1000 / elapsed;
+            wakeups = (double) switches / elapsed;
+            reclaimTicks += ticks;
+            last = now;
+         }
+         char usedText[32] = "-";
+         if( accounted && cgroup_read_epc( cgroupDir, "misc.current", &used ) ) {
+            snprintf( usedText, sizeof( usedText ), "%" PRIu64, used / MiB );
+         }
+
+         printf( "    %8.3f  %10.1f  %9.1f  %14s  %s\n", seconds_between( &start, &nowTime ), cpuMs, wakeups, usedText, active ? "yes" : "" );
+         if( active && !reclaiming ) {
+            printf( "  ALERT:  EPC reclaim started -- " KSGXD " is paging enclave memory out (EWB), so enclaves will fault it back in (ELDU)\n" );
+         } else if( !active && reclaiming ) {
+            printf( "  EPC reclaim stopped\n" );
+         }
+         reclaiming = active;
+         reclaimIntervals += active ? 1 : 0;
+         fflush( stdout );
+      }
+
+      printf( "  Reclaim in %ld of %ld intervals", reclaimIntervals, samples );
+      if( reclaimIntervals > 0 ) {
+         printf( ", " KSGXD " used %.0f ms of CPU.  The EPC is overcommitted:  Shrink or move enclaves\n"
+                 "  (see `--epc-plan` and `--epc-cgroup`)", (double) reclaimTicks / ticksPerSecond * 1000 );
+      }
+      printf( "\n" );
+      return EXIT_SUCCESS;
+
+   #else
+      (void) sysDir;
+      (void) procDir;
+      (void) cgroupDir;
+      printf( "The EPC monitor needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  epcmon.h - 2026
+//
+/// This module watches the in-kernel SGX driver's EPC per NUMA node and its
+/// reclaimer thread (`ksgxd`), and alerts when EPC reclaim starts.
+///
+/// @file   epcmon.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--epc-monitor [--sys DIR] [--proc DIR] [--cgroup DIR] [--interval MS] [--count N]`
+int epcmon_main( int argc, char* argv[] );
@@ -0,0 +1,508 @@
+///////////////////////////////////////////////////////////////////////////////
+//  epcsim.c - 2026
+//
+/// This module replays an enclave's page-access trace against the EPC to
+/// predict how much it will page before it's deployed.
+///
+/// A trace is a binary file:  A 16 byte header, then one 8 byte record per
+/// access, in the CPU's (little-endian) byte order:
+///
+///     char     magic[8];   // "EPCTRACE"
+///     uint32_t pageSize;   // 4096
+///     uint32_t reserved;   // 0
+///     { uint32_t page; uint32_t delta; } ...
+///
+/// `page` is the page number in the enclave (its offset / 4096, below 2^28)
+/// and `delta` is the microseconds since the previous access.  At 8 bytes an
+/// access, 500 million accesses is a 4 GB trace.
+///
+/// The model follows the in-kernel SGX driver (arch/x86/kernel/cpu/sgx):
+///
+///   - Resident pages are on an LRU list.  Every access sets the page's
+///     accessed (young) bit.
+///   - Reclaim isolates `SGX_NR_TO_SCAN` (16) pages from the head of the
+///     list.  Young pages have their bit cleared and go back to the tail;
+///     the rest are written back with one ETRACK and an EWB each.
+///   - When an allocation leaves fewer than `SGX_NR_LOW_PAGES` free, ksgxd
+///     wakes and reclaims batches until `SGX_NR_HIGH_PAGES` are free.  ksgxd
+///     runs in the background, but only as fast as EWB goes.  If the EPC runs
+///     out before it catches up, the faulting thread reclaims a batch itself
+///     (direct reclaim), and that's added to the fault.
+///   - Touching an evicted page faults and loads it back with ELDU.
+///   - Every 512 evicted pages need a Version Array (VA) page, which stays in
+///     the EPC, so the EPC shrinks as more is paged out.
+///
+/// The first touch of a page allocates it, but isn't counted as a fault.
+/// (On SGX1 every page is EADDed while the enclave is built, so an enclave
+/// that doesn't fit pages while it's being built too.)  The costs are
+/// ballpark figures for a server CPU -- `--eldu-us` and `--ewb-us` override
+/// them.  The enclave is assumed to have the EPC to itself.
+///
+/// To keep up with hundreds of millions of accesses, the page state is one
+/// byte per page in a flat array indexed by page number, the LRU list is a
+/// ring of 32-bit page numbers and the trace is read in large blocks.  A hit
+/// (the common case) touches one byte.
+///
+/// Usage:
+///
+///     test-sgx --epc-sim enclave.trace                 # Against this host's EPC
+///     test-sgx --epc-sim --epc 256 enclave.trace       # Against 256 MiB
+///     test-sgx --epc-sim --from host17.cap enclave.trace
+///     test-sgx --epc-sim --epc 64 --synthetic 65536,100000000
+///
+/// @see https://docs.kernel.org/arch/x86/sgx.html
+///
+/// @file   epcsim.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fopen() fread()
+#include <stdlib.h>    // For calloc() realloc() free() strtod() strtoull()
+#include <string.h>    // For strcmp() memcmp() memset()
+#include <inttypes.h>  // For PRIu64 uint64_t uint32_t uint8_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime() timespec_get()
+
+#include "epcsim.h"    // For obvious reasons
+#include "capture.h"   // For capture_load() capture_total_EPC()
+#include "cache.h"     // For cache_probe()
+#include "decode.h"    // For fields[] field_from_capture()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+#define PAGE_SIZE          4096
+
+/// From arch/x86/kernel/cpu/sgx/main.c & sgx.h
+#define SGX_NR_TO_SCAN       16
+#define SGX_NR_LOW_PAGES     32
+#define SGX_NR_HIGH_PAGES    64
+#define SGX_VA_SLOT_COUNT   512
+
+/// Default costs (ns).  A fault is the AEX, the kernel's fault handler, ELDU
+/// and ERESUME.
+#define DEFAULT_ELDU_NS   15000
+#define DEFAULT_EWB_NS    10000
+#define ETRACK_NS          5000  ///< ETRACK and the IPIs that flush the enclave's threads
+#define SCAN_NS            1000  ///< Aging a batch (walking the page tables)
+
+/// The records read at a time
+#define TRACE_BLOCK  65536
+
+/// The largest enclave we simulate:  1 TiB.  The page state is a byte a
+/// page, so a bad page number can't make us allocate more than 256 MiB.
+#define MAX_PAGES  ((uint32_t) 1 << 28)
+
+#define PAGE_RESIDENT  0x01
+#define PAGE_YOUNG     0x02
+#define PAGE_SEEN      0x04
+
+
+/// The header of a trace file
+struct trace_header {
+   char     magic[8];  ///< `EPCTRACE`
+   uint32_t pageSize;
+   uint32_t reserved;
+};
+
+
+/// One access in a trace file
+struct trace_record {
+   uint32_t page;
+   uint32_t delta;  ///< Microseconds since the previous access
+};
+
+
+/// The simulated EPC and what happened to it
+struct epc_sim {
+   uint8_t*  state;        ///< `PAGE_*` flags for every page, indexed by page number
+   uint64_t  stateSize;
+   uint32_t* lru;          ///< A ring of the resident pages, oldest first
+   uint64_t  lruSize;
+   uint64_t  head;
+   uint64_t  count;
+   uint64_t  freePages;
+
+   uint64_t  elduNs;
+   uint64_t  ewbNs;
+   uint64_t  now;          ///< ns, including the time the enclave stalled
+   uint64_t  traceNs;      ///< ns the trace itself covers
+   bool      ksgxdAwake;
+   uint64_t  ksgxdClock;   ///< How far ksgxd has got (ns)
+
+   uint64_t  accesses;
+   uint64_t  firstTouches;
+   uint64_t  faults;
+   uint64_t  evictions;
+   uint64_t  batches;
+   uint64_t  ksgxdBatches;
+   uint64_t  ksgxdNs;
+   uint64_t  directReclaims;  ///< Faults that had to reclaim a batch themselves
+   uint64_t  vaPages;
+   uint64_t  vaSlots;
+   uint64_t  outstanding;     ///< Pages that are paged out (each holds a VA slot)
+   uint64_t  addedNs;         ///< Time the enclave spent in faults & direct reclaim
+};
+
+
+/// Format a size like `48 KiB`, `1.5 MiB` or `64 GiB`
+static const char* format_size( uint64_t bytes, char* out, size_t size ) {
+   const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+   double value = (double) bytes;
+   int u = 0;
+
+   while( value >= 1024 && u < 4 ) {
+      value /= 1024;
+      u++;
+   }
+   snprintf( out, size, value == (double) (uint64_t) value ? "%.0f %s" : "%.1f %s", value, units[u] );
+   return out;
+}
+
+
+/// @return CLOCK_MONOTONIC (or, without POSIX clocks, the C11 wall clock)
+///         in seconds
+static double now_seconds( void ) {
+   struct timespec now;
+
+   #ifdef __linux__
+      clock_gettime( CLOCK_MONOTONIC, &now );
+   #else
+      timespec_get( &now, TIME_UTC );
+   #endif
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Add `page` to the tail of the LRU list
+static inline void lru_push( struct epc_sim* sim, uint32_t page ) {
+   uint64_t tail = sim->head + sim->count;
+   if( tail >= sim->lruSize ) {
+      tail -= sim->lruSize;
+   }
+   sim->lru[tail] = page;
+   sim->count++;
+}
+
+
+/// Take the page at the head of the LRU list
+static inline uint32_t lru_pop( struct epc_sim* sim ) {
+   uint32_t page = sim->lru[sim->head];
+   if( ++sim->head == sim->lruSize ) {
+      sim->head = 0;
+   }
+   sim->count--;
+   return page;
+}
+
+
+/// Reclaim one batch, like `sgx_reclaim_pages()`
+///
+/// @return How long it took (ns)
+static uint64_t reclaim_batch( struct epc_sim* sim ) {
+   uint32_t young[SGX_NR_TO_SCAN];
+   uint64_t youngCount = 0;
+   uint64_t evicted = 0;
+   uint64_t scan = sim->count < SGX_NR_TO_SCAN ? sim->count : SGX_NR_TO_SCAN;
+
+   for( uint64_t i = 0 ; i < scan ; i++ ) {
+      uint32_t page = lru_pop( sim );
+      if( sim->state[page] & PAGE_YOUNG ) {
+         sim->state[page] &= (uint8_t) ~PAGE_YOUNG;
+         young[youngCount++] = page;
+      } else {
+         sim->state[page] &= (uint8_t) ~PAGE_RESIDENT;
+         evicted++;
+      }
+   }
+   for( uint64_t i = 0 ; i < youngCount ; i++ ) {  // After the scan, so no page is scanned twice
+      lru_push( sim, young[i] );
+   }
+
+   sim->batches++;
+   sim->evictions   += evicted;
+   sim->freePages   += evicted;
+   sim->outstanding += evicted;
+   if( sim->outstanding > sim->vaSlots && sim->freePages > 0 ) {
+      sim->vaPages++;  // It's never reclaimed
+      sim->vaSlots += SGX_VA_SLOT_COUNT;
+      sim->freePages--;
+   }
+
+   return SCAN_NS + (evicted > 0 ? ETRACK_NS + evicted * sim->ewbNs : 0);
+}
+
+
+/// Let ksgxd catch up to `sim->now`
+static void run_ksgxd( struct epc_sim* sim ) {
+   while( sim->ksgxdAwake && sim->ksgxdClock < sim->now ) {
+      if( sim->freePages >= SGX_NR_HIGH_PAGES || sim->count == 0 ) {
+         sim->ksgxdAwake = false;
+         break;
+      }
+      uint64_t cost = reclaim_batch( sim );
+      sim->ksgxdClock += cost;
+      sim->ksgxdNs += cost;
+      sim->ksgxdBatches++;
+   }
+}
+
+
+/// Take a free page, reclaiming directly if there isn't one
+///
+/// @return The time the allocating thread spent reclaiming (ns)
+static uint64_t allocate( struct epc_sim* sim ) {
+   uint64_t cost = 0;
+
+   if( sim->freePages == 0 && sim->count > 0 ) {
+      sim->directReclaims++;
+      while( sim->freePages == 0 && sim->count > 0 ) {
+         cost += reclaim_batch( sim );
+      }
+   }
+   if( sim->freePages > 0 ) {
+      sim->freePages--;
+   }
+   if( sim->freePages < SGX_NR_LOW_PAGES && !sim->ksgxdAwake ) {
+      sim->ksgxdAwake = true;
+      sim->ksgxdClock = sim->now;
+   }
+   return cost;
+}
+
+
+/// Make room for pages up to `page`
+///
+/// @return `false` if we're out of memory
+static bool grow_state( struct epc_sim* sim, uint32_t page ) {
+   uint64_t size = sim->stateSize == 0 ? 65536 : sim->stateSize;
+   while( size <= page ) {
+      size *= 2;
+   }
+   uint8_t* state = realloc( sim->state, size );
+   if( state == NULL ) {
+      return false;
+   }
+   memset( state + sim->stateSize, 0, size - sim->stateSize );
+   sim->state = state;
+   sim->stateSize = size;
+   return true;
+}
+
+
+/// Replay one access
+static inline void access_page( struct epc_sim* sim, uint32_t page, uint32_t deltaUs ) {
+   uint64_t delta = (uint64_t) deltaUs * 1000;
+   sim->now     += delta;
+   sim->traceNs += delta;
+   sim->accesses++;
+
+   uint8_t state = sim->state[page];
+   if( state & PAGE_RESIDENT ) {
+      sim->state[page] = state | PAGE_YOUNG;
+      return;
+   }
+
+   uint64_t cost = 0;
+   if( state & PAGE_SEEN ) {
+      sim->faults++;
+      sim->outstanding--;
+      cost += sim->elduNs;
+   } else {
+      sim->firstTouches++;
+   }
+   run_ksgxd( sim );
+   cost += allocate( sim );
+   lru_push( sim, page );
+   sim->state[page] |= PAGE_SEEN | PAGE_RESIDENT | PAGE_YOUNG;
+   sim->addedNs += cost;
+   sim->now += cost;  // The enclave thread stalls
+}
+
+
+/// Replay the trace in `fileName`
+///
+/// @return `false` if it couldn't be read
+static bool replay_file( struct epc_sim* sim, const char* fileName ) {
+   static struct trace_record records[TRACE_BLOCK];
+   struct trace_header header;
+
+   FILE* file = fopen( fileName, "rb" );
+   if( file == NULL ) {
+      fprintf( stderr, PROGRAM_NAME ": Can't open %s\n", fileName );
+      return false;
+   }
+   if( fread( &header, sizeof( header ), 1, file ) != 1 || memcmp( header.magic, "EPCTRACE", 8 ) != 0 || header.pageSize != PAGE_SIZE ) {
+      fprintf( stderr, PROGRAM_NAME ": %s isn't a trace of 4 KiB pages\n", fileName );
+      fclose( file );
+      return false;
+   }
+
+   // Read bytes, not records, so a partial record at the end is noticed
+   size_t bytes;
+   while( (bytes = fread( records, 1, sizeof( records ), file )) > 0 ) {
+      size_t count = bytes / sizeof( records[0] );
+      for( size_t i = 0 ; i < count ; i++ ) {
+         if( records[i].page >= MAX_PAGES ) {
+            fprintf( stderr, PROGRAM_NAME ": Page %" PRIu32 " in %s is beyond the largest enclave we simulate (%" PRIu32 " pages)\n", records[i].page, fileName, MAX_PAGES );
+            fclose( file );
+            return false;
+         }
+         if( records[i].page >= sim->stateSize && !grow_state( sim, records[i].page ) ) {
+            fprintf( stderr, PROGRAM_NAME ": Out of memory at page %" PRIu32 "\n", records[i].page );
+            fclose( file );
+            return false;
+         }
+         access_page( sim, records[i].page, records[i].delta );
+      }
+      if( bytes % sizeof( records[0] ) != 0 ) {
+         fprintf( stderr, PROGRAM_NAME ": %s ends with a partial record.  Is it truncated?\n", fileName );
+         fclose( file );
+         return false;
+      }
+   }
+   bool ok = !ferror( file );
+   fclose( file );
+   return ok;
+}
+
+
+/// Replay a synthetic trace:  90% of the accesses go to a hot tenth of
+/// `pages`, the rest anywhere, one microsecond apart
+static bool replay_synthetic( struct epc_sim* sim, uint32_t pages, uint64_t accesses ) {
+   uint64_t x = 0x9E3779B97F4A7C15;  // xorshift64 state
+   uint32_t hot = pages / 10 > 0 ? pages / 10 : 1;
+
+   if( !grow_state( sim, pages - 1 ) ) {
+      return false;
+   }
+   for( uint64_t i = 0 ; i < accesses ; i++ ) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      uint32_t r = (uint32_t) (x >> 32);
+      uint32_t page = (x & 0xFF) < 230 ? r % hot : r % pages;  // 230/256 is about 90%
+      access_page( sim, page, 1 );
+   }
+   return true;
+}
+
+
+/// `--epc-sim [--from CAPTURE] [--epc MIB] [--eldu-us US] [--ewb-us US] TRACE | --synthetic PAGES,ACCESSES`
+int epcsim_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;  // Too big for the stack
+   static struct epc_sim sim;
+   const char* fromFile = NULL;
+   const char* traceFile = NULL;
+   double epcMiB = 0;
+   double elduUs = DEFAULT_ELDU_NS / 1000.0;
+   double ewbUs = DEFAULT_EWB_NS / 1000.0;
+   unsigned long long synthPages = 0;
+   unsigned long long synthAccesses = 0;
+   bool usage = false;
+
+   for( int i = 1 ; i < argc && !usage ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( strcmp( argv[i], "--epc" ) == 0 && i + 1 < argc ) {
+         epcMiB = strtod( argv[++i], NULL );
+      } else if( strcmp( argv[i], "--eldu-us" ) == 0 && i + 1 < argc ) {
+         elduUs = strtod( argv[++i], NULL );
+      } else if( strcmp( argv[i], "--ewb-us" ) == 0 && i + 1 < argc ) {
+         ewbUs = strtod( argv[++i], NULL );
+      } else if( strcmp( argv[i], "--synthetic" ) == 0 && i + 1 < argc ) {
+         usage = sscanf( argv[++i], "%llu,%llu", &synthPages, &synthAccesses ) != 2 || synthPages == 0 || synthPages > MAX_PAGES;
+      } else if( traceFile == NULL && argv[i][0] != '-' ) {
+         traceFile = argv[i];
+      } else {
+         usage = true;
+      }
+   }
+   if( usage || (traceFile == NULL) == (synthPages == 0) || epcMiB < 0 || elduUs < 0 || ewbUs < 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --epc-sim [--from CAPTURE] [--epc MIB] [--eldu-us US] [--ewb-us US] TRACE\n" );
+      fprintf( stderr, "       " PROGRAM_NAME " --epc-sim [--from CAPTURE] [--epc MIB] [--eldu-us US] [--ewb-us US] --synthetic PAGES,ACCESSES\n" );
+      return EXIT_FAILURE;
+   }
+
+   // The EPC
+   uint64_t epcBytes = (uint64_t) (epcMiB * 1024 * 1024);
+   const char* epcSource = "--epc";
+   if( epcBytes == 0 ) {
+      if( fromFile != NULL ) {
+         if( !capture_load( fromFile, &cap ) ) {
+            return EXIT_FAILURE;
+         }
+      } else {
+         cache_probe( &cap, false );
+      }
+      uint64_t sgx = 0;
+      field_from_capture( &fields[FIELD_SGX], &cap, &sgx );
+      epcBytes = sgx ? capture_total_EPC( &cap ) : 0;
+      epcSource = "CPUID";
+   }
+   uint64_t epcPages = epcBytes / PAGE_SIZE;
+   if( epcPages <= SGX_NR_HIGH_PAGES ) {
+      fprintf( stderr, PROGRAM_NAME ": There's no EPC to simulate%s.  Give its size with --epc MIB.\n", epcBytes == 0 ? " on this host" : " (it's too small)" );
+      return EXIT_FAILURE;
+   }
+
+   memset( &sim, 0, sizeof( sim ) );
+   sim.lruSize   = epcPages;
+   sim.freePages = epcPages - 1;  // The SECS
+   sim.elduNs    = (uint64_t) (elduUs * 1000);
+   sim.ewbNs     = (uint64_t) (ewbUs * 1000);
+   sim.lru       = calloc( epcPages, sizeof( sim.lru[0] ) );
+   if( sim.lru == NULL ) {
+      fprintf( stderr, PROGRAM_NAME ": Out of memory\n" );
+      return EXIT_FAILURE;
+   }
+
+   char size1[32];
+   char size2[32];
+   char size3[32];
+   printf( "EPC paging simulation:  " );
+   if( traceFile != NULL ) {
+      printf( "%s\n", traceFile );
+   } else {
+      printf( "synthetic, %llu pages, %llu accesses (90%% to a hot tenth)\n", synthPages, synthAccesses );
+   }
+   printf( "  EPC:  %s (%s), %" PRIu64 " pages\n", format_size( epcPages * PAGE_SIZE, size1, sizeof( size1 ) ), epcSource, epcPages );
+   printf( "  Costs:  ELDU fault %.1f us, EWB %.1f us a page, ETRACK %.1f us a batch of %d\n"
+          ,elduUs, ewbUs, ETRACK_NS / 1000.0, SGX_NR_TO_SCAN );
+
+   double start = now_seconds();
+   bool ok = traceFile != NULL ? replay_file( &sim, traceFile ) : replay_synthetic( &sim, (uint32_t) synthPages, synthAccesses );
+   double seconds = now_seconds() - start;
+   free( sim.lru );
+   free( sim.state );
+   if( !ok ) {
+      return EXIT_FAILURE;
+   }
+
+   double simulated = (double) sim.now / 1e9;
+   uint64_t trafficOut = sim.evictions * PAGE_SIZE;
+   uint64_t trafficIn  = sim.faults * PAGE_SIZE;
+
+   printf( "  Accesses:            %" PRIu64 " over %.3f s of trace\n", sim.accesses, (double) sim.traceNs / 1e9 );
+   printf( "  Footprint:           %" PRIu64 " pages (%s)\n", sim.firstTouches, format_size( sim.firstTouches * PAGE_SIZE, size1, sizeof( size1 ) ) );
+   printf( "  Faults (ELDU):       %" PRIu64 " (%.3f%% of accesses)\n", sim.faults, sim.accesses == 0 ? 0 : 100.0 * (double) sim.faults / (double) sim.accesses );
+   printf( "  Evictions (EWB):     %" PRIu64 " in %" PRIu64 " batches (%" PRIu64 " by ksgxd)\n", sim.evictions, sim.batches, sim.ksgxdBatches );
+   printf( "  Direct reclaim:      %" PRIu64 " faults had to reclaim a batch themselves\n", sim.directReclaims );
+   printf( "  VA pages:            %" PRIu64 " (%s of EPC)\n", sim.vaPages, format_size( sim.vaPages * PAGE_SIZE, size1, sizeof( size1 ) ) );
+   printf( "  Paging traffic:      %s out, %s in (%s/s)\n"
+          ,format_size( trafficOut, size1, sizeof( size1 ) )
+          ,format_size( trafficIn, size2, sizeof( size2 ) )
+          ,format_size( simulated > 0 ? (uint64_t) ((double) (trafficOut + trafficIn) / simulated) : 0, size3, sizeof( size3 ) ) );
+   printf( "  Added latency:       %.3f s (%.2f us an access, %.1f%% of the run)\n"
+          ,(double) sim.addedNs / 1e9
+          ,sim.accesses == 0 ? 0 : (double) sim.addedNs / 1000 / (double) sim.accesses
+          ,sim.now == 0 ? 0 : 100.0 * (double) sim.addedNs / (double) sim.now );
+   printf( "  ksgxd:               %.3f s of CPU (%.1f%% of one CPU)\n", (double) sim.ksgxdNs / 1e9, sim.now == 0 ? 0 : 100.0 * (double) sim.ksgxdNs / (double) sim.now );
+   printf( "  Simulated in %.2f s (%.1f M accesses/s)\n", seconds, seconds > 0 ? (double) sim.accesses / seconds / 1e6 : 0 );
+
+   if( sim.evictions == 0 ) {
+      printf( "The enclave fits in the EPC\n" );
+   } else {
+      printf( "The enclave pages:  Its footprint is %.1fx the EPC\n", (double) sim.firstTouches / (double) epcPages );
+   }
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  epcsim.h - 2026
+//
+/// This module replays an enclave's page-access trace against the EPC to
+/// predict how much it will page before it's deployed.
+///
+/// @file   epcsim.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--epc-sim [--from CAPTURE] [--epc MIB] [--eldu-us US] [--ewb-us US] TRACE | --synthetic PAGES,ACCESSES`
+int epcsim_main( int argc, char* argv[] );
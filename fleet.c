@@ -0,0 +1,505 @@
+///////////////////////////////////////////////////////////////////////////////
+//  fleet.c - 2026
+//
+/// This module aggregates captures from many nodes, deduplicates identical
+/// CPUID sets and answers feature queries over the whole fleet.
+///
+/// Most nodes in a fleet report exactly the same CPUID leaves, so each
+/// distinct CPUID set is stored once and addressed by its FNV-1a hash.  Nodes
+/// only hold a reference to their CPUID set.
+///
+/// Decoded features are kept in a columnar bitset index:  one bitset per
+/// feature with one bit per node.  A query like `sgx2,epc>=64G` is answered
+/// by AND-ing the columns together a word at a time and counting the bits.
+///
+/// Usage:
+///
+///     test-sgx --capture host17.cap             # On every node
+///     test-sgx --fleet *.cap                    # Summarize the fleet
+///     test-sgx --fleet --query 'sgx2,epc>=64G' --list *.cap
+///     test-sgx --fleet --readme *.cap           # Hardware table for README.md
+///
+/// A query is a comma-separated list of column names.  Prefix a column with
+/// `!` to negate it.  All of the terms must match.
+///
+/// @file   fleet.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fopen() snprintf()
+#include <time.h>      // For time() localtime() strftime()
+#include <stdlib.h>    // For calloc() realloc() free()
+#include <string.h>    // For strcmp() strtok()
+#include <inttypes.h>  // For PRIx64 uint64_t
+#include <ctype.h>     // For isprint()
+
+#if defined( _MSC_VER )
+   #include <intrin.h>    // For __popcnt64() _BitScanForward64()
+#endif
+
+#include "fleet.h"     // For obvious reasons
+#include "capture.h"   // For struct sgx_capture capture_read()
+#include "decode.h"    // For fields[] xsave_components[] field_from_capture()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The largest number of terms in a single query
+#define MAX_QUERY_TERMS 32
+
+/// The number of bits in a bitset word
+#define WORD_BITS 64
+
+
+/// @return The number of bits set in `word`
+static inline int popcount64( uint64_t word ) {
+#if !defined( _MSC_VER )
+   return __builtin_popcountll( word );
+#else
+   return (int) __popcnt64( word );
+#endif
+}
+
+
+/// @return The index of the lowest bit set in `word` (which isn't 0)
+static inline int lowest_bit( uint64_t word ) {
+#if !defined( _MSC_VER )
+   return __builtin_ctzll( word );
+#else
+   unsigned long index = 0;
+   _BitScanForward64( &index, word );
+   return (int) index;
+#endif
+}
+
+
+/// How a column is decoded from a capture
+enum column_kind {
+   COLUMN_FIELD,         ///< A field from `fields[]`
+   COLUMN_XFRM,          ///< An XSAVE component in the XFRM allowed by CPUID.(EAX=12H, ECX=1)
+   COLUMN_EPC_AT_LEAST   ///< The total EPC is at least `arg` bytes
+};
+
+
+/// One column of the bitset index
+struct fleet_column {
+   const char*      name;
+   enum column_kind kind;
+   uint64_t         arg;   ///< `enum field_id`, `enum xsave_component_id` or EPC threshold
+};
+
+
+#define GiB ((uint64_t) 1 << 30)
+#define MiB ((uint64_t) 1 << 20)
+
+static const struct fleet_column columns[] = {
+   { "sgx",              COLUMN_FIELD,        FIELD_SGX },
+   { "sgx_lc",           COLUMN_FIELD,        FIELD_SGX_LC },
+   { "sgx_keys",         COLUMN_FIELD,        FIELD_SGX_KEYS },
+   { "sgx1",             COLUMN_FIELD,        FIELD_SGX1 },
+   { "sgx2",             COLUMN_FIELD,        FIELD_SGX2 },
+   { "oversub_vmx",      COLUMN_FIELD,        FIELD_OVERSUB_VMX },
+   { "oversub_super",    COLUMN_FIELD,        FIELD_OVERSUB_SUPERVISOR },
+   { "everifyreport2",   COLUMN_FIELD,        FIELD_EVERIFYREPORT2 },
+   { "eupdatesvn",       COLUMN_FIELD,        FIELD_EUPDATESVN },
+   { "edeccssa",         COLUMN_FIELD,        FIELD_EDECCSSA },
+   { "cet",              COLUMN_FIELD,        FIELD_SECS_CET },
+   { "kss",              COLUMN_FIELD,        FIELD_SECS_KSS },
+   { "aexnotify",        COLUMN_FIELD,        FIELD_SECS_AEXNOTIFY },
+   { "xfrm.avx",         COLUMN_XFRM,         XSTATE_AVX },
+   { "xfrm.bndreg",      COLUMN_XFRM,         XSTATE_BNDREG },
+   { "xfrm.bndcsr",      COLUMN_XFRM,         XSTATE_BNDCSR },
+   { "xfrm.opmask",      COLUMN_XFRM,         XSTATE_OPMASK },
+   { "xfrm.zmm_hi256",   COLUMN_XFRM,         XSTATE_ZMM_HI256 },
+   { "xfrm.hi16_zmm",    COLUMN_XFRM,         XSTATE_HI16_ZMM },
+   { "xfrm.pkru",        COLUMN_XFRM,         XSTATE_PKRU },
+   { "xfrm.tilecfg",     COLUMN_XFRM,         XSTATE_TILECFG },
+   { "xfrm.tiledata",    COLUMN_XFRM,         XSTATE_TILEDATA },
+   { "xfrm.apx",         COLUMN_XFRM,         XSTATE_APX },
+   { "epc>=128M",        COLUMN_EPC_AT_LEAST, 128 * MiB },
+   { "epc>=1G",          COLUMN_EPC_AT_LEAST,   1 * GiB },
+   { "epc>=8G",          COLUMN_EPC_AT_LEAST,   8 * GiB },
+   { "epc>=64G",         COLUMN_EPC_AT_LEAST,  64 * GiB },
+   { "epc>=256G",        COLUMN_EPC_AT_LEAST, 256 * GiB },
+   { "epc>=512G",        COLUMN_EPC_AT_LEAST, 512 * GiB },
+   { "msr.sgx_enable",   COLUMN_FIELD,        FIELD_FC_SGX_ENABLE },
+   { "msr.lc_writable",  COLUMN_FIELD,        FIELD_FC_SGX_LC },
+};
+
+#define COLUMN_COUNT (sizeof( columns ) / sizeof( columns[0] ))
+
+
+/// The whole fleet
+struct fleet {
+   struct sgx_capture* classes;       ///< One capture per distinct CPUID set
+   uint64_t* class_hash;
+   uint32_t* class_nodes;             ///< How many nodes share each CPUID set
+   uint32_t  class_count;
+   uint32_t  class_capacity;
+
+   uint32_t* slots;                   ///< Open-addressed hash -> class index + 1
+   uint32_t  slot_count;              ///< Always a power of 2
+
+   char    (*node_name)[CAPTURE_NODE_NAME_SIZE];
+   uint32_t* node_class;
+   uint32_t  node_count;
+   uint32_t  node_capacity;           ///< Always a multiple of WORD_BITS
+
+   uint64_t* bits[COLUMN_COUNT];      ///< The columnar bitset index
+};
+
+
+/// Allocate or grow `*p` to `count` elements of `size` bytes, zeroing the new
+/// part.  Exit if we run out of memory.
+static void grow( void* p, size_t oldCount, size_t count, size_t size ) {
+   void** pp = p;
+   void* q = realloc( *pp, count * size );
+   if( q == NULL ) {
+      fprintf( stderr, "fleet: Out of memory\n" );
+      exit( EXIT_FAILURE );
+   }
+   memset( (char*) q + oldCount * size, 0, (count - oldCount) * size );
+   *pp = q;
+}
+
+
+/// Decode one column for one capture.  Everything goes through the same
+/// field decoder that the live report uses.
+static bool column_value( const struct fleet_column* column, const struct sgx_capture* cap ) {
+   uint64_t value = 0;
+   uint64_t xfrmLo = 0;
+   uint64_t xfrmHi = 0;
+
+   switch( column->kind ) {
+      case COLUMN_FIELD:
+         return field_from_capture( &fields[column->arg], cap, &value ) && value != 0;
+
+      case COLUMN_XFRM:
+         if(   !field_from_capture( &fields[FIELD_XFRM_LO], cap, &xfrmLo )
+            || !field_from_capture( &fields[FIELD_XFRM_HI], cap, &xfrmHi ) ) {
+            return false;
+         }
+         return field_extract( &xsave_components[column->arg], xfrmHi << 32 | xfrmLo ) != 0;
+
+      case COLUMN_EPC_AT_LEAST:
+         return capture_total_EPC( cap ) >= column->arg;
+   }
+
+   return false;
+}
+
+
+/// Find the class for `cap`'s CPUID set, adding a new one if it's not there
+static uint32_t fleet_intern_class( struct fleet* fleet, const struct sgx_capture* cap ) {
+   uint64_t hash = capture_cpuid_hash( cap );
+
+   // Keep the load factor under 1/2
+   if( (fleet->class_count + 1) * 2 > fleet->slot_count ) {
+      uint32_t newCount = fleet->slot_count ? fleet->slot_count * 2 : 64;
+      uint32_t* newSlots = calloc( newCount, sizeof( uint32_t ) );
+      if( newSlots == NULL ) {
+         fprintf( stderr, "fleet: Out of memory\n" );
+         exit( EXIT_FAILURE );
+      }
+      for( uint32_t c = 0 ; c < fleet->class_count ; c++ ) {
+         uint32_t s = fleet->class_hash[c] & (newCount - 1);
+         while( newSlots[s] != 0 ) {
+            s = (s + 1) & (newCount - 1);
+         }
+         newSlots[s] = c + 1;
+      }
+      free( fleet->slots );
+      fleet->slots = newSlots;
+      fleet->slot_count = newCount;
+   }
+
+   uint32_t s = hash & (fleet->slot_count - 1);
+   while( fleet->slots[s] != 0 ) {
+      uint32_t c = fleet->slots[s] - 1;
+      if( fleet->class_hash[c] == hash && capture_cpuid_equal( &fleet->classes[c], cap ) ) {
+         return c;
+      }
+      s = (s + 1) & (fleet->slot_count - 1);
+   }
+
+   if( fleet->class_count == fleet->class_capacity ) {
+      uint32_t newCapacity = fleet->class_capacity ? fleet->class_capacity * 2 : 8;
+      grow( &fleet->classes,     fleet->class_capacity, newCapacity, sizeof( fleet->classes[0] ) );
+      grow( &fleet->class_hash,  fleet->class_capacity, newCapacity, sizeof( fleet->class_hash[0] ) );
+      grow( &fleet->class_nodes, fleet->class_capacity, newCapacity, sizeof( fleet->class_nodes[0] ) );
+      fleet->class_capacity = newCapacity;
+   }
+
+   uint32_t c = fleet->class_count++;
+   fleet->classes[c] = *cap;
+   fleet->classes[c].msr_count = 0;  // MSRs belong to nodes, not classes
+   fleet->class_hash[c] = hash;
+   fleet->slots[s] = c + 1;
+
+   return c;
+}
+
+
+/// Add one node to the fleet and index its features
+static void fleet_add( struct fleet* fleet, const struct sgx_capture* cap ) {
+   if( fleet->node_count == fleet->node_capacity ) {
+      uint32_t newCapacity = fleet->node_capacity ? fleet->node_capacity * 2 : 1024;
+      grow( &fleet->node_name,  fleet->node_capacity, newCapacity, sizeof( fleet->node_name[0] ) );
+      grow( &fleet->node_class, fleet->node_capacity, newCapacity, sizeof( fleet->node_class[0] ) );
+      for( size_t col = 0 ; col < COLUMN_COUNT ; col++ ) {
+         grow( &fleet->bits[col], fleet->node_capacity / WORD_BITS, newCapacity / WORD_BITS, sizeof( uint64_t ) );
+      }
+      fleet->node_capacity = newCapacity;
+   }
+
+   uint32_t n = fleet->node_count++;
+   uint32_t c = fleet_intern_class( fleet, cap );
+
+   snprintf( fleet->node_name[n], sizeof( fleet->node_name[n] ), "%s", cap->node );
+   fleet->node_class[n] = c;
+   fleet->class_nodes[c]++;
+
+   for( size_t col = 0 ; col < COLUMN_COUNT ; col++ ) {
+      if( column_value( &columns[col], cap ) ) {
+         fleet->bits[col][n / WORD_BITS] |= (uint64_t) 1 << (n % WORD_BITS);
+      }
+   }
+}
+
+
+/// Find a column by name
+///
+/// @return The column index or -1 if there isn't one
+static int find_column( const char* name ) {
+   for( size_t col = 0 ; col < COLUMN_COUNT ; col++ ) {
+      if( strcmp( columns[col].name, name ) == 0 ) {
+         return (int) col;
+      }
+   }
+   return -1;
+}
+
+
+/// Count the nodes that have every feature in `query`.  If `list`, print them.
+///
+/// @return The number of matching nodes or -1 if the query is malformed
+static long fleet_query( const struct fleet* fleet, const char* query, bool list ) {
+   int  term[MAX_QUERY_TERMS];
+   bool negate[MAX_QUERY_TERMS];
+   int  termCount = 0;
+
+   char buffer[512];
+   snprintf( buffer, sizeof( buffer ), "%s", query );
+
+   for( char* token = strtok( buffer, ", " ) ; token != NULL ; token = strtok( NULL, ", " ) ) {
+      if( termCount == MAX_QUERY_TERMS ) {
+         fprintf( stderr, "fleet: Too many terms in query [%s]\n", query );
+         return -1;
+      }
+      negate[termCount] = token[0] == '!';
+      term[termCount] = find_column( token + negate[termCount] );
+      if( term[termCount] < 0 ) {
+         fprintf( stderr, "fleet: Unknown column [%s]\n", token );
+         return -1;
+      }
+      termCount++;
+   }
+
+   long matches = 0;
+   uint32_t words = (fleet->node_count + WORD_BITS - 1) / WORD_BITS;
+
+   for( uint32_t w = 0 ; w < words ; w++ ) {
+      uint64_t word = ~(uint64_t) 0;
+
+      if( w == words - 1 && fleet->node_count % WORD_BITS != 0 ) {
+         word = ((uint64_t) 1 << (fleet->node_count % WORD_BITS)) - 1;
+      }
+
+      for( int t = 0 ; t < termCount ; t++ ) {
+         uint64_t column = fleet->bits[term[t]][w];
+         word &= negate[t] ? ~column : column;
+      }
+
+      matches += popcount64( word );
+
+      while( list && word != 0 ) {
+         int bit = lowest_bit( word );
+         printf( "  %s\n", fleet->node_name[w * WORD_BITS + bit] );
+         word &= word - 1;
+      }
+   }
+
+   return matches;
+}
+
+
+/// Copy the processor brand string from a capture into `brand`
+static void capture_brand_string( const struct sgx_capture* cap, char* brand, size_t size ) {
+   char raw[49] = { 0 };
+   int  len = 0;
+
+   for( uint32_t leaf = 0x80000002 ; leaf <= 0x80000004 ; leaf++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( cap, leaf, 0 );
+      if( r == NULL ) {
+         break;
+      }
+      uint32_t regs[4] = { r->eax, r->ebx, r->ecx, r->edx };
+      for( int i = 0 ; i < 16 ; i++ ) {
+         char c = (regs[i / 4] >> ((i % 4) * 8)) & 0xFF;
+         raw[len++] = isprint( (unsigned char) c ) ? c : '\0';
+      }
+   }
+
+   const char* start = raw;
+   while( *start == ' ' ) {
+      start++;
+   }
+
+   snprintf( brand, size, "%s", *start ? start : "Unknown CPU" );
+}
+
+
+/// Format a byte count as MiB or GiB
+static void format_bytes( uint64_t bytes, char* out, size_t size ) {
+   if( bytes >= GiB && bytes % GiB == 0 ) {
+      snprintf( out, size, "%" PRIu64 " GiB", bytes / GiB );
+   } else {
+      snprintf( out, size, "%" PRIu64 " MiB", bytes / MiB );
+   }
+}
+
+
+/// Print one row per distinct CPUID set in the columns of README.md's
+/// hardware tables.  A capture can't tell what kind of device or whose it
+/// is, so those are left as `-` to fill in.  The CPU, its SGX features and
+/// EPC go in Model, and a node of the class in Confirmed.
+static void fleet_print_readme_table( const struct fleet* fleet ) {
+   const struct fleet_column* sgx1 = &columns[find_column( "sgx1" )];
+   const struct fleet_column* sgx2 = &columns[find_column( "sgx2" )];
+   const struct fleet_column* flc  = &columns[find_column( "sgx_lc" )];
+
+   char date[32];
+   time_t now = time( NULL );
+   strftime( date, sizeof( date ), "%d %b %Y", localtime( &now ) );
+
+   printf( "| Device | Vendor | Model |  Source | Date | Confirmed |\n" );
+   printf( "|--------|--------|-------|---------|------|-----------|\n" );
+
+   for( uint32_t c = 0 ; c < fleet->class_count ; c++ ) {
+      const struct sgx_capture* cap = &fleet->classes[c];
+      char brand[64];
+      char epc[32];
+
+      capture_brand_string( cap, brand, sizeof( brand ) );
+      format_bytes( capture_total_EPC( cap ), epc, sizeof( epc ) );
+
+      uint32_t node = 0;
+      while( node < fleet->node_count && fleet->node_class[node] != c ) {
+         node++;
+      }
+
+      printf( "| - | - | %s (%s%s%s, %s EPC) | `test-sgx --fleet` | %s | %s"
+             ,brand
+             ,column_value( sgx2, cap ) ? "SGX2" : column_value( sgx1, cap ) ? "SGX1" : "no SGX"
+             ,column_value( flc,  cap ) ? ", " : ""
+             ,column_value( flc,  cap ) ? "FLC" : ""
+             ,epc
+             ,date[0] == '0' ? date + 1 : date
+             ,node < fleet->node_count ? fleet->node_name[node] : "-" );
+      if( fleet->class_nodes[c] > 1 ) {
+         printf( " and %" PRIu32 " more", fleet->class_nodes[c] - 1 );
+      }
+      printf( " |\n" );
+   }
+}
+
+
+/// Print the fleet summary:  distinct CPUID sets and the population of each
+/// column
+static void fleet_print_summary( const struct fleet* fleet ) {
+   printf( "Fleet: %" PRIu32 " nodes, %" PRIu32 " distinct CPUID sets\n", fleet->node_count, fleet->class_count );
+
+   for( uint32_t c = 0 ; c < fleet->class_count ; c++ ) {
+      char brand[64];
+      char epc[32];
+
+      capture_brand_string( &fleet->classes[c], brand, sizeof( brand ) );
+      format_bytes( capture_total_EPC( &fleet->classes[c] ), epc, sizeof( epc ) );
+      printf( "  CPUID set %016" PRIx64 "  nodes: %-8" PRIu32 " EPC: %-10s CPU: %s\n"
+             ,fleet->class_hash[c], fleet->class_nodes[c], epc, brand );
+   }
+
+   printf( "  %-18s Nodes\n", "Column" );
+   for( size_t col = 0 ; col < COLUMN_COUNT ; col++ ) {
+      printf( "  %-18s %ld\n", columns[col].name, fleet_query( fleet, columns[col].name, false ) );
+   }
+}
+
+
+/// Read every capture in `file` into the fleet
+static void fleet_load( struct fleet* fleet, FILE* file, const char* name ) {
+   static struct sgx_capture cap;  // Too big for the stack
+   struct capture_reader reader;
+
+   capture_reader_init( &reader, file, name );
+   while( capture_read( &reader, &cap ) ) {
+      fleet_add( fleet, &cap );
+   }
+}
+
+
+/// `--fleet [--query EXPR]... [--list] [--readme] FILE...`
+int fleet_main( int argc, char* argv[] ) {
+   static struct fleet fleet;
+   const char* queries[MAX_QUERY_TERMS];
+   int  queryCount = 0;
+   bool list = false;
+   bool readme = false;
+   int  fileCount = 0;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--query" ) == 0 && i + 1 < argc ) {
+         if( queryCount < MAX_QUERY_TERMS ) {
+            queries[queryCount++] = argv[++i];
+         }
+      } else if( strcmp( argv[i], "--list" ) == 0 ) {
+         list = true;
+      } else if( strcmp( argv[i], "--readme" ) == 0 ) {
+         readme = true;
+      } else if( strcmp( argv[i], "-" ) == 0 ) {
+         fleet_load( &fleet, stdin, "stdin" );
+         fileCount++;
+      } else {
+         FILE* file = fopen( argv[i], "r" );
+         if( file == NULL ) {
+            fprintf( stderr, "fleet: Unable to open [%s]\n", argv[i] );
+            return EXIT_FAILURE;
+         }
+         fleet_load( &fleet, file, argv[i] );
+         fclose( file );
+         fileCount++;
+      }
+   }
+
+   if( fileCount == 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --fleet [--query EXPR]... [--list] [--readme] FILE...\n" );
+      return EXIT_FAILURE;
+   }
+
+   if( readme ) {
+      fleet_print_readme_table( &fleet );
+      return EXIT_SUCCESS;
+   }
+
+   fleet_print_summary( &fleet );
+
+   for( int q = 0 ; q < queryCount ; q++ ) {
+      printf( "Query [%s]:\n", queries[q] );
+      long matches = fleet_query( &fleet, queries[q], list );
+      if( matches < 0 ) {
+         return EXIT_FAILURE;
+      }
+      printf( "  %ld of %" PRIu32 " nodes match\n", matches, fleet.node_count );
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  fleet.h - 2026
+//
+/// This module aggregates captures from many nodes, deduplicates identical
+/// CPUID sets and answers feature queries over the whole fleet.
+///
+/// @file   fleet.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--fleet [--query EXPR]... [--list] [--readme] FILE...`
+int fleet_main( int argc, char* argv[] );
@@ -0,0 +1,506 @@
+///////////////////////////////////////////////////////////////////////////////
+//  freq.c - 2026
+//
+/// This module samples the effective frequency of CPUs with IA32_APERF and
+/// IA32_MPERF.
+///
+/// IA32_MPERF counts at the base (TSC) frequency and IA32_APERF counts at the
+/// actual frequency, both only while the CPU is in C0.  So over an interval:
+///
+///     effective frequency = base frequency * ΔAPERF / ΔMPERF
+///     busy                = ΔMPERF / ΔTSC
+///
+/// A core that is busy but running below its base frequency is being
+/// throttled -- for example by the AVX-512 license when an enclave uses wide
+/// vectors, or by a power or thermal limit.
+///
+/// The counters are read from (in order of preference):
+///
+///   - `perf`:  The perf `msr` PMU, which doesn't need the `msr` driver.  Its
+///     events are per-CPU (system-wide), so they need `perf_event_paranoid`
+///     <= 0 or CAP_PERFMON (root).  One group read per CPU gets APERF, MPERF
+///     & TSC at the same instant.
+///   - `msr`:  /dev/cpu/N/msr through `rdmsr()`.  The files are kept open.
+///   - `status`:  IA32_PERF_STATUS, the current ratio.  That's only a snapshot
+///     at the end of each interval, not an average, and has no busy time.
+///
+/// Usage:
+///
+///     test-sgx --freq                                  # Every online CPU, 10 x 1s
+///     test-sgx --freq --cpus 2-3 --interval 100 --count 50
+///
+/// @file   freq.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `syscall()` and `clock_nanosleep()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen()
+#include <stdlib.h>    // For atol()
+#include <string.h>    // For strcmp() memset() memcpy()
+#include <inttypes.h>  // For PRIu64 uint64_t
+#include <time.h>      // For clock_gettime() clock_nanosleep()
+
+#ifdef __linux__
+   #include <unistd.h>               // For syscall() read() close() access()
+   #include <sys/syscall.h>          // For SYS_perf_event_open
+   #include <linux/perf_event.h>     // For struct perf_event_attr
+#endif
+
+#include "freq.h"      // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "rdmsr.h"     // For rdmsr() checkCapabilitiesQuietly() IA32_APERF IA32_MPERF
+#include "decode.h"    // For fields[] field_from_regs() field_extract()
+#include "topology.h"  // For topology_parse_cpulist() topology_online_cpus() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+#define PERF_MSR_PMU "/sys/bus/event_source/devices/msr"
+
+/// Assume a 100 MHz bus clock when CPUID leaf 16H doesn't say
+#define DEFAULT_BUS_MHZ 100
+
+
+/// Where the counters come from
+enum freq_source {
+   SOURCE_PERF,         ///< The perf msr PMU
+   SOURCE_MSR,          ///< rdmsr() IA32_APERF, IA32_MPERF & IA32_TIME_STAMP_COUNTER
+   SOURCE_PERF_STATUS,  ///< rdmsr() IA32_PERF_STATUS
+   SOURCE_COUNT
+};
+
+static const char* sourceNames[SOURCE_COUNT] = { "perf", "msr", "status" };
+
+
+/// One reading of a CPU's counters
+struct counters {
+   uint64_t aperf;
+   uint64_t mperf;
+   uint64_t tsc;     ///< 0 if not available
+   uint64_t ratio;   ///< SOURCE_PERF_STATUS only
+};
+
+
+/// What we know about one sampled CPU
+struct cpu_sampler {
+   int      cpu;
+   int      fd[3];   ///< The perf group (SOURCE_PERF).  `fd[0]` leads.  `-1` if not open.
+   struct counters last;
+   double   sum_mhz;
+   double   min_mhz;
+   double   max_mhz;
+   double   sum_busy;
+   unsigned busy_samples;  ///< Samples with a busy figure (not every source has a TSC)
+   unsigned samples;
+   unsigned throttled;  ///< Samples that were busy but below base
+};
+
+
+/// Find the base & bus frequency from CPUID leaf 16H, or MSR_PLATFORM_INFO
+/// (if `useMSRs`)
+///
+/// @return The base frequency in MHz, or 0 if nothing says
+static uint64_t base_MHz( bool useMSRs, uint64_t* pBusMHz ) {
+   uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+   uint64_t base = 0;
+
+   *pBusMHz = DEFAULT_BUS_MHZ;
+
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   if( eax >= 0x16 ) {
+      eax = 0x16; ebx = 0; ecx = 0; edx = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      base = field_from_regs( &fields[FIELD_BASE_MHZ], eax, ebx, ecx, edx );
+      if( field_from_regs( &fields[FIELD_BUS_MHZ], eax, ebx, ecx, edx ) != 0 ) {
+         *pBusMHz = field_from_regs( &fields[FIELD_BUS_MHZ], eax, ebx, ecx, edx );
+      }
+   }
+
+   uint64_t platformInfo = 0;
+   if( base == 0 && useMSRs && rdmsr( MSR_PLATFORM_INFO, 0, &platformInfo ) ) {
+      base = field_extract( &fields[FIELD_PLATFORM_BASE_RATIO], platformInfo ) * *pBusMHz;
+   }
+
+   return base;
+}
+
+
+#ifdef __linux__
+
+/// Read `events/NAME` from the perf msr PMU (e.g. `event=0x01`)
+///
+/// @return `false` if the PMU doesn't have the event
+static bool perf_msr_event( const char* name, uint64_t* pConfig ) {
+   char path[128];
+   bool found = false;
+
+   snprintf( path, sizeof( path ), PERF_MSR_PMU "/events/%s", name );
+   FILE* file = fopen( path, "r" );
+   if( file != NULL ) {
+      found = fscanf( file, "event=%" SCNx64, pConfig ) == 1;
+      fclose( file );
+   }
+   return found;
+}
+
+
+/// Close the perf groups that are open on `cpus`
+static void perf_close( struct cpu_sampler* cpus, int count ) {
+   for( int c = 0 ; c < count ; c++ ) {
+      for( int e = 0 ; e < 3 ; e++ ) {
+         if( cpus[c].fd[e] >= 0 ) {
+            close( cpus[c].fd[e] );
+            cpus[c].fd[e] = -1;
+         }
+      }
+   }
+}
+
+
+/// Open an APERF, MPERF (and TSC if there is one) group on each CPU
+///
+/// @return `false` if the perf msr PMU can't be used on every CPU.  Nothing
+///         is left open then.
+static bool perf_open( struct cpu_sampler* cpus, int count ) {
+   int type = 0;
+   uint64_t configs[3];
+   int events = 2;
+
+   FILE* file = fopen( PERF_MSR_PMU "/type", "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   bool ok = fscanf( file, "%d", &type ) == 1;
+   fclose( file );
+
+   if( !ok || !perf_msr_event( "aperf", &configs[0] ) || !perf_msr_event( "mperf", &configs[1] ) ) {
+      return false;
+   }
+   if( perf_msr_event( "tsc", &configs[2] ) ) {
+      events = 3;
+   }
+
+   for( int c = 0 ; c < count ; c++ ) {
+      for( int e = 0 ; e < events ; e++ ) {
+         struct perf_event_attr attr;
+         memset( &attr, 0, sizeof( attr ) );
+         attr.size = sizeof( attr );
+         attr.type = (uint32_t) type;
+         attr.config = configs[e];
+         attr.read_format = PERF_FORMAT_GROUP;
+
+         cpus[c].fd[e] = (int) syscall( SYS_perf_event_open, &attr, -1, cpus[c].cpu, cpus[c].fd[0], 0 );
+         if( cpus[c].fd[e] < 0 ) {
+            perf_close( cpus, count );  // So the next source starts clean
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+
+/// Read the APERF, MPERF & TSC group of one CPU with a single read()
+static bool perf_read( const struct cpu_sampler* cpu, struct counters* now ) {
+   uint64_t values[1 + 3] = { 0, 0, 0, 0 };  // nr, then the events in group order
+
+   if( read( cpu->fd[0], values, sizeof( values ) ) < (ssize_t) (3 * sizeof( uint64_t )) ) {
+      return false;
+   }
+   now->aperf = values[1];
+   now->mperf = values[2];
+   now->tsc   = values[0] >= 3 ? values[3] : 0;
+   return true;
+}
+
+#endif  // __linux__
+
+
+/// Read one CPU's counters from `source`
+static bool read_counters( enum freq_source source, const struct cpu_sampler* cpu, struct counters* now ) {
+   uint64_t status = 0;
+
+   switch( source ) {
+      #ifdef __linux__
+      case SOURCE_PERF:
+         return perf_read( cpu, now );
+      #endif
+
+      case SOURCE_MSR:
+         if( !rdmsr( IA32_TIME_STAMP_COUNTER, cpu->cpu, &now->tsc ) ) {
+            now->tsc = 0;
+         }
+         return rdmsr( IA32_APERF, cpu->cpu, &now->aperf ) && rdmsr( IA32_MPERF, cpu->cpu, &now->mperf );
+
+      case SOURCE_PERF_STATUS:
+         if( !rdmsr( IA32_PERF_STATUS, cpu->cpu, &status ) ) {
+            return false;
+         }
+         now->ratio = field_extract( &fields[FIELD_PERF_STATUS_RATIO], status );
+         return true;
+
+      default:
+         return false;
+   }
+}
+
+
+/// Get ready to read the counters of every CPU from `source`
+static bool open_source( enum freq_source source, struct cpu_sampler* cpus, int count ) {
+   uint32_t eax = 0x06, ebx = 0, ecx = 0, edx = 0;
+
+   switch( source ) {
+      #ifdef __linux__
+      case SOURCE_PERF:
+         return perf_open( cpus, count );
+      #endif
+
+      case SOURCE_MSR:
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+         if( !field_from_regs( &fields[FIELD_APERFMPERF], eax, ebx, ecx, edx ) ) {
+            return false;
+         }
+         // Then check we can read the MSRs, just like IA32_PERF_STATUS
+         // Fall through
+
+      case SOURCE_PERF_STATUS:
+         if( !checkCapabilitiesQuietly() ) {
+            return false;
+         }
+         #ifdef __linux__
+         if( access( "/dev/cpu/0/msr", R_OK ) != 0 ) {  // The msr driver isn't loaded
+            return false;
+         }
+         #endif
+         for( int c = 0 ; c < count ; c++ ) {
+            if( !read_counters( source, &cpus[c], &cpus[c].last ) ) {
+               return false;
+            }
+         }
+         return true;
+
+      default:
+         return false;
+   }
+}
+
+
+#ifdef __linux__  // The sampling loop's clocks are POSIX's
+
+/// Return the time in seconds from `start` to `now`
+static double seconds_between( const struct timespec* start, const struct timespec* now ) {
+   return (double) (now->tv_sec - start->tv_sec) + (double) (now->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+#endif  // __linux__
+
+
+/// `--freq [--cpus LIST] [--interval MS] [--count N] [--source perf|msr|status]`
+int freq_main( int argc, char* argv[] ) {
+   static struct cpu_sampler cpus[MAX_CPUS];
+   static int cpuList[MAX_CPUS];
+   int cpuCount = 0;
+   long intervalMS = 1000;
+   long samples = 10;
+   int forced = -1;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--cpus" ) == 0 && i + 1 < argc ) {
+         cpuCount = topology_parse_cpulist( argv[++i], cpuList, MAX_CPUS );
+         if( cpuCount <= 0 ) {
+            fprintf( stderr, "freq: [%s] isn't a CPU list\n", argv[i] );
+            return EXIT_FAILURE;
+         }
+      } else if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         intervalMS = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--count" ) == 0 && i + 1 < argc ) {
+         samples = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--source" ) == 0 && i + 1 < argc ) {
+         i++;
+         for( int s = 0 ; s < SOURCE_COUNT ; s++ ) {
+            if( strcmp( argv[i], sourceNames[s] ) == 0 ) {
+               forced = s;
+            }
+         }
+         if( forced < 0 ) {
+            fprintf( stderr, "freq: Unknown source [%s]\n", argv[i] );
+            return EXIT_FAILURE;
+         }
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --freq [--cpus LIST] [--interval MS] [--count N] [--source perf|msr|status]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+
+   if( intervalMS <= 0 || samples <= 0 ) {
+      fprintf( stderr, "freq: The interval and count must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   static int online[MAX_CPUS];
+   int onlineCount = topology_online_cpus( online, MAX_CPUS );
+
+   if( cpuCount == 0 ) {
+      memcpy( cpuList, online, sizeof( online[0] ) * (size_t) onlineCount );
+      cpuCount = onlineCount;
+   }
+   for( int c = 0 ; c < cpuCount ; c++ ) {
+      bool isOnline = false;
+      for( int o = 0 ; o < onlineCount ; o++ ) {
+         isOnline = isOnline || online[o] == cpuList[c];
+      }
+      if( !isOnline ) {
+         fprintf( stderr, "freq: CPU %d isn't online\n", cpuList[c] );
+         return EXIT_FAILURE;
+      }
+   }
+   for( int c = 0 ; c < cpuCount ; c++ ) {
+      memset( &cpus[c], 0, sizeof( cpus[c] ) );
+      cpus[c].cpu = cpuList[c];
+      cpus[c].fd[0] = cpus[c].fd[1] = cpus[c].fd[2] = -1;
+      cpus[c].min_mhz = 1e9;
+   }
+
+   enum freq_source source = SOURCE_COUNT;
+   for( int s = 0 ; s < SOURCE_COUNT && source == SOURCE_COUNT ; s++ ) {
+      if( (forced < 0 || forced == s) && open_source( (enum freq_source) s, cpus, cpuCount ) ) {
+         source = (enum freq_source) s;
+      }
+   }
+   if( source == SOURCE_COUNT ) {
+      printf( "Unable to read IA32_APERF/IA32_MPERF or IA32_PERF_STATUS.  The perf msr PMU\n" );
+      printf( "doesn't have aperf & mperf (or needs perf_event_paranoid <= 0 or CAP_PERFMON), and\n" );
+      printf( "/dev/cpu/N/msr isn't readable (modprobe msr and run as root).\n" );
+      return EXIT_FAILURE;
+   }
+
+   uint64_t busMHz = 0;
+   uint64_t baseMHz = base_MHz( source != SOURCE_PERF, &busMHz );
+
+   #ifdef __linux__
+   if( source == SOURCE_PERF ) {  // The group's first read is the starting point
+      for( int c = 0 ; c < cpuCount ; c++ ) {
+         perf_read( &cpus[c], &cpus[c].last );
+      }
+   }
+   #endif
+
+   printf( "Effective frequency every %ld ms from %s", intervalMS
+          ,source == SOURCE_PERF ? "the perf msr PMU" : source == SOURCE_MSR ? "IA32_APERF/IA32_MPERF" : "IA32_PERF_STATUS" );
+   if( baseMHz != 0 ) {
+      printf( " (base %" PRIu64 " MHz)\n", baseMHz );
+   } else {
+      printf( " (base frequency measured from the TSC)\n" );
+   }
+   if( forced < 0 && source != SOURCE_PERF ) {
+      printf( "  Chose --source %s:  %s\n", sourceNames[source]
+             ,source == SOURCE_MSR ? "The perf msr PMU has no aperf & mperf (or isn't allowed)"
+                                   : "Neither the perf msr PMU nor IA32_APERF/IA32_MPERF is readable" );
+   }
+
+   printf( "  Time (s)" );
+   for( int c = 0 ; c < cpuCount ; c++ ) {
+      char label[16];
+      snprintf( label, sizeof( label ), "CPU %d MHz", cpus[c].cpu );
+      printf( "  %11s busy", label );
+   }
+   printf( "\n" );
+
+   #ifdef __linux__
+   struct timespec start, next, before, after, last;
+   double overhead = 0;  // Time spent reading counters
+   clock_gettime( CLOCK_MONOTONIC, &start );
+   next = start;
+   last = start;
+
+   for( long s = 1 ; s <= samples ; s++ ) {
+      // Sleep until an absolute time, so the series doesn't drift
+      next.tv_sec  += intervalMS / 1000;
+      next.tv_nsec += (intervalMS % 1000) * 1000000;
+      if( next.tv_nsec >= 1000000000 ) {
+         next.tv_sec++;
+         next.tv_nsec -= 1000000000;
+      }
+      clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+
+      clock_gettime( CLOCK_MONOTONIC, &before );
+      printf( "  %8.3f", seconds_between( &start, &before ) );
+      double elapsed = seconds_between( &last, &before );
+      last = before;
+
+      for( int c = 0 ; c < cpuCount ; c++ ) {
+         struct cpu_sampler* cpu = &cpus[c];
+         struct counters now = { 0, 0, 0, 0 };
+         double mhz = 0;
+         double busy = -1;
+
+         clock_gettime( CLOCK_MONOTONIC, &before );
+         bool readable = read_counters( source, cpu, &now );
+         clock_gettime( CLOCK_MONOTONIC, &after );
+         overhead += seconds_between( &before, &after );
+
+         if( !readable ) {
+            printf( "  %16s", "unreadable" );
+            continue;
+         }
+
+         if( source == SOURCE_PERF_STATUS ) {
+            mhz = (double) (now.ratio * busMHz);
+         } else {
+            uint64_t dAPERF = now.aperf - cpu->last.aperf;
+            uint64_t dMPERF = now.mperf - cpu->last.mperf;
+            uint64_t dTSC   = now.tsc   - cpu->last.tsc;
+            double   base   = baseMHz != 0 ? (double) baseMHz : (double) dTSC / (elapsed * 1e6);
+
+            mhz  = dMPERF != 0 ? base * (double) dAPERF / (double) dMPERF : 0;
+            busy = now.tsc != 0 && dTSC != 0 ? 100.0 * (double) dMPERF / (double) dTSC : -1;
+         }
+         cpu->last = now;
+
+         printf( "  %11.0f", mhz );
+         if( busy >= 0 ) {
+            printf( " %3.0f%%", busy );
+            cpu->sum_busy += busy;
+            cpu->busy_samples++;
+         } else {
+            printf( "    -" );
+         }
+
+         cpu->samples++;
+         cpu->sum_mhz += mhz;
+         cpu->min_mhz = mhz < cpu->min_mhz ? mhz : cpu->min_mhz;
+         cpu->max_mhz = mhz > cpu->max_mhz ? mhz : cpu->max_mhz;
+         if( baseMHz != 0 && busy >= 50 && mhz < 0.95 * (double) baseMHz ) {
+            cpu->throttled++;
+         }
+      }
+
+      printf( "\n" );
+   }
+
+   printf( "Summary\n" );
+   printf( "    CPU  Avg MHz  Min MHz  Max MHz  Avg busy  Busy below base\n" );
+   printf( "    ===  =======  =======  =======  ========  ===============\n" );
+   for( int c = 0 ; c < cpuCount ; c++ ) {
+      const struct cpu_sampler* cpu = &cpus[c];
+      if( cpu->samples == 0 ) {
+         continue;
+      }
+      printf( "    %3d  %7.0f  %7.0f  %7.0f  ", cpu->cpu, cpu->sum_mhz / cpu->samples, cpu->min_mhz, cpu->max_mhz );
+      if( cpu->busy_samples == 0 ) {
+         printf( "%8s  %15s\n", "-", "-" );
+      } else {
+         printf( "%7.0f%%  %u of %u samples\n", cpu->sum_busy / cpu->busy_samples, cpu->throttled, cpu->busy_samples );
+      }
+   }
+   printf( "  Sampling overhead: %.1f us per sample of %d CPUs\n", overhead * 1e6 / (double) samples, cpuCount );
+
+   return EXIT_SUCCESS;
+   #else
+   printf( "Sampling the frequency needs Linux\n" );
+   return EXIT_FAILURE;
+   #endif
+}
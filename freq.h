@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  freq.h - 2026
+//
+/// This module samples the effective frequency of CPUs with IA32_APERF and
+/// IA32_MPERF.
+///
+/// @file   freq.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--freq [--cpus LIST] [--interval MS] [--count N] [--source perf|msr|status]`
+int freq_main( int argc, char* argv[] );
@@ -0,0 +1,608 @@
+///////////////////////////////////////////////////////////////////////////////
+//  irq.c - 2026
+//
+/// This module samples interrupt rates on the CPUs that run enclaves, to
+/// estimate how many asynchronous enclave exits (AEXs) they cause.
+///
+/// Every interrupt that arrives while a CPU is running an enclave forces an
+/// AEX:  The CPU saves the enclave's state to the SSA, exits, handles the
+/// interrupt and comes back with ERESUME -- several microseconds, with the
+/// L1D flush & buffer clear the SGX microcode adds to every exit.  With
+/// AEXNOTIFY an enclave can see its AEXs, but it's still worth knowing the
+/// rate, and where it comes from, before placing enclave threads.
+///
+/// Each interval, this reads `/proc/interrupts` and `/proc/softirqs` and
+/// attributes the increase on each selected CPU to:
+///
+///   - Timer:  The local APIC timer (LOC).  `nohz_full` stops it on a CPU
+///     with one runnable thread.
+///   - IPI:  Rescheduling, function call, TLB shootdown & IRQ work IPIs
+///   - Device:  The numbered IRQs
+///   - Other:  NMIs, PMIs, thermal, hypervisor callbacks...
+///
+/// The sum is the AEX rate an enclave thread would see if it ran on that CPU
+/// all the time -- an upper bound.  Softirqs don't exit an enclave by
+/// themselves (the interrupt that raised them did), but they're work the
+/// kernel does on that CPU, so they're shown too.
+///
+/// The files are kept open and re-read into the same buffers every interval.
+/// A line that's byte-for-byte the same as last time has no new interrupts,
+/// so it isn't parsed at all, and only the columns of the selected CPUs are
+/// converted -- on a 200-CPU host that's most of the cost of reading them.
+///
+/// At the end, every device IRQ whose affinity (`/proc/irq/N/
+/// effective_affinity_list`) includes a selected CPU is flagged, busiest
+/// first.
+///
+/// Usage:
+///
+///     test-sgx --irq                                  # Every online CPU, 10 x 1s
+///     test-sgx --irq --cpus 4-7 --interval 500 --count 20
+///
+/// @file   irq.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `clock_nanosleep()` and `pread()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For atol() atoi() calloc() realloc() free() qsort() strtoull()
+#include <string.h>    // For strcmp() strncmp() memcmp() memcpy() memchr() strcspn()
+#include <inttypes.h>  // For PRIu64 uint64_t
+#include <stdbool.h>   // For bool
+#include <ctype.h>     // For isdigit() isspace()
+#include <time.h>      // For clock_gettime() clock_nanosleep()
+
+#ifdef __linux__
+   #include <fcntl.h>          // For open() O_RDONLY
+   #include <unistd.h>         // For pread() close()
+#endif
+
+#include "irq.h"       // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_parse_cpulist() topology_online_cpus() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The most rows we'll track in a file
+#define MAX_ROWS 4096
+
+/// The first read's buffer size.  It grows as needed.
+#define INITIAL_BUFFER 65536
+
+/// The most flagged devices to list
+#define MAX_FLAGGED 20
+
+
+/// Where an interrupt comes from
+enum irq_kind {
+   KIND_TIMER,    ///< LOC
+   KIND_IPI,      ///< RES, CAL, TLB & IWI
+   KIND_DEVICE,   ///< A numbered IRQ
+   KIND_OTHER,    ///< Any other interrupt
+   KIND_SOFTIRQ,  ///< A row of /proc/softirqs
+   KIND_IGNORED,  ///< Counters that aren't interrupts on a CPU (ERR, MIS, posted interrupts...)
+   KIND_COUNT
+};
+
+
+/// One row (line) of /proc/interrupts or /proc/softirqs
+struct row {
+   char          label[16];      ///< Like `24` or `LOC`
+   char          name[48];       ///< The device or description
+   enum irq_kind kind;
+   uint64_t*     last;           ///< Each selected CPU's count at the last sample
+   uint64_t      events;         ///< Since the first sample, on the selected CPUs
+   size_t        offset;         ///< Where its line was in the last text
+   size_t        length;
+   bool          onSelected;     ///< Its IRQ affinity includes a selected CPU
+   char          affinity[64];
+};
+
+
+/// A /proc file that's sampled incrementally
+struct proc_table {
+   const char* path;
+   int         fd;
+   char*       text;              ///< This sample
+   size_t      textSize;
+   size_t      textCapacity;
+   char*       previous;          ///< The last sample (the buffers swap)
+   size_t      previousSize;
+   size_t      previousCapacity;
+   size_t      headerLength;      ///< The header (`CPU0 CPU1...`) line's length
+   int         columns;           ///< CPU columns in the header
+   int*        selectedOf;        ///< For each column, the selected CPU's index (or -1)
+   int         cpuCount;          ///< Selected CPUs
+   struct row* rows;
+   int         rowCount;
+};
+
+
+/// The rows that aren't interrupts delivered to a CPU
+static const char* ignoredLabels[] = { "ERR", "MIS", "MCP", "PIN", "NPI", "PIW", "RTR" };
+
+/// The rows that are IPIs
+static const char* ipiLabels[] = { "RES", "CAL", "TLB", "IWI" };
+
+
+#ifdef __linux__
+
+/// @return How the row labeled `label` is counted
+static enum irq_kind kind_of( const char* label, bool softirq ) {
+   if( softirq ) {
+      return KIND_SOFTIRQ;
+   }
+   if( isdigit( (unsigned char) label[0] ) ) {
+      return KIND_DEVICE;
+   }
+   if( strcmp( label, "LOC" ) == 0 ) {
+      return KIND_TIMER;
+   }
+   for( size_t i = 0 ; i < sizeof( ipiLabels ) / sizeof( ipiLabels[0] ) ; i++ ) {
+      if( strcmp( label, ipiLabels[i] ) == 0 ) {
+         return KIND_IPI;
+      }
+   }
+   for( size_t i = 0 ; i < sizeof( ignoredLabels ) / sizeof( ignoredLabels[0] ) ; i++ ) {
+      if( strcmp( label, ignoredLabels[i] ) == 0 ) {
+         return KIND_IGNORED;
+      }
+   }
+   return KIND_OTHER;
+}
+
+
+/// Open `path` for sampling the columns of `cpus`
+///
+/// @return `false` if it can't be read
+static bool table_open( struct proc_table* table, const char* path, int cpuCount ) {
+   memset( table, 0, sizeof( *table ) );
+   table->path = path;
+   table->cpuCount = cpuCount;
+   table->fd = open( path, O_RDONLY | O_CLOEXEC );
+   table->textCapacity = INITIAL_BUFFER;
+   table->previousCapacity = INITIAL_BUFFER;
+   table->text = malloc( table->textCapacity );
+   table->previous = malloc( table->previousCapacity );
+   table->rows = calloc( MAX_ROWS, sizeof( struct row ) );
+   return table->fd >= 0 && table->text != NULL && table->previous != NULL && table->rows != NULL;
+}
+
+
+/// Close the file and free the buffers
+static void table_close( struct proc_table* table ) {
+   if( table->fd >= 0 ) {
+      close( table->fd );
+   }
+   for( int r = 0 ; r < table->rowCount ; r++ ) {
+      free( table->rows[r].last );
+   }
+   free( table->rows );
+   free( table->text );
+   free( table->previous );
+   free( table->selectedOf );
+}
+
+
+/// Read the whole file into `table->text`, keeping the last sample in
+/// `table->previous`
+///
+/// @return `false` if it couldn't be read
+static bool table_read( struct proc_table* table ) {
+   char*  swap = table->previous;
+   size_t swapCapacity = table->previousCapacity;
+
+   table->previous = table->text;
+   table->previousSize = table->textSize;
+   table->previousCapacity = table->textCapacity;
+   table->text = swap;
+   table->textCapacity = swapCapacity;
+   table->textSize = 0;
+
+   for( ;; ) {
+      if( table->textSize + 1 >= table->textCapacity ) {
+         char* bigger = realloc( table->text, table->textCapacity * 2 );
+         if( bigger == NULL ) {
+            return false;
+         }
+         table->text = bigger;
+         table->textCapacity *= 2;
+      }
+      ssize_t got = pread( table->fd, table->text + table->textSize, table->textCapacity - table->textSize - 1, (off_t) table->textSize );
+      if( got < 0 ) {
+         return false;
+      }
+      if( got == 0 ) {
+         break;
+      }
+      table->textSize += (size_t) got;
+   }
+   table->text[table->textSize] = '\0';
+   return table->textSize > 0;
+}
+
+
+/// Map the header's `CPUn` columns to the selected CPUs
+///
+/// @return `false` if the header has no CPU columns
+static bool table_header( struct proc_table* table, const int* cpus ) {
+   const char* p = table->text;
+   int columns = 0;
+
+   table->headerLength = strcspn( table->text, "\n" );
+   free( table->selectedOf );
+   table->selectedOf = calloc( MAX_CPUS, sizeof( int ) );
+   if( table->selectedOf == NULL ) {
+      return false;
+   }
+
+   while( (size_t) (p - table->text) < table->headerLength && columns < MAX_CPUS ) {
+      while( *p == ' ' ) {
+         p++;
+      }
+      if( strncmp( p, "CPU", 3 ) != 0 ) {
+         break;
+      }
+      int cpu = atoi( p + 3 );
+      table->selectedOf[columns] = -1;
+      for( int c = 0 ; c < table->cpuCount ; c++ ) {
+         table->selectedOf[columns] = cpus[c] == cpu ? c : table->selectedOf[columns];
+      }
+      columns++;
+      while( *p != ' ' && *p != '\n' && *p != '\0' ) {
+         p++;
+      }
+   }
+   table->columns = columns;
+
+   // The columns changed (a CPU went on or offline):  Start counting again
+   for( int r = 0 ; r < table->rowCount ; r++ ) {
+      free( table->rows[r].last );
+      table->rows[r].last = NULL;
+   }
+   table->rowCount = 0;
+   return columns > 0;
+}
+
+
+/// Read `/proc/irq/N/effective_affinity_list` (or `smp_affinity_list`) for
+/// a device row, and see if it includes a selected CPU
+static void read_affinity( struct row* row, const int* cpus, int cpuCount ) {
+   static int affinity[MAX_CPUS];
+   const char* files[] = { "effective_affinity_list", "smp_affinity_list" };
+   char path[128];
+
+   for( size_t f = 0 ; f < sizeof( files ) / sizeof( files[0] ) && row->affinity[0] == '\0' ; f++ ) {
+      snprintf( path, sizeof( path ), "/proc/irq/%s/%s", row->label, files[f] );
+      FILE* file = fopen( path, "r" );
+      if( file == NULL ) {
+         continue;
+      }
+      if( fgets( row->affinity, sizeof( row->affinity ), file ) == NULL ) {
+         row->affinity[0] = '\0';
+      }
+      fclose( file );
+      row->affinity[strcspn( row->affinity, "\n" )] = '\0';
+   }
+
+   int count = topology_parse_cpulist( row->affinity, affinity, MAX_CPUS );
+   for( int a = 0 ; a < count && !row->onSelected ; a++ ) {
+      for( int c = 0 ; c < cpuCount ; c++ ) {
+         row->onSelected = row->onSelected || affinity[a] == cpus[c];
+      }
+   }
+}
+
+
+/// @return The row labeled `label` (`hint` is where it was last time), or a
+///         new one, or `NULL` if there are too many
+static struct row* find_row( struct proc_table* table, const char* label, int hint, bool* pNew ) {
+   *pNew = false;
+   if( hint < table->rowCount && strcmp( table->rows[hint].label, label ) == 0 ) {
+      return &table->rows[hint];
+   }
+   for( int r = 0 ; r < table->rowCount ; r++ ) {
+      if( strcmp( table->rows[r].label, label ) == 0 ) {
+         return &table->rows[r];
+      }
+   }
+   if( table->rowCount >= MAX_ROWS ) {
+      return NULL;
+   }
+   struct row* row = &table->rows[table->rowCount];
+   memset( row, 0, sizeof( *row ) );
+   row->last = calloc( (size_t) table->cpuCount, sizeof( uint64_t ) );
+   if( row->last == NULL ) {
+      return NULL;
+   }
+   snprintf( row->label, sizeof( row->label ), "%s", label );
+   table->rowCount++;
+   *pNew = true;
+   return row;
+}
+
+
+/// Parse this sample's text, adding each selected CPU's new events to
+/// `deltas[cpu * KIND_COUNT + kind]`
+///
+/// @return `false` if the file couldn't be read or parsed
+static bool table_sample( struct proc_table* table, const int* cpus, bool softirq, uint64_t* deltas ) {
+   if( !table_read( table ) ) {
+      return false;
+   }
+   size_t headerLength = strcspn( table->text, "\n" );
+   if( table->columns == 0 || headerLength != table->headerLength || memcmp( table->text, table->previous, headerLength ) != 0 ) {
+      if( !table_header( table, cpus ) ) {
+         return false;
+      }
+   }
+
+   char* line = table->text + headerLength + (table->text[headerLength] == '\n' ? 1 : 0);
+   for( int index = 0 ; *line != '\0' ; index++ ) {
+      size_t length = strcspn( line, "\n" );
+      char*  next = line + length + (line[length] == '\n' ? 1 : 0);
+      char*  colon = memchr( line, ':', length );
+      if( colon == NULL ) {
+         line = next;
+         continue;
+      }
+
+      char label[16];
+      const char* start = line;
+      while( start < colon && *start == ' ' ) {
+         start++;
+      }
+      size_t labelLength = (size_t) (colon - start) < sizeof( label ) - 1 ? (size_t) (colon - start) : sizeof( label ) - 1;
+      memcpy( label, start, labelLength );
+      label[labelLength] = '\0';
+
+      bool isNew = false;
+      struct row* row = find_row( table, label, index, &isNew );
+      if( row == NULL ) {
+         line = next;
+         continue;
+      }
+
+      // Unchanged since the last sample:  No new events, nothing to parse
+      bool unchanged = !isNew && row->length == length && memcmp( table->previous + row->offset, line, length ) == 0;
+      row->offset = (size_t) (line - table->text);
+      row->length = length;
+      if( unchanged ) {
+         line = next;
+         continue;
+      }
+
+      char* p = colon + 1;
+      for( int column = 0 ; column < table->columns ; column++ ) {
+         while( *p == ' ' ) {
+            p++;
+         }
+         if( !isdigit( (unsigned char) *p ) ) {
+            break;  // Rows like ERR & MIS have a single count
+         }
+         int selected = table->selectedOf[column];
+         if( selected < 0 ) {
+            while( isdigit( (unsigned char) *p ) ) {  // Skip columns we don't want
+               p++;
+            }
+            continue;
+         }
+         uint64_t count = strtoull( p, &p, 10 );
+         if( !isNew ) {
+            uint64_t delta = count - row->last[selected];
+            deltas[selected * KIND_COUNT + row->kind] += delta;
+            row->events += delta;
+         }
+         row->last[selected] = count;
+      }
+
+      if( isNew ) {
+         // The rest of the line is the description.  For devices, the name
+         // is after the last run of spaces (following the chip & trigger).
+         row->kind = kind_of( row->label, softirq );
+         const char* name = p;
+         for( const char* q = p ; q + 1 < line + length ; q++ ) {
+            name = q[0] == ' ' && q[1] == ' ' ? q + 2 : name;
+         }
+         while( *name == ' ' ) {
+            name++;
+         }
+         size_t nameLength = (size_t) (line + length - name);
+         nameLength = nameLength < sizeof( row->name ) - 1 ? nameLength : sizeof( row->name ) - 1;
+         memcpy( row->name, name, nameLength );
+         row->name[nameLength] = '\0';
+         if( row->kind == KIND_DEVICE ) {
+            read_affinity( row, cpus, table->cpuCount );
+         }
+      }
+      line = next;
+   }
+   return true;
+}
+
+
+/// @return The number of seconds from `start` to `now`
+static double seconds_between( const struct timespec* start, const struct timespec* now ) {
+   return (double) (now->tv_sec - start->tv_sec) + (double) (now->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/// Sort device rows by events, busiest first
+static int compare_events( const void* left, const void* right ) {
+   const struct row* l = *(const struct row* const*) left;
+   const struct row* r = *(const struct row* const*) right;
+   return (l->events < r->events) - (l->events > r->events);
+}
+
+#endif
+
+
+/// `--irq [--cpus LIST] [--interval MS] [--count N]`
+int irq_main( int argc, char* argv[] ) {
+   static int cpus[MAX_CPUS];
+   int cpuCount = 0;
+   long intervalMS = 1000;
+   long samples = 10;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--cpus" ) == 0 && i + 1 < argc ) {
+         cpuCount = topology_parse_cpulist( argv[++i], cpus, MAX_CPUS );
+         if( cpuCount <= 0 ) {
+            fprintf( stderr, "irq: [%s] isn't a CPU list\n", argv[i] );
+            return EXIT_FAILURE;
+         }
+      } else if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         intervalMS = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--count" ) == 0 && i + 1 < argc ) {
+         samples = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --irq [--cpus LIST] [--interval MS] [--count N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( intervalMS <= 0 || samples <= 0 ) {
+      fprintf( stderr, "irq: The interval and count must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static int online[MAX_CPUS];
+      int onlineCount = topology_online_cpus( online, MAX_CPUS );
+
+      if( cpuCount == 0 ) {
+         memcpy( cpus, online, sizeof( online[0] ) * (size_t) onlineCount );
+         cpuCount = onlineCount;
+      }
+      for( int c = 0 ; c < cpuCount ; c++ ) {
+         bool isOnline = false;
+         for( int o = 0 ; o < onlineCount ; o++ ) {
+            isOnline = isOnline || online[o] == cpus[c];
+         }
+         if( !isOnline ) {
+            fprintf( stderr, "irq: CPU %d isn't online\n", cpus[c] );
+            return EXIT_FAILURE;
+         }
+      }
+
+      struct proc_table interrupts;
+      struct proc_table softirqs;
+      uint64_t* deltas = calloc( (size_t) cpuCount * KIND_COUNT, sizeof( uint64_t ) );
+      uint64_t* totals = calloc( (size_t) cpuCount * KIND_COUNT, sizeof( uint64_t ) );
+      bool haveInterrupts = table_open( &interrupts, "/proc/interrupts", cpuCount );
+      bool haveSoftirqs = table_open( &softirqs, "/proc/softirqs", cpuCount );
+      if( deltas == NULL || totals == NULL || !haveInterrupts || !table_sample( &interrupts, cpus, false, deltas ) ) {
+         fprintf( stderr, "irq: Unable to read /proc/interrupts\n" );
+         table_close( &interrupts );
+         table_close( &softirqs );
+         free( deltas );
+         free( totals );
+         return EXIT_FAILURE;
+      }
+      haveSoftirqs = haveSoftirqs && table_sample( &softirqs, cpus, true, deltas );
+
+      uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+      bool aexNotify = false;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      if( eax >= 0x12 ) {
+         eax = 0x12; ebx = 0; ecx = 1; edx = 0;
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+         aexNotify = field_from_regs( &fields[FIELD_SECS_AEXNOTIFY], eax, ebx, ecx, edx ) != 0;
+      }
+
+      printf( "Interrupts (potential AEXs) every %ld ms on %d CPU(s).  AEXNOTIFY is %s.\n", intervalMS, cpuCount, aexNotify ? "supported" : "not supported" );
+      printf( "  Time (s)  CPU     AEX/s    Timer      IPI   Device    Other  Softirq/s\n" );
+
+      struct timespec start, next, last, before, after;
+      double overhead = 0;  // Time spent reading & parsing
+      clock_gettime( CLOCK_MONOTONIC, &start );
+      next = start;
+      last = start;
+
+      for( long s = 1 ; s <= samples ; s++ ) {
+         next.tv_sec  += intervalMS / 1000;
+         next.tv_nsec += (intervalMS % 1000) * 1000000;
+         if( next.tv_nsec >= 1000000000 ) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+         }
+         clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+
+         memset( deltas, 0, (size_t) cpuCount * KIND_COUNT * sizeof( uint64_t ) );
+         clock_gettime( CLOCK_MONOTONIC, &before );
+         bool ok = table_sample( &interrupts, cpus, false, deltas );
+         if( haveSoftirqs ) {
+            table_sample( &softirqs, cpus, true, deltas );
+         }
+         clock_gettime( CLOCK_MONOTONIC, &after );
+         overhead += seconds_between( &before, &after );
+         if( !ok ) {
+            fprintf( stderr, "irq: Unable to read /proc/interrupts\n" );
+            break;
+         }
+
+         double elapsed = seconds_between( &last, &before );
+         last = before;
+         for( int c = 0 ; c < cpuCount ; c++ ) {
+            const uint64_t* d = &deltas[c * KIND_COUNT];
+            uint64_t aex = d[KIND_TIMER] + d[KIND_IPI] + d[KIND_DEVICE] + d[KIND_OTHER];
+            printf( "  %8.3f  %3d  %8.0f %8.0f %8.0f %8.0f %8.0f  %9.0f\n", seconds_between( &start, &before ), cpus[c]
+                   ,(double) aex / elapsed, (double) d[KIND_TIMER] / elapsed, (double) d[KIND_IPI] / elapsed
+                   ,(double) d[KIND_DEVICE] / elapsed, (double) d[KIND_OTHER] / elapsed, (double) d[KIND_SOFTIRQ] / elapsed );
+            for( int k = 0 ; k < KIND_COUNT ; k++ ) {
+               totals[c * KIND_COUNT + k] += d[k];
+            }
+         }
+      }
+
+      double total = seconds_between( &start, &last );
+      printf( "Summary (an upper bound:  an enclave thread only sees the interrupts that arrive while it runs)\n" );
+      printf( "    CPU     AEX/s    Timer      IPI   Device    Other  Softirq/s\n" );
+      printf( "    ===  ========  =======  =======  =======  =======  =========\n" );
+      for( int c = 0 ; c < cpuCount && total > 0 ; c++ ) {
+         const uint64_t* t = &totals[c * KIND_COUNT];
+         uint64_t aex = t[KIND_TIMER] + t[KIND_IPI] + t[KIND_DEVICE] + t[KIND_OTHER];
+         printf( "    %3d  %8.0f  %7.0f  %7.0f  %7.0f  %7.0f  %9.0f\n", cpus[c], (double) aex / total
+                ,(double) t[KIND_TIMER] / total, (double) t[KIND_IPI] / total, (double) t[KIND_DEVICE] / total
+                ,(double) t[KIND_OTHER] / total, (double) t[KIND_SOFTIRQ] / total );
+      }
+
+      // Devices that may interrupt the selected CPUs, busiest first
+      static const struct row* flagged[MAX_ROWS];
+      int flaggedCount = 0;
+      for( int r = 0 ; r < interrupts.rowCount ; r++ ) {
+         if( interrupts.rows[r].kind == KIND_DEVICE && (interrupts.rows[r].onSelected || interrupts.rows[r].events > 0) ) {
+            flagged[flaggedCount++] = &interrupts.rows[r];
+         }
+      }
+      qsort( flagged, (size_t) flaggedCount, sizeof( flagged[0] ), compare_events );
+      if( flaggedCount > 0 ) {
+         printf( "  Device IRQs that can land on these CPUs:\n" );
+         printf( "       IRQ  Events/s  Affinity          Device\n" );
+         for( int f = 0 ; f < flaggedCount && f < MAX_FLAGGED ; f++ ) {
+            printf( "    %6s  %8.0f  %-16s  %s\n", flagged[f]->label, total > 0 ? (double) flagged[f]->events / total : 0
+                   ,flagged[f]->affinity[0] != '\0' ? flagged[f]->affinity : "?", flagged[f]->name );
+         }
+         if( flaggedCount > MAX_FLAGGED ) {
+            printf( "    ... and %d more\n", flaggedCount - MAX_FLAGGED );
+         }
+         printf( "  Move them with `echo LIST > /proc/irq/N/smp_affinity_list` (or irqbalance's\n" );
+         printf( "  IRQBALANCE_BANNED_CPULIST), and use nohz_full to stop the timer on enclave cores.\n" );
+      }
+      printf( "  Sampling overhead: %.1f us per sample\n", overhead * 1e6 / (double) samples );
+
+      table_close( &interrupts );
+      table_close( &softirqs );
+      free( deltas );
+      free( totals );
+      return EXIT_SUCCESS;
+
+   #else
+      printf( "The interrupt sampler needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  irq.h - 2026
+//
+/// This module samples interrupt rates on the CPUs that run enclaves, to
+/// estimate how many asynchronous enclave exits (AEXs) they cause.
+///
+/// @file   irq.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--irq [--cpus LIST] [--interval MS] [--count N]`
+int irq_main( int argc, char* argv[] );
@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////
+//  isa.c - 2026
+//
+/// This module advises which vector ISA an enclave can safely be compiled
+/// for on this host.
+///
+/// An enclave can only use a register set if three things are all true:
+///
+///   - The CPU implements the instructions (CPUID leaves 1, 7 & 80000001H)
+///   - SGX allows the state component in `SECS.ATTRIBUTES.XFRM`
+///     (CPUID.(EAX=12H, ECX=1):ECX:EDX -- the "XCR0 copy")
+///   - The OS has enabled the state component in XCR0, because `ECREATE`
+///     faults if XFRM isn't a subset of XCR0
+///
+/// This module intersects all three, then reports the widest safe compiler
+/// target (using the x86-64 micro-architecture levels) and the smallest XFRM
+/// that target needs.  A smaller XFRM means a smaller SSA frame and a
+/// cheaper AEX, so don't ask for more state than the code uses.
+///
+/// It can also write a header with a per-level dispatch table.  Note that GCC
+/// function multiversioning (`target_clones`, `__builtin_cpu_supports`)
+/// resolves with CPUID, which is illegal inside an enclave (#UD), so the
+/// header uses an explicit table indexed by a level the enclave chooses from
+/// its own XFRM.
+///
+/// Usage:
+///
+///     test-sgx --isa                                  # Advise for this host
+///     test-sgx --isa --from host17.cap                # Advise for a captured host
+///     test-sgx --isa --header enclave_isa_dispatch.h  # Also write the dispatch header
+///
+/// @file   isa.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fopen()
+#include <string.h>    // For strcmp()
+#include <inttypes.h>  // For PRIx64 uint64_t
+#include <ctype.h>     // For toupper()
+
+#include "isa.h"       // For obvious reasons
+#include "capture.h"   // For capture_load()
+#include "cache.h"     // For cache_probe()
+#include "decode.h"    // For fields[] field_from_capture()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The largest number of ISA extensions a level requires
+#define MAX_LEVEL_FEATURES 12
+
+/// XSAVE state components each class of registers needs
+#define XFRM_SSE     ( (1 << XSTATE_X87) | (1 << XSTATE_SSE) )
+#define XFRM_AVX     ( XFRM_SSE | (1 << XSTATE_AVX) )
+#define XFRM_AVX512  ( XFRM_AVX | (1 << XSTATE_OPMASK) | (1 << XSTATE_ZMM_HI256) | (1 << XSTATE_HI16_ZMM) )
+#define XFRM_AMX     ( XFRM_AVX512 | (1 << XSTATE_TILECFG) | (1 << XSTATE_TILEDATA) )
+
+
+/// A compiler target level, from narrowest to widest
+struct isa_level {
+   const char* name;      ///< Suffix for dispatched function names
+   const char* march;     ///< GCC/Clang flags
+   const char* target;    ///< String for `__attribute__((target(...)))`
+   uint64_t    xfrm;      ///< XSAVE state components this level needs
+   enum field_id features[MAX_LEVEL_FEATURES];  ///< Each level also needs everything below it
+   int         featureCount;
+};
+
+
+/// @see https://gitlab.com/x86-psABIs/x86-64-ABI (Micro-architecture levels)
+static const struct isa_level levels[] = {
+   { "x86_64",    "-march=x86-64",    "arch=x86-64",    XFRM_SSE,
+      { FIELD_SSE2 }, 1 },
+   { "x86_64_v2", "-march=x86-64-v2", "arch=x86-64-v2", XFRM_SSE,
+      { FIELD_CX16, FIELD_LAHF_LM, FIELD_POPCNT, FIELD_SSE3, FIELD_SSE4_1, FIELD_SSE4_2, FIELD_SSSE3 }, 7 },
+   { "x86_64_v3", "-march=x86-64-v3", "arch=x86-64-v3", XFRM_AVX,
+      { FIELD_AVX, FIELD_AVX2, FIELD_BMI1, FIELD_BMI2, FIELD_F16C, FIELD_FMA, FIELD_LZCNT, FIELD_MOVBE, FIELD_OSXSAVE }, 9 },
+   { "x86_64_v4", "-march=x86-64-v4", "arch=x86-64-v4", XFRM_AVX512,
+      { FIELD_AVX512F, FIELD_AVX512BW, FIELD_AVX512CD, FIELD_AVX512DQ, FIELD_AVX512VL }, 5 },
+   { "amx",       "-march=x86-64-v4 -mamx-tile -mamx-int8 -mamx-bf16", "arch=x86-64-v4,amx-tile,amx-int8,amx-bf16", XFRM_AMX,
+      { FIELD_AMX_TILE, FIELD_AMX_INT8, FIELD_AMX_BF16 }, 3 },
+};
+
+#define LEVEL_COUNT ((int) (sizeof( levels ) / sizeof( levels[0] )))
+
+
+/// Return `true` if the capture has every ISA extension level `l` needs
+static bool level_has_features( const struct sgx_capture* cap, int l ) {
+   for( int f = 0 ; f < levels[l].featureCount ; f++ ) {
+      uint64_t value = 0;
+      if( !field_from_capture( &fields[levels[l].features[f]], cap, &value ) || value == 0 ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+
+/// Write the dispatch table header for every level up to and including `best`
+static bool write_header( const char* fileName, const struct sgx_capture* cap, int best, uint64_t usable ) {
+   FILE* file = fopen( fileName, "w" );
+   if( file == NULL ) {
+      fprintf( stderr, "isa: Unable to open [%s]\n", fileName );
+      return false;
+   }
+
+   fprintf( file, "// Generated by `" PROGRAM_NAME " --isa` for node %s.  Do not edit.\n", cap->node );
+   fprintf( file, "//\n" );
+   fprintf( file, "// Function multiversioning (target_clones) resolves with CPUID, which\n" );
+   fprintf( file, "// raises #UD inside an enclave.  Instead, declare one variant per level:\n" );
+   fprintf( file, "//\n" );
+   fprintf( file, "//     ENCLAVE_DISPATCH_TABLE( void, kernel, ( float* out, const float* in, int n ) );\n" );
+   fprintf( file, "//     ENCLAVE_TARGET_X86_64_V3 void kernel_x86_64_v3( float* out, const float* in, int n ) { ... }\n" );
+   fprintf( file, "//\n" );
+   fprintf( file, "// ...call `enclave_isa_init()` once with SECS.ATTRIBUTES.XFRM (from the\n" );
+   fprintf( file, "// enclave's own EREPORT) and then `ENCLAVE_DISPATCH( kernel )( out, in, n )`.\n" );
+   fprintf( file, "// Define ENCLAVE_ISA_IMPLEMENTATION in exactly one source file before\n" );
+   fprintf( file, "// including this header, so every file dispatches on the same level.\n" );
+   fprintf( file, "#pragma once\n\n" );
+   fprintf( file, "#include <stdint.h>\n\n" );
+
+   fprintf( file, "/// The widest level that is safe on this host class\n" );
+   fprintf( file, "#define ENCLAVE_ISA_BEST_LEVEL %d\n", best );
+   fprintf( file, "#define ENCLAVE_ISA_MARCH \"%s\"\n", levels[best].march );
+   fprintf( file, "/// The XFRM to put in SECS.ATTRIBUTES for ENCLAVE_ISA_MARCH\n" );
+   fprintf( file, "#define ENCLAVE_XFRM 0x%016" PRIx64 "ULL\n", levels[best].xfrm & usable );
+   fprintf( file, "/// Every XSAVE state component an enclave may enable on this host class\n" );
+   fprintf( file, "#define ENCLAVE_XFRM_USABLE 0x%016" PRIx64 "ULL\n\n", usable );
+
+   for( int l = 0 ; l <= best ; l++ ) {
+      char upper[32];
+      size_t i;
+      for( i = 0 ; levels[l].name[i] != '\0' && i < sizeof( upper ) - 1 ; i++ ) {
+         upper[i] = (char) toupper( (unsigned char) levels[l].name[i] );
+      }
+      upper[i] = '\0';
+      fprintf( file, "#define ENCLAVE_TARGET_%-10s __attribute__(( target( \"%s\" ) ))\n", upper, levels[l].target );
+   }
+
+   fprintf( file, "\n/// Levels in dispatch-table order, with the XFRM each one needs\n" );
+   fprintf( file, "static const uint64_t enclave_isa_xfrm[%d] = {", best + 1 );
+   for( int l = 0 ; l <= best ; l++ ) {
+      fprintf( file, "%s 0x%016" PRIx64 "ULL", l ? "," : "", levels[l].xfrm );
+   }
+   fprintf( file, " };\n\n" );
+
+   fprintf( file, "/// The level ENCLAVE_DISPATCH() uses -- set by enclave_isa_init()\n" );
+   fprintf( file, "extern int enclave_isa_level;\n\n" );
+   fprintf( file, "/// Pick the widest level whose state components are all enabled in `xfrm`\n" );
+   fprintf( file, "int enclave_isa_init( uint64_t xfrm );\n\n" );
+   fprintf( file, "#ifdef ENCLAVE_ISA_IMPLEMENTATION\n" );
+   fprintf( file, "int enclave_isa_level = 0;\n\n" );
+   fprintf( file, "int enclave_isa_init( uint64_t xfrm ) {\n" );
+   fprintf( file, "   int level = 0;\n" );
+   fprintf( file, "   for( int l = 1 ; l <= ENCLAVE_ISA_BEST_LEVEL ; l++ ) {\n" );
+   fprintf( file, "      level = ( enclave_isa_xfrm[l] & ~xfrm ) == 0 ? l : level;\n" );
+   fprintf( file, "   }\n" );
+   fprintf( file, "   enclave_isa_level = level;\n" );
+   fprintf( file, "   return level;\n" );
+   fprintf( file, "}\n" );
+   fprintf( file, "#endif  // ENCLAVE_ISA_IMPLEMENTATION\n\n" );
+
+   fprintf( file, "#define ENCLAVE_DISPATCH_TABLE( ret, name, args ) \\\n" );
+   for( int l = 0 ; l <= best ; l++ ) {
+      fprintf( file, "   ret name##_%s args; \\\n", levels[l].name );
+   }
+   fprintf( file, "   static ret (* const name##_table[%d]) args = {", best + 1 );
+   for( int l = 0 ; l <= best ; l++ ) {
+      fprintf( file, "%s name##_%s", l ? "," : "", levels[l].name );
+   }
+   fprintf( file, " }\n\n" );
+
+   fprintf( file, "#define ENCLAVE_DISPATCH( name ) ( name##_table[enclave_isa_level] )\n" );
+
+   fclose( file );
+   return true;
+}
+
+
+/// `--isa [--from CAPTURE] [--header FILE]`
+int isa_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;  // Too big for the stack
+   const char* fromFile = NULL;
+   const char* headerFile = NULL;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( strcmp( argv[i], "--header" ) == 0 && i + 1 < argc ) {
+         headerFile = argv[++i];
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --isa [--from CAPTURE] [--header FILE]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+
+   if( fromFile != NULL ) {
+      if( !capture_load( fromFile, &cap ) ) {
+         return EXIT_FAILURE;
+      }
+   } else {
+      cache_probe( &cap, false );
+   }
+
+   uint64_t sgx = 0;
+   uint64_t xfrmLo = 0;
+   uint64_t xfrmHi = 0;
+   field_from_capture( &fields[FIELD_SGX], &cap, &sgx );
+   field_from_capture( &fields[FIELD_XFRM_LO], &cap, &xfrmLo );
+   field_from_capture( &fields[FIELD_XFRM_HI], &cap, &xfrmHi );
+
+   uint64_t xfrmAllowed = xfrmHi << 32 | xfrmLo;
+   uint64_t xcr0 = cap.has_xcr0 ? cap.xcr0 : 0;
+   uint64_t usable = xfrmAllowed & xcr0;
+
+   printf( "Enclave ISA advisor\n" );
+   if( !sgx ) {
+      printf( "  This CPU does not support SGX.  Checking XCR0 alone -- there's no XFRM to advise.\n" );
+      usable = xcr0;
+   }
+   printf( "  XFRM allowed by SGX (CPUID.12H.1:ECX:EDX): %016" PRIx64 "\n", xfrmAllowed );
+   printf( "  XCR0 enabled by the OS:                    %016" PRIx64 "\n", xcr0 );
+   if( sgx ) {
+      printf( "  Usable in an enclave (XFRM & XCR0):        %016" PRIx64 "\n", usable );
+   }
+   printf( "    Level      CPU  State  Safe  XFRM\n" );
+   printf( "    =========  ===  =====  ====  ================\n" );
+
+   int best = -1;
+   for( int l = 0 ; l < LEVEL_COUNT ; l++ ) {
+      bool cpu   = level_has_features( &cap, l );
+      bool state = (levels[l].xfrm & ~usable) == 0;
+      bool safe  = cpu && state && best == l - 1;  // Every lower level must be safe too
+
+      printf( "    %-9s  %-3s  %-5s  %-4s  %016" PRIx64 "\n"
+             ,levels[l].name
+             ,cpu   ? "yes" : "no"
+             ,state ? "yes" : "no"
+             ,safe  ? "yes" : "no"
+             ,levels[l].xfrm );
+
+      if( safe ) {
+         best = l;
+      }
+   }
+
+   if( best < 0 ) {
+      printf( "No safe compiler target.  The CPU or OS doesn't support SSE state.\n" );
+      return EXIT_FAILURE;
+   }
+
+   if( !sgx ) {
+      // Without SGX there's no enclave to build, so no XFRM or dispatch header
+      printf( "Widest compiler target outside an enclave: %s\n", levels[best].march );
+      if( headerFile != NULL ) {
+         fprintf( stderr, "isa: Not writing [%s].  This CPU can't run enclaves.\n", headerFile );
+         return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+   }
+
+   printf( "Best safe compiler target: %s\n", levels[best].march );
+   printf( "Matching SECS.ATTRIBUTES.XFRM: 0x%016" PRIx64 "\n", levels[best].xfrm & usable );
+
+   if( headerFile != NULL ) {
+      if( !write_header( headerFile, &cap, best, usable ) ) {
+         return EXIT_FAILURE;
+      }
+      printf( "Wrote dispatch table header: %s\n", headerFile );
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  isa.h - 2026
+//
+/// This module advises which vector ISA an enclave can safely be compiled
+/// for on this host.
+///
+/// @file   isa.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--isa [--from CAPTURE] [--header FILE]`
+int isa_main( int argc, char* argv[] );
@@ -0,0 +1,573 @@
+///////////////////////////////////////////////////////////////////////////////
+//  membench.c - 2026
+//
+/// This module measures memory latency & bandwidth at working sets sized from
+/// the caches and the EPC, to predict how an enclave's working set will
+/// perform before it's deployed.
+///
+/// The working sets are picked from the host:
+///
+///   - `L1`, `L2` & `LLC`:  Half of each cache (CPUID leaf 4, or 8000001DH)
+///   - `DRAM`:  Four times the LLC
+///   - `EPC/2`, `EPC` & `2xEPC`:  Half, 7/8 and twice each EPC section size
+///     (from `find_EPC_sections()`).  Some of a section holds the EPCM and
+///     version arrays, so 7/8 is about where an enclave starts paging.
+///
+/// Each working set gets four measurements:
+///
+///   - Latency:  A pointer chase through a random cycle of cache lines.  Every
+///     load depends on the last, so this is the time for one miss.
+///   - Read, Write & NT write:  Streaming 16-byte loads, stores and
+///     non-temporal (`movntdq`) stores.  The best of three runs.
+///
+/// This runs outside of an enclave, so the EPC rows show plain DRAM at those
+/// sizes.  Inside an enclave, every LLC miss also goes through the memory
+/// encryption engine, and a working set bigger than the EPC makes the kernel
+/// page EPC (EWB/ELDU) -- that costs tens of microseconds per fault.  So read
+/// the table for where a working set falls, then expect a step beyond `LLC`
+/// and a cliff beyond `EPC`.
+///
+/// Buffers use 4 KiB pages (like EPC) unless `--huge` asks for 2 MiB pages.
+/// The benchmark pins itself to one CPU -- the first CPU of `--node`, with
+/// its memory bound to that node, when a node is given.
+///
+/// Usage:
+///
+///     test-sgx --membench                     # Up to 4 GiB working sets
+///     test-sgx --membench --huge --node 1     # 2 MiB pages on NUMA node 1
+///     test-sgx --membench --max 65536         # Include a 64 GiB EPC section
+///
+/// @file   membench.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sched_setaffinity()`, `MAP_HUGETLB` and `syscall()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For atol() malloc() free()
+#include <string.h>    // For strcmp() memset() strncmp()
+#include <inttypes.h>  // For PRIu64 uint64_t uint32_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime()
+
+#ifdef __linux__
+   #include <sched.h>          // For sched_setaffinity() sched_getcpu() CPU_SET()
+   #include <unistd.h>         // For syscall()
+   #include <sys/mman.h>       // For mmap() madvise() munmap()
+   #include <sys/syscall.h>    // For SYS_mbind
+#endif
+
+#include "membench.h"  // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32() find_EPC_sections()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_parse_cpulist() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+#define KiB ((uint64_t) 1 << 10)
+#define MiB ((uint64_t) 1 << 20)
+#define GiB ((uint64_t) 1 << 30)
+
+/// The kernels move whole cache lines
+#define LINE_SIZE 64
+
+/// The size of a huge page on x86-64
+#define HUGE_PAGE_SIZE (2 * MiB)
+
+/// `mbind()` policy:  Only allocate from the nodes in the mask
+#define MPOL_BIND 2
+
+/// The most working sets we'll measure
+#define MAX_POINTS 32
+
+/// The largest working set, unless `--max` says otherwise
+#define DEFAULT_MAX_MiB 4096
+
+
+/// The data cache sizes
+struct cache_sizes {
+   uint64_t l1;
+   uint64_t l2;
+   uint64_t llc;
+   bool     enumerated;  ///< `false` if we guessed
+};
+
+/// One working set to measure
+struct point {
+   char     name[24];
+   uint64_t size;
+};
+
+
+#ifdef __linux__
+
+/// Find the data cache sizes with CPUID's deterministic cache parameters
+/// (leaf 4 on Intel, 8000001DH on AMD)
+static void find_caches( struct cache_sizes* caches ) {
+   const uint32_t leaves[] = { 0x04, 0x8000001D };
+   uint32_t eax, ebx, ecx, edx;
+
+   caches->l1 = 0;
+   caches->l2 = 0;
+   caches->llc = 0;
+
+   eax = 0; ebx = 0; ecx = 0; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   uint32_t maxBasicLeaf = eax;
+   eax = 0x80000000; ebx = 0; ecx = 0; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   uint32_t maxExtendedLeaf = eax;
+
+   for( size_t l = 0 ; l < sizeof( leaves ) / sizeof( leaves[0] ) && caches->l1 == 0 ; l++ ) {
+      if( leaves[l] > (leaves[l] < 0x80000000 ? maxBasicLeaf : maxExtendedLeaf) ) {
+         continue;
+      }
+      for( uint32_t sub = 0 ; sub < 16 ; sub++ ) {
+         eax = leaves[l]; ebx = 0; ecx = sub; edx = 0;
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+
+         uint64_t type = field_from_regs( &fields[FIELD_CACHE_TYPE], eax, ebx, ecx, edx );
+         if( type == 0 ) {  // No more caches
+            break;
+         }
+         if( type == 2 ) {  // Instruction cache
+            continue;
+         }
+         uint64_t size = ( field_from_regs( &fields[FIELD_CACHE_WAYS],       eax, ebx, ecx, edx ) + 1 )
+                       * ( field_from_regs( &fields[FIELD_CACHE_PARTITIONS], eax, ebx, ecx, edx ) + 1 )
+                       * ( field_from_regs( &fields[FIELD_CACHE_LINE_SIZE],  eax, ebx, ecx, edx ) + 1 )
+                       * ( field_from_regs( &fields[FIELD_CACHE_SETS],       eax, ebx, ecx, edx ) + 1 );
+
+         switch( field_from_regs( &fields[FIELD_CACHE_LEVEL], eax, ebx, ecx, edx ) ) {
+            case 1:  caches->l1 = size; break;
+            case 2:  caches->l2 = size; break;
+            default: caches->llc = size > caches->llc ? size : caches->llc; break;
+         }
+      }
+   }
+
+   caches->enumerated = caches->l1 != 0;
+   if( caches->l1 == 0 ) {
+      caches->l1 = 32 * KiB;
+   }
+   if( caches->l2 == 0 ) {
+      caches->l2 = 1 * MiB;
+   }
+   if( caches->llc == 0 ) {
+      caches->llc = caches->l2 > 8 * MiB ? caches->l2 : 8 * MiB;
+   }
+}
+
+
+/// Add a working set to `points`, keeping them in size order.  Sizes are
+/// rounded down to a whole number of cache lines.
+static void add_point( struct point* points, int* pCount, const char* name, uint64_t size ) {
+   size -= size % LINE_SIZE;
+   if( *pCount >= MAX_POINTS || size < 4 * KiB ) {
+      return;
+   }
+
+   int at = *pCount;
+   while( at > 0 && points[at - 1].size > size ) {
+      points[at] = points[at - 1];
+      at--;
+   }
+   snprintf( points[at].name, sizeof( points[at].name ), "%s", name );
+   points[at].size = size;
+   (*pCount)++;
+}
+
+
+/// Format a size like `48 KiB`, `1.5 MiB` or `64 GiB`
+static const char* format_size( uint64_t bytes, char* out, size_t size ) {
+   const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+   double value = (double) bytes;
+   int u = 0;
+
+   while( value >= 1024 && u < 4 ) {
+      value /= 1024;
+      u++;
+   }
+   snprintf( out, size, value == (double) (uint64_t) value ? "%.0f %s" : "%.1f %s", value, units[u] );
+   return out;
+}
+
+
+/// @return The current time in seconds
+static double now_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Follow `steps` pointers starting at `p`
+///
+/// @return Where the chase ended, so the loads can't be optimized away
+static void* chase( void* p, uint64_t steps ) {
+   __asm volatile (
+      "1:;"
+      "mov %0, [%0];"
+      "dec %1;"
+      "jnz 1b;"
+      :"+r" (p)
+      ,"+r" (steps)
+      :
+      : "memory", "cc" );
+   return p;
+}
+
+
+/// Load `bytes` (a multiple of 64) from `p`
+static void read_lines( void* p, uint64_t bytes ) {
+   __asm volatile (
+      "1:;"
+      "movdqa xmm0, [%0];"
+      "movdqa xmm1, [%0+16];"
+      "movdqa xmm2, [%0+32];"
+      "movdqa xmm3, [%0+48];"
+      "add %0, 64;"
+      "sub %1, 64;"
+      "jnz 1b;"
+      :"+r" (p)
+      ,"+r" (bytes)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "memory", "cc" );
+}
+
+
+/// Store `bytes` (a multiple of 64) to `p`
+static void write_lines( void* p, uint64_t bytes ) {
+   __asm volatile (
+      "pxor xmm0, xmm0;"
+      "1:;"
+      "movdqa [%0], xmm0;"
+      "movdqa [%0+16], xmm0;"
+      "movdqa [%0+32], xmm0;"
+      "movdqa [%0+48], xmm0;"
+      "add %0, 64;"
+      "sub %1, 64;"
+      "jnz 1b;"
+      :"+r" (p)
+      ,"+r" (bytes)
+      :
+      : "xmm0", "memory", "cc" );
+}
+
+
+/// Store `bytes` (a multiple of 64) to `p` without reading the lines into the
+/// cache first
+static void stream_lines( void* p, uint64_t bytes ) {
+   __asm volatile (
+      "pxor xmm0, xmm0;"
+      "1:;"
+      "movntdq [%0], xmm0;"
+      "movntdq [%0+16], xmm0;"
+      "movntdq [%0+32], xmm0;"
+      "movntdq [%0+48], xmm0;"
+      "add %0, 64;"
+      "sub %1, 64;"
+      "jnz 1b;"
+      "sfence;"
+      :"+r" (p)
+      ,"+r" (bytes)
+      :
+      : "xmm0", "memory", "cc" );
+}
+
+
+/// Link the cache lines of `buffer[0..size)` into one random cycle (Sattolo's
+/// algorithm), so the hardware prefetchers can't guess the next line
+///
+/// @return `false` if we're out of memory
+static bool link_lines( void* buffer, uint64_t size ) {
+   uint64_t lines = size / LINE_SIZE;
+   uint32_t* order = malloc( lines * sizeof( *order ) );
+   uint64_t seed = 0x9E3779B97F4A7C15;
+
+   if( order == NULL ) {
+      return false;
+   }
+   for( uint64_t i = 0 ; i < lines ; i++ ) {
+      order[i] = (uint32_t) i;
+   }
+   for( uint64_t i = lines - 1 ; i > 0 ; i-- ) {
+      seed ^= seed << 13;  // xorshift64
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      uint64_t j = seed % i;  // j < i makes it one cycle
+      uint32_t swap = order[i];
+      order[i] = order[j];
+      order[j] = swap;
+   }
+
+   char* base = buffer;
+   for( uint64_t i = 0 ; i < lines ; i++ ) {
+      *(void**) (base + (uint64_t) order[i] * LINE_SIZE) = base + (uint64_t) order[(i + 1) % lines] * LINE_SIZE;
+   }
+   free( order );
+   return true;
+}
+
+
+/// @return The nanoseconds per dependent load in `buffer[0..size)`, or `-1`
+static double measure_latency( void* buffer, uint64_t size ) {
+   const uint64_t steps = (uint64_t) 1 << 21;
+   double best = 0;
+
+   if( !link_lines( buffer, size ) ) {
+      return -1;
+   }
+   void* p = chase( buffer, size / LINE_SIZE );  // Warm up (and fault in the TLB)
+   for( int trial = 0 ; trial < 3 ; trial++ ) {
+      double start = now_seconds();
+      p = chase( p, steps );
+      double ns = (now_seconds() - start) * 1e9 / (double) steps;
+      best = trial == 0 || ns < best ? ns : best;
+   }
+   return p != NULL ? best : -1;
+}
+
+
+/// @return The best GB/s of three runs of `kernel` over `buffer[0..size)`
+static double measure_bandwidth( void (*kernel)( void*, uint64_t ), void* buffer, uint64_t size ) {
+   uint64_t passes = 256 * MiB / size > 0 ? 256 * MiB / size : 1;
+   double best = 0;
+
+   kernel( buffer, size );  // Warm up
+   for( int trial = 0 ; trial < 3 ; trial++ ) {
+      double start = now_seconds();
+      for( uint64_t pass = 0 ; pass < passes ; pass++ ) {
+         kernel( buffer, size );
+      }
+      double gbs = (double) (size * passes) / (now_seconds() - start) / 1e9;
+      best = gbs > best ? gbs : best;
+   }
+   return best;
+}
+
+
+/// Pin this thread to the first CPU of `node`, or to the CPU it's on now if
+/// `node` is `-1`
+///
+/// @return The CPU we're pinned to, or `-1`
+static int pin_cpu( int node ) {
+   int cpu = sched_getcpu();
+
+   if( node >= 0 ) {
+      char path[128];
+      char line[4096];
+      static int cpus[MAX_CPUS];
+      int count = -1;
+
+      snprintf( path, sizeof( path ), "/sys/devices/system/node/node%d/cpulist", node );
+      FILE* file = fopen( path, "r" );
+      if( file != NULL ) {
+         if( fgets( line, sizeof( line ), file ) != NULL ) {
+            count = topology_parse_cpulist( line, cpus, MAX_CPUS );
+         }
+         fclose( file );
+      }
+      if( count <= 0 ) {
+         return -1;
+      }
+      cpu = cpus[0];
+   }
+
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   return sched_setaffinity( 0, sizeof( set ), &set ) == 0 ? cpu : -1;
+}
+
+
+/// Map `size` bytes for the benchmark, bound to `node` (unless it's `-1`) and
+/// faulted in
+///
+/// @return The buffer (and what pages it got in `pPages`), or `NULL`
+static void* map_buffer( uint64_t size, bool huge, int node, const char** pPages ) {
+   void* buffer = MAP_FAILED;
+
+   if( huge ) {
+      size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+      buffer = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+      *pPages = "2 MiB pages";
+   }
+   if( buffer == MAP_FAILED ) {
+      buffer = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+      if( buffer == MAP_FAILED ) {
+         return NULL;
+      }
+      if( huge ) {  // No hugetlbfs pages reserved:  Ask for transparent ones
+         madvise( buffer, size, MADV_HUGEPAGE );
+         *pPages = "transparent 2 MiB pages (none reserved in nr_hugepages)";
+      } else {
+         madvise( buffer, size, MADV_NOHUGEPAGE );
+         *pPages = "4 KiB pages";
+      }
+   }
+
+   if( node >= 0 ) {
+      unsigned long nodeMask[16] = { 0 };  // 1024 nodes
+      if( node >= (int) (sizeof( nodeMask ) * 8) ) {
+         munmap( buffer, size );
+         return NULL;
+      }
+      nodeMask[node / (8 * sizeof( nodeMask[0] ))] |= 1UL << (node % (8 * sizeof( nodeMask[0] )));
+      if( syscall( SYS_mbind, buffer, size, MPOL_BIND, nodeMask, sizeof( nodeMask ) * 8, 0 ) != 0 ) {
+         munmap( buffer, size );
+         return NULL;
+      }
+   }
+
+   memset( buffer, 1, size );  // Fault it in now, not while we're timing
+   return buffer;
+}
+
+
+/// @return The bytes in MemAvailable (or `0`)
+static uint64_t available_memory( void ) {
+   char line[256];
+   uint64_t kB = 0;
+
+   FILE* file = fopen( "/proc/meminfo", "r" );
+   if( file != NULL ) {
+      while( fgets( line, sizeof( line ), file ) != NULL ) {
+         if( sscanf( line, "MemAvailable: %" SCNu64, &kB ) == 1 ) {
+            break;
+         }
+      }
+      fclose( file );
+   }
+   return kB * KiB;
+}
+
+#endif
+
+
+/// `--membench [--huge] [--node N] [--max MIB]`
+int membench_main( int argc, char* argv[] ) {
+   bool huge = false;
+   int  node = -1;
+   long maxMiB = DEFAULT_MAX_MiB;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--huge" ) == 0 ) {
+         huge = true;
+      } else if( strcmp( argv[i], "--node" ) == 0 && i + 1 < argc ) {
+         node = atoi( argv[++i] );
+      } else if( strcmp( argv[i], "--max" ) == 0 && i + 1 < argc ) {
+         maxMiB = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --membench [--huge] [--node N] [--max MIB]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( node < -1 || maxMiB <= 0 ) {
+      fprintf( stderr, "membench: The node and maximum size must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      struct cache_sizes caches;
+      struct epc_section sections[NUMBER_OF_EPCs_TO_ENUMERATE];
+      struct point points[MAX_POINTS];
+      int pointCount = 0;
+      char text[32];
+
+      find_caches( &caches );
+      int sectionCount = find_EPC_sections( sections, NUMBER_OF_EPCs_TO_ENUMERATE );
+
+      add_point( points, &pointCount, "L1",   caches.l1 / 2 );
+      if( caches.l2 > 2 * caches.l1 ) {
+         add_point( points, &pointCount, "L2", caches.l2 / 2 );
+      }
+      add_point( points, &pointCount, "LLC",  caches.llc / 2 );
+      add_point( points, &pointCount, "DRAM", caches.llc * 4 );
+      for( int s = 0 ; s < sectionCount ; s++ ) {
+         bool seen = false;  // Sockets usually have the same size of section
+         for( int t = 0 ; t < s ; t++ ) {
+            seen = seen || sections[t].size == sections[s].size;
+         }
+         if( seen ) {
+            continue;
+         }
+         char name[24];
+         snprintf( name, sizeof( name ), "EPC[%d]/2", s );
+         add_point( points, &pointCount, name, sections[s].size / 2 );
+         snprintf( name, sizeof( name ), "EPC[%d]", s );
+         add_point( points, &pointCount, name, sections[s].size / 8 * 7 );
+         snprintf( name, sizeof( name ), "2xEPC[%d]", s );
+         add_point( points, &pointCount, name, sections[s].size * 2 );
+      }
+
+      // Don't ask for more than --max or half of the free memory
+      uint64_t maxSize = (uint64_t) maxMiB * MiB;
+      uint64_t available = available_memory();
+      if( available != 0 && maxSize > available / 2 ) {
+         maxSize = available / 2;
+      }
+      uint64_t largest = 0;
+      for( int p = 0 ; p < pointCount ; p++ ) {
+         largest = points[p].size <= maxSize && points[p].size > largest ? points[p].size : largest;
+      }
+
+      int cpu = pin_cpu( node );
+      if( cpu < 0 ) {
+         fprintf( stderr, "membench: Unable to pin to %s%d\n", node >= 0 ? "NUMA node " : "CPU ", node >= 0 ? node : cpu );
+         return EXIT_FAILURE;
+      }
+
+      const char* pages = "";
+      void* buffer = map_buffer( largest, huge, node, &pages );
+      if( buffer == NULL ) {
+         fprintf( stderr, "membench: Unable to map %s%s\n", format_size( largest, text, sizeof( text ) ), node >= 0 ? " on that node" : "" );
+         return EXIT_FAILURE;
+      }
+
+      printf( "Memory latency & bandwidth on CPU %d", cpu );
+      if( node >= 0 ) {
+         printf( " (NUMA node %d)", node );
+      }
+      printf( " with %s\n", pages );
+      printf( "  L1d %s", format_size( caches.l1, text, sizeof( text ) ) );
+      printf( ", L2 %s", format_size( caches.l2, text, sizeof( text ) ) );
+      printf( ", LLC %s%s\n", format_size( caches.llc, text, sizeof( text ) ), caches.enumerated ? "" : " (guessed -- CPUID doesn't enumerate the caches)" );
+      if( sectionCount == 0 ) {
+         printf( "  No EPC sections (SGX isn't available), so there are no EPC working sets\n" );
+      }
+      for( int s = 0 ; s < sectionCount ; s++ ) {
+         printf( "  EPC[%d] %s\n", s, format_size( sections[s].size, text, sizeof( text ) ) );
+      }
+
+      printf( "    Class        Working set     Latency      Read     Write  NT write\n" );
+      printf( "                                      ns      GB/s      GB/s      GB/s\n" );
+      printf( "    ===========  ===========  ==========  ========  ========  ========\n" );
+      for( int p = 0 ; p < pointCount ; p++ ) {
+         printf( "    %-11s  %11s", points[p].name, format_size( points[p].size, text, sizeof( text ) ) );
+         if( points[p].size > maxSize ) {
+            printf( "  skipped (bigger than --max or half of MemAvailable)\n" );
+            continue;
+         }
+         fflush( stdout );  // The bigger working sets take a while
+
+         double read   = measure_bandwidth( read_lines,   buffer, points[p].size );
+         double write  = measure_bandwidth( write_lines,  buffer, points[p].size );
+         double stream = measure_bandwidth( stream_lines, buffer, points[p].size );
+         double ns     = measure_latency( buffer, points[p].size );
+
+         printf( "  %10.1f  %8.1f  %8.1f  %8.1f\n", ns, read, write, stream );
+      }
+
+      munmap( buffer, huge ? (largest + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : largest );
+      return EXIT_SUCCESS;
+
+   #else
+      (void) huge;
+      printf( "The memory benchmark needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
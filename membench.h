@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  membench.h - 2026
+//
+/// This module measures memory latency & bandwidth at working sets sized from
+/// the caches and the EPC.
+///
+/// @file   membench.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--membench [--huge] [--node N] [--max MIB]`
+int membench_main( int argc, char* argv[] );
@@ -0,0 +1,351 @@
+///////////////////////////////////////////////////////////////////////////////
+//  metrics.c - 2026
+//
+/// This module exports this node's SGX state as OpenMetrics gauges for
+/// node_exporter's textfile collector.
+///
+/// Every value is a labelled gauge:  The SGX feature flags (SGX1, SGX2,
+/// SGX_LC...), the size of each EPC section, the SGX MSRs (when we can read
+/// them), XCR0, IA32_XSS and the XSAVE area sizes.  `MSR_SGXOWNEREPOCH` is
+/// never exported -- it's a secret that goes into every sealing key, and the
+/// textfile has to be readable by node_exporter.
+///
+/// It's meant to run every 15 seconds on every node, so it's cheap:  CPUID
+/// and the SGX MSRs come from the probe cache (see cache.c) and only the
+/// registers that change while the node is up are read live:  XCR0, IA32_XSS
+/// and, when launch control is unlocked, IA32_SGXLEPUBKEYHASH0-3 (the kernel
+/// rewrites them before each EINIT).  With `--interval` it stays running,
+/// keeps the static values and only re-reads those registers each time.
+///
+/// The file is published atomically:  The metrics are written to a temporary
+/// file in the same directory (which node_exporter ignores, because it doesn't
+/// end in `.prom`) and renamed over FILE, so a scrape never sees a partial
+/// file.  It isn't fsync'd -- after a crash the next run rewrites it anyway.
+///
+/// Usage:
+///
+///     test-sgx --metrics /var/lib/node_exporter/textfile/sgx.prom
+///     test-sgx --metrics --interval 15 /var/lib/node_exporter/textfile/sgx.prom
+///     test-sgx --metrics --from host17.cap -
+///
+/// @see https://github.com/prometheus/node_exporter#textfile-collector
+/// @see https://prometheus.io/docs/specs/om/open_metrics_spec/
+///
+/// @file   metrics.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `open_memstream()` `mkstemp()` and `clock_nanosleep()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fprintf() open_memstream()
+#include <stdlib.h>    // For mkstemp() free() strtod()
+#include <string.h>    // For strcmp() strlen()
+#include <inttypes.h>  // For PRIu64 PRIx64 uint64_t
+#include <limits.h>    // For PATH_MAX
+#include <time.h>      // For clock_gettime() clock_nanosleep()
+
+#ifdef __linux__
+   #include <unistd.h>    // For write() close() unlink()
+   #include <signal.h>    // For sigaction() sig_atomic_t SIGTERM SIGINT
+   #include <sys/stat.h>  // For fchmod()
+#endif
+
+#include "metrics.h"   // For obvious reasons
+#include "capture.h"   // For capture_load() capture_find_cpuid() capture_find_msr()
+#include "cache.h"     // For cache_probe()
+#include "cpuid.h"     // For decode_EPC_section() NUMBER_OF_EPCs_TO_ENUMERATE
+#include "decode.h"    // For fields[] xsave_components[] field_from_capture() field_extract()
+#include "rdmsr.h"     // For rdmsr() IA32_XSS IA32_SGXLEPUBKEYHASH0 IA32_FEATURE_CONTROL
+#include "xsave.h"     // For native_XGETBV() XSAVE_area_size()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+#ifdef __linux__
+
+/// Set by SIGTERM or SIGINT so `--interval` stops between files, rather than
+/// leaving a temporary file behind
+static volatile sig_atomic_t stopping = 0;
+
+
+/// The SIGTERM & SIGINT handler
+static void stop( int signal ) {
+   (void) signal;
+   stopping = 1;
+}
+
+
+/// @return CLOCK_MONOTONIC in seconds
+static double now_seconds( void ) {
+   struct timespec now;
+
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Print the `HELP` and `TYPE` lines for a gauge
+static void gauge( FILE* out, const char* name, const char* help ) {
+   fprintf( out, "# HELP %s %s\n", name, help );
+   fprintf( out, "# TYPE %s gauge\n", name );
+}
+
+
+/// Print one sample of a field from `cap`.  Fields that weren't captured
+/// (for example, leaf 12H on a CPU without SGX) are `0`.
+static void field_sample( FILE* out, const char* metric, const char* label, enum field_id id, const struct sgx_capture* cap ) {
+   uint64_t value = 0;
+
+   field_from_capture( &fields[id], cap, &value );
+   fprintf( out, "%s{%s=\"%s\"} %" PRIu64 "\n", metric, label, fields[id].name, value );
+}
+
+
+/// Write every metric for `cap` to `out`
+///
+/// @param msrs          `true` if `cap` holds the SGX MSRs
+/// @param probeSeconds  How long it took to get `cap`
+static void write_metrics( FILE* out, const struct sgx_capture* cap, bool msrs, double probeSeconds ) {
+   uint64_t value = 0;
+
+   // Feature flags
+   gauge( out, "sgx_feature", "SGX features enumerated by CPUID leaves 7 and 12H (1 = supported)" );
+   field_sample( out, "sgx_feature", "feature", FIELD_SGX, cap );
+   for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+      if( fields[i].group == GROUP_SGX ) {
+         field_sample( out, "sgx_feature", "feature", (enum field_id) i, cap );
+      }
+   }
+
+   // EPC
+   uint64_t total = 0;
+   gauge( out, "sgx_epc_section_bytes", "Size of each EPC section (CPUID leaf 12H, sub-leaf 2 and up)" );
+   for( uint32_t sub = 2 ; sub <= NUMBER_OF_EPCs_TO_ENUMERATE ; sub++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( cap, 0x12, sub );
+      struct epc_section section;
+      if( r != NULL && decode_EPC_section( r->eax, r->ebx, r->ecx, r->edx, &section ) ) {
+         fprintf( out, "sgx_epc_section_bytes{section=\"%" PRIu32 "\",base=\"0x%" PRIx64 "\",protection=\"%c%c\"} %" PRIu64 "\n"
+                ,sub - 2, section.base, section.confidentiality, section.integrity, section.size );
+         total += section.size;
+      }
+   }
+   gauge( out, "sgx_epc_bytes", "Size of all of the EPC sections" );
+   fprintf( out, "sgx_epc_bytes %" PRIu64 "\n", total );
+
+   // MSRs
+   gauge( out, "sgx_msrs_readable", "1 if the SGX MSRs could be read (it takes root and the msr driver)" );
+   fprintf( out, "sgx_msrs_readable %d\n", msrs ? 1 : 0 );
+   if( msrs ) {
+      if( capture_find_msr( cap, IA32_FEATURE_CONTROL, &value ) ) {
+         gauge( out, "sgx_feature_control", "IA32_FEATURE_CONTROL bits" );
+         for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+            if( fields[i].group == GROUP_FEATURE_CONTROL ) {
+               field_sample( out, "sgx_feature_control", "bit", (enum field_id) i, cap );
+            }
+         }
+      }
+
+      uint64_t hash[4];
+      bool haveHash = true;
+      for( uint32_t i = 0 ; i < 4 ; i++ ) {
+         haveHash = haveHash && capture_find_msr( cap, IA32_SGXLEPUBKEYHASH0 + i, &hash[i] );
+      }
+      if( haveHash ) {
+         gauge( out, "sgx_le_pubkey_hash_info", "The launch enclave public key hash (IA32_SGXLEPUBKEYHASH0-3)" );
+         fprintf( out, "sgx_le_pubkey_hash_info{hash=\"%016" PRIx64 "%016" PRIx64 "%016" PRIx64 "%016" PRIx64 "\"} 1\n"
+                ,hash[3], hash[2], hash[1], hash[0] );
+      }
+
+      if( capture_find_msr( cap, IA32_SGX_SVN_STATUS, &value ) ) {
+         gauge( out, "sgx_svn_status", "IA32_SGX_SVN_STATUS fields" );
+         field_sample( out, "sgx_svn_status", "field", FIELD_SVN_LOCK, cap );
+         field_sample( out, "sgx_svn_status", "field", FIELD_SVN_SINIT, cap );
+      }
+   }
+
+   // XSAVE
+   uint64_t xfrmLo = 0;
+   uint64_t xfrmHi = 0;
+   field_from_capture( &fields[FIELD_XFRM_LO], cap, &xfrmLo );
+   field_from_capture( &fields[FIELD_XFRM_HI], cap, &xfrmHi );
+   uint64_t xfrmAllowed = xfrmHi << 32 | xfrmLo;
+
+   if( cap->has_xcr0 ) {
+      gauge( out, "sgx_xcr0", "XCR0:  The user state components the OS enabled" );
+      fprintf( out, "sgx_xcr0 %" PRIu64 "\n", cap->xcr0 );
+   }
+   if( msrs && capture_find_msr( cap, IA32_XSS, &value ) ) {
+      gauge( out, "sgx_xss", "IA32_XSS:  The supervisor state components the OS enabled" );
+      fprintf( out, "sgx_xss %" PRIu64 "\n", value );
+   }
+
+   gauge( out, "sgx_xsave_component_bytes", "Size of each XSAVE state component (CPUID leaf 0DH)" );
+   for( int i = XSTATE_AVX ; i < XSTATE_COUNT ; i++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( cap, 0x0D, (uint32_t) i );
+      if( r != NULL && r->eax != 0 ) {
+         const char* name = xsave_components[i].name;
+         fprintf( out, "sgx_xsave_component_bytes{component=\"%.*s\"} %" PRIu32 "\n"
+                ,(int) strlen( name ) - 1, name, r->eax );  // Without the trailing ':'
+      }
+   }
+   if( cap->has_xcr0 ) {
+      gauge( out, "sgx_xsave_bytes", "Size of a standard XSAVE area holding the state in XCR0, or in XCR0 & the XFRM SGX allows" );
+      fprintf( out, "sgx_xsave_bytes{state=\"xcr0\"} %" PRIu32 "\n", XSAVE_area_size( cap, cap->xcr0 ) );
+      if( xfrmAllowed != 0 ) {
+         fprintf( out, "sgx_xsave_bytes{state=\"xfrm\"} %" PRIu32 "\n", XSAVE_area_size( cap, cap->xcr0 & xfrmAllowed ) );
+      }
+   }
+
+   gauge( out, "sgx_metrics_probe_seconds", "How long it took " PROGRAM_NAME " to read these values" );
+   fprintf( out, "sgx_metrics_probe_seconds %.6f\n", probeSeconds );
+   fprintf( out, "# EOF\n" );
+}
+
+
+/// Write `size` bytes of `text` to `path` through a temporary file that's
+/// renamed into place.  `-` is stdout.
+///
+/// @return `false` if it couldn't be written
+static bool publish( const char* path, const char* text, size_t size ) {
+   char tempPath[PATH_MAX];
+
+   if( strcmp( path, "-" ) == 0 ) {
+      return fwrite( text, 1, size, stdout ) == size && fflush( stdout ) == 0;
+   }
+
+   snprintf( tempPath, sizeof( tempPath ), "%s.XXXXXX", path );
+   int fd = mkstemp( tempPath );
+   if( fd < 0 ) {
+      fprintf( stderr, PROGRAM_NAME ": Can't create a temporary file next to %s\n", path );
+      return false;
+   }
+
+   // mkstemp() makes the file 0600, but node_exporter usually runs as another user
+   bool ok = fchmod( fd, 0644 ) == 0 && write( fd, text, size ) == (ssize_t) size;
+   ok = close( fd ) == 0 && ok;
+   if( !ok || rename( tempPath, path ) != 0 ) {
+      fprintf( stderr, PROGRAM_NAME ": Can't write %s\n", path );
+      unlink( tempPath );
+      return false;
+   }
+   return true;
+}
+
+
+/// Re-read the registers the OS can change at any time:  XCR0, IA32_XSS and,
+/// when IA32_FEATURE_CONTROL.SGX_LC lets the kernel write them, the launch
+/// enclave public key hash
+static void refresh_volatile( struct sgx_capture* cap, bool msrs ) {
+   if( cap->has_xcr0 ) {
+      cap->xcr0 = native_XGETBV( 0 );
+   }
+   if( msrs ) {
+      uint64_t featureControl = 0;
+      bool lcWritable = capture_find_msr( cap, IA32_FEATURE_CONTROL, &featureControl )
+                     && field_extract( &fields[FIELD_FC_SGX_LC], featureControl ) != 0;
+
+      for( uint32_t i = 0 ; i < cap->msr_count ; i++ ) {
+         uint32_t reg = cap->msr[i].reg;
+         bool isHash = reg >= IA32_SGXLEPUBKEYHASH0 && reg < IA32_SGXLEPUBKEYHASH0 + 4;
+         if( reg == IA32_XSS || ( lcWritable && isHash ) ) {
+            rdmsr( reg, 0, &cap->msr[i].value );
+         }
+      }
+   }
+}
+
+#endif  // __linux__
+
+
+/// `--metrics [--from CAPTURE] [--interval SECONDS] FILE`
+int metrics_main( int argc, char* argv[] ) {
+   const char* fromFile = NULL;
+   const char* path = NULL;
+   double interval = 0;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( strcmp( argv[i], "--interval" ) == 0 && i + 1 < argc ) {
+         interval = strtod( argv[++i], NULL );
+      } else if( path == NULL && (argv[i][0] != '-' || strcmp( argv[i], "-" ) == 0) ) {
+         path = argv[i];
+      } else {
+         path = NULL;
+         break;
+      }
+   }
+   if( path == NULL || interval < 0 || (interval > 0 && fromFile != NULL) ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --metrics [--from CAPTURE] [--interval SECONDS] FILE\n" );
+      fprintf( stderr, "  FILE is usually a .prom file in node_exporter's textfile directory (- for stdout).\n" );
+      fprintf( stderr, "  --interval keeps rewriting it, re-reading only XCR0, IA32_XSS & an unlocked LE hash.  It needs a live node.\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct sgx_capture cap;  // Too big for the stack
+      bool msrs = false;
+
+      double start = now_seconds();
+      if( fromFile != NULL ) {
+         if( !capture_load( fromFile, &cap ) ) {
+            return EXIT_FAILURE;
+         }
+         msrs = cap.msr_count > 0;
+      } else {
+         msrs = cache_probe( &cap, true );
+      }
+      double probeSeconds = now_seconds() - start;
+
+      if( interval > 0 ) {
+         struct sigaction action = { 0 };
+         action.sa_handler = stop;  // No SA_RESTART, so the sleep is interrupted
+         sigaction( SIGTERM, &action, NULL );
+         sigaction( SIGINT,  &action, NULL );
+      }
+
+      struct timespec next;
+      clock_gettime( CLOCK_MONOTONIC, &next );
+      for( ;; ) {
+         char*  text = NULL;
+         size_t size = 0;
+         FILE*  memory = open_memstream( &text, &size );
+         if( memory == NULL ) {
+            return EXIT_FAILURE;
+         }
+         write_metrics( memory, &cap, msrs, probeSeconds );
+         fclose( memory );
+         bool ok = publish( path, text, size );
+         free( text );
+
+         if( !ok ) {
+            return EXIT_FAILURE;
+         }
+         if( interval <= 0 || stopping ) {
+            return EXIT_SUCCESS;
+         }
+
+         long nanoseconds = (long) (interval * 1e9);
+         next.tv_sec  += nanoseconds / 1000000000;
+         next.tv_nsec += nanoseconds % 1000000000;
+         if( next.tv_nsec >= 1000000000 ) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+         }
+         clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+         if( stopping ) {
+            return EXIT_SUCCESS;
+         }
+
+         start = now_seconds();
+         refresh_volatile( &cap, msrs );
+         probeSeconds = now_seconds() - start;
+      }
+   #else
+      (void) fromFile;
+      printf( "The metrics exporter needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  metrics.h - 2026
+//
+/// This module exports this node's SGX state as OpenMetrics gauges for
+/// node_exporter's textfile collector.
+///
+/// @file   metrics.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--metrics [--from CAPTURE] [--interval SECONDS] FILE`
+int metrics_main( int argc, char* argv[] );
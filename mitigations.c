@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////
+//  mitigations.c - 2026
+//
+/// This module reports the speculative-execution mitigations that slow
+/// enclave transitions, and measures what the host's kernel paths cost.
+///
+/// Every ocall leaves the enclave (EEXIT), makes a system call and comes back
+/// (EENTER).  Every interrupt or fault inside an enclave is an AEX, a trip
+/// through the kernel and an ERESUME.  The mitigations on those paths add up:
+///
+///   - The kernel's, listed in `/sys/devices/system/cpu/vulnerabilities`:
+///     page table isolation (a CR3 switch on every entry), IBRS/retpolines &
+///     return thunks, and a VERW buffer clear on every return to user space.
+///   - The SGX microcode's:  On parts affected by L1TF or MDS, every enclave
+///     exit (EEXIT or AEX) flushes the L1D and clears the CPU buffers, however
+///     the kernel is configured.  That's what the CPU SVN in an attestation
+///     vouches for, and why a microcode update can change it (see EUPDATESVN).
+///
+/// The report shows what the CPU enumerates (CPUID.7:EDX, IA32_ARCH_CAPABILITIES
+/// and the SGX SVN status), what the kernel says it's doing, and times the
+/// host paths an enclave transition rides on:
+///
+///   - A system call (getppid):  The kernel half of an ocall
+///   - A minor page fault:  The kernel half of an AEX for a fault
+///   - A signal to a handler and back:  How an SGX runtime sees an exception
+///     inside an enclave
+///   - VERW:  The buffer clear that MD_CLEAR microcode adds to VERW, timed on
+///     its own.  The kernel pays it on every return to user space when MDS,
+///     TAA, MMIO stale data or RFDS are mitigated with it, and SGX microcode
+///     pays it on every enclave exit.
+///
+/// The SGX paths themselves can't be timed without an enclave, so the numbers
+/// are a floor:  Add EEXIT/EENTER (or AEX/ERESUME) and the microcode flushes.
+///
+/// Usage:
+///
+///     test-sgx --mitigations
+///     test-sgx --mitigations --iterations 1000000
+///
+/// @file   mitigations.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `syscall()` and `MAP_ANONYMOUS`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For atol() qsort()
+#include <string.h>    // For strcmp() strncmp() strlen() strcspn() memcpy()
+#include <inttypes.h>  // For PRIx64 uint64_t uint32_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime()
+
+#ifdef __linux__
+   #include <dirent.h>         // For opendir() readdir() closedir()
+   #include <signal.h>         // For sigaction() raise()
+   #include <unistd.h>         // For syscall() sysconf() access()
+   #include <sys/mman.h>       // For mmap() madvise() munmap()
+   #include <sys/syscall.h>    // For SYS_getppid
+#endif
+
+#include "mitigations.h"  // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs() field_extract()
+#include "rdmsr.h"     // For rdmsr() IA32_ARCH_CAPABILITIES IA32_SGX_SVN_STATUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// Round trips per measurement, unless `--iterations` says otherwise
+#define DEFAULT_ITERATIONS 100000
+
+/// Each measurement is the best of this many batches
+#define BATCHES 5
+
+/// Pages to fault in each batch
+#define FAULT_PAGES 4096
+
+/// The most vulnerabilities we'll list
+#define MAX_VULNERABILITIES 64
+
+/// Where the kernel reports its mitigations
+#define VULNERABILITIES_DIR "/sys/devices/system/cpu/vulnerabilities"
+
+
+/// What each vulnerability's mitigation does to an enclave transition
+static const struct {
+   const char* name;
+   const char* effect;
+} effects[] = {
+   { "meltdown",                  "Page table isolation:  A CR3 switch on every syscall, fault & interrupt" },
+   { "l1tf",                      "SGX microcode flushes the L1D on every enclave exit" },
+   { "mds",                       "VERW on every return to user; SGX microcode clears buffers on every exit" },
+   { "tsx_async_abort",           "VERW on every return to user (or TSX disabled)" },
+   { "mmio_stale_data",           "VERW on every return to user" },
+   { "reg_file_data_sampling",    "VERW on every return to user" },
+   { "tsa",                       "VERW on every return to user" },
+   { "spectre_v2",                "IBRS, retpolines or BHI clearing on every kernel entry" },
+   { "retbleed",                  "Return thunks or IBRS on every kernel entry" },
+   { "spec_rstack_overflow",      "Safe RET on every kernel entry" },
+   { "indirect_target_selection", "Indirect branch thunks in the kernel" },
+   { "srbds",                     "RDRAND & RDSEED are much slower -- including inside enclaves" },
+   { "gather_data_sampling",      "AVX gathers are slower -- including inside enclaves" },
+   { "old_microcode",             "Update the microcode -- attestations will report the old CPU SVN too" },
+   { "spec_store_bypass",         "Only for processes that ask (prctl/seccomp)" },
+   { "spectre_v1",                "Little:  Barriers on user pointers" },
+   { "itlb_multihit",             "Only for virtual machines" },
+   { "vmscape",                   "Only for virtual machines" },
+};
+
+
+#ifdef __linux__
+
+/// @return What `name`'s mitigation does to an enclave transition, or `""`
+static const char* effect_of( const char* name ) {
+   for( size_t i = 0 ; i < sizeof( effects ) / sizeof( effects[0] ) ; i++ ) {
+      if( strcmp( effects[i].name, name ) == 0 ) {
+         return effects[i].effect;
+      }
+   }
+   return "";
+}
+
+
+static int compare_names( const void* left, const void* right ) {
+   return strcmp( (const char*) left, (const char*) right );
+}
+
+
+/// Print every file in `/sys/devices/system/cpu/vulnerabilities`, and what
+/// the active mitigations do to enclave transitions
+///
+/// @return The number of vulnerabilities being mitigated
+static int print_vulnerabilities( void ) {
+   static char names[MAX_VULNERABILITIES][64];
+   int count = 0;
+   int mitigated = 0;
+
+   DIR* dir = opendir( VULNERABILITIES_DIR );
+   if( dir == NULL ) {
+      printf( "  The kernel doesn't report its mitigations (no %s)\n", VULNERABILITIES_DIR );
+      return 0;
+   }
+   struct dirent* entry;
+   while( (entry = readdir( dir )) != NULL && count < MAX_VULNERABILITIES ) {
+      if( entry->d_name[0] != '.' && strlen( entry->d_name ) < sizeof( names[0] ) ) {
+         memcpy( names[count++], entry->d_name, strlen( entry->d_name ) + 1 );
+      }
+   }
+   closedir( dir );
+   qsort( names, (size_t) count, sizeof( names[0] ), compare_names );
+
+   printf( "  The kernel (%s):\n", VULNERABILITIES_DIR );
+   for( int i = 0 ; i < count ; i++ ) {
+      char path[256];
+      char status[512] = "";
+
+      if( snprintf( path, sizeof( path ), VULNERABILITIES_DIR "/%s", names[i] ) >= (int) sizeof( path ) ) {
+         continue;
+      }
+      FILE* file = fopen( path, "r" );
+      if( file != NULL ) {
+         if( fgets( status, sizeof( status ), file ) == NULL ) {
+            status[0] = '\0';
+         }
+         fclose( file );
+      }
+      status[strcspn( status, "\n" )] = '\0';
+
+      printf( "    %-26s %s\n", names[i], status );
+      bool notAffected = strncmp( status, "Not affected", 12 ) == 0;
+      if( !notAffected && effect_of( names[i] )[0] != '\0' ) {
+         printf( "    %-26s   -> %s\n", "", effect_of( names[i] ) );
+      }
+      mitigated += strncmp( status, "Mitigation", 10 ) == 0 ? 1 : 0;
+   }
+   return mitigated;
+}
+
+
+/// Print every GROUP_MITIGATION field from CPUID.(EAX=leaf, ECX=subleaf)
+static void print_cpuid_mitigations( uint32_t leaf, uint32_t subleaf ) {
+   uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   if( eax < leaf ) {
+      return;
+   }
+   eax = leaf; ebx = 0; ecx = subleaf; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+      const struct field_desc* f = &fields[i];
+      if( f->group == GROUP_MITIGATION && f->source != SRC_MSR && f->leaf == leaf && f->subleaf == subleaf ) {
+         printf( "    %-18s %d  %s\n", f->name, (int) field_from_regs( f, eax, ebx, ecx, edx ), f->description );
+      }
+   }
+}
+
+
+/// Print every GROUP_MITIGATION field from the MSR `reg` (if it's readable)
+static void print_msr_mitigations( uint32_t reg, const char* name ) {
+   uint64_t value;
+
+   if( access( "/dev/cpu/0/msr", R_OK ) != 0 || !rdmsr( reg, 0, &value ) ) {
+      printf( "  %s isn't readable (it needs root and the msr module)\n", name );
+      return;
+   }
+   printf( "  %s:  %016" PRIx64 "\n", name, value );
+   for( int i = 0 ; i < FIELD_COUNT ; i++ ) {
+      const struct field_desc* f = &fields[i];
+      if( f->group == GROUP_MITIGATION && f->source == SRC_MSR && f->leaf == reg ) {
+         printf( "    %-18s %d  %s\n", f->name, (int) field_extract( f, value ), f->description );
+      }
+   }
+}
+
+
+/// @return The time in seconds from a monotonic clock
+static double now_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+static volatile sig_atomic_t signalsCaught = 0;
+
+/// The signal round trip's handler
+static void count_signal( int signal ) {
+   (void) signal;
+   signalsCaught++;
+}
+
+
+/// The round trips to time
+enum path { PATH_SYSCALL, PATH_FAULT, PATH_SIGNAL, PATH_VERW, PATH_COUNT };
+
+/// What each path stands in for
+static const struct {
+   const char* name;
+   const char* proxy;
+} paths[PATH_COUNT] = {
+   [PATH_SYSCALL] = { "syscall (getppid)",   "The kernel half of an ocall" },
+   [PATH_FAULT]   = { "minor page fault",    "The kernel half of an AEX for a page fault" },
+   [PATH_SIGNAL]  = { "signal to handler",   "An exception inside an enclave, as the runtime sees it" },
+   [PATH_VERW]    = { "VERW buffer clear",   "Paid on each return to user (and each enclave exit)" },
+};
+
+
+/// Run `path` `iterations` times (or fault `FAULT_PAGES` pages)
+///
+/// @return The time for one, in ns, or `0` if it couldn't be run
+static double time_path( enum path path, long iterations ) {
+   double start = 0;
+   long count = iterations;
+
+   switch( path ) {
+      case PATH_SYSCALL:
+         start = now_seconds();
+         for( long i = 0 ; i < iterations ; i++ ) {
+            syscall( SYS_getppid );
+         }
+         break;
+
+      case PATH_FAULT: {
+         long pageSize = sysconf( _SC_PAGESIZE );
+         size_t size = (size_t) FAULT_PAGES * (size_t) pageSize;
+         char* pages = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+         if( pages == MAP_FAILED ) {
+            return 0;
+         }
+         madvise( pages, size, MADV_NOHUGEPAGE );  // One fault per 4 KiB page, like EPC
+         count = FAULT_PAGES;
+         start = now_seconds();
+         for( long i = 0 ; i < FAULT_PAGES ; i++ ) {
+            ((volatile char*) pages)[i * pageSize] = 1;
+         }
+         double ns = (now_seconds() - start) * 1e9 / (double) count;
+         munmap( pages, size );
+         return ns;
+      }
+
+      case PATH_SIGNAL:
+         start = now_seconds();
+         for( long i = 0 ; i < iterations ; i++ ) {
+            raise( SIGUSR1 );
+         }
+         break;
+
+      case PATH_VERW: {
+         // VERW clears the buffers only in its memory-operand form, with a
+         // writable data segment:  SS is one (and user code may run VERW)
+         uint16_t selector;
+         __asm__ volatile ( "mov %0, ss" : "=r" (selector) );
+         start = now_seconds();
+         for( long i = 0 ; i < iterations ; i++ ) {
+            __asm__ volatile ( "verw %0" :: "m" (selector) : "cc", "memory" );
+         }
+         break;
+      }
+
+      default:
+         return 0;
+   }
+   return (now_seconds() - start) * 1e9 / (double) count;
+}
+
+#endif
+
+
+/// `--mitigations [--iterations N]`
+int mitigations_main( int argc, char* argv[] ) {
+   long iterations = DEFAULT_ITERATIONS;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--iterations" ) == 0 && i + 1 < argc ) {
+         iterations = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --mitigations [--iterations N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( iterations <= 0 ) {
+      fprintf( stderr, "mitigations: The number of iterations must be positive\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+      printf( "Mitigations on the enclave transition paths\n" );
+
+      printf( "  The CPU (CPUID.7:EDX):\n" );
+      print_cpuid_mitigations( 0x07, 0 );
+      print_cpuid_mitigations( 0x07, 2 );
+      print_msr_mitigations( IA32_ARCH_CAPABILITIES, "IA32_ARCH_CAPABILITIES" );
+
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      if( eax >= 0x12 ) {
+         eax = 0x12; ebx = 0; ecx = 0; edx = 0;
+         native_cpuid32( &eax, &ebx, &ecx, &edx );
+         printf( "  SGX:  EUPDATESVN %d (%s)\n", (int) field_from_regs( &fields[FIELD_EUPDATESVN], eax, ebx, ecx, edx )
+                ,field_from_regs( &fields[FIELD_EUPDATESVN], eax, ebx, ecx, edx ) ? "a microcode update can raise the CPU SVN without a reboot" : "a microcode update raises the CPU SVN at the next reboot" );
+      }
+      print_msr_mitigations( IA32_SGX_SVN_STATUS, "IA32_SGX_SVN_STATUS" );
+
+      int mitigated = print_vulnerabilities();
+
+      struct sigaction action = { 0 };
+      action.sa_handler = count_signal;
+      sigemptyset( &action.sa_mask );
+      sigaction( SIGUSR1, &action, NULL );
+
+      printf( "  Host round trips (the best of %d batches of %ld):\n", BATCHES, iterations );
+      printf( "    Path                       ns  Stands in for\n" );
+      printf( "    ===================  ========  ===========================================\n" );
+      double ns[PATH_COUNT] = { 0 };
+      for( int p = 0 ; p < PATH_COUNT ; p++ ) {
+         for( int b = 0 ; b < BATCHES ; b++ ) {
+            double t = time_path( (enum path) p, iterations );
+            ns[p] = t > 0 && (ns[p] == 0 || t < ns[p]) ? t : ns[p];
+         }
+         printf( "    %-19s  %8.0f  %s\n", paths[p].name, ns[p], paths[p].proxy );
+      }
+      signal( SIGUSR1, SIG_DFL );
+
+      printf( "  %d vulnerabilit%s mitigated by the kernel.", mitigated, mitigated == 1 ? "y is" : "ies are" );
+      if( ns[PATH_SYSCALL] > 0 && ns[PATH_VERW] > 0 ) {
+         printf( "  A VERW is %.0f%% of a syscall round trip.", ns[PATH_VERW] / ns[PATH_SYSCALL] * 100 );
+      }
+      printf( "\n" );
+      printf( "  Inside an enclave, add EEXIT & EENTER (or AEX & ERESUME) to each path, and\n" );
+      printf( "  the L1D flush & buffer clear the SGX microcode does on every enclave exit.\n" );
+      return EXIT_SUCCESS;
+
+   #else
+      printf( "The mitigation report needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  mitigations.h - 2026
+//
+/// This module reports the speculative-execution mitigations that slow
+/// enclave transitions, and measures what the host's kernel paths cost.
+///
+/// @file   mitigations.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--mitigations [--iterations N]`
+int mitigations_main( int argc, char* argv[] );
@@ -0,0 +1,629 @@
+///////////////////////////////////////////////////////////////////////////////
+//  placement.c - 2026
+//
+/// This module recommends which CPUs should run enclave threads, switchless
+/// workers and housekeeping.
+///
+/// An enclave's tail latency is mostly placement:  Every interrupt, timer
+/// tick or RCU callback on its CPU is an AEX, a thread that migrates to
+/// another socket leaves its EPC behind, and an SMT sibling running
+/// something else shares the enclave's L1D (L1TF & MDS).  So this reads:
+///
+///   - `isolcpus`, `nohz_full` & `rcu_nocbs` from sysfs
+///     (`/sys/devices/system/cpu/isolated` & `nohz_full`) and `/proc/cmdline`
+///   - The cpuset of our cgroup (`cpuset.cpus.effective`) and our affinity
+///   - Which CPUs each device IRQ can land on (`/proc/irq/N/
+///     effective_affinity_list`)
+///   - Whether each CPU has SGX:  CPUID.(EAX=07H):EBX.SGX on that CPU, and
+///     IA32_FEATURE_CONTROL through `rdmsr( reg, cpu, ... )` when it's
+///     readable.  CPUs are numbered the way Linux numbers them, the same as
+///     /dev/cpu/N/msr.
+///
+/// Then it picks the package with the most usable cores (each package has
+/// its own EPC section) and splits its cores:
+///
+///   - Enclave threads:  The quietest cores -- isolated, `nohz_full`, with
+///     the fewest device IRQs.  One logical CPU per core; the SMT siblings
+///     are left idle.
+///   - Switchless workers:  Untrusted threads that poll for ocalls.  They
+///     don't AEX, so they get the noisier cores, but on the same package to
+///     share the L3 with the enclave threads.
+///   - Housekeeping:  Everything else -- IRQs, kernel threads & the rest of
+///     the system.  CPU 0 and the cores with the most IRQs go here first.
+///
+/// With nothing isolated yet, it reserves about one core in 8 for
+/// housekeeping and suggests the kernel command line that would isolate the
+/// rest.
+///
+/// Usage:
+///
+///     test-sgx --placement
+///     test-sgx --placement --threads 8 --workers 2
+///
+/// @file   placement.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sched_setaffinity()` and `CPU_SET()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fopen() fgets() snprintf()
+#include <stdlib.h>    // For atol() strtol() qsort()
+#include <string.h>    // For strcmp() strncmp() strlen() strcspn() strchr() strstr() memset() memcpy()
+#include <inttypes.h>  // For uint64_t
+#include <stdbool.h>   // For bool
+#include <ctype.h>     // For isalpha() isdigit()
+
+#ifdef __linux__
+   #include <sched.h>          // For sched_setaffinity() sched_getaffinity() cpu_set_t
+   #include <unistd.h>         // For access()
+   #include <dirent.h>         // For opendir() readdir() closedir()
+#endif
+
+#include "placement.h" // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "rdmsr.h"     // For rdmsr() IA32_FEATURE_CONTROL
+#include "decode.h"    // For fields[] field_from_regs() field_extract()
+#include "topology.h"  // For topology_parse_cpulist() topology_format_cpulist() topology_online_cpus() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The most NUMA nodes we look for
+#define MAX_NODES 64
+
+/// With nothing isolated, reserve one core in this many for housekeeping
+#define HOUSEKEEPING_SHARE 8
+
+/// By default, one core in this many runs switchless workers
+#define WORKER_SHARE 4
+
+
+/// Whether a CPU can run enclaves
+enum sgx_state {
+   SGX_NO,        ///< CPUID doesn't report SGX
+   SGX_OFF,       ///< IA32_FEATURE_CONTROL hasn't enabled (and locked) it
+   SGX_CPUID,     ///< CPUID reports SGX, but we can't read IA32_FEATURE_CONTROL
+   SGX_ON         ///< CPUID reports it and IA32_FEATURE_CONTROL enables it
+};
+
+static const char* sgxNames[] = { "no", "off", "cpuid", "yes" };
+
+
+/// What we recommend a CPU does
+enum role {
+   ROLE_OUTSIDE,       ///< Not in our cpuset
+   ROLE_HOUSEKEEPING,
+   ROLE_ENCLAVE,
+   ROLE_SIBLING,       ///< The idle SMT sibling of an enclave thread
+   ROLE_WORKER,        ///< A switchless worker
+   ROLE_COUNT
+};
+
+static const char* roleNames[ROLE_COUNT] = { "outside cpuset", "housekeeping", "enclave", "idle sibling", "switchless" };
+
+
+/// One online CPU
+struct cpu_place {
+   int            cpu;
+   int            package;
+   int            node;
+   int            core;       ///< The lowest-numbered SMT sibling
+   enum sgx_state sgx;
+   bool           allowed;    ///< In our cpuset & affinity
+   bool           isolated;
+   bool           nohz;
+   bool           nocb;       ///< rcu_nocbs
+   int            irqs;       ///< Device IRQs that can land on it
+   enum role      role;
+};
+
+
+/// One core (a set of SMT siblings)
+struct core_place {
+   int  core;       ///< The lowest-numbered SMT sibling
+   int  package;
+   int  irqs;       ///< On all of its siblings
+   bool quiet;      ///< All of its siblings are isolated or nohz_full
+   bool usable;     ///< All of its siblings are allowed & have SGX
+   bool hasCPU0;
+   enum role role;
+};
+
+
+#ifdef __linux__
+
+/// Pin the calling thread to `cpu`
+///
+/// @return `false` if it couldn't be pinned
+static bool pin_to( int cpu ) {
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   return sched_setaffinity( 0, sizeof( set ), &set ) == 0;
+}
+
+
+/// Read a CPU list from a file
+///
+/// @return The number of CPUs in `cpus`, or `-1` if it isn't there (or isn't
+///         a CPU list -- `nohz_full` says `(null)`)
+static int read_list( const char* path, int* cpus ) {
+   char line[4096];
+   int  count = -1;
+
+   FILE* file = fopen( path, "r" );
+   if( file != NULL ) {
+      if( fgets( line, sizeof( line ), file ) != NULL ) {
+         count = line[0] == '\n' ? 0 : topology_parse_cpulist( line, cpus, MAX_CPUS );
+      }
+      fclose( file );
+   }
+   return count;
+}
+
+
+/// Find `key=` on the kernel command line
+///
+/// @return `false` if it isn't there
+static bool read_cmdline( const char* key, char* value, size_t size ) {
+   char line[4096];
+   bool found = false;
+   size_t keyLength = strlen( key );
+
+   value[0] = '\0';
+   FILE* file = fopen( "/proc/cmdline", "r" );
+   if( file == NULL ) {
+      return false;
+   }
+   if( fgets( line, sizeof( line ), file ) != NULL ) {
+      for( char* p = line ; *p != '\0' ; ) {
+         size_t length = strcspn( p, " \n" );
+         if( length > keyLength && strncmp( p, key, keyLength ) == 0 && p[keyLength] == '=' ) {
+            size_t valueLength = length - keyLength - 1 < size - 1 ? length - keyLength - 1 : size - 1;
+            memcpy( value, p + keyLength + 1, valueLength );
+            value[valueLength] = '\0';
+            found = true;
+         }
+         p += length;
+         p += *p != '\0' ? 1 : 0;
+      }
+   }
+   fclose( file );
+   return found;
+}
+
+
+/// Mark the CPUs in a kernel parameter.  `isolcpus` & `nohz_full` come from
+/// sysfs when it has them; otherwise (and for `rcu_nocbs`) the command line.
+///
+/// `value` gets the parameter from the command line, or `""`.
+static void read_parameter( const char* key, const char* sysfs, struct cpu_place* places, int count, bool* (*flag)( struct cpu_place* ), char* value, size_t size ) {
+   static int cpus[MAX_CPUS];
+   int found = sysfs != NULL ? read_list( sysfs, cpus ) : -1;
+
+   if( read_cmdline( key, value, size ) && found < 0 ) {
+      const char* list = value;
+      while( isalpha( (unsigned char) *list ) ) {  // Skip isolcpus' flags like `managed_irq,domain,`
+         list += strcspn( list, "," );
+         list += *list == ',' ? 1 : 0;
+      }
+      found = strcmp( list, "all" ) == 0 ? MAX_CPUS : topology_parse_cpulist( list, cpus, MAX_CPUS );
+      if( found == MAX_CPUS ) {
+         for( int i = 0 ; i < count ; i++ ) {
+            cpus[i] = places[i].cpu;
+         }
+         found = count;
+      }
+   }
+   for( int i = 0 ; i < found ; i++ ) {
+      for( int p = 0 ; p < count ; p++ ) {
+         *flag( &places[p] ) = *flag( &places[p] ) || places[p].cpu == cpus[i];
+      }
+   }
+}
+
+static bool* isolated_flag( struct cpu_place* place ) { return &place->isolated; }
+static bool* nohz_flag( struct cpu_place* place )     { return &place->nohz; }
+static bool* nocb_flag( struct cpu_place* place )     { return &place->nocb; }
+
+
+/// Read our cgroup's cpuset (cgroup v2, then v1)
+///
+/// @return The number of CPUs in `cpus`, or `-1` if there's no cpuset
+static int read_cpuset( int* cpus, char* path, size_t size ) {
+   char line[1024];
+   int count = -1;
+
+   FILE* file = fopen( "/proc/self/cgroup", "r" );
+   if( file == NULL ) {
+      return -1;
+   }
+   while( count < 0 && fgets( line, sizeof( line ), file ) != NULL ) {
+      line[strcspn( line, "\n" )] = '\0';
+      char* cgroup = strchr( line, ':' ) != NULL ? strchr( strchr( line, ':' ) + 1, ':' ) : NULL;
+      if( cgroup == NULL ) {
+         continue;
+      }
+      if( strncmp( line, "0::", 3 ) == 0 ) {
+         snprintf( path, size, "/sys/fs/cgroup%s/cpuset.cpus.effective", strcmp( cgroup + 1, "/" ) == 0 ? "" : cgroup + 1 );
+         count = read_list( path, cpus );
+      } else if( strstr( line, ":cpuset:" ) != NULL ) {
+         snprintf( path, size, "/sys/fs/cgroup/cpuset%s/cpuset.effective_cpus", strcmp( cgroup + 1, "/" ) == 0 ? "" : cgroup + 1 );
+         count = read_list( path, cpus );
+      }
+   }
+   fclose( file );
+   return count;
+}
+
+
+/// Count the device IRQs that can land on each CPU.  IRQs without a handler
+/// (a subdirectory in `/proc/irq/N`) aren't devices.
+static void read_irqs( struct cpu_place* places, int count ) {
+   static int cpus[MAX_CPUS];
+   char path[300];
+
+   DIR* dir = opendir( "/proc/irq" );
+   if( dir == NULL ) {
+      return;
+   }
+   struct dirent* entry;
+   while( (entry = readdir( dir )) != NULL ) {
+      if( !isdigit( (unsigned char) entry->d_name[0] ) ) {
+         continue;
+      }
+      snprintf( path, sizeof( path ), "/proc/irq/%s", entry->d_name );
+      DIR* irq = opendir( path );
+      bool hasHandler = false;
+      struct dirent* handler;
+      while( irq != NULL && (handler = readdir( irq )) != NULL ) {
+         hasHandler = hasHandler || (handler->d_type == DT_DIR && handler->d_name[0] != '.');
+      }
+      if( irq != NULL ) {
+         closedir( irq );
+      }
+      if( !hasHandler ) {
+         continue;
+      }
+
+      snprintf( path, sizeof( path ), "/proc/irq/%s/effective_affinity_list", entry->d_name );
+      int cpuCount = read_list( path, cpus );
+      if( cpuCount < 0 ) {
+         snprintf( path, sizeof( path ), "/proc/irq/%s/smp_affinity_list", entry->d_name );
+         cpuCount = read_list( path, cpus );
+      }
+      for( int i = 0 ; i < cpuCount ; i++ ) {
+         for( int p = 0 ; p < count ; p++ ) {
+            places[p].irqs += places[p].cpu == cpus[i] ? 1 : 0;
+         }
+      }
+   }
+   closedir( dir );
+}
+
+
+/// Read where a CPU sits and whether it has SGX.  This pins the calling
+/// thread to it to run CPUID there.
+static void read_cpu( struct cpu_place* place, const int* nodeOf, bool msrReadable ) {
+   static int siblings[MAX_CPUS];
+   char path[128];
+   uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+   place->package = topology_package_of( place->cpu );
+   place->node = place->cpu < MAX_CPUS ? nodeOf[place->cpu] : -1;
+   snprintf( path, sizeof( path ), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", place->cpu );
+   place->core = read_list( path, siblings ) > 0 ? siblings[0] : place->cpu;
+
+   place->sgx = SGX_NO;
+   if( !pin_to( place->cpu ) ) {
+      return;
+   }
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   if( eax >= 0x07 ) {
+      eax = 0x07; ebx = 0; ecx = 0; edx = 0;
+      native_cpuid32( &eax, &ebx, &ecx, &edx );
+      place->sgx = field_from_regs( &fields[FIELD_SGX], eax, ebx, ecx, edx ) ? SGX_CPUID : SGX_NO;
+   }
+
+   uint64_t featureControl = 0;
+   if( place->sgx == SGX_CPUID && msrReadable && rdmsr( IA32_FEATURE_CONTROL, place->cpu, &featureControl ) ) {
+      bool enabled = field_extract( &fields[FIELD_FC_SGX_ENABLE], featureControl ) && field_extract( &fields[FIELD_FC_LOCK], featureControl );
+      place->sgx = enabled ? SGX_ON : SGX_OFF;
+   }
+}
+
+
+/// Find the NUMA node of every CPU (`nodeOf` is indexed by CPU number)
+static void read_nodes( int* nodeOf ) {
+   static int cpus[MAX_CPUS];
+   char path[128];
+
+   for( int cpu = 0 ; cpu < MAX_CPUS ; cpu++ ) {
+      nodeOf[cpu] = -1;
+   }
+   for( int node = 0 ; node < MAX_NODES ; node++ ) {
+      snprintf( path, sizeof( path ), "/sys/devices/system/node/node%d/cpulist", node );
+      int count = read_list( path, cpus );
+      for( int i = 0 ; i < count ; i++ ) {
+         if( cpus[i] < MAX_CPUS ) {
+            nodeOf[cpus[i]] = node;
+         }
+      }
+   }
+}
+
+
+/// Sort cores quietest first:  Isolated, then the fewest IRQs, then by number
+static int compare_quiet( const void* left, const void* right ) {
+   const struct core_place* l = *(const struct core_place* const*) left;
+   const struct core_place* r = *(const struct core_place* const*) right;
+
+   if( l->quiet != r->quiet ) {
+      return l->quiet ? -1 : 1;
+   }
+   if( l->irqs != r->irqs ) {
+      return l->irqs - r->irqs;
+   }
+   return l->core - r->core;
+}
+
+
+/// Sort cores for housekeeping:  CPU 0's core, then the most IRQs
+static int compare_noisy( const void* left, const void* right ) {
+   const struct core_place* l = *(const struct core_place* const*) left;
+   const struct core_place* r = *(const struct core_place* const*) right;
+
+   if( l->hasCPU0 != r->hasCPU0 ) {
+      return l->hasCPU0 ? -1 : 1;
+   }
+   if( l->irqs != r->irqs ) {
+      return r->irqs - l->irqs;
+   }
+   return l->core - r->core;
+}
+
+
+/// Group the CPUs into cores.  With `requireSGX`, a core is only usable if
+/// all of its siblings have SGX.
+///
+/// @return The number of cores
+static int find_cores( const struct cpu_place* places, int count, struct core_place* cores, bool requireSGX ) {
+   int coreCount = 0;
+
+   for( int p = 0 ; p < count ; p++ ) {
+      int c = 0;
+      while( c < coreCount && cores[c].core != places[p].core ) {
+         c++;
+      }
+      if( c == coreCount ) {
+         memset( &cores[c], 0, sizeof( cores[c] ) );
+         cores[c].core = places[p].core;
+         cores[c].package = places[p].package;
+         cores[c].quiet = true;
+         cores[c].usable = true;
+         coreCount++;
+      }
+      cores[c].irqs += places[p].irqs;
+      cores[c].quiet = cores[c].quiet && (places[p].isolated || places[p].nohz);
+      cores[c].usable = cores[c].usable && places[p].allowed && (!requireSGX || places[p].sgx == SGX_ON || places[p].sgx == SGX_CPUID);
+      cores[c].hasCPU0 = cores[c].hasCPU0 || places[p].cpu == 0;
+   }
+   return coreCount;
+}
+
+
+/// Print the CPUs that have `role` as a CPU list
+static void print_role( const struct cpu_place* places, int count, enum role role, const char* label, const char* hint ) {
+   static int cpus[MAX_CPUS];
+   char list[1024];
+   int cpuCount = 0;
+
+   for( int p = 0 ; p < count ; p++ ) {
+      if( places[p].role == role ) {
+         cpus[cpuCount++] = places[p].cpu;
+      }
+   }
+   printf( "  %-20s %-16s %s\n", label, topology_format_cpulist( cpus, cpuCount, list, sizeof( list ) ), hint );
+}
+
+#endif  // __linux__
+
+
+/// `--placement [--threads N] [--workers N]`
+int placement_main( int argc, char* argv[] ) {
+   long threads = -1;
+   long workers = -1;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc ) {
+         threads = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--workers" ) == 0 && i + 1 < argc ) {
+         workers = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --placement [--threads N] [--workers N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( threads == 0 || threads < -1 || workers < -1 ) {
+      fprintf( stderr, "placement: The threads must be positive and the workers can't be negative\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static struct cpu_place places[MAX_CPUS];
+      static struct core_place cores[MAX_CPUS];
+      static struct core_place* pool[MAX_CPUS];
+      static int online[MAX_CPUS];
+      static int cpuset[MAX_CPUS];
+      static int nodeOf[MAX_CPUS];
+      char cpusetPath[1200];
+      char list[1024];
+
+      int count = topology_online_cpus( online, MAX_CPUS );
+      int cpusetCount = read_cpuset( cpuset, cpusetPath, sizeof( cpusetPath ) );
+      bool msrReadable = access( "/dev/cpu/0/msr", R_OK ) == 0;
+      cpu_set_t affinity;
+      CPU_ZERO( &affinity );
+      if( sched_getaffinity( 0, sizeof( affinity ), &affinity ) != 0 ) {
+         CPU_SET( 0, &affinity );
+      }
+
+      read_nodes( nodeOf );
+      for( int p = 0 ; p < count ; p++ ) {
+         memset( &places[p], 0, sizeof( places[p] ) );
+         places[p].cpu = online[p];
+         places[p].allowed = online[p] < CPU_SETSIZE && CPU_ISSET( online[p], &affinity );
+         if( cpusetCount >= 0 ) {
+            bool inCpuset = false;
+            for( int c = 0 ; c < cpusetCount ; c++ ) {
+               inCpuset = inCpuset || cpuset[c] == online[p];
+            }
+            places[p].allowed = places[p].allowed && inCpuset;
+         }
+         read_cpu( &places[p], nodeOf, msrReadable );
+      }
+      sched_setaffinity( 0, sizeof( affinity ), &affinity );  // Undo read_cpu()'s pinning
+
+      char isolcpus[1024];
+      char nohz[1024];
+      char nocbs[1024];
+      read_parameter( "isolcpus",  "/sys/devices/system/cpu/isolated",  places, count, isolated_flag, isolcpus, sizeof( isolcpus ) );
+      read_parameter( "nohz_full", "/sys/devices/system/cpu/nohz_full", places, count, nohz_flag,     nohz,     sizeof( nohz ) );
+      read_parameter( "rcu_nocbs", NULL,                                places, count, nocb_flag,     nocbs,    sizeof( nocbs ) );
+      read_irqs( places, count );
+
+      bool anySGX = false;
+      for( int p = 0 ; p < count ; p++ ) {
+         anySGX = anySGX || places[p].sgx == SGX_ON || places[p].sgx == SGX_CPUID;
+      }
+
+      printf( "CPU placement for enclaves\n" );
+      printf( "  Kernel command line:  isolcpus=%s  nohz_full=%s  rcu_nocbs=%s\n"
+             ,isolcpus[0] != '\0' ? isolcpus : "-", nohz[0] != '\0' ? nohz : "-", nocbs[0] != '\0' ? nocbs : "-" );
+      if( cpusetCount >= 0 ) {
+         printf( "  Cpuset:  %s (%s)\n", topology_format_cpulist( cpuset, cpusetCount, list, sizeof( list ) ), cpusetPath );
+      } else {
+         printf( "  Cpuset:  None found (using this process' affinity)\n" );
+      }
+      if( !msrReadable ) {
+         printf( "  IA32_FEATURE_CONTROL isn't readable (run as root with the msr module), so SGX is from CPUID only\n" );
+      }
+
+      // Split the cores
+      int coreCount = find_cores( places, count, cores, anySGX );
+      bool anyQuiet = false;
+      for( int c = 0 ; c < coreCount ; c++ ) {
+         anyQuiet = anyQuiet || (cores[c].usable && cores[c].quiet);
+         cores[c].role = ROLE_HOUSEKEEPING;
+      }
+      int package = -1;
+      int best = 0;
+      for( int c = 0 ; c < coreCount ; c++ ) {
+         int inPackage = 0;
+         for( int d = 0 ; d < coreCount ; d++ ) {
+            inPackage += cores[d].package == cores[c].package && cores[d].usable && (cores[d].quiet || !anyQuiet) ? 1 : 0;
+         }
+         if( inPackage > best ) {
+            best = inPackage;
+            package = cores[c].package;
+         }
+      }
+      int poolCount = 0;
+      for( int c = 0 ; c < coreCount ; c++ ) {
+         if( cores[c].package == package && cores[c].usable && (cores[c].quiet || !anyQuiet) ) {
+            pool[poolCount++] = &cores[c];
+         }
+      }
+
+      // Nothing isolated yet:  Keep some of the pool for housekeeping
+      if( !anyQuiet && poolCount > 1 ) {
+         qsort( pool, (size_t) poolCount, sizeof( pool[0] ), compare_noisy );
+         int reserve = (poolCount + HOUSEKEEPING_SHARE - 1) / HOUSEKEEPING_SHARE;
+         for( int r = 0 ; r < poolCount - reserve ; r++ ) {
+            pool[r] = pool[r + reserve];
+         }
+         poolCount -= reserve;
+      }
+      qsort( pool, (size_t) poolCount, sizeof( pool[0] ), compare_quiet );
+
+      long workerCores = workers >= 0 ? workers : (poolCount >= 2 ? (poolCount + WORKER_SHARE - 1) / WORKER_SHARE : 0);
+      workerCores = workerCores < poolCount ? workerCores : (poolCount > 0 ? poolCount - 1 : 0);
+      long enclaveCores = poolCount - workerCores;
+      if( threads > 0 && threads < enclaveCores ) {
+         enclaveCores = threads;
+      }
+      for( long c = 0 ; c < enclaveCores ; c++ ) {
+         pool[c]->role = ROLE_ENCLAVE;
+      }
+      for( long c = 0 ; c < workerCores ; c++ ) {
+         pool[poolCount - 1 - c]->role = ROLE_WORKER;
+      }
+      for( int p = 0 ; p < count ; p++ ) {
+         for( int c = 0 ; c < coreCount ; c++ ) {
+            if( cores[c].core == places[p].core ) {
+               places[p].role = cores[c].role;
+            }
+         }
+         if( places[p].role == ROLE_ENCLAVE && places[p].cpu != places[p].core ) {
+            places[p].role = ROLE_SIBLING;
+         }
+         if( !places[p].allowed ) {
+            places[p].role = ROLE_OUTSIDE;
+         }
+      }
+
+      printf( "\n    CPU  Core  Pkg  Node  SGX    Isolated  nohz  RCU-nocb  IRQs  Role\n" );
+      printf( "    ===  ====  ===  ====  =====  ========  ====  ========  ====  ==============\n" );
+      for( int p = 0 ; p < count ; p++ ) {
+         const struct cpu_place* place = &places[p];
+         printf( "    %3d  %4d  %3d  %4d  %-5s  %-8s  %-4s  %-8s  %4d  %s\n", place->cpu, place->core, place->package, place->node
+                ,sgxNames[place->sgx], place->isolated ? "yes" : "", place->nohz ? "yes" : "", place->nocb ? "yes" : ""
+                ,place->irqs, roleNames[place->role] );
+      }
+
+      printf( "\nRecommended sets%s\n", package < 0 ? ":  None -- no core is allowed here and has SGX"
+                                       : anySGX ? "" : " (no CPU reports SGX, so this is only a plan)" );
+      if( package >= 0 ) {
+         printf( "  (package %d, to keep the enclave threads next to its EPC section)\n", package );
+         print_role( places, count, ROLE_ENCLAVE,      "Enclave threads:",    "One per core; pin each TCS's thread" );
+         print_role( places, count, ROLE_WORKER,       "Switchless workers:", "Untrusted; same package & L3" );
+         print_role( places, count, ROLE_SIBLING,      "Idle siblings:",      "Share L1D with enclave threads" );
+         print_role( places, count, ROLE_HOUSEKEEPING, "Housekeeping:",       "IRQs, kernel threads & everything else" );
+
+         // What to put on the kernel command line
+         static int isolate[MAX_CPUS];
+         static int housekeeping[MAX_CPUS];
+         int isolateCount = 0;
+         int housekeepingCount = 0;
+         int noisy = 0;
+         for( int p = 0 ; p < count ; p++ ) {
+            if( places[p].role == ROLE_ENCLAVE || places[p].role == ROLE_SIBLING || places[p].role == ROLE_WORKER ) {
+               isolate[isolateCount++] = places[p].cpu;
+               noisy += places[p].role == ROLE_ENCLAVE && (places[p].irqs > 0 || !places[p].nohz) ? 1 : 0;
+            } else if( places[p].role == ROLE_HOUSEKEEPING ) {
+               housekeeping[housekeepingCount++] = places[p].cpu;
+            }
+         }
+         char isolateList[1024];
+         topology_format_cpulist( isolate, isolateCount, isolateList, sizeof( isolateList ) );
+         topology_format_cpulist( housekeeping, housekeepingCount, list, sizeof( list ) );
+         if( threads > enclaveCores ) {
+            printf( "\n  Only %ld core(s) for the %ld enclave threads asked for:  Some will share a core\n", enclaveCores, threads );
+         }
+         if( housekeepingCount == 0 ) {
+            printf( "\n  No CPU is left for housekeeping, so the enclave threads share theirs with IRQs & the kernel\n" );
+         } else if( noisy > 0 && isolateCount > 0 ) {
+            printf( "\n  %d enclave CPU(s) still take IRQs or timer ticks.  Boot with:\n", noisy );
+            printf( "    isolcpus=managed_irq,domain,%s nohz_full=%s rcu_nocbs=%s irqaffinity=%s\n", isolateList, isolateList, isolateList, list );
+            printf( "  and set IRQBALANCE_BANNED_CPULIST=%s (`--irq` shows what lands there now)\n", isolateList );
+         }
+      }
+      return EXIT_SUCCESS;
+
+   #else
+      printf( "The placement advisor needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  placement.h - 2026
+//
+/// This module recommends which CPUs should run enclave threads, switchless
+/// workers and housekeeping.
+///
+/// @file   placement.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--placement [--threads N] [--workers N]`
+int placement_main( int argc, char* argv[] );
@@ -0,0 +1,483 @@
+///////////////////////////////////////////////////////////////////////////////
+//  planner.c - 2026
+//
+/// This module plans how many enclaves fit in the EPC before it has to page.
+///
+/// Each line of a manifest describes an enclave:
+///
+///     # name  settings (sizes take K, M or G)
+///     enclave web   heap=64M stack=256K tcs=8 nssa=2 xfrm=0x3 code=12M count=4
+///     enclave db    heap=1G  tcs=16 xfrm=0xe7 code=40M
+///
+/// Missing settings default to `heap=0 stack=256K tcs=1 nssa=1 xfrm=0x3
+/// code=0 count=1`.  `count` places that many copies of the enclave.  Blank
+/// lines and `#` comments are skipped.  Any other line is an error, so a typo
+/// can't quietly drop an enclave from the plan.
+///
+/// Every enclave's EPC footprint is computed in 4K pages:
+///
+///   - 1 SECS page
+///   - 1 TCS page & 1 thread data page per thread
+///   - `nssa` SSA frames per thread.  A frame holds GPRSGX, the MISC region
+///     and a standard format XSAVE area for `xfrm`, sized from CPUID leaf 0DH.
+///   - The stack per thread, the heap and the code & data
+///   - 1 version array (VA) page per 512 of the above.  Linux allocates VA
+///     pages as it adds pages to the enclave, so they're resident too.
+///
+/// Then the enclaves are bin-packed (first-fit decreasing) onto the EPC
+/// sections from CPUID leaf 12H.  On a multi-socket host each section is
+/// local to one NUMA node, so an enclave is kept within one section.  Any
+/// enclave that doesn't fit will make the kernel page EPC.
+///
+/// The exit status is `EXIT_SUCCESS` only if every enclave fits without
+/// paging, so this can gate a deployment.
+///
+/// Usage:
+///
+///     test-sgx --epc-plan enclaves.txt                # Plan for this host
+///     test-sgx --epc-plan --from host17.cap enclaves.txt
+///
+/// @file   planner.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fopen() fgets() sscanf()
+#include <stdlib.h>    // For strtoull() qsort()
+#include <string.h>    // For strcmp() strncpy() strchr()
+#include <inttypes.h>  // For PRIu64 PRIx64 uint64_t
+#include <errno.h>     // For errno ERANGE
+
+#include "planner.h"   // For obvious reasons
+#include "capture.h"   // For capture_load() capture_find_cpuid()
+#include "cache.h"     // For cache_probe()
+#include "cpuid.h"     // For decode_EPC_section() NUMBER_OF_EPCs_TO_ENUMERATE
+#include "xsave.h"     // For XSAVE_area_size()
+#include "decode.h"    // For fields[] field_from_capture()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The largest number of enclaves (after `count`) in a plan
+#define MAX_ENCLAVES 4096
+
+#define PAGE_SIZE 4096
+
+/// Pages that each VA page holds a version for
+#define VA_SLOTS_PER_PAGE 512
+
+/// The size of the GPRSGX region at the end of an SSA frame
+#define GPRSGX_SIZE 184
+
+/// The size of the EXINFO part of the MISC region (MISCSELECT bit 0)
+#define EXINFO_SIZE 16
+
+/// XFRM must always have x87 & SSE
+#define XFRM_REQUIRED 0x3
+
+#define MiB ((uint64_t) 1 << 20)
+
+#define PAGES( bytes ) ( (bytes) / PAGE_SIZE + ((bytes) % PAGE_SIZE != 0) )
+
+/// The most pages an enclave can have, so that MAX_ENCLAVES of them still
+/// add up (in bytes) to a `uint64_t`
+#define MAX_ENCLAVE_PAGES ( UINT64_MAX / PAGE_SIZE / MAX_ENCLAVES )
+
+
+/// One enclave from a manifest
+struct enclave {
+   char     name[32];
+   uint64_t heap;      ///< Bytes
+   uint64_t stack;     ///< Bytes per thread
+   uint64_t code;      ///< Bytes of code & data
+   uint64_t tcs;       ///< Threads
+   uint64_t nssa;      ///< SSA frames per thread
+   uint64_t xfrm;
+   uint64_t count;     ///< Copies to place
+
+   uint32_t xsave;     ///< Bytes in the XSAVE area of an SSA frame
+   uint64_t ssa_frame; ///< Pages in an SSA frame
+   uint64_t pages;     ///< Total EPC footprint
+   uint64_t va;        ///< VA pages (included in `pages`)
+   int      section;   ///< Where it was placed, or -1
+};
+
+
+/// The EPC sections we're packing into
+struct section_plan {
+   struct epc_section section;
+   uint64_t free;      ///< Pages
+   unsigned enclaves;
+};
+
+
+/// Parse a size like `64M` or `0x1000`
+///
+/// @return `false` if it isn't a size or it doesn't fit in 64 bits
+static bool parse_size( const char* text, uint64_t* pValue ) {
+   char* end = NULL;
+   int shift = 0;
+
+   if( text[0] == '-' ) {
+      return false;  // strtoull() would negate it
+   }
+   errno = 0;
+   uint64_t value = strtoull( text, &end, 0 );
+   if( end == text || errno == ERANGE ) {
+      return false;
+   }
+   switch( *end ) {
+      case 'K': case 'k': shift = 10; end++; break;
+      case 'M': case 'm': shift = 20; end++; break;
+      case 'G': case 'g': shift = 30; end++; break;
+      default: break;
+   }
+   if( value > UINT64_MAX >> shift ) {
+      return false;
+   }
+   *pValue = value << shift;
+   return *end == '\0';
+}
+
+
+/// Parse one `enclave` line into `e`
+static bool parse_enclave( char* line, struct enclave* e ) {
+   static const struct enclave defaults = { "", 0, 256 << 10, 0, 1, 1, XFRM_REQUIRED, 1, 0, 0, 0, 0, -1 };
+   char* token = strtok( line, " \t\r\n" );  // `enclave`
+
+   *e = defaults;
+   token = strtok( NULL, " \t\r\n" );
+   if( token == NULL ) {
+      return false;
+   }
+   strncpy( e->name, token, sizeof( e->name ) - 1 );
+
+   while( (token = strtok( NULL, " \t\r\n" )) != NULL ) {
+      char* value = strchr( token, '=' );
+      uint64_t* setting = NULL;
+
+      if( value == NULL ) {
+         return false;
+      }
+      *value++ = '\0';
+
+      if(      strcmp( token, "heap" )  == 0 ) { setting = &e->heap; }
+      else if( strcmp( token, "stack" ) == 0 ) { setting = &e->stack; }
+      else if( strcmp( token, "code" )  == 0 ) { setting = &e->code; }
+      else if( strcmp( token, "tcs" )   == 0 ) { setting = &e->tcs; }
+      else if( strcmp( token, "nssa" )  == 0 ) { setting = &e->nssa; }
+      else if( strcmp( token, "xfrm" )  == 0 ) { setting = &e->xfrm; }
+      else if( strcmp( token, "count" ) == 0 ) { setting = &e->count; }
+
+      if( setting == NULL || !parse_size( value, setting ) ) {
+         return false;
+      }
+   }
+
+   return e->tcs > 0 && e->nssa > 0;
+}
+
+
+/// Read every enclave in a manifest, appending to `enclaves`
+static bool read_manifest( const char* fileName, struct enclave* enclaves, int* pCount ) {
+   FILE* file = fopen( fileName, "r" );
+   char line[512];
+   unsigned lineNumber = 0;
+   bool ok = true;
+
+   if( file == NULL ) {
+      fprintf( stderr, "epc-plan: Unable to open [%s]\n", fileName );
+      return false;
+   }
+
+   while( ok && fgets( line, sizeof( line ), file ) != NULL ) {
+      lineNumber++;
+
+      char keyword[16];
+      if( sscanf( line, "%15s", keyword ) != 1 || keyword[0] == '#' ) {
+         continue;  // Blank line or comment
+      }
+      if( strchr( line, '\n' ) == NULL && !feof( file ) ) {
+         fprintf( stderr, "epc-plan: %s:%u is too long\n", fileName, lineNumber );
+         ok = false;
+      } else if( strcmp( keyword, "enclave" ) != 0 ) {
+         fprintf( stderr, "epc-plan: %s:%u: Unknown keyword [%s]\n", fileName, lineNumber, keyword );
+         ok = false;
+      } else if( *pCount >= MAX_ENCLAVES ) {
+         fprintf( stderr, "epc-plan: Too many enclaves in [%s]\n", fileName );
+         ok = false;
+      } else if( !parse_enclave( line, &enclaves[*pCount] ) ) {
+         fprintf( stderr, "epc-plan: Unable to parse %s:%u\n", fileName, lineNumber );
+         ok = false;
+      } else {
+         (*pCount)++;
+      }
+   }
+
+   fclose( file );
+   return ok;
+}
+
+
+/// The pages in one SSA frame for an enclave with `xfrm` on the host in `cap`.
+/// We assume the enclave enables EXINFO if the CPU supports it.
+///
+/// @return `0` if a state component in `xfrm` isn't enumerated in `cap`
+uint64_t SSA_frame_pages( const struct sgx_capture* cap, uint64_t xfrm ) {
+   uint64_t miscselect = 0;
+   uint32_t xsave = XSAVE_area_size( cap, xfrm );
+
+   if( xsave == 0 ) {
+      return 0;
+   }
+   field_from_capture( &fields[FIELD_MISCSELECT], cap, &miscselect );
+   return PAGES( xsave + ((miscselect & 1) ? EXINFO_SIZE : 0) + GPRSGX_SIZE );
+}
+
+
+/// Add `a` x `b` to `*pSum`
+///
+/// @return `false` (leaving `*pSum` alone) if it doesn't fit in 64 bits
+static bool add_product( uint64_t* pSum, uint64_t a, uint64_t b ) {
+   if( b != 0 && a > UINT64_MAX / b ) {
+      return false;
+   }
+   if( a * b > UINT64_MAX - *pSum ) {
+      return false;
+   }
+   *pSum += a * b;
+   return true;
+}
+
+
+/// Compute an enclave's EPC footprint for the host in `cap`
+///
+/// @return `false` (after printing why) if the enclave can't be created there
+static bool size_enclave( struct enclave* e, const struct sgx_capture* cap, uint64_t xfrmAllowed ) {
+   uint64_t maxEnclaveSize = 0;
+
+   field_from_capture( &fields[FIELD_MAX_ENCLAVE_SIZE_64], cap, &maxEnclaveSize );
+
+   if( (e->xfrm & XFRM_REQUIRED) != XFRM_REQUIRED || (e->xfrm & ~xfrmAllowed) != 0 ) {
+      printf( "  %s: XFRM %016" PRIx64 " isn't allowed (SGX allows %016" PRIx64 ").  ECREATE would fault.\n"
+             ,e->name, e->xfrm, xfrmAllowed );
+      return false;
+   }
+
+   e->xsave = XSAVE_area_size( cap, e->xfrm );
+   if( e->xsave == 0 ) {
+      printf( "  %s: XFRM %016" PRIx64 " has a state component CPUID doesn't enumerate\n", e->name, e->xfrm );
+      return false;
+   }
+
+   e->ssa_frame = SSA_frame_pages( cap, e->xfrm );
+
+   uint64_t frames = 0;  // SSA frames
+   uint64_t pages = 1;   // SECS
+   bool fits = add_product( &frames, e->tcs, e->nssa )
+            && add_product( &pages, e->tcs, 2 )         // TCS + thread data
+            && add_product( &pages, frames, e->ssa_frame )
+            && add_product( &pages, e->tcs, PAGES( e->stack ) )
+            && add_product( &pages, PAGES( e->heap ), 1 )
+            && add_product( &pages, PAGES( e->code ), 1 );
+
+   e->va = pages / VA_SLOTS_PER_PAGE + (pages % VA_SLOTS_PER_PAGE != 0);
+   if( !fits || pages > MAX_ENCLAVE_PAGES || e->va > MAX_ENCLAVE_PAGES - pages ) {
+      printf( "  %s: It's too big to plan (more than %" PRIu64 " pages)\n", e->name, MAX_ENCLAVE_PAGES );
+      return false;
+   }
+   e->pages = pages + e->va;
+
+   if( maxEnclaveSize > 0 && maxEnclaveSize < 64 && e->pages * PAGE_SIZE > (uint64_t) 1 << maxEnclaveSize ) {
+      printf( "  %s: %" PRIu64 " MiB is bigger than the largest enclave (2^%" PRIu64 ")\n"
+             ,e->name, e->pages * PAGE_SIZE / MiB, maxEnclaveSize );
+      return false;
+   }
+
+   return true;
+}
+
+
+/// Sort enclaves by decreasing footprint (then by name, so plans are stable)
+static int compare_enclaves( const void* a, const void* b ) {
+   const struct enclave* x = a;
+   const struct enclave* y = b;
+
+   if( x->pages != y->pages ) {
+      return x->pages < y->pages ? 1 : -1;
+   }
+   return strcmp( x->name, y->name );
+}
+
+
+/// `--epc-plan [--from CAPTURE] MANIFEST...`
+int planner_main( int argc, char* argv[] ) {
+   static struct sgx_capture cap;                // Too big for the stack
+   static struct enclave enclaves[MAX_ENCLAVES];
+   static struct enclave placed[MAX_ENCLAVES];   // After expanding `count`
+   struct section_plan sections[NUMBER_OF_EPCs_TO_ENUMERATE];
+   const char* fromFile = NULL;
+   int enclaveCount = 0;
+   int placedCount = 0;
+   int sectionCount = 0;
+   int firstManifest = 0;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--from" ) == 0 && i + 1 < argc ) {
+         fromFile = argv[++i];
+      } else if( argv[i][0] != '-' ) {
+         firstManifest = i;
+         break;
+      }
+   }
+
+   if( firstManifest == 0 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --epc-plan [--from CAPTURE] MANIFEST...\n" );
+      return EXIT_FAILURE;
+   }
+
+   for( int i = firstManifest ; i < argc ; i++ ) {
+      if( !read_manifest( argv[i], enclaves, &enclaveCount ) ) {
+         return EXIT_FAILURE;
+      }
+   }
+
+   if( fromFile != NULL ) {
+      if( !capture_load( fromFile, &cap ) ) {
+         return EXIT_FAILURE;
+      }
+   } else {
+      cache_probe( &cap, false );
+   }
+
+   uint64_t sgx = 0;
+   uint64_t xfrmLo = 0;
+   uint64_t xfrmHi = 0;
+   uint64_t oversubVMX = 0;
+   uint64_t oversubSupervisor = 0;
+   field_from_capture( &fields[FIELD_SGX], &cap, &sgx );
+   field_from_capture( &fields[FIELD_XFRM_LO], &cap, &xfrmLo );
+   field_from_capture( &fields[FIELD_XFRM_HI], &cap, &xfrmHi );
+   field_from_capture( &fields[FIELD_OVERSUB_VMX], &cap, &oversubVMX );
+   field_from_capture( &fields[FIELD_OVERSUB_SUPERVISOR], &cap, &oversubSupervisor );
+
+   if( !sgx ) {
+      printf( "Does not support SGX\n" );
+      return EXIT_FAILURE;
+   }
+
+   uint64_t totalFree = 0;
+   for( uint32_t sub = 2 ; sub <= NUMBER_OF_EPCs_TO_ENUMERATE ; sub++ ) {
+      const struct cpuid_record* r = capture_find_cpuid( &cap, 0x12, sub );
+      struct section_plan* s = &sections[sectionCount];
+      if( r != NULL && decode_EPC_section( r->eax, r->ebx, r->ecx, r->edx, &s->section ) ) {
+         s->free = s->section.size / PAGE_SIZE;
+         s->enclaves = 0;
+         totalFree += s->free;
+         sectionCount++;
+      }
+   }
+
+   printf( "EPC capacity plan for %s\n", cap.node );
+   printf( "  %d EPC sections, %" PRIu64 " MiB in total\n", sectionCount, totalFree * PAGE_SIZE / MiB );
+
+   printf( "    Enclave          Count  TCS  NSSA  XSAVE  SSA pages  VA pages     Pages        MiB\n" );
+   printf( "    ===============  =====  ===  ====  =====  =========  ========  ========  =========\n" );
+
+   bool ok = true;
+   for( int i = 0 ; i < enclaveCount ; i++ ) {
+      struct enclave* e = &enclaves[i];
+
+      if( !size_enclave( e, &cap, xfrmHi << 32 | xfrmLo ) ) {
+         ok = false;
+         continue;
+      }
+
+      printf( "    %-15s  %5" PRIu64 "  %3" PRIu64 "  %4" PRIu64 "  %5" PRIu32 "  %9" PRIu64 "  %8" PRIu64 "  %8" PRIu64 "  %9.1f\n"
+             ,e->name, e->count, e->tcs, e->nssa, e->xsave, e->ssa_frame, e->va, e->pages
+             ,(double) (e->pages * PAGE_SIZE) / MiB );
+
+      if( e->count > (uint64_t) (MAX_ENCLAVES - placedCount) ) {
+         fprintf( stderr, "epc-plan: More than %d enclaves to place\n", MAX_ENCLAVES );
+         return EXIT_FAILURE;
+      }
+      for( uint64_t c = 0 ; c < e->count ; c++ ) {
+         placed[placedCount++] = *e;
+      }
+   }
+   if( !ok ) {
+      return EXIT_FAILURE;
+   }
+
+   qsort( placed, (size_t) placedCount, sizeof( placed[0] ), compare_enclaves );
+
+   uint64_t needed = 0;
+   int unplaced = 0;
+   for( int i = 0 ; i < placedCount ; i++ ) {
+      placed[i].section = -1;
+      needed += placed[i].pages;
+      for( int s = 0 ; s < sectionCount ; s++ ) {
+         if( placed[i].pages <= sections[s].free ) {
+            sections[s].free -= placed[i].pages;
+            sections[s].enclaves++;
+            placed[i].section = s;
+            break;
+         }
+      }
+      if( placed[i].section < 0 ) {
+         unplaced++;
+      }
+   }
+
+   printf( "  Placement (first-fit decreasing, each enclave within one section):\n" );
+   for( int s = 0 ; s < sectionCount ; s++ ) {
+      uint64_t pages = sections[s].section.size / PAGE_SIZE;
+      printf( "    EPC[%d]: %3u enclaves  %8.1f of %8.1f MiB used  "
+             ,s, sections[s].enclaves
+             ,(double) ((pages - sections[s].free) * PAGE_SIZE) / MiB
+             ,(double) sections[s].section.size / MiB );
+      for( int i = 0 ; i < placedCount ; i++ ) {
+         if( placed[i].section == s ) {
+            printf( " %s", placed[i].name );
+         }
+      }
+      printf( "\n" );
+   }
+
+   if( unplaced > 0 ) {
+      printf( "    Doesn't fit:  " );
+      for( int i = 0 ; i < placedCount ; i++ ) {
+         if( placed[i].section < 0 ) {
+            printf( " %s", placed[i].name );
+         }
+      }
+      printf( "\n" );
+   }
+
+   printf( "  %d enclaves need %.1f of %.1f MiB of EPC (%.0f%%)\n"
+          ,placedCount
+          ,(double) (needed * PAGE_SIZE) / MiB
+          ,(double) (totalFree * PAGE_SIZE) / MiB
+          ,totalFree > 0 ? 100.0 * (double) needed / (double) totalFree : 0.0 );
+
+   if( oversubVMX || oversubSupervisor ) {
+      printf( "  This CPU supports EPC oversubscription (OVERSUB-VMX: %d, OVERSUB-Supervisor: %d).\n"
+             ,(int) oversubVMX, (int) oversubSupervisor );
+      printf( "  In a VM, the hypervisor may oversubscribe the EPC it shows here, so a plan\n" );
+      printf( "  that fits can still page on the host.\n" );
+   }
+
+   if( unplaced == 0 ) {
+      printf( "Paging-free:  yes\n" );
+      return EXIT_SUCCESS;
+   }
+
+   if( needed <= totalFree ) {
+      printf( "Paging-free:  no.  %d enclaves only fit by spreading them over sections (remote NUMA EPC)\n", unplaced );
+   } else {
+      printf( "Paging-free:  no.  The EPC is overcommitted by %.1f MiB\n"
+             ,(double) ((needed - totalFree) * PAGE_SIZE) / MiB );
+   }
+   if( oversubSupervisor ) {
+      printf( "  The kernel can page with ETRACKC, ERDINFO, ELDBC and ELDUC (OVERSUB-Supervisor).\n" );
+   }
+   return EXIT_FAILURE;
+}
@@ -0,0 +1,23 @@
+///////////////////////////////////////////////////////////////////////////////
+//  planner.h - 2026
+//
+/// This module plans how many enclaves fit in the EPC before it has to page.
+///
+/// @file   planner.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <inttypes.h>  // For uint64_t
+
+
+struct sgx_capture;
+
+/// The pages in one SSA frame for an enclave with `xfrm` on the host in `cap`.
+/// We assume the enclave enables EXINFO if the CPU supports it.
+///
+/// @return `0` if a state component in `xfrm` isn't enumerated in `cap`
+uint64_t SSA_frame_pages( const struct sgx_capture* cap, uint64_t xfrm );
+
+/// `--epc-plan [--from CAPTURE] MANIFEST...`
+int planner_main( int argc, char* argv[] );
@@ -36,60 +36,105 @@
 #include <inttypes.h>   // For PRIx64 uint64_t
 
 #ifdef __linux__
-   #include <fcntl.h>   // For open() O_RDONLY
+   #include <fcntl.h>   // For open() O_RDONLY O_CLOEXEC
    #include <unistd.h>  // For pread() close()
    #include <sys/capability.h>  // For CAP_SYS_ADMIN cap_get_proc() cap_set_flag() cap_set_proc() cap_free()
 #endif
 
 #include "rdmsr.h"           // For obvious reasons
 #include "test-sgx.h"        // For EXIT_ON_FAILURE
+#include "decode.h"          // For fields[] field_extract() print_msr_fields()
+#include "capture.h"         // For capture_probes_msr() capture_find_msr()
+
+
+/// When set, `rdmsr()` answers CPU 0's MSRs from this capture (the probe cache)
+static const struct sgx_capture* msrCapture = NULL;
+
+
+/// Keep /dev/cpu/N/msr open for this many CPUs, so sampling modes don't pay
+/// for an open() & close() on every read
+#define MAX_MSR_FILES 1024
+
+/// The open /dev/cpu/N/msr files, plus one (so 0 means not open yet)
+static int msrFiles[MAX_MSR_FILES];
 
 
 /// On Linux, return true if we are running as root (with CAP_SYS_ADMIN).  In
-/// all other situations, return false.
-bool checkCapabilities( void ) {
+/// all other situations, return false.  Say why not if `verbose`.
+static bool acquireCapabilities( bool verbose ) {
    #ifdef __linux__
 
       cap_t myCapabilities ;
       const cap_value_t requiredCapabilitiesList[1] = { CAP_SYS_ADMIN } ;
 
       if( !CAP_IS_SUPPORTED( CAP_SYS_ADMIN )) {
-         printf( "Does not support CAP_SYS_ADMIN\n" ) ;
+         if( verbose ) {
+            printf( "Does not support CAP_SYS_ADMIN\n" ) ;
+         }
          return false;
       }
 
       myCapabilities = cap_get_proc() ;
       if( myCapabilities == NULL ) {
-         printf( "Unable to get the process' capabilities\n" ) ;
+         if( verbose ) {
+            printf( "Unable to get the process' capabilities\n" ) ;
+         }
          return false;
       }
 
       int rVal = cap_set_flag( myCapabilities, CAP_EFFECTIVE, 1, requiredCapabilitiesList, CAP_SET) ;
       if( rVal != 0 ) {
-         printf( "cap_set_flag() did not set a capability\n" ) ;
+         if( verbose ) {
+            printf( "cap_set_flag() did not set a capability\n" ) ;
+         }
          return false;
       }
 
       rVal = cap_set_proc( myCapabilities ) ;
       if( rVal != 0 ) {
-         printf( "Not running with admin privlidges... On Linux, run as root for more SGX info.\n" ) ;
+         if( verbose ) {
+            printf( "Not running with admin privlidges... On Linux, run as root for more SGX info.\n" ) ;
+         }
          return false;
       }
 
       rVal = cap_free( myCapabilities ) ;
       if( rVal != 0 ) {
-         printf( "cap_free failed\n" ) ;
+         if( verbose ) {
+            printf( "cap_free failed\n" ) ;
+         }
          return false;
       }
 
       return true;
 
    #else
+      (void) verbose;
       return false;  // In all other operating systems, return false
    #endif
 }
 
 
+/// On Linux, return true if we are running as root (with CAP_SYS_ADMIN).  In
+/// all other situations, return false.
+bool checkCapabilities( void ) {
+   return acquireCapabilities( true );
+}
+
+
+/// Like `checkCapabilities()`, but without printing why not
+bool checkCapabilitiesQuietly( void ) {
+   return acquireCapabilities( false );
+}
+
+
+/// Answer `rdmsr()` for the MSRs a capture reads on CPU 0 from `cap`.  Pass
+/// `NULL` to go back to reading /dev/cpu/0/msr.
+void rdmsr_use_capture( const struct sgx_capture* cap ) {
+   msrCapture = cap;
+}
+
+
 /// Read an MSR on a CPU
 ///
 /// Courtesy of Intel:  https://github.com/intel/msr-tools/blob/master/rdmsr.c
@@ -100,32 +145,48 @@ bool checkCapabilities( void ) {
 ///
 /// @returns true if successful, false if not successful
 bool rdmsr( uint32_t reg, int cpu, uint64_t* pData ) {
+   if( msrCapture != NULL && cpu == 0 && capture_probes_msr( reg ) ) {
+      return capture_find_msr( msrCapture, reg, pData );
+   }
+
    #ifdef __linux__
 
       char     msr_file_name[64];
       int      fd;  // File descriptor to /dev/cpu/%d/msr
+      bool     keep = cpu >= 0 && cpu < MAX_MSR_FILES;
 
       if( reg >= 0x40000000 && reg <= 0x4000FFFF ) {
          fprintf( stderr, "rdmsr: Attempting to read from reserved range\n" );
          return false;
       }
 
-      sprintf( msr_file_name, "/dev/cpu/%d/msr", cpu );
-      fd = open( msr_file_name, O_RDONLY );
-      if (fd < 0) {
-         fprintf( stderr, "rdmsr: CPU %d doesn't support MSRs\n", cpu );
-         return false;
+      if( keep && msrFiles[cpu] > 0 ) {
+         fd = msrFiles[cpu] - 1;
+      } else {
+         sprintf( msr_file_name, "/dev/cpu/%d/msr", cpu );
+         fd = open( msr_file_name, O_RDONLY | O_CLOEXEC );
+         if (fd < 0) {
+            fprintf( stderr, "rdmsr: CPU %d doesn't support MSRs\n", cpu );
+            return false;
+         }
+         if( keep ) {
+            msrFiles[cpu] = fd + 1;
+         }
       }
 
       // pread:  Upon successful completion, pread shall return a non-negative
       //         integer indicating  the  number of bytes actually read.
-      if( pread( fd, pData, sizeof *pData, reg ) != sizeof *pData ) {
+      bool ok = pread( fd, pData, sizeof *pData, reg ) == sizeof *pData;
+
+      if( !keep ) {
+         close(fd);
+      }
+
+      if( !ok ) {
          // fprintf( stderr, "rdmsr: CPU %d did not read MSR 0x%08" PRIx32 "\n", cpu, reg );
          return false;
       }
 
-      close(fd);
-
    #else
       (void) reg;    // Squelch unused parameter warnings
       (void) cpu;
@@ -143,11 +204,10 @@ void read_SGX_MSRs( void ) {
    if( rdmsr( IA32_FEATURE_CONTROL, 0, &feature_control_msr ) ) {
       printf( "Raw IA32_FEATURE_CONTROL: %016" PRIx64 "\n", feature_control_msr );
 
-      printf( "    IA32_FEATURE_CONTROL.LOCK_BIT[bit 0]: %d\n", (int)((feature_control_msr >> 0) & 1 ));
-      printf( "    IA32_FEATURE_CONTROL.SGX_LAUNCH_CONTROL[bit 17] (Is the SGX LE PubKey writable?): %d\n", (int)((feature_control_msr >> 17) & 1 ));
-      printf( "    IA32_FEATURE_CONTROL.SGX_GLOBAL_ENABLE[bit 18]: %d\n", (int)((feature_control_msr >> 18) & 1 ));
+      print_msr_fields( GROUP_FEATURE_CONTROL, IA32_FEATURE_CONTROL, feature_control_msr );
 
-      if( (feature_control_msr & 1 ) && ( (feature_control_msr >> 17) & 1 ) ) {
+      if(    field_extract( &fields[FIELD_FC_LOCK],   feature_control_msr )
+          && field_extract( &fields[FIELD_FC_SGX_LC], feature_control_msr ) ) {
          printf( "The SGX Launch Enclave Public Key Hash can be changed\n" );
       } else {
          printf( "The SGX Launch Enclave Public Key Hash can NOT be changed\n" );
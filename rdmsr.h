@@ -15,16 +15,35 @@
 
 
 #define IA32_FEATURE_CONTROL  0x03A
+#define IA32_ARCH_CAPABILITIES 0x10A
 #define IA32_SGXLEPUBKEYHASH0 0x08C
 #define IA32_SGX_SVN_STATUS   0x500
 #define MSR_SGXOWNEREPOCH0    0x300
 #define IA32_XSS              0xda0
+#define IA32_TIME_STAMP_COUNTER 0x010
+#define IA32_MPERF            0x0E7
+#define IA32_APERF            0x0E8
+#define MSR_PLATFORM_INFO     0x0CE
+#define IA32_PERF_STATUS      0x198
+#define MSR_RAPL_POWER_UNIT   0x606
+#define MSR_PKG_ENERGY_STATUS 0x611
+#define MSR_DRAM_ENERGY_STATUS 0x619
+#define MSR_PP0_ENERGY_STATUS 0x639
 
 
 /// On Linux, return true if we are running as root (with CAP_SYS_ADMIN).  In
 /// all other situations, return false.
 bool checkCapabilities( void );
 
+/// Like `checkCapabilities()`, but without printing why not
+bool checkCapabilitiesQuietly( void );
+
+struct sgx_capture;
+
+/// Answer `rdmsr()` for the MSRs a capture reads on CPU 0 from `cap`.  Pass
+/// `NULL` to go back to reading /dev/cpu/0/msr.
+void rdmsr_use_capture( const struct sgx_capture* cap );
+
 /// Read an MSR on a CPU
 bool rdmsr( uint32_t reg, int cpu, uint64_t* pData );
 
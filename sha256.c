@@ -0,0 +1,497 @@
+///////////////////////////////////////////////////////////////////////////////
+//  sha256.c - 2026
+//
+/// This module benchmarks SHA-256 on this host to predict how long it takes
+/// to measure (compute MRENCLAVE for) an enclave of a given size.
+///
+/// A signing tool computes MRENCLAVE by replaying the enclave's build in
+/// software:  One SHA-256 runs over a 64 byte record for ECREATE, a 64 byte
+/// record for every EADD and, for every EEXTEND, a 64 byte record followed by
+/// the 256 bytes it measures.  A fully measured 4 KiB page is one EADD and 16
+/// EEXTENDs -- 81 SHA-256 blocks, or 5,184 bytes hashed.  It's one hash, so it
+/// can't be split across cores:  The time is pages x the cost of a page on
+/// one core.
+///
+/// The module times each SHA-256 implementation this CPU can run:
+///
+///   - `generic`:  Portable C
+///   - `sha-ni`:   The SHA extensions (`SHA256RNDS2` & friends), when
+///                 CPUID.(EAX=7, ECX=0):EBX[29] is set
+///
+/// AVX2 (CPUID.(EAX=7, ECX=0):EBX[5]) is reported but not timed.  AVX2
+/// SHA-256 is multi-buffer -- it hashes 8 independent messages at once -- and
+/// MRENCLAVE is a single serial stream, so it can't go any faster with it.
+///
+/// The Makefile compiles this file with `-O2`, like a signing tool would be.
+/// Unoptimized SHA-256 would predict the wrong thing.
+///
+/// Each is checked against a known digest before it's timed.  It reports the
+/// bulk throughput, the cost of a measured page (EADD + 16 EEXTENDs) and an
+/// unmeasured page (EADD alone), and predicts the measurement time for a few
+/// enclave sizes (and `--enclave SIZE`).
+///
+/// This predicts the build (signing) step.  At launch, EEXTEND hashes in
+/// microcode, so the launch time depends on the CPU, not on this code.
+///
+/// Usage:
+///
+///     test-sgx --sha256                # Predict for 256 MiB to 16 GiB
+///     test-sgx --sha256 --enclave 6G   # ... and for a 6 GiB enclave
+///     test-sgx --sha256 --size 256     # Time a 256 MiB buffer
+///
+/// @see Intel SDM Vol. 3D, 35.3 (Measuring an enclave)
+/// @see https://www.intel.com/content/www/us/en/developer/articles/technical/intel-sha-extensions.html
+///
+/// @file   sha256.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For printf() fprintf()
+#include <stdlib.h>    // For malloc() free() strtod()
+#include <string.h>    // For strcmp() memcpy() memset() memcmp()
+#include <inttypes.h>  // For PRIu64 uint64_t uint32_t uint8_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime() timespec_get()
+
+#if defined( __GNUC__ )
+   #include <immintrin.h>  // For _mm_sha256rnds2_epu32() and friends
+#endif
+
+#include "sha256.h"    // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+#define PAGE_SIZE        4096
+#define BLOCK_SIZE         64
+#define EEXTEND_SIZE      256  ///< The bytes one EEXTEND measures
+#define EEXTENDS_PER_PAGE ( PAGE_SIZE / EEXTEND_SIZE )
+#define BLOCKS_PER_PAGE   ( 1 + EEXTENDS_PER_PAGE * (1 + EEXTEND_SIZE / BLOCK_SIZE) )  ///< 81
+
+/// The pages in the per-page test
+#define TEST_PAGES       4096
+
+/// Each timing is the best of this many runs
+#define RUNS                3
+
+
+/// Compress `count` 64 byte blocks into `state`
+typedef void (*compress_fn)( uint32_t state[8], const uint8_t* blocks, size_t count );
+
+
+/// One SHA-256 implementation
+struct implementation {
+   const char* name;
+   compress_fn compress;   ///< `NULL` if this compiler can't build it
+   bool        available;  ///< The CPU (and OS) can run it
+   const char* needs;      ///< What it takes, for the report
+};
+
+
+static const uint32_t K[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t H0[8] = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+
+#define ROTR( x, n ) ( ((x) >> (n)) | ((x) << (32 - (n))) )
+
+
+/// The portable compression function
+static void compress_generic( uint32_t state[8], const uint8_t* blocks, size_t count ) {
+   uint32_t w[64];
+
+   for( ; count > 0 ; count--, blocks += BLOCK_SIZE ) {
+      for( int i = 0 ; i < 16 ; i++ ) {
+         w[i] = (uint32_t) blocks[i * 4] << 24 | (uint32_t) blocks[i * 4 + 1] << 16 | (uint32_t) blocks[i * 4 + 2] << 8 | blocks[i * 4 + 3];
+      }
+      for( int i = 16 ; i < 64 ; i++ ) {
+         uint32_t s0 = ROTR( w[i - 15], 7 ) ^ ROTR( w[i - 15], 18 ) ^ (w[i - 15] >> 3);
+         uint32_t s1 = ROTR( w[i - 2], 17 ) ^ ROTR( w[i - 2], 19 ) ^ (w[i - 2] >> 10);
+         w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+      }
+
+      uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+      uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+      for( int i = 0 ; i < 64 ; i++ ) {
+         uint32_t t1 = h + (ROTR( e, 6 ) ^ ROTR( e, 11 ) ^ ROTR( e, 25 )) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+         uint32_t t2 = (ROTR( a, 2 ) ^ ROTR( a, 13 ) ^ ROTR( a, 22 )) + ((a & b) ^ (a & c) ^ (b & c));
+         h = g;
+         g = f;
+         f = e;
+         e = d + t1;
+         d = c;
+         c = b;
+         b = a;
+         a = t1 + t2;
+      }
+      state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+      state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+   }
+}
+
+
+#if defined( __GNUC__ )
+
+/// The SHA extensions.  Each `SHA256RNDS2` does two rounds on the state
+/// split into ABEF & CDGH, and `SHA256MSG1`/`SHA256MSG2` compute the message
+/// schedule four words at a time.
+__attribute__(( target( "sha,sse4.1" ) ))
+static void compress_sha_ni( uint32_t state[8], const uint8_t* blocks, size_t count ) {
+   const __m128i byteSwap = _mm_set_epi64x( 0x0c0d0e0f08090a0bLL, 0x0405060700010203LL );
+
+   // Rearrange the state from ABCD EFGH to ABEF CDGH
+   __m128i tmp    = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*) &state[0] ), 0xB1 );  // CDAB
+   __m128i state1 = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*) &state[4] ), 0x1B );  // EFGH
+   __m128i state0 = _mm_alignr_epi8( tmp, state1, 8 );     // ABEF
+   state1         = _mm_blend_epi16( state1, tmp, 0xF0 );  // CDGH
+
+   for( ; count > 0 ; count--, blocks += BLOCK_SIZE ) {
+      __m128i w[4];  // The last 16 words of the schedule
+      __m128i abefSave = state0;
+      __m128i cdghSave = state1;
+
+      #pragma GCC unroll 16
+      for( int i = 0 ; i < 16 ; i++ ) {
+         if( i < 4 ) {
+            w[i] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (blocks + i * 16) ), byteSwap );
+         } else {
+            // W[t] = σ1(W[t-2]) + W[t-7] + σ0(W[t-15]) + W[t-16], four at a time
+            __m128i x = _mm_sha256msg1_epu32( w[i & 3], w[(i + 1) & 3] );
+            x = _mm_add_epi32( x, _mm_alignr_epi8( w[(i + 3) & 3], w[(i + 2) & 3], 4 ) );
+            w[i & 3] = _mm_sha256msg2_epu32( x, w[(i + 3) & 3] );
+         }
+         __m128i message = _mm_add_epi32( w[i & 3], _mm_loadu_si128( (const __m128i*) &K[i * 4] ) );
+         state1  = _mm_sha256rnds2_epu32( state1, state0, message );
+         message = _mm_shuffle_epi32( message, 0x0E );
+         state0  = _mm_sha256rnds2_epu32( state0, state1, message );
+      }
+
+      state0 = _mm_add_epi32( state0, abefSave );
+      state1 = _mm_add_epi32( state1, cdghSave );
+   }
+
+   // Back to ABCD EFGH
+   tmp    = _mm_shuffle_epi32( state0, 0x1B );      // FEBA
+   state1 = _mm_shuffle_epi32( state1, 0xB1 );      // DCHG
+   state0 = _mm_blend_epi16( tmp, state1, 0xF0 );   // DCBA
+   state1 = _mm_alignr_epi8( state1, tmp, 8 );      // HGFE
+   _mm_storeu_si128( (__m128i*) &state[0], state0 );
+   _mm_storeu_si128( (__m128i*) &state[4], state1 );
+}
+
+#endif  // __GNUC__
+
+
+/// Hash `size` bytes of `data` into `digest` with `compress`
+static void sha256( compress_fn compress, const uint8_t* data, size_t size, uint8_t digest[32] ) {
+   uint32_t state[8];
+   uint8_t  tail[2 * BLOCK_SIZE] = { 0 };
+   size_t   whole = size / BLOCK_SIZE;
+   size_t   rest = size % BLOCK_SIZE;
+
+   memcpy( state, H0, sizeof( state ) );
+   compress( state, data, whole );
+
+   // The padding:  0x80, zeros and the length in bits (big-endian)
+   memcpy( tail, data + whole * BLOCK_SIZE, rest );
+   tail[rest] = 0x80;
+   size_t tailBlocks = rest < BLOCK_SIZE - 8 ? 1 : 2;
+   uint64_t bits = (uint64_t) size * 8;
+   for( int i = 0 ; i < 8 ; i++ ) {
+      tail[tailBlocks * BLOCK_SIZE - 1 - i] = (uint8_t) (bits >> (i * 8));
+   }
+   compress( state, tail, tailBlocks );
+
+   for( int i = 0 ; i < 8 ; i++ ) {
+      digest[i * 4]     = (uint8_t) (state[i] >> 24);
+      digest[i * 4 + 1] = (uint8_t) (state[i] >> 16);
+      digest[i * 4 + 2] = (uint8_t) (state[i] >> 8);
+      digest[i * 4 + 3] = (uint8_t) state[i];
+   }
+}
+
+
+/// @return `true` if `compress` gets SHA-256("abc") right
+static bool known_answer( compress_fn compress ) {
+   static const uint8_t expected[32] = {
+      0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+      0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+   };
+   uint8_t digest[32];
+
+   sha256( compress, (const uint8_t*) "abc", 3, digest );
+   return memcmp( digest, expected, sizeof( digest ) ) == 0;
+}
+
+
+/// @return CLOCK_MONOTONIC (or, without POSIX clocks, the C11 wall clock)
+///         in seconds
+static double now_seconds( void ) {
+   struct timespec now;
+
+   #ifdef __linux__
+      clock_gettime( CLOCK_MONOTONIC, &now );
+   #else
+      timespec_get( &now, TIME_UTC );
+   #endif
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Measure `pages` pages of `image` like a signing tool:  Per page, an EADD
+/// record and (if `extend`) 16 EEXTEND records, each followed by 256 bytes
+/// of the page
+static void measure_pages( compress_fn compress, uint32_t state[8], const uint8_t* image, size_t pages, bool extend ) {
+   uint8_t records[BLOCKS_PER_PAGE * BLOCK_SIZE];
+
+   for( size_t p = 0 ; p < pages ; p++ ) {
+      uint64_t offset = (uint64_t) p * PAGE_SIZE;
+      uint8_t* r = records;
+
+      // EADD:  "EADD", the page's offset and the first 48 bytes of SECINFO
+      memset( r, 0, BLOCK_SIZE );
+      memcpy( r, "EADD", 4 );
+      memcpy( r + 8, &offset, sizeof( offset ) );
+      r[16] = 0x01 | 0x02 | 0x04;  // SECINFO.FLAGS[7:0]:   R W X
+      r[17] = 0x02;                // SECINFO.FLAGS[15:8]:  PT_REG
+      r += BLOCK_SIZE;
+
+      for( int e = 0 ; extend && e < EEXTENDS_PER_PAGE ; e++ ) {
+         uint64_t chunk = offset + (uint64_t) e * EEXTEND_SIZE;
+         memset( r, 0, BLOCK_SIZE );
+         memcpy( r, "EEXTEND", 7 );
+         memcpy( r + 8, &chunk, sizeof( chunk ) );
+         memcpy( r + BLOCK_SIZE, image + chunk, EEXTEND_SIZE );
+         r += BLOCK_SIZE + EEXTEND_SIZE;
+      }
+      compress( state, records, (size_t) (r - records) / BLOCK_SIZE );
+   }
+}
+
+
+/// The results for one implementation
+struct timing {
+   double bytesPerSecond;
+   double measuredPage;    ///< Seconds per EADD + 16 EEXTENDs
+   double addedPage;       ///< Seconds per EADD alone
+};
+
+
+/// Time `compress` over `buffer`
+static void time_implementation( compress_fn compress, const uint8_t* buffer, size_t size, struct timing* timing ) {
+   uint8_t  digest[32];
+   uint32_t state[8];
+   double   bulk = 1e30;
+   double   measured = 1e30;
+   double   added = 1e30;
+
+   for( int run = 0 ; run < RUNS ; run++ ) {
+      double start = now_seconds();
+      sha256( compress, buffer, size, digest );
+      double seconds = now_seconds() - start;
+      bulk = seconds < bulk ? seconds : bulk;
+
+      memcpy( state, H0, sizeof( state ) );
+      start = now_seconds();
+      measure_pages( compress, state, buffer, TEST_PAGES, true );
+      seconds = now_seconds() - start;
+      measured = seconds < measured ? seconds : measured;
+
+      start = now_seconds();
+      measure_pages( compress, state, buffer, TEST_PAGES, false );
+      seconds = now_seconds() - start;
+      added = seconds < added ? seconds : added;
+   }
+
+   timing->bytesPerSecond = (double) size / bulk;
+   timing->measuredPage   = measured / TEST_PAGES;
+   timing->addedPage      = added / TEST_PAGES;
+}
+
+
+/// Parse a size like `512M`, `6G` or `1T` (MiB if there's no suffix)
+///
+/// @return `0` if it isn't a size
+static uint64_t parse_size( const char* text ) {
+   char* end = NULL;
+   double value = strtod( text, &end );
+   double unit = 1024.0 * 1024;
+
+   switch( *end ) {
+      case 'K': case 'k':  unit = 1024.0;                        end++;  break;
+      case 'M': case 'm':  unit = 1024.0 * 1024;                 end++;  break;
+      case 'G': case 'g':  unit = 1024.0 * 1024 * 1024;          end++;  break;
+      case 'T': case 't':  unit = 1024.0 * 1024 * 1024 * 1024;   end++;  break;
+      default:  break;
+   }
+   if( end == text || (*end != '\0' && strcmp( end, "iB" ) != 0 && strcmp( end, "B" ) != 0) || value <= 0 ) {
+      return 0;
+   }
+   return (uint64_t) (value * unit);
+}
+
+
+/// Format a size like `256 MiB`, `1.5 GiB` or `16 GiB`
+static const char* format_size( uint64_t bytes, char* out, size_t size ) {
+   const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+   double value = (double) bytes;
+   int u = 0;
+
+   while( value >= 1024 && u < 4 ) {
+      value /= 1024;
+      u++;
+   }
+   snprintf( out, size, value == (double) (uint64_t) value ? "%.0f %s" : "%.1f %s", value, units[u] );
+   return out;
+}
+
+
+/// Format a time like `850 ms`, `12.4 s` or `3.2 min`
+static const char* format_time( double seconds, char* out, size_t size ) {
+   if( seconds < 1 ) {
+      snprintf( out, size, "%.0f ms", seconds * 1000 );
+   } else if( seconds < 120 ) {
+      snprintf( out, size, "%.1f s", seconds );
+   } else {
+      snprintf( out, size, "%.1f min", seconds / 60 );
+   }
+   return out;
+}
+
+
+/// `--sha256 [--size MIB] [--enclave SIZE]`
+int sha256_main( int argc, char* argv[] ) {
+   double   sizeMiB = 64;
+   uint64_t enclave = 0;
+   bool     usage = false;
+
+   for( int i = 1 ; i < argc && !usage ; i++ ) {
+      if( strcmp( argv[i], "--size" ) == 0 && i + 1 < argc ) {
+         sizeMiB = strtod( argv[++i], NULL );
+      } else if( strcmp( argv[i], "--enclave" ) == 0 && i + 1 < argc ) {
+         enclave = parse_size( argv[++i] );
+         usage = enclave == 0;
+      } else {
+         usage = true;
+      }
+   }
+   size_t size = (size_t) (sizeMiB * 1024 * 1024);
+   if( usage || size < TEST_PAGES * PAGE_SIZE ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " --sha256 [--size MIB] [--enclave SIZE]\n" );
+      fprintf( stderr, "  --size is at least 16 (MiB).  SIZE is like 512M or 6G.\n" );
+      return EXIT_FAILURE;
+   }
+
+   // What the CPU (and OS) support
+   uint32_t eax = 1, ebx = 0, ecx = 0, edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   bool ssse3   = field_from_regs( &fields[FIELD_SSSE3],   eax, ebx, ecx, edx );
+   bool sse4_1  = field_from_regs( &fields[FIELD_SSE4_1],  eax, ebx, ecx, edx );
+
+   eax = 7; ebx = 0; ecx = 0; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   bool sha = field_from_regs( &fields[FIELD_SHA], eax, ebx, ecx, edx );
+   bool avx2 = field_from_regs( &fields[FIELD_AVX2], eax, ebx, ecx, edx );
+
+   struct implementation implementations[] = {
+      { "generic", compress_generic, true, "" },
+      #if defined( __GNUC__ )
+         { "sha-ni",  compress_sha_ni,  sha && ssse3 && sse4_1, "The SHA extensions (CPUID.7.0:EBX[29])" },
+      #else
+         { "sha-ni",  NULL,             false,                 "GCC or Clang" },
+      #endif
+   };
+   enum { IMPLEMENTATIONS = sizeof( implementations ) / sizeof( implementations[0] ) };
+   struct timing timings[IMPLEMENTATIONS];
+   bool timed[IMPLEMENTATIONS] = { false };
+
+   uint8_t* buffer = malloc( size );
+   if( buffer == NULL ) {
+      fprintf( stderr, PROGRAM_NAME ": Out of memory\n" );
+      return EXIT_FAILURE;
+   }
+   uint64_t x = 0x9E3779B97F4A7C15;  // Fill it with xorshift64 noise, so every page is touched
+   for( size_t i = 0 ; i < size ; i++ ) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      buffer[i] = (uint8_t) x;
+   }
+
+   char text1[32];
+   char text2[32];
+   printf( "SHA-256 for enclave measurement (MRENCLAVE):  Best of %d over %.0f MiB, %d pages\n", RUNS, sizeMiB, TEST_PAGES );
+   printf( "  SHA extensions:  %s\n", sha ? "Yes" : "No" );
+   printf( "  AVX2:            %s\n", avx2 ? "Yes" : "No" );
+   printf( "  (AVX2 SHA-256 is multi-buffer.  MRENCLAVE is one serial hash that can't use it, so it isn't timed.)\n" );
+   printf( "    Implementation  GB/s    Measured page  EADD-only page  Needs\n" );
+   printf( "    ==============  ======  =============  ==============  =====\n" );
+
+   int best = -1;
+   for( int i = 0 ; i < IMPLEMENTATIONS ; i++ ) {
+      const struct implementation* impl = &implementations[i];
+      if( !impl->available ) {
+         printf( "    %-14s  %6s  %13s  %14s  %s (not here)\n", impl->name, "-", "-", "-", impl->needs );
+         continue;
+      }
+      if( !known_answer( impl->compress ) ) {
+         printf( "    %-14s  FAILED the known-answer test\n", impl->name );
+         continue;
+      }
+      time_implementation( impl->compress, buffer, size, &timings[i] );
+      timed[i] = true;
+      snprintf( text1, sizeof( text1 ), "%.2f us", timings[i].measuredPage * 1e6 );
+      snprintf( text2, sizeof( text2 ), "%.0f ns", timings[i].addedPage * 1e9 );
+      printf( "    %-14s  %6.2f  %13s  %14s  %s\n", impl->name, timings[i].bytesPerSecond / 1e9, text1, text2, impl->needs );
+      if( best < 0 || timings[i].measuredPage < timings[best].measuredPage ) {
+         best = i;
+      }
+   }
+   free( buffer );
+
+   if( best < 0 ) {
+      return EXIT_FAILURE;
+   }
+
+   // Predictions
+   uint64_t sizes[] = { 256ULL << 20, 1ULL << 30, 4ULL << 30, 16ULL << 30, enclave };
+   int sizeCount = enclave != 0 ? 5 : 4;
+
+   printf( "  Predicted measurement time (every page EEXTENDed, on one core):\n" );
+   printf( "    Enclave     " );
+   for( int i = 0 ; i < IMPLEMENTATIONS ; i++ ) {
+      if( timed[i] ) {
+         printf( "%-12s", implementations[i].name );
+      }
+   }
+   printf( "\n" );
+   for( int s = 0 ; s < sizeCount ; s++ ) {
+      uint64_t pages = (sizes[s] + PAGE_SIZE - 1) / PAGE_SIZE;
+      printf( "    %-10s  ", format_size( sizes[s], text2, sizeof( text2 ) ) );
+      for( int i = 0 ; i < IMPLEMENTATIONS ; i++ ) {
+         if( timed[i] ) {
+            printf( "%-12s", format_time( (double) pages * timings[i].measuredPage, text1, sizeof( text1 ) ) );
+         }
+      }
+      printf( "\n" );
+   }
+
+   printf( "The fastest here is %s.  Pages added without EEXTEND (heap, stack) cost %.0f ns each.\n"
+          ,implementations[best].name, timings[best].addedPage * 1e9 );
+   if( strcmp( implementations[best].name, "sha-ni" ) != 0 ) {
+      printf( "A CPU with the SHA extensions would sign large enclaves several times faster.\n" );
+   }
+   return EXIT_SUCCESS;
+}
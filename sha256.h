@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+//  sha256.h - 2026
+//
+/// This module benchmarks SHA-256 on this host to predict how long it takes
+/// to measure (compute MRENCLAVE for) an enclave of a given size.
+///
+/// @file   sha256.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+
+/// `--sha256 [--size MIB] [--enclave SIZE]`
+int sha256_main( int argc, char* argv[] );
@@ -0,0 +1,654 @@
+///////////////////////////////////////////////////////////////////////////////
+//  spsc.c - 2026
+//
+/// A reference lock-free single-producer/single-consumer ring, like the ones
+/// switchless ecalls & ocalls pass requests through, and a benchmark of it
+/// between pinned threads.
+///
+/// The ring is an array of cache-line slots.  Each slot has a sequence
+/// number that says whose turn it is:  The producer may fill slot `i` when
+/// its sequence is `i`, and publishes it by setting it to `i + 1`.  The
+/// consumer may read it when it's `i + 1`, and hands it back by setting it to
+/// `i + capacity` (the producer's next lap).  So the two threads never write
+/// the same line, except the slot being handed over, and there are no locked
+/// instructions.
+///
+/// How a thread waits for its turn is what decides the latency & the CPU a
+/// switchless worker burns while it's idle:
+///
+///   - `spin`:  Reload as fast as possible.  The lowest latency, but it
+///     starves an SMT sibling and the memory-order machine clear on exit
+///     costs a little.
+///   - `pause`:  A PAUSE between loads.  Kinder to the sibling & power, at
+///     the cost of up to one PAUSE (~40-140 cycles, by generation) of latency.
+///   - `umwait`:  UMONITOR the slot and UMWAIT in C0.1 until it's written (or
+///     a deadline passes).  Needs WAITPKG (CPUID.7.0:ECX[5]).  Wakes nearly as
+///     fast as `pause`, but the core idles while it waits.
+///   - `futex`:  Spin briefly with PAUSE, then sleep in the kernel.  The side
+///     that hands over a slot only makes the wake syscall when the other side
+///     said it was going to sleep.  No CPU while idle, but a wake costs
+///     microseconds.
+///
+/// `spsc_best_wait()` picks UMWAIT where CPUID reports WAITPKG, otherwise
+/// PAUSE.
+///
+/// The benchmark pins a producer (the caller) and a consumer (the worker) to
+/// two CPUs and measures, for each wait:
+///
+///   - Throughput:  Messages/s streamed one way through the ring
+///   - Round trip:  A request through one ring and the reply through another,
+///     like a switchless call.  The median & 99th percentile.
+///   - Worker CPU:  The share of the round-trip run the worker was on the
+///     CPU.  With `--gap US` the caller waits between calls, to see what an
+///     idle worker costs.
+///
+/// Usage:
+///
+///     test-sgx --spsc                        # The first two CPUs, every wait
+///     test-sgx --spsc --cpus 2,3 --wait umwait
+///     test-sgx --spsc --gap 50               # A call every 50 us
+///     test-sgx --spsc --wait futex --slots 2 --messages 10000000
+///                                            # Stress the futex hand-over
+///
+/// A small ring (`--slots 2`) makes both sides sleep and wake on nearly
+/// every message, which is where a lost wake would hang the benchmark.
+///
+/// @file   spsc.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+/// Enables declaration of `sched_setaffinity()`, `CPU_SET()` and `syscall()`
+///
+/// @NOLINTNEXTLINE(bugprone-reserved-identifier, cert-dcl37-c, cert-dcl51-cpp): This is a legitimate use of a reserved identifier
+#define _GNU_SOURCE
+
+#include <stdio.h>     // For printf() fprintf()
+#include <stdlib.h>    // For atol() aligned_alloc() malloc() free() qsort()
+#include <string.h>    // For strcmp() memcpy()
+#include <inttypes.h>  // For PRIu64 uint64_t uint32_t
+#include <stdbool.h>   // For bool
+#include <time.h>      // For clock_gettime()
+
+#ifdef __linux__
+   #include <sched.h>          // For sched_setaffinity() sched_getaffinity() CPU_SET()
+   #include <pthread.h>        // For pthread_create() pthread_join()
+   #include <unistd.h>         // For syscall()
+   #include <sys/syscall.h>    // For SYS_futex
+   #include <linux/futex.h>    // For FUTEX_WAIT_PRIVATE FUTEX_WAKE_PRIVATE
+#endif
+
+#include "spsc.h"      // For obvious reasons
+#include "cpuid.h"     // For native_cpuid32()
+#include "decode.h"    // For fields[] field_from_regs()
+#include "topology.h"  // For topology_online_cpus() topology_parse_cpulist() MAX_CPUS
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// SPSC_FUTEX spins this many PAUSEs before it sleeps
+#define FUTEX_SPINS 2000
+
+/// The longest UMWAIT (in TSC ticks) before the slot is checked again
+#define UMWAIT_TICKS 100000
+
+/// UMWAIT's control:  Bit 0 set asks for C0.1 (faster wake than C0.2)
+#define UMWAIT_C0_1 1
+
+/// The benchmark's ring size, unless `--slots` says otherwise
+#define BENCH_CAPACITY 256
+
+/// Messages to stream, unless `--messages` says otherwise.  The round trip
+/// runs a tenth as many calls.
+#define DEFAULT_MESSAGES 1000000
+
+/// Names for `enum spsc_wait`
+static const char* waitNames[SPSC_WAIT_COUNT] = { "spin", "pause", "umwait", "futex" };
+
+_Static_assert( sizeof( struct spsc_slot ) == 64, "A slot must be exactly one cache line" );
+
+
+/// @return The name of `wait`, like `umwait`
+const char* spsc_wait_name( enum spsc_wait wait ) {
+   return wait < SPSC_WAIT_COUNT ? waitNames[wait] : "unknown";
+}
+
+
+#ifdef __linux__
+
+/// @return `true` if CPUID reports WAITPKG (UMONITOR, UMWAIT & TPAUSE)
+static bool has_waitpkg( void ) {
+   uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   if( eax < 0x07 ) {
+      return false;
+   }
+   eax = 0x07; ebx = 0; ecx = 0; edx = 0;
+   native_cpuid32( &eax, &ebx, &ecx, &edx );
+   return field_from_regs( &fields[FIELD_WAITPKG], eax, ebx, ecx, edx ) != 0;
+}
+
+
+/// @return `true` if this CPU can use `wait`
+bool spsc_wait_supported( enum spsc_wait wait ) {
+   switch( wait ) {
+      case SPSC_SPIN:
+      case SPSC_PAUSE:
+      case SPSC_FUTEX:
+         return true;
+      case SPSC_UMWAIT:
+         return has_waitpkg();
+      default:
+         return false;
+   }
+}
+
+
+/// @return The wait that suits this host best:  UMWAIT where CPUID reports
+///         WAITPKG, PAUSE everywhere else
+enum spsc_wait spsc_best_wait( void ) {
+   return has_waitpkg() ? SPSC_UMWAIT : SPSC_PAUSE;
+}
+
+
+/// Set up `ring` with `capacity` slots (a power of 2, at least 2)
+///
+/// @return `false` if `capacity` is 1 or isn't a power of 2, `wait` isn't
+///         supported on this CPU or there's no memory
+bool spsc_init( struct spsc_ring* ring, uint32_t capacity, enum spsc_wait wait ) {
+   if( capacity < 2 || (capacity & (capacity - 1)) != 0 || capacity > ((uint32_t) 1 << 31) || !spsc_wait_supported( wait ) ) {
+      return false;
+   }
+
+   ring->slots = aligned_alloc( sizeof( struct spsc_slot ), (size_t) capacity * sizeof( struct spsc_slot ) );
+   if( ring->slots == NULL ) {
+      return false;
+   }
+   for( uint32_t i = 0 ; i < capacity ; i++ ) {
+      ring->slots[i].seq = i;
+      ring->slots[i].length = 0;
+   }
+   ring->mask = capacity - 1;
+   ring->wait = wait;
+   ring->head = 0;
+   ring->tail = 0;
+   ring->producerSleeping = 0;
+   ring->consumerSleeping = 0;
+   return true;
+}
+
+
+/// Free the ring's slots
+void spsc_free( struct spsc_ring* ring ) {
+   free( ring->slots );
+   ring->slots = NULL;
+}
+
+
+/// PAUSE:  Tell the core we're spinning (yields to the SMT sibling and avoids
+/// the memory-order machine clear when the spin ends)
+static inline void cpu_pause( void ) {
+   __asm__ volatile ( "pause" ::: "memory" );
+}
+
+/// @return The time stamp counter
+static inline uint64_t read_tsc( void ) {
+   uint32_t lo, hi;
+   __asm__ volatile ( "rdtsc" : "=a" (lo), "=d" (hi) );
+   return (uint64_t) hi << 32 | lo;
+}
+
+
+/// Wait until `*seq == want`, the way `ring->wait` says.  `sleeping` is the
+/// waiting side's futex flag.
+static void wait_for( const struct spsc_ring* ring, uint32_t* seq, uint32_t want, uint32_t* sleeping ) {
+   switch( ring->wait ) {
+      case SPSC_SPIN:
+         while( __atomic_load_n( seq, __ATOMIC_ACQUIRE ) != want ) {
+         }
+         break;
+
+      case SPSC_PAUSE:
+         while( __atomic_load_n( seq, __ATOMIC_ACQUIRE ) != want ) {
+            cpu_pause();
+         }
+         break;
+
+      case SPSC_UMWAIT:
+         while( __atomic_load_n( seq, __ATOMIC_ACQUIRE ) != want ) {
+            __asm__ volatile ( "umonitor %0" :: "r" (seq) : "memory" );
+            if( __atomic_load_n( seq, __ATOMIC_ACQUIRE ) == want ) {  // Written before the monitor was armed
+               break;
+            }
+            uint64_t deadline = read_tsc() + UMWAIT_TICKS;
+            __asm__ volatile ( "umwait %0" :: "r" ((uint32_t) UMWAIT_C0_1), "a" ((uint32_t) deadline), "d" ((uint32_t) (deadline >> 32)) : "memory", "cc" );
+         }
+         break;
+
+      case SPSC_FUTEX:
+         for( int spins = 0 ; spins < FUTEX_SPINS ; spins++ ) {
+            if( __atomic_load_n( seq, __ATOMIC_ACQUIRE ) == want ) {
+               return;
+            }
+            cpu_pause();
+         }
+         for( ;; ) {
+            // Say we're going to sleep, then check again -- the other side
+            // stores the slot, then checks the flag (both with full fences),
+            // so one of us sees the other
+            __atomic_store_n( sleeping, 1, __ATOMIC_SEQ_CST );
+            uint32_t seen = __atomic_load_n( seq, __ATOMIC_SEQ_CST );
+            if( seen == want ) {
+               break;
+            }
+            syscall( SYS_futex, seq, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0 );
+         }
+         // Only the sleeper clears its flag.  If the waker cleared it, a late
+         // clear could wipe the flag of our next sleep (on the next slot),
+         // and that slot would be published without a wake.
+         __atomic_store_n( sleeping, 0, __ATOMIC_SEQ_CST );
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+/// Publish `value` in `*seq` and, for SPSC_FUTEX, wake the other side if
+/// it's asleep.  The flag is left for the sleeper to clear, so a wake may be
+/// spare, but never missing.
+static void hand_over( const struct spsc_ring* ring, uint32_t* seq, uint32_t value, uint32_t* sleeping ) {
+   if( ring->wait != SPSC_FUTEX ) {
+      __atomic_store_n( seq, value, __ATOMIC_RELEASE );
+      return;
+   }
+   __atomic_store_n( seq, value, __ATOMIC_SEQ_CST );
+   if( __atomic_load_n( sleeping, __ATOMIC_SEQ_CST ) != 0 ) {
+      syscall( SYS_futex, seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+   }
+}
+
+
+/// Fill the producer's slot and hand it to the consumer
+static void fill( struct spsc_ring* ring, struct spsc_slot* slot, const void* message, uint32_t length ) {
+   length = length < SPSC_MESSAGE_SIZE ? length : SPSC_MESSAGE_SIZE;
+   memcpy( slot->message, message, length );
+   slot->length = length;
+   hand_over( ring, &slot->seq, ring->head + 1, &ring->consumerSleeping );
+   ring->head++;
+}
+
+
+/// Push a message (up to `SPSC_MESSAGE_SIZE` bytes) without waiting
+///
+/// @return `false` if the ring is full
+bool spsc_try_push( struct spsc_ring* ring, const void* message, uint32_t length ) {
+   struct spsc_slot* slot = &ring->slots[ring->head & ring->mask];
+
+   if( __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE ) != ring->head ) {
+      return false;
+   }
+   fill( ring, slot, message, length );
+   return true;
+}
+
+
+/// Push a message, waiting for a free slot
+void spsc_push( struct spsc_ring* ring, const void* message, uint32_t length ) {
+   struct spsc_slot* slot = &ring->slots[ring->head & ring->mask];
+
+   wait_for( ring, &slot->seq, ring->head, &ring->producerSleeping );
+   fill( ring, slot, message, length );
+}
+
+
+/// Copy the consumer's slot out and hand it back to the producer
+///
+/// @return The message's length
+static int drain( struct spsc_ring* ring, struct spsc_slot* slot, void* message ) {
+   uint32_t length = slot->length;
+
+   memcpy( message, slot->message, length );
+   hand_over( ring, &slot->seq, ring->tail + ring->mask + 1, &ring->producerSleeping );
+   ring->tail++;
+   return (int) length;
+}
+
+
+/// Pop a message into `message` (which holds `SPSC_MESSAGE_SIZE` bytes)
+/// without waiting
+///
+/// @return The message's length, or `-1` if the ring is empty
+int spsc_try_pop( struct spsc_ring* ring, void* message ) {
+   struct spsc_slot* slot = &ring->slots[ring->tail & ring->mask];
+
+   if( __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE ) != ring->tail + 1 ) {
+      return -1;
+   }
+   return drain( ring, slot, message );
+}
+
+
+/// Pop a message into `message`, waiting for one
+///
+/// @return The message's length
+int spsc_pop( struct spsc_ring* ring, void* message ) {
+   struct spsc_slot* slot = &ring->slots[ring->tail & ring->mask];
+
+   wait_for( ring, &slot->seq, ring->tail + 1, &ring->consumerSleeping );
+   return drain( ring, slot, message );
+}
+
+
+/// @return The time in seconds from a monotonic clock
+static double now_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_MONOTONIC, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// @return The CPU time (seconds) the calling thread has used
+static double thread_seconds( void ) {
+   struct timespec now;
+   clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now );
+   return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+
+/// Pin the calling thread to `cpu`
+static void pin_to( int cpu ) {
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   sched_setaffinity( 0, sizeof( set ), &set );
+}
+
+
+/// What the worker thread does, and what it found
+struct worker {
+   struct spsc_ring* requests;
+   struct spsc_ring* replies;    ///< `NULL` to just drain `requests`
+   int               cpu;
+   uint64_t          count;
+   uint64_t          sum;        ///< Of the streamed messages, to check them
+   double            cpuSeconds;
+};
+
+
+/// The worker:  Pop `count` messages, replying to each if there's a reply
+/// ring
+static void* worker_main( void* arg ) {
+   struct worker* w = arg;
+   uint8_t message[SPSC_MESSAGE_SIZE];
+   uint64_t value;
+
+   pin_to( w->cpu );
+   double start = thread_seconds();
+   for( uint64_t i = 0 ; i < w->count ; i++ ) {
+      spsc_pop( w->requests, message );
+      if( w->replies != NULL ) {
+         spsc_push( w->replies, message, sizeof( value ) );
+      } else {
+         memcpy( &value, message, sizeof( value ) );
+         w->sum += value;
+      }
+   }
+   w->cpuSeconds = thread_seconds() - start;
+   return NULL;
+}
+
+
+/// Busy-wait `seconds` (the caller's think time between calls)
+static void think( double seconds ) {
+   if( seconds > 0 ) {
+      double until = now_seconds() + seconds;
+      while( now_seconds() < until ) {
+         cpu_pause();
+      }
+   }
+}
+
+
+static int compare_doubles( const void* left, const void* right ) {
+   double l = *(const double*) left;
+   double r = *(const double*) right;
+   return (l > r) - (l < r);
+}
+
+
+/// The results for one wait
+struct result {
+   double messagesPerSecond;
+   double medianNs;
+   double p99Ns;
+   double workerBusy;  ///< 0 - 1
+};
+
+
+/// Stream `messages` one way from this thread to a worker on `workerCPU`
+///
+/// @return `false` if it couldn't be run (or the messages came out wrong)
+static bool measure_throughput( struct spsc_ring* ring, int workerCPU, uint64_t messages, struct result* result ) {
+   struct worker w = { .requests = ring, .replies = NULL, .cpu = workerCPU, .count = messages };
+   pthread_t thread;
+
+   if( pthread_create( &thread, NULL, worker_main, &w ) != 0 ) {
+      return false;
+   }
+   double start = now_seconds();
+   for( uint64_t i = 0 ; i < messages ; i++ ) {
+      spsc_push( ring, &i, sizeof( i ) );
+   }
+   pthread_join( thread, NULL );
+   result->messagesPerSecond = (double) messages / (now_seconds() - start);
+
+   if( w.sum != messages * (messages - 1) / 2 ) {
+      fprintf( stderr, "spsc: The %s ring lost or mangled messages\n", spsc_wait_name( ring->wait ) );
+      return false;
+   }
+   return true;
+}
+
+
+/// Make `calls` round trips (a request through `requests` and the reply
+/// through `replies`) to a worker on `workerCPU`, `gap` seconds apart
+///
+/// @return `false` if it couldn't be run
+static bool measure_round_trips( struct spsc_ring* requests, struct spsc_ring* replies, int workerCPU, uint64_t calls, double gap, struct result* result ) {
+   struct worker w = { .requests = requests, .replies = replies, .cpu = workerCPU, .count = calls };
+   uint8_t reply[SPSC_MESSAGE_SIZE];
+   pthread_t thread;
+
+   double* ns = malloc( calls * sizeof( double ) );
+   if( ns == NULL ) {
+      return false;
+   }
+   if( pthread_create( &thread, NULL, worker_main, &w ) != 0 ) {
+      free( ns );
+      return false;
+   }
+
+   double start = now_seconds();
+   for( uint64_t i = 0 ; i < calls ; i++ ) {
+      struct timespec before, after;
+      clock_gettime( CLOCK_MONOTONIC, &before );
+      spsc_push( requests, &i, sizeof( i ) );
+      spsc_pop( replies, reply );
+      clock_gettime( CLOCK_MONOTONIC, &after );
+      ns[i] = (double) (after.tv_sec - before.tv_sec) * 1e9 + (double) (after.tv_nsec - before.tv_nsec);
+      think( gap );
+   }
+   pthread_join( thread, NULL );
+   double elapsed = now_seconds() - start;
+
+   qsort( ns, calls, sizeof( double ), compare_doubles );
+   result->medianNs = ns[calls / 2];
+   result->p99Ns = ns[calls * 99 / 100];
+   result->workerBusy = w.cpuSeconds / elapsed;
+   free( ns );
+   return true;
+}
+
+
+/// Benchmark `wait` between this thread (on `callerCPU`) and a worker on
+/// `workerCPU`
+///
+/// @return `false` if it couldn't be run (or the messages came out wrong)
+static bool run_benchmark( enum spsc_wait wait, uint32_t capacity, int callerCPU, int workerCPU, uint64_t messages, double gap, struct result* result ) {
+   struct spsc_ring requests;
+   struct spsc_ring replies;
+   uint64_t calls = messages / 10 > 0 ? messages / 10 : 1;
+
+   if( !spsc_init( &requests, capacity, wait ) ) {
+      return false;
+   }
+   if( !spsc_init( &replies, capacity, wait ) ) {
+      spsc_free( &requests );
+      return false;
+   }
+
+   pin_to( callerCPU );
+   bool ok = measure_throughput( &requests, workerCPU, messages, result )
+          && measure_round_trips( &requests, &replies, workerCPU, calls, gap, result );
+
+   spsc_free( &requests );
+   spsc_free( &replies );
+   return ok;
+}
+
+#endif
+
+
+/// `--spsc [--cpus A,B] [--wait NAME] [--messages N] [--gap US] [--slots N]`
+int spsc_main( int argc, char* argv[] ) {
+   const char* cpuList = NULL;
+   const char* waitName = NULL;
+   long messages = DEFAULT_MESSAGES;
+   long gapUs = 0;
+   long slots = BENCH_CAPACITY;
+
+   for( int i = 1 ; i < argc ; i++ ) {
+      if( strcmp( argv[i], "--cpus" ) == 0 && i + 1 < argc ) {
+         cpuList = argv[++i];
+      } else if( strcmp( argv[i], "--wait" ) == 0 && i + 1 < argc ) {
+         waitName = argv[++i];
+      } else if( strcmp( argv[i], "--messages" ) == 0 && i + 1 < argc ) {
+         messages = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--gap" ) == 0 && i + 1 < argc ) {
+         gapUs = atol( argv[++i] );
+      } else if( strcmp( argv[i], "--slots" ) == 0 && i + 1 < argc ) {
+         slots = atol( argv[++i] );
+      } else {
+         fprintf( stderr, "Usage: " PROGRAM_NAME " --spsc [--cpus A,B] [--wait spin|pause|umwait|futex] [--messages N] [--gap US] [--slots N]\n" );
+         return EXIT_FAILURE;
+      }
+   }
+   if( messages <= 0 || gapUs < 0 ) {
+      fprintf( stderr, "spsc: The number of messages must be positive and the gap can't be negative\n" );
+      return EXIT_FAILURE;
+   }
+   if( slots < 2 || slots > 65536 || (slots & (slots - 1)) != 0 ) {
+      fprintf( stderr, "spsc: --slots takes a power of 2 from 2 to 65536\n" );
+      return EXIT_FAILURE;
+   }
+
+   #ifdef __linux__
+      static int cpus[MAX_CPUS];
+      cpu_set_t allowed;
+      int count = 0;
+      int only = -1;
+
+      if( waitName != NULL ) {
+         for( int w = 0 ; w < SPSC_WAIT_COUNT ; w++ ) {
+            only = strcmp( waitName, waitNames[w] ) == 0 ? w : only;
+         }
+         if( only < 0 ) {
+            fprintf( stderr, "spsc: [%s] isn't a wait.  Use spin, pause, umwait or futex\n", waitName );
+            return EXIT_FAILURE;
+         }
+         if( !spsc_wait_supported( (enum spsc_wait) only ) ) {
+            fprintf( stderr, "spsc: This CPU doesn't support %s (CPUID doesn't report WAITPKG)\n", waitName );
+            return EXIT_FAILURE;
+         }
+      }
+
+      if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) {
+         fprintf( stderr, "spsc: Unable to read this process's CPU affinity\n" );
+         return EXIT_FAILURE;
+      }
+      if( cpuList != NULL ) {
+         count = topology_parse_cpulist( cpuList, cpus, MAX_CPUS );
+         if( count != 2 || cpus[0] == cpus[1] ) {
+            fprintf( stderr, "spsc: --cpus takes two different CPUs, like 2,3\n" );
+            return EXIT_FAILURE;
+         }
+         for( int i = 0 ; i < count ; i++ ) {
+            if( cpus[i] >= CPU_SETSIZE || !CPU_ISSET( cpus[i], &allowed ) ) {
+               fprintf( stderr, "spsc: CPU %d isn't online or available to this process\n", cpus[i] );
+               return EXIT_FAILURE;
+            }
+         }
+      } else {
+         int online = topology_online_cpus( cpus, MAX_CPUS );
+         for( int i = 0 ; i < online && count < 2 ; i++ ) {
+            if( cpus[i] < CPU_SETSIZE && CPU_ISSET( cpus[i], &allowed ) ) {
+               cpus[count++] = cpus[i];
+            }
+         }
+         if( count < 2 ) {
+            fprintf( stderr, "spsc: The benchmark needs two CPUs (a spinning worker would starve the caller)\n" );
+            return EXIT_FAILURE;
+         }
+      }
+
+      bool waitpkg = spsc_wait_supported( SPSC_UMWAIT );
+      printf( "SPSC ring (switchless call) benchmark:  Caller on CPU %d, worker on CPU %d\n", cpus[0], cpus[1] );
+      printf( "  %ld-slot ring of %zu-byte slots, %ld messages streamed, %ld round trips", slots, sizeof( struct spsc_slot ), messages, messages / 10 > 0 ? messages / 10 : 1 );
+      if( gapUs > 0 ) {
+         printf( " %ld us apart", gapUs );
+      }
+      printf( "\n" );
+      if( !waitpkg ) {
+         printf( "  CPUID doesn't report WAITPKG, so umwait is skipped\n" );
+      }
+
+      printf( "    Wait     Throughput  Round trip  Round trip  Worker\n" );
+      printf( "                 Mmsg/s   median ns      p99 ns     CPU\n" );
+      printf( "    =======  ==========  ==========  ==========  ======\n" );
+
+      enum spsc_wait best = spsc_best_wait();
+      double bestMedian = 0;
+      bool failed = false;
+      for( int w = 0 ; w < SPSC_WAIT_COUNT ; w++ ) {
+         struct result result = { 0 };
+         if( (only >= 0 && w != only) || !spsc_wait_supported( (enum spsc_wait) w ) ) {
+            continue;
+         }
+         fflush( stdout );
+         if( !run_benchmark( (enum spsc_wait) w, (uint32_t) slots, cpus[0], cpus[1], (uint64_t) messages, (double) gapUs / 1e6, &result ) ) {
+            printf( "    %-7s  failed\n", waitNames[w] );
+            failed = true;
+            continue;
+         }
+         printf( "    %-7s  %10.1f  %10.0f  %10.0f  %5.0f%%\n", waitNames[w], result.messagesPerSecond / 1e6, result.medianNs, result.p99Ns, result.workerBusy * 100 );
+         if( w == (int) best ) {
+            bestMedian = result.medianNs;
+         }
+      }
+
+      printf( "  Best wait for this host:  %s (%s)\n", spsc_wait_name( best ), waitpkg ? "CPUID reports WAITPKG" : "no WAITPKG" );
+      if( bestMedian > 0 ) {
+         printf( "  With %s, one worker answers about %.0f calls/s back to back.  Size the pool\n", spsc_wait_name( best ), 1e9 / bestMedian );
+         printf( "  at the peak ocall rate divided by that, plus headroom for the work itself.\n" );
+      }
+      return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+   #else
+      (void) cpuList;
+      (void) waitName;
+      (void) slots;
+      printf( "The SPSC ring benchmark needs Linux\n" );
+      return EXIT_FAILURE;
+   #endif
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+//  spsc.h - 2026
+//
+/// A reference lock-free single-producer/single-consumer ring, like the ones
+/// switchless ecalls & ocalls pass requests through, and a benchmark of it
+/// between pinned threads.
+///
+/// @file   spsc.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stdbool.h>  // For bool
+#include <stdint.h>   // For uint32_t uint8_t
+
+
+/// The most bytes a message can hold (a slot is one cache line)
+#define SPSC_MESSAGE_SIZE 56
+
+
+/// How a side of the ring waits for the other
+enum spsc_wait {
+   SPSC_SPIN,    ///< Reload the slot as fast as possible
+   SPSC_PAUSE,   ///< Reload the slot with a PAUSE between loads
+   SPSC_UMWAIT,  ///< UMONITOR the slot and UMWAIT (C0.1) until it's written
+   SPSC_FUTEX,   ///< Spin briefly, then sleep in the kernel until woken
+   SPSC_WAIT_COUNT
+};
+
+/// One slot:  A whole cache line, so the producer & consumer only share the
+/// line that's being handed over
+struct spsc_slot {
+   _Alignas( 64 ) uint32_t seq;  ///< The position this slot is ready for
+   uint32_t length;
+   uint8_t  message[SPSC_MESSAGE_SIZE];
+};
+
+/// The ring.  `head` and `tail` are each only touched by one side, and each
+/// side's futex flag only by the other, so each gets a line of its own.
+struct spsc_ring {
+   struct spsc_slot* slots;
+   uint32_t          mask;                    ///< Capacity - 1
+   enum spsc_wait    wait;
+   _Alignas( 64 ) uint32_t head;              ///< The producer's next position
+   _Alignas( 64 ) uint32_t tail;              ///< The consumer's next position
+   _Alignas( 64 ) uint32_t producerSleeping;  ///< SPSC_FUTEX:  The producer may be asleep
+   _Alignas( 64 ) uint32_t consumerSleeping;  ///< SPSC_FUTEX:  The consumer may be asleep
+};
+
+
+#ifdef __linux__  // The ring is built on Linux's futexes (see spsc.c)
+
+/// Set up `ring` with `capacity` slots (a power of 2, at least 2)
+///
+/// @return `false` if `capacity` is 1 or isn't a power of 2, `wait` isn't
+///         supported on this CPU or there's no memory
+bool spsc_init( struct spsc_ring* ring, uint32_t capacity, enum spsc_wait wait );
+
+/// Free the ring's slots
+void spsc_free( struct spsc_ring* ring );
+
+/// Push a message (up to `SPSC_MESSAGE_SIZE` bytes) without waiting
+///
+/// @return `false` if the ring is full
+bool spsc_try_push( struct spsc_ring* ring, const void* message, uint32_t length );
+
+/// Push a message, waiting for a free slot
+void spsc_push( struct spsc_ring* ring, const void* message, uint32_t length );
+
+/// Pop a message into `message` (which holds `SPSC_MESSAGE_SIZE` bytes)
+/// without waiting
+///
+/// @return The message's length, or `-1` if the ring is empty
+int spsc_try_pop( struct spsc_ring* ring, void* message );
+
+/// Pop a message into `message`, waiting for one
+///
+/// @return The message's length
+int spsc_pop( struct spsc_ring* ring, void* message );
+
+/// @return `true` if this CPU can use `wait`
+bool spsc_wait_supported( enum spsc_wait wait );
+
+/// @return The wait that suits this host best:  UMWAIT where CPUID reports
+///         WAITPKG, PAUSE everywhere else
+enum spsc_wait spsc_best_wait( void );
+
+#endif  // __linux__
+
+/// @return The name of `wait`, like `umwait`
+const char* spsc_wait_name( enum spsc_wait wait );
+
+/// `--spsc [--cpus A,B] [--wait NAME] [--messages N] [--gap US] [--slots N]`
+int spsc_main( int argc, char* argv[] );
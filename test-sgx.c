@@ -130,14 +130,38 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>     // For printf()
+#include <string.h>    // For strcmp()
 #include <inttypes.h>  // For PRIx64 uint64_t PRIx32 uint32_t
 #include <time.h>      // For fetching timestamps
 
 #include "test-sgx.h"  // For obvious reasons
-#include "cpuid.h"     // For native_cpuid32()
-#include "rdmsr.h"     // For checkCapabilities()
-#include "vdso.h"      // For dump_vDSO()
+#include "cpuid.h"     // For native_cpuid32() cpuid_use_capture()
+#include "rdmsr.h"     // For checkCapabilities() read_SGX_MSRs() rdmsr_use_capture()
+#include "vdso.h"      // For dump_vDSO() vdso_main()
 #include "xsave.h"     // For print_XSAVE_enumeration()
+#include "capture.h"   // For capture_main()
+#include "fleet.h"     // For fleet_main()
+#include "isa.h"       // For isa_main()
+#include "cgroup.h"    // For cgroup_main()
+#include "planner.h"   // For planner_main()
+#include "cache.h"     // For cache_probe() cache_main()
+#include "freq.h"      // For freq_main()
+#include "energy.h"    // For energy_main()
+#include "membench.h"  // For membench_main()
+#include "amx.h"       // For amx_main()
+#include "cpuidtab.h"  // For cpuidtab_main()
+#include "c2c.h"       // For c2c_main()
+#include "spsc.h"      // For spsc_main()
+#include "mitigations.h"  // For mitigations_main()
+#include "irq.h"          // For irq_main()
+#include "attach.h"       // For attach_main()
+#include "placement.h"    // For placement_main()
+#include "clockpage.h"    // For clockpage_main()
+#include "epcmon.h"       // For epcmon_main()
+#include "metrics.h"      // For metrics_main()
+#include "avx512.h"       // For avx512_main()
+#include "epcsim.h"       // For epcsim_main()
+#include "sha256.h"       // For sha256_main()
 
 // Prove the compiler regognizes SGX instructions
 void sgxInstruction( void ) {
@@ -150,7 +174,62 @@ void sgxInstruction( void ) {
 }
 
 
-int main( void ) {
+/// The optional modes test-sgx can run in.  Each mode gets the command line
+/// starting at its own option (so `argv[0]` is the option).  With no
+/// arguments, test-sgx prints its usual SGX enumeration.
+static const struct mode {
+   const char* option;
+   int (*main)( int argc, char* argv[] );
+   const char* usage;
+} modes[] = {
+   { "--capture", capture_main, "[FILE] [NODE]                            Save this node's raw CPUID/XCR0/MSR values" },
+   { "--fleet",   fleet_main,   "[--query EXPR]... [--list] [--readme] FILE...  Aggregate captures from many nodes" },
+   { "--isa",     isa_main,     "[--from CAPTURE] [--header FILE]           Advise the widest vector ISA safe in an enclave" },
+   { "--amx",        amx_main,     "[--from CAPTURE] [--nssa N]           Report AMX readiness & SSA cost for enclaves" },
+   { "--avx512-usage", avx512_main, "[--proc DIR] [--recent MS] [--all]  Find enclave hosts that never use AVX-512 (to shrink XFRM)" },
+   { "--cpuid-header", cpuidtab_main, "[--from CAPTURE] FILE              Write a CPUID/XGETBV lookup header for enclaves" },
+   { "--epc-cgroup", cgroup_main, "[--root DIR] [--from CAPTURE] [--all]  Report EPC usage & limits per cgroup" },
+   { "--epc-monitor", epcmon_main,  "[--sys DIR] [--proc DIR] [--cgroup DIR] [--interval MS] [--count N]  Alert when ksgxd starts reclaiming EPC" },
+   { "--cache",      cache_main,   "[--clear]                             Show (or delete) the probe cache" },
+   { "--metrics",    metrics_main, "[--from CAPTURE] [--interval SECONDS] FILE  Write SGX state as OpenMetrics for node_exporter" },
+   { "--freq",       freq_main,    "[--cpus LIST] [--interval MS] [--count N] [--source perf|msr|status]  Sample effective CPU frequency" },
+   { "--energy",     energy_main,  "[--interval MS] -- COMMAND [ARG]...  Meter the RAPL energy a command uses" },
+   { "--c2c",        c2c_main,     "[--cpus LIST] [--pairs N]             Measure core-to-core latency to pair switchless threads" },
+   { "--spsc",       spsc_main,    "[--cpus A,B] [--wait NAME] [--messages N] [--gap US] [--slots N]  Benchmark a switchless-call ring" },
+   { "--mitigations", mitigations_main, "[--iterations N]                Report mitigations & time the host's transition paths" },
+   { "--irq",         irq_main,         "[--cpus LIST] [--interval MS] [--count N]  Estimate AEXs/s from interrupt rates" },
+   { "--attach",      attach_main,      "PID [--interval MS] [--count N]  Count faults, switches, migrations & IPC per thread of a process" },
+   { "--placement",   placement_main,   "[--threads N] [--workers N]      Recommend CPU sets for enclave threads, switchless workers & housekeeping" },
+   { "--clock-page",  clockpage_main,   "[--cpus A,B] [--rate HZ] [--reads N]  Compare an exitless clock page with vDSO clock_gettime" },
+   { "--membench",   membench_main, "[--huge] [--node N] [--max MIB]     Measure memory latency & bandwidth up to the EPC size" },
+   { "--vdso",       vdso_main,    "[--dump FILE] [--symbols] [IMAGE]...  Check vDSO images for __vdso_sgx_enter_enclave" },
+   { "--epc-plan",   planner_main, "[--from CAPTURE] MANIFEST...         Bin-pack enclaves onto the EPC sections" },
+   { "--epc-sim",    epcsim_main,  "[--from CAPTURE] [--epc MIB] [--eldu-us US] [--ewb-us US] TRACE  Predict EPC paging from a page-access trace" },
+   { "--sha256",     sha256_main,  "[--size MIB] [--enclave SIZE]        Time SHA-256 to predict how long measuring an enclave takes" },
+};
+
+
+/// Print the modes test-sgx supports
+static void print_usage( void ) {
+   printf( "Usage: " PROGRAM_NAME "                 Enumerate SGX on this node\n" );
+   for( size_t i = 0 ; i < sizeof( modes ) / sizeof( modes[0] ) ; i++ ) {
+      printf( "       " PROGRAM_NAME " %s %s\n", modes[i].option, modes[i].usage );
+   }
+}
+
+
+int main( int argc, char* argv[] ) {
+   if( argc > 1 ) {
+      for( size_t i = 0 ; i < sizeof( modes ) / sizeof( modes[0] ) ; i++ ) {
+         if( strcmp( argv[1], modes[i].option ) == 0 ) {
+            return modes[i].main( argc - 1, argv + 1 );
+         }
+      }
+
+      print_usage();
+      return strcmp( argv[1], "--help" ) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+   }
+
    // Get current timestamp
    time_t timestamp;
    time(&timestamp);
@@ -158,6 +237,14 @@ int main( void ) {
    // Print program info
    printf( "Start " PROGRAM_NAME " (version %d.%d.%d) at %s\n", PROGRAM_VERSION_MAJOR, PROGRAM_VERSION_MINOR, PROGRAM_VERSION_PATCH, ctime(&timestamp) );
 
+   // CPUID & the SGX MSRs come from the probe cache when it's valid
+   static struct sgx_capture cap;  // Too big for the stack
+   bool haveMSRs = cache_probe( &cap, true );
+   cpuid_use_capture( &cap );
+   if( haveMSRs ) {
+      rdmsr_use_capture( &cap );
+   }
+
    doesCPUIDwork();
    isIntelCPU();
    printCPUBrandString();
@@ -165,7 +252,8 @@ int main( void ) {
    enumerateEPCsections();
    dump_vDSO();
 
-   if( checkCapabilities() ) {
+   // checkCapabilities() says why not here, like it always has
+   if( haveMSRs || checkCapabilities() ) {
       read_SGX_MSRs();
    }
 
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//  topology.c - 2026
+//
+/// This module reads which CPUs are online (and which package they're in) and
+/// parses and formats CPU lists like `0-3,8,10-11`.
+///
+/// @file   topology.c
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>     // For fopen() fgets() fscanf() snprintf()
+#include <stdlib.h>    // For strtol() qsort()
+#include <ctype.h>     // For isspace()
+
+#include "topology.h"  // For obvious reasons
+
+
+/// Parse a CPU list like `0-3,8,10-11` (the format the kernel uses in sysfs)
+///
+/// @return The number of CPUs in `cpus`, or `-1` if `text` isn't a CPU list
+int topology_parse_cpulist( const char* text, int* cpus, int max ) {
+   int count = 0;
+   const char* p = text;
+
+   while( *p != '\0' && !isspace( (unsigned char) *p ) ) {
+      char* end = NULL;
+      long first = strtol( p, &end, 10 );
+      long last = first;
+
+      if( end == p || first < 0 ) {
+         return -1;
+      }
+      p = end;
+      if( *p == '-' ) {
+         p++;
+         last = strtol( p, &end, 10 );
+         if( end == p || last < first ) {
+            return -1;
+         }
+         p = end;
+      }
+
+      for( long cpu = first ; cpu <= last && count < max ; cpu++ ) {
+         cpus[count++] = (int) cpu;
+      }
+
+      if( *p == ',' ) {
+         p++;
+      } else if( *p != '\0' && !isspace( (unsigned char) *p ) ) {
+         return -1;
+      }
+   }
+
+   return count;
+}
+
+
+/// Read the CPUs that are online (`/sys/devices/system/cpu/online`)
+///
+/// @return The number of CPUs in `cpus`.  At least CPU 0.
+int topology_online_cpus( int* cpus, int max ) {
+   char line[4096];
+   int count = -1;
+
+   FILE* file = fopen( "/sys/devices/system/cpu/online", "r" );
+   if( file != NULL ) {
+      if( fgets( line, sizeof( line ), file ) != NULL ) {
+         count = topology_parse_cpulist( line, cpus, max );
+      }
+      fclose( file );
+   }
+
+   if( count <= 0 ) {  // Not Linux (or no sysfs):  Assume CPU 0
+      cpus[0] = 0;
+      count = 1;
+   }
+   return count;
+}
+
+
+/// Read the physical package (socket) a CPU is in
+/// (`/sys/devices/system/cpu/cpuN/topology/physical_package_id`)
+///
+/// @return The package ID, or `0` if sysfs doesn't say
+int topology_package_of( int cpu ) {
+   char path[128];
+   int  package = 0;
+
+   snprintf( path, sizeof( path ), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu );
+   FILE* file = fopen( path, "r" );
+   if( file != NULL ) {
+      if( fscanf( file, "%d", &package ) != 1 || package < 0 ) {
+         package = 0;
+      }
+      fclose( file );
+   }
+   return package;
+}
+
+
+/// Compare two CPU numbers for `qsort()`
+static int compare_cpus( const void* left, const void* right ) {
+   return *(const int*) left - *(const int*) right;
+}
+
+
+/// Format CPUs as a CPU list like `0-3,8,10-11`.  `cpus` is sorted in place.
+///
+/// @return `out`, or `-` if there are no CPUs
+const char* topology_format_cpulist( int* cpus, int count, char* out, size_t size ) {
+   size_t used = 0;
+
+   snprintf( out, size, "-" );
+   qsort( cpus, (size_t) count, sizeof( cpus[0] ), compare_cpus );
+   for( int i = 0 ; i < count && used < size ; ) {
+      int last = i;
+      while( last + 1 < count && cpus[last + 1] <= cpus[last] + 1 ) {
+         last++;
+      }
+      int written = cpus[last] == cpus[i] ? snprintf( out + used, size - used, "%s%d", used > 0 ? "," : "", cpus[i] )
+                                          : snprintf( out + used, size - used, "%s%d-%d", used > 0 ? "," : "", cpus[i], cpus[last] );
+      used += written > 0 ? (size_t) written : 0;
+      i = last + 1;
+   }
+   return out;
+}
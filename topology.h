@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+//  topology.h - 2026
+//
+/// This module reads which CPUs are online (and which package they're in) and
+/// parses and formats CPU lists like `0-3,8,10-11`.
+///
+/// @file   topology.h
+/// @author Mark Nelson <marknels@hawaii.edu>
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <stddef.h>  // For size_t
+
+
+/// The largest number of CPUs the modes that take a CPU list work with
+#define MAX_CPUS 1024
+
+
+/// Parse a CPU list like `0-3,8,10-11` (the format the kernel uses in sysfs)
+///
+/// @return The number of CPUs in `cpus`, or `-1` if `text` isn't a CPU list
+int topology_parse_cpulist( const char* text, int* cpus, int max );
+
+/// Read the CPUs that are online (`/sys/devices/system/cpu/online`)
+///
+/// @return The number of CPUs in `cpus`.  At least CPU 0.
+int topology_online_cpus( int* cpus, int max );
+
+/// Read the physical package (socket) a CPU is in
+/// (`/sys/devices/system/cpu/cpuN/topology/physical_package_id`)
+///
+/// @return The package ID, or `0` if sysfs doesn't say
+int topology_package_of( int cpu );
+
+/// Format CPUs as a CPU list like `0-3,8,10-11`.  `cpus` is sorted in place.
+///
+/// @return `out`, or `-` if there are no CPUs
+const char* topology_format_cpulist( int* cpus, int count, char* out, size_t size );
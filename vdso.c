@@ -3,32 +3,118 @@
 //
 /// This module contains code to dump the vDSO symbol table
 ///
+/// The reader works on any 64-bit ELF image in memory -- the live vDSO at
+/// `getauxval(AT_SYSINFO_EHDR)`, a vDSO saved with `--vdso --dump` (or read
+/// out of `/proc/<pid>/mem`), or a kernel build's `vdso64.so`.  Files are
+/// mapped, not copied, and no offset, address or count in the image is
+/// trusted:  Everything is checked against the size of the image first.
+///
+/// Usage:
+///
+///     test-sgx --vdso                            # Check the live vDSO
+///     test-sgx --vdso --dump vdso-$(uname -r).so # Save the live vDSO
+///     test-sgx --vdso --symbols vdso-*.so        # Check many saved vDSOs
+///
 /// @file   vdso.c
 /// @author Mark Nelson <marknels@hawaii.edu>
 /// @author Brooke Maeda <bmhm@hawaii.edu>
 ///////////////////////////////////////////////////////////////////////////////
 
-#include <stdio.h>     // For printf()
-#include <sys/auxv.h>  // For getauxval
+#include <stdio.h>     // For printf() fopen() fwrite()
+#include <string.h>    // For memcmp() strcmp() memchr()
+#include <inttypes.h>  // For uintptr_t
 #include <stdbool.h>   // For bool true false
 
+#ifdef __linux__
+	#include <sys/auxv.h>  // For getauxval
+	#include <fcntl.h>     // For open() O_RDONLY
+	#include <unistd.h>    // For close()
+	#include <sys/mman.h>  // For mmap() munmap()
+	#include <sys/stat.h>  // For fstat()
+#endif
+
 #include "vdso.h"      // For obvious reasons
+#include "test-sgx.h"  // For PROGRAM_NAME
+
+
+/// The vDSO symbol that enters an SGX enclave
+#define SGX_ENTER_ENCLAVE "__vdso_sgx_enter_enclave"
+
+
+#ifdef __linux__  // The vDSO and the ELF headers are Linux's
+
+
+/// Return a pointer to `size` bytes at `offset` in `image`
+///
+/// @return `NULL` if any of it is outside of the image
+static const void* elf_at( const struct elf_image* image, uint64_t offset, uint64_t size ) {
+	if( offset > image->size || size > image->size - offset ) {
+		return NULL;
+	}
+	return image->base + offset;
+}
+
+
+/// Return a pointer to `size` bytes at the virtual address `vaddr`, by finding
+/// the `PT_LOAD` segment that holds it
+///
+/// @return `NULL` if no segment in the image holds all of it
+static const void* elf_at_vaddr( const struct elf_image* image, uint64_t vaddr, uint64_t size ) {
+	for( int i = 0 ; i < image->phnum ; i++ ) {
+		const Elf64_Phdr* phdr = &image->phdrtab[i];
+		if( phdr->p_type != PT_LOAD || vaddr < phdr->p_vaddr ) {
+			continue;
+		}
+		uint64_t into = vaddr - phdr->p_vaddr;
+		if( into <= phdr->p_filesz && size <= phdr->p_filesz - into ) {
+			return elf_at( image, phdr->p_offset + into, size );
+		}
+	}
+	return NULL;
+}
+
+
+/// Check the ELF header & program headers of the image at `base` and fill in
+/// `image`
+///
+/// @return `false` if it isn't a 64-bit little-endian ELF image that fits in `size`
+bool elf_image_open( const void* base, size_t size, struct elf_image* image ) {
+	image->base = base;
+	image->size = size;
+	image->phdrtab = NULL;
+	image->phnum = 0;
+
+	const Elf64_Ehdr* ehdr = elf_at( image, 0, sizeof( *ehdr ) );
+	if( ehdr == NULL
+	 || memcmp( ehdr->e_ident, ELFMAG, SELFMAG ) != 0
+	 || ehdr->e_ident[EI_CLASS] != ELFCLASS64
+	 || ehdr->e_ident[EI_DATA] != ELFDATA2LSB
+	 || ehdr->e_phentsize != sizeof( Elf64_Phdr ) ) {
+		return false;
+	}
+
+	image->phdrtab = elf_at( image, ehdr->e_phoff, (uint64_t) ehdr->e_phnum * sizeof( Elf64_Phdr ) );
+	if( image->phdrtab == NULL || (uintptr_t) image->phdrtab % _Alignof( Elf64_Phdr ) != 0 ) {
+		return false;
+	}
+	image->phnum = ehdr->e_phnum;
+	return true;
+}
 
 
 /// Get the vDSO dynamic link table `PT_DYNAMIC`
 ///
 /// Iterate over `phdrtab` until it finds the `PT_DYNAMIC` entry
 ///
-/// @param addr vDSO base address
+/// @param image  The ELF image
+/// @param pCount Set to the number of entries that fit in the segment
 /// @return A pointer to the table or `NULL` if it's not found
-static Elf64_Dyn* vdso_get_dynamic_link_table( void* addr ) {
-	Elf64_Ehdr* ehdr = addr;
-	Elf64_Phdr* phdrtab = (Elf64_Phdr*)((char*)addr + ehdr->e_phoff);
-
-	for( int i = 0 ; i < ehdr->e_phnum ; i++ ) {
-		if( phdrtab[i].p_type == PT_DYNAMIC ) {
-			// return (Elf64_Dyn*)addr + phdrtab[i].p_offset;
-			return (Elf64_Dyn*)((char*)addr + phdrtab[i].p_offset);
+static const Elf64_Dyn* vdso_get_dynamic_link_table( const struct elf_image* image, size_t* pCount ) {
+	for( int i = 0 ; i < image->phnum ; i++ ) {
+		const Elf64_Phdr* phdr = &image->phdrtab[i];
+		if( phdr->p_type == PT_DYNAMIC ) {
+			*pCount = phdr->p_filesz / sizeof( Elf64_Dyn );
+			return elf_at( image, phdr->p_offset, *pCount * sizeof( Elf64_Dyn ) );
 		}
 	}
 
@@ -36,82 +122,181 @@ static Elf64_Dyn* vdso_get_dynamic_link_table( void* addr ) {
 }
 
 
-/// Get a dynamic section from a vDSO file
+/// Get a dynamic section's value from a vDSO file
 ///
-/// @param addr   vDSO base address
 /// @param dyntab Pointer to a vDSO dynamic link table
+/// @param count  The number of entries in `dyntab`
 /// @param tag    A dynamic section type. eg. `DT_HASH`, `DT_STRTAB`, et.al.
-/// @return A pointer to a dynamic vDSO section or `NULL` if it's not found
-static void* vdso_get_dynamic_section( void* addr, Elf64_Dyn* dyntab, Elf64_Sxword tag ) {
-	for( int i = 0 ; dyntab[i].d_tag != DT_NULL ; i++ ) {
+/// @param pValue Set to the section's address (or value)
+/// @return `false` if it's not found
+static bool vdso_get_dynamic_section( const Elf64_Dyn* dyntab, size_t count, Elf64_Sxword tag, Elf64_Xword* pValue ) {
+	for( size_t i = 0 ; i < count && dyntab[i].d_tag != DT_NULL ; i++ ) {
 		if( dyntab[i].d_tag == tag ) {
-			// return (Elf64_Phdr*)addr + dyntab[i].d_un.d_ptr;
-			return (char*)addr + dyntab[i].d_un.d_ptr;
+			*pValue = dyntab[i].d_un.d_val;
+			return true;
 		}
 	}
 
-	return NULL;
+	return false;
 }
 
 
 /// Get the symbol table from the vDSO
 ///
-/// @param addr vDSO base address
+/// @param image  The ELF image
 /// @param symtab A pointer to a symbol table structure which gets populated
 ///               by this function.
 /// @return `true` if successful.  `false` if not.
-static bool vdso_get_symbol_table( void* addr, struct vdso_symtab* symtab ) {
-	Elf64_Dyn* dyntab = vdso_get_dynamic_link_table( addr );
+bool vdso_get_symbol_table( const struct elf_image* image, struct vdso_symtab* symtab ) {
+	size_t count = 0;
+	Elf64_Xword symtabAddr, strtabAddr, hashAddr, versymAddr, verdefAddr;
 
-	symtab->elf_symtab = vdso_get_dynamic_section( addr, dyntab, DT_SYMTAB );
-	if( !symtab->elf_symtab )
+	memset( symtab, 0, sizeof( *symtab ) );
+	symtab->image = image;
+
+	const Elf64_Dyn* dyntab = vdso_get_dynamic_link_table( image, &count );
+	if( dyntab == NULL )
+		return false;
+
+	if( !vdso_get_dynamic_section( dyntab, count, DT_SYMTAB, &symtabAddr )
+	 || !vdso_get_dynamic_section( dyntab, count, DT_STRTAB, &strtabAddr )
+	 || !vdso_get_dynamic_section( dyntab, count, DT_STRSZ,  &symtab->strtab_size )
+	 || !vdso_get_dynamic_section( dyntab, count, DT_HASH,   &hashAddr ) )
 		return false;
 
-	symtab->elf_symstrtab = vdso_get_dynamic_section( addr, dyntab, DT_STRTAB );
-	if( !symtab->elf_symstrtab )
+	// The hash table is nbucket, nchain, then the buckets & chains.  nchain is
+	// the number of symbols.
+	const Elf64_Word* header = elf_at_vaddr( image, hashAddr, 2 * sizeof( Elf64_Word ) );
+	if( header == NULL )
 		return false;
+	symtab->elf_hashtab = elf_at_vaddr( image, hashAddr, (2 + (uint64_t) header[0] + header[1]) * sizeof( Elf64_Word ) );
+	symtab->symbol_count = header[1];
 
-	symtab->elf_hashtab = vdso_get_dynamic_section( addr, dyntab, DT_HASH );
-	if( !symtab->elf_hashtab )
+	symtab->elf_symtab = elf_at_vaddr( image, symtabAddr, (uint64_t) symtab->symbol_count * sizeof( Elf64_Sym ) );
+	symtab->elf_symstrtab = elf_at_vaddr( image, strtabAddr, symtab->strtab_size );
+	if( !symtab->elf_hashtab || !symtab->elf_symtab || !symtab->elf_symstrtab )
 		return false;
 
+	// Symbol versions are optional
+	if( vdso_get_dynamic_section( dyntab, count, DT_VERSYM, &versymAddr )
+	 && vdso_get_dynamic_section( dyntab, count, DT_VERDEF, &verdefAddr ) ) {
+		symtab->versym = elf_at_vaddr( image, versymAddr, (uint64_t) symtab->symbol_count * sizeof( Elf64_Half ) );
+		symtab->verdef = elf_at_vaddr( image, verdefAddr, sizeof( Elf64_Verdef ) );
+	}
+
 	return true;
 }
 
 
+/// @return The string at `offset` in the string table, or `NULL` if it isn't
+///         terminated inside the table
+static const char* vdso_string( const struct vdso_symtab* symtab, Elf64_Word offset ) {
+	if( offset >= symtab->strtab_size
+	 || memchr( symtab->elf_symstrtab + offset, '\0', symtab->strtab_size - offset ) == NULL ) {
+		return NULL;
+	}
+	return symtab->elf_symstrtab + offset;
+}
+
+
+/// @return The name of symbol `index`, or `NULL` if it's out of bounds
+const char* vdso_symbol_name( const struct vdso_symtab* symtab, Elf64_Word index ) {
+	if( index >= symtab->symbol_count ) {
+		return NULL;
+	}
+	return vdso_string( symtab, symtab->elf_symtab[index].st_name );
+}
+
+
+/// @return The version (like `LINUX_2.6`) of symbol `index`, or `NULL` if it
+///         doesn't have one
+const char* vdso_symbol_version( const struct vdso_symtab* symtab, Elf64_Word index ) {
+	if( symtab->versym == NULL || symtab->verdef == NULL || index >= symtab->symbol_count ) {
+		return NULL;
+	}
+	Elf64_Half version = symtab->versym[index] & 0x7FFF;  // Bit 15 is "hidden"
+
+	// Walk the version definitions (a linked list of offsets) to find it.  The
+	// walk is bounded, so a loop in a corrupt image can't hang us.
+	const Elf64_Verdef* verdef = symtab->verdef;
+	for( Elf64_Word steps = 0 ; verdef != NULL && steps < symtab->symbol_count + 1 ; steps++ ) {
+		uint64_t at = (uint64_t) ((const unsigned char*) verdef - symtab->image->base);
+
+		if( verdef->vd_ndx == version && verdef->vd_cnt > 0 ) {
+			const Elf64_Verdaux* aux = elf_at( symtab->image, at + verdef->vd_aux, sizeof( Elf64_Verdaux ) );
+			return aux != NULL ? vdso_string( symtab, aux->vda_name ) : NULL;
+		}
+		if( verdef->vd_next == 0 ) {
+			break;
+		}
+		verdef = elf_at( symtab->image, at + verdef->vd_next, sizeof( Elf64_Verdef ) );
+	}
+	return NULL;
+}
+
+
 /// Print the symbol table pointed to by `symtab`
 ///
 /// @param symtab Pointer to a vDSO symbol table
 void print_whole_symbol_table( struct vdso_symtab* symtab ) {
-	Elf64_Word  bucketnum = symtab->elf_hashtab[0];
-	Elf64_Word* buckettab = &symtab->elf_hashtab[2];
-	Elf64_Word* chaintab = &symtab->elf_hashtab[2 + bucketnum];
-	Elf64_Sym*  sym;
+	Elf64_Word        bucketnum = symtab->elf_hashtab[0];
+	const Elf64_Word* buckettab = &symtab->elf_hashtab[2];
+	const Elf64_Word* chaintab = &symtab->elf_hashtab[2 + bucketnum];
 
 	for( Elf64_Word i = 0 ; i < bucketnum ; ++i ) {
-		for( Elf64_Word j = buckettab[i] ; j != STN_UNDEF ; j = chaintab[j]) {
-			sym = &symtab->elf_symtab[j];
-			printf( "vDSO symbol: %s\n", &symtab->elf_symstrtab[sym->st_name] );
+		Elf64_Word steps = 0;  // A chain can't be longer than the symbol table
+		for( Elf64_Word j = buckettab[i] ; j != STN_UNDEF && j < symtab->symbol_count && steps < symtab->symbol_count ; j = chaintab[j], steps++ ) {
+			const char* name = vdso_symbol_name( symtab, j );
+			printf( "vDSO symbol: %s\n", name != NULL ? name : "(bad name)" );
+		}
+	}
+}
+
+
+/// Find the live vDSO and how big it is (from `/proc/self/maps`)
+///
+/// @return `false` if we can't find it
+static bool vdso_live_image( struct elf_image* image ) {
+	const void* base = (const void*) getauxval( AT_SYSINFO_EHDR );
+	size_t size = 0;
+	char line[512];
+
+	if( !base ) {
+		return false;
+	}
+
+	FILE* maps = fopen( "/proc/self/maps", "r" );
+	if( maps != NULL ) {
+		while( fgets( line, sizeof( line ), maps ) != NULL ) {
+			uintptr_t start = 0, end = 0;
+			if( strstr( line, "[vdso]" ) != NULL && sscanf( line, "%" SCNxPTR "-%" SCNxPTR, &start, &end ) == 2 && start == (uintptr_t) base ) {
+				size = end - start;
+			}
 		}
+		fclose( maps );
+	}
+	if( size == 0 ) {
+		size = (size_t) sysconf( _SC_PAGESIZE );  // At least the ELF header is mapped
 	}
+
+	return elf_image_open( base, size, image );
 }
 
 
 /// Print out the vDSO symbol table
 void dump_vDSO ( void ) {
+	struct elf_image   image;
 	struct vdso_symtab symtab;
 
 	// Get vDSO base address
-	void* vdso_base_addr;
-	vdso_base_addr = (void *)getauxval( AT_SYSINFO_EHDR );
-	if( !vdso_base_addr ) {
+	if( !vdso_live_image( &image ) ) {
 		printf( "Can't get vDSO base address\n" );
 		return;
 	}
-	
-	printf( "vDSO base address: %p\n", vdso_base_addr );
 
-	if( !vdso_get_symbol_table( vdso_base_addr, &symtab ) ){
+	printf( "vDSO base address: %p\n", (const void*) image.base );
+
+	if( !vdso_get_symbol_table( &image, &symtab ) ){
 		printf( "Can't get a symbol table from the vDSO\n" );
 		return;
 	}
@@ -120,3 +305,146 @@ void dump_vDSO ( void ) {
 	print_whole_symbol_table( &symtab );
 }
 
+
+/// Report one image:  Whether it has `__vdso_sgx_enter_enclave`, and which
+/// version.  With `symbols`, list every symbol and its version too.
+///
+/// @return `false` if the image couldn't be read
+static bool vdso_report( const char* label, const struct elf_image* image, bool symbols ) {
+	struct vdso_symtab symtab;
+
+	if( !vdso_get_symbol_table( image, &symtab ) ) {
+		printf( "%-40s  not a readable vDSO (bad or truncated ELF)\n", label );
+		return false;
+	}
+
+	const char* sgxVersion = NULL;
+	bool        hasSGX = false;
+	for( Elf64_Word i = 1 ; i < symtab.symbol_count ; i++ ) {
+		const char* name = vdso_symbol_name( &symtab, i );
+		if( name != NULL && strcmp( name, SGX_ENTER_ENCLAVE ) == 0 ) {
+			hasSGX = true;
+			sgxVersion = vdso_symbol_version( &symtab, i );
+		}
+	}
+
+	printf( "%-40s  %3u symbols  " SGX_ENTER_ENCLAVE ": %s%s%s\n"
+	       ,label
+	       ,symtab.symbol_count > 0 ? symtab.symbol_count - 1 : 0
+	       ,hasSGX ? "yes" : "no"
+	       ,sgxVersion != NULL ? "@" : ""
+	       ,sgxVersion != NULL ? sgxVersion : "" );
+
+	for( Elf64_Word i = 1 ; symbols && i < symtab.symbol_count ; i++ ) {
+		const char* name = vdso_symbol_name( &symtab, i );
+		const char* version = vdso_symbol_version( &symtab, i );
+		printf( "    %s%s%s\n", name != NULL ? name : "(bad name)", version != NULL ? "@" : "", version != NULL ? version : "" );
+	}
+	return true;
+}
+
+
+/// Write the live vDSO to `path`
+///
+/// @return `false` if it couldn't be written
+static bool vdso_dump_live( const struct elf_image* image, const char* path ) {
+	FILE* file = fopen( path, "wb" );
+	if( file == NULL ) {
+		perror( path );
+		return false;
+	}
+	bool ok = fwrite( image->base, 1, image->size, file ) == image->size;
+	ok = fclose( file ) == 0 && ok;
+	if( !ok ) {
+		fprintf( stderr, "vdso: Unable to write %s\n", path );
+	}
+	return ok;
+}
+
+
+/// `--vdso [--dump FILE] [--symbols] [IMAGE]...`
+int vdso_main( int argc, char* argv[] ) {
+	const char* dumpFile = NULL;
+	bool        symbols = false;
+	bool        ok = true;
+	int         firstImage = argc;
+
+	for( int i = 1 ; i < argc ; i++ ) {
+		if( strcmp( argv[i], "--dump" ) == 0 && i + 1 < argc ) {
+			dumpFile = argv[++i];
+		} else if( strcmp( argv[i], "--symbols" ) == 0 ) {
+			symbols = true;
+		} else if( argv[i][0] != '-' ) {
+			firstImage = i;
+			break;
+		} else {
+			fprintf( stderr, "Usage: " PROGRAM_NAME " --vdso [--dump FILE] [--symbols] [IMAGE]...\n" );
+			return EXIT_FAILURE;
+		}
+	}
+
+	if( firstImage == argc || dumpFile != NULL ) {
+		struct elf_image image;
+		if( !vdso_live_image( &image ) ) {
+			printf( "Can't get vDSO base address\n" );
+			return EXIT_FAILURE;
+		}
+		if( dumpFile != NULL && !vdso_dump_live( &image, dumpFile ) ) {
+			return EXIT_FAILURE;
+		}
+		if( firstImage == argc ) {  // No images:  Report the live vDSO
+			return vdso_report( "[vdso]", &image, symbols ) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	for( int i = firstImage ; i < argc ; i++ ) {
+		struct elf_image image;
+		struct stat      st;
+
+		int fd = open( argv[i], O_RDONLY | O_CLOEXEC );
+		if( fd < 0 || fstat( fd, &st ) != 0 || st.st_size <= 0 ) {
+			printf( "%-40s  unreadable\n", argv[i] );
+			if( fd >= 0 ) {
+				close( fd );
+			}
+			ok = false;
+			continue;
+		}
+
+		void* base = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		close( fd );
+		if( base == MAP_FAILED ) {
+			printf( "%-40s  unreadable\n", argv[i] );
+			ok = false;
+			continue;
+		}
+
+		if( !elf_image_open( base, (size_t) st.st_size, &image ) ) {
+			printf( "%-40s  not a 64-bit ELF image\n", argv[i] );
+			ok = false;
+		} else {
+			ok = vdso_report( argv[i], &image, symbols ) && ok;
+		}
+		munmap( base, (size_t) st.st_size );
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#else  // __linux__
+
+/// Print out the vDSO symbol table
+void dump_vDSO ( void ) {
+	printf( "There's no vDSO outside of Linux\n" );
+}
+
+
+/// `--vdso [--dump FILE] [--symbols] [IMAGE]...`
+int vdso_main( int argc, char* argv[] ) {
+	(void) argc;  // Squelch unused parameter warnings
+	(void) argv;
+	printf( "Reading the vDSO needs Linux\n" );
+	return EXIT_FAILURE;
+}
+
+#endif  // __linux__
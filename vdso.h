@@ -8,20 +8,67 @@
 /// @author Brooke Maeda <bmhm@hawaii.edu>
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <stddef.h>    // For size_t
+#include <stdbool.h>   // For bool
+
+#ifdef __linux__  // The ELF reader needs Linux's <elf.h>
+
 #include <elf.h>       // For Elf64_Sym Elf64_Word
 
+/// An ELF image in memory (the live vDSO or a mapped file).  Every offset the
+/// reader follows is checked against `size`.
+struct elf_image {
+	const unsigned char* base;     ///< The first byte of the image
+	size_t               size;     ///< The bytes we may read from `base`
+	const Elf64_Phdr*    phdrtab;  ///< Program headers (checked)
+	Elf64_Half           phnum;
+};
+
 /// vDSO symbol table information
 struct vdso_symtab {
-	Elf64_Sym*  elf_symtab;     ///< Symbol table
-	const char* elf_symstrtab;  ///< String table
-	Elf64_Word* elf_hashtab;    ///< Hash table
+	const Elf64_Sym*  elf_symtab;     ///< Symbol table
+	const char*       elf_symstrtab;  ///< String table
+	const Elf64_Word* elf_hashtab;    ///< Hash table
+	Elf64_Word        symbol_count;   ///< Symbols in `elf_symtab` (the hash table's nchain)
+	Elf64_Xword       strtab_size;    ///< Bytes in `elf_symstrtab`
+	const Elf64_Half* versym;         ///< Version of each symbol, or `NULL`
+	const Elf64_Verdef* verdef;       ///< Version definitions, or `NULL`
+	const struct elf_image* image;
 };
 
 
+/// Check the ELF header & program headers of the image at `base` and fill in
+/// `image`
+///
+/// @return `false` if it isn't a 64-bit little-endian ELF image that fits in `size`
+bool elf_image_open( const void* base, size_t size, struct elf_image* image );
+
+
+/// Find the dynamic symbol table of `image`, checking every table fits
+///
+/// @return `true` if successful.  `false` if not.
+bool vdso_get_symbol_table( const struct elf_image* image, struct vdso_symtab* symtab );
+
+
+/// @return The name of symbol `index`, or `NULL` if it's out of bounds
+const char* vdso_symbol_name( const struct vdso_symtab* symtab, Elf64_Word index );
+
+
+/// @return The version (like `LINUX_2.6`) of symbol `index`, or `NULL` if it
+///         doesn't have one
+const char* vdso_symbol_version( const struct vdso_symtab* symtab, Elf64_Word index );
+
+
 // Print the symbol table pointed to by `symtab`
 void print_whole_symbol_table( struct vdso_symtab* symtab );
 
 
+#endif  // __linux__
+
+
 // Print out the symbol table
 void dump_vDSO ( void );
 
+
+/// `--vdso [--dump FILE] [--symbols] [IMAGE]...`
+int vdso_main( int argc, char* argv[] );
@@ -50,6 +50,12 @@
 #include "xsave.h"  // For obvious reasons
 #include "cpuid.h"  // For native_cpuid32()
 #include "rdmsr.h"  // For checkCapabilities()
+#include "decode.h" // For xsave_components[] field_extract() print_cpuid_fields()
+#include "capture.h" // For capture_find_cpuid()
+
+
+/// The legacy region (x87 & SSE) and the XSAVE header
+#define XSAVE_LEGACY_AND_HEADER_SIZE ( 512 + 64 )
 
 
 bool is_XGETBV_supported = 0;
@@ -85,23 +91,23 @@ uint64_t native_XGETBV( uint32_t xcr ) {
 }
 
 
-void print_detailed_state_component( char* type, char* name, int bit, uint64_t flag_supported, uint64_t flag_acutal, char* desc ) {
-   printf( "    %-8s %-10s", type, name );
+void print_detailed_state_component( const struct field_desc* component, uint64_t flag_supported, uint64_t flag_acutal ) {
+   printf( "    %-8s %-10s", component->source == SRC_XSS ? "IA32_XSS" : "XCR0", component->name );
 
-   if( flag_supported >> bit & 1 ) {
+   if( field_extract( component, flag_supported ) ) {
       printf( " yes    " );
    } else {
       printf( "  no    " );
    }
 
-   if( flag_acutal >> bit & 1 ) {
+   if( field_extract( component, flag_acutal ) ) {
       printf( "  set" );
    } else {
       printf( "clear" );
    }
 
-   if( strlen( desc ) > 0 ) {
-      printf( " %s", desc );
+   if( strlen( component->description ) > 0 ) {
+      printf( " %s", component->description );
    }
 
    printf( "\n" );
@@ -115,36 +121,49 @@ void print_XSAVE_state_components( uint64_t xcr0, uint64_t xss, uint64_t xcr0_ac
 
 /// @see https://en.wikipedia.org/wiki/Control_register
 
-   print_detailed_state_component( "XCR0",     "x87:",       0, xcr0, xcr0_actual, "x87 Floating Point Unit & MMX" );
-   print_detailed_state_component( "XCR0",     "SSE:",       1, xcr0, xcr0_actual, "MXCSR and XMM registers" );
-   print_detailed_state_component( "XCR0",     "AVX:",       2, xcr0, xcr0_actual, "YMM registers" );
-   print_detailed_state_component( "XCR0",     "BNDREG:",    3, xcr0, xcr0_actual, "MPX for BND registers" );
-   print_detailed_state_component( "XCR0",     "BNDCSR:",    4, xcr0, xcr0_actual, "MPX for BNDCFGU and BNDSTATUS registers" );
-   print_detailed_state_component( "XCR0",     "opmask:",    5, xcr0, xcr0_actual, "AVX-512 for AVX opmask and AKA k-mask" );
-   print_detailed_state_component( "XCR0",     "ZMM_hi256:", 6, xcr0, xcr0_actual, "AVX-512 for the upper-halves of lower ZMM registers" );
-   print_detailed_state_component( "XCR0",     "Hi16_ZMM:",  7, xcr0, xcr0_actual, "AVX-512 for the upper ZMM registers" );
-   print_detailed_state_component( "IA32_XSS", "PT:",        8, xss,  xss_actual,  "Processor Trace" );
-   print_detailed_state_component( "XCR0",     "PKRU:",      9, xcr0, xcr0_actual, "User Protection Keys" );
-   print_detailed_state_component( "IA32_XSS", "PASID:",    10, xss,  xss_actual,  "Process Address Space ID" );
-   print_detailed_state_component( "IA32_XSS", "CET_U:",    11, xss,  xss_actual,  "Control-flow Enforcement Technology: user-mode functionality MSRs" );
-   print_detailed_state_component( "IA32_XSS", "CET_S:",    10, xss,  xss_actual,  "CET: shadow stack pointers for rings 0,1,2" );
-   print_detailed_state_component( "IA32_XSS", "HDC:",      13, xss,  xss_actual,  "Hardware Duty Cycling" );
-   print_detailed_state_component( "IA32_XSS", "UINTR:",    14, xss,  xss_actual,  "User-Mode Interrupts" );
-   print_detailed_state_component( "IA32_XSS", "LBR:",      15, xss,  xss_actual,  "Last Branch Record" );
-   print_detailed_state_component( "IA32_XSS", "HWP:",      16, xss,  xss_actual,  "Hardware P-state control" );
-   print_detailed_state_component( "XCR0",     "TILECFG:",  17, xcr0, xcr0_actual, "AMX - Advanced Matrix Extensions" );
-   print_detailed_state_component( "XCR0",     "TILEDATA:", 18, xcr0, xcr0_actual, "AMX - Advanced Matrix Extensions" );
-   print_detailed_state_component( "XCR0",     "APX:",      19, xcr0, xcr0_actual, "Extended General Purpose Registers R16-R31" );
+   for( int i = 0 ; i < XSTATE_COUNT ; i++ ) {
+      const struct field_desc* component = &xsave_components[i];
+
+      if( component->source == SRC_XSS ) {
+         print_detailed_state_component( component, xss, xss_actual );
+      } else {
+         print_detailed_state_component( component, xcr0, xcr0_actual );
+      }
+   }
 }
 
 
 void print_XSAVE_feature_flags( uint32_t eax ) {
+   print_cpuid_fields( GROUP_XSAVE_FLAGS, 0x0D, 1, eax, 0, 0, 0 );
+}
+
+
+/// The size of a standard (non-compacted) format XSAVE area holding the user
+/// state components in `xfrm`.  This is the XSAVE part of an SSA frame.
+///
+/// Each component's size and offset come from CPUID.(EAX=0DH, ECX=i) in `cap`.
+///
+/// @return `0` if a component in `xfrm` isn't enumerated in `cap`
+uint32_t XSAVE_area_size( const struct sgx_capture* cap, uint64_t xfrm ) {
+   uint32_t size = XSAVE_LEGACY_AND_HEADER_SIZE;
+
+   for( uint32_t i = 2 ; i < 64 ; i++ ) {
+      if( !((xfrm >> i) & 1) ) {
+         continue;
+      }
+
+      const struct cpuid_record* r = capture_find_cpuid( cap, 0x0D, i );
+      if( r == NULL || r->eax == 0 ) {
+         return 0;
+      }
+
+      uint32_t end = r->ebx + r->eax;  // Offset + size
+      if( end > size ) {
+         size = end;
+      }
+   }
 
-   printf( "    xsaveopt - save state-components that have been modified since last XRSTOR: %" PRId32 "\n", (eax >> 0) & 1 );
-   printf( "    xsavec - save/restore state with compaction: %" PRId32 "\n", (eax >> 1) & 1 );
-   printf( "    xgetbv_ecx1 - XGETBV with ECX=1 support: %" PRId32 "\n", (eax >> 2) & 1 );
-   printf( "    xss - save/restore state with compaction, including supervisor state: %" PRId32 "\n", (eax >> 3) & 1 );
-   printf( "    xfd - Extended Feature Disable supported: %" PRId32 "\n", (eax >> 4) & 1 );
+   return size;
 }
 
 
@@ -170,7 +189,7 @@ void print_XSAVE_enumeration() {
    native_cpuid32( &eax_1, &ebx_1, &ecx_1, &edx_1 );
    // print_registers32( eax_1, ebx_1, ecx_1, edx_1 );
 
-   is_XGETBV_supported = (eax_1 >> 2) & 1;
+   is_XGETBV_supported = field_from_regs( &fields[FIELD_XGETBV_ECX1], eax_1, ebx_1, ecx_1, edx_1 );
 
    if( is_XGETBV_supported ) {
       xcr0 = native_XGETBV( 0 );  // Get xcr0
@@ -8,4 +8,20 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <inttypes.h>  // For uint32_t uint64_t
+
+
+/// Call `XGETBV`, passing `ecx`.
+///
+/// @param xcr Extended control register (XCR) specified in the ECX register
+uint64_t native_XGETBV( uint32_t xcr );
+
+struct sgx_capture;
+
+/// The size of a standard (non-compacted) format XSAVE area holding the user
+/// state components in `xfrm`
+///
+/// @return `0` if a component in `xfrm` isn't enumerated in `cap`
+uint32_t XSAVE_area_size( const struct sgx_capture* cap, uint64_t xfrm );
+
 void print_XSAVE_enumeration();